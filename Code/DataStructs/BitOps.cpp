@@ -20,9 +20,364 @@
 #include <sstream>
 
 #include <boost/lexical_cast.hpp>
+#include <iterator>
 
 using namespace RDKit;
 
+// """ -------------------------------------------------------
+//
+//  Bitmap kernels
+//
+// """ -------------------------------------------------------
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && \
+  (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define RDK_X86_BITMAP_KERNELS
+#include <immintrin.h>
+#if __GNUC__ >= 8
+#define RDK_AVX512_BITMAP_KERNELS
+#endif
+#endif
+
+namespace {
+  // the bit operations the kernels are built on. Each provides the
+  // scalar version and the vector versions for the different kernels.
+  struct FirstOp {
+    static boost::uint64_t scalar(boost::uint64_t a,boost::uint64_t b) { return a; };
+#ifdef RDK_X86_BITMAP_KERNELS
+    __attribute__((target("avx2"),always_inline))
+    static __m256i vec256(__m256i a,__m256i b) { return a; };
+#endif
+#ifdef RDK_AVX512_BITMAP_KERNELS
+    __attribute__((target("avx512f"),always_inline))
+    static __m512i vec512(__m512i a,__m512i b) { return a; };
+#endif
+  };
+  struct AndOp {
+    static boost::uint64_t scalar(boost::uint64_t a,boost::uint64_t b) { return a&b; };
+#ifdef RDK_X86_BITMAP_KERNELS
+    __attribute__((target("avx2"),always_inline))
+    static __m256i vec256(__m256i a,__m256i b) { return _mm256_and_si256(a,b); };
+#endif
+#ifdef RDK_AVX512_BITMAP_KERNELS
+    __attribute__((target("avx512f"),always_inline))
+    static __m512i vec512(__m512i a,__m512i b) { return _mm512_and_si512(a,b); };
+#endif
+  };
+  struct XorOp {
+    static boost::uint64_t scalar(boost::uint64_t a,boost::uint64_t b) { return a^b; };
+#ifdef RDK_X86_BITMAP_KERNELS
+    __attribute__((target("avx2"),always_inline))
+    static __m256i vec256(__m256i a,__m256i b) { return _mm256_xor_si256(a,b); };
+#endif
+#ifdef RDK_AVX512_BITMAP_KERNELS
+    __attribute__((target("avx512f"),always_inline))
+    static __m512i vec512(__m512i a,__m512i b) { return _mm512_xor_si512(a,b); };
+#endif
+  };
+  struct OrOp {
+    static boost::uint64_t scalar(boost::uint64_t a,boost::uint64_t b) { return a|b; };
+#ifdef RDK_X86_BITMAP_KERNELS
+    __attribute__((target("avx2"),always_inline))
+    static __m256i vec256(__m256i a,__m256i b) { return _mm256_or_si256(a,b); };
+#endif
+#ifdef RDK_AVX512_BITMAP_KERNELS
+    __attribute__((target("avx512f"),always_inline))
+    static __m512i vec512(__m512i a,__m512i b) { return _mm512_or_si512(a,b); };
+#endif
+  };
+
+  inline unsigned int genericPopcount(boost::uint64_t v){
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<unsigned int>((v * 0x0101010101010101ULL) >> 56);
+  }
+
+  template <typename Op>
+  unsigned int genericKernel(const boost::uint64_t *bv1,const boost::uint64_t *bv2,
+                             unsigned int nWords){
+    unsigned int res=0;
+    for(unsigned int i=0;i<nWords;++i){
+      res+=genericPopcount(Op::scalar(bv1[i],bv2[i]));
+    }
+    return res;
+  }
+
+#ifdef RDK_X86_BITMAP_KERNELS
+  template <typename Op>
+  __attribute__((target("popcnt")))
+  unsigned int popcntKernel(const boost::uint64_t *bv1,const boost::uint64_t *bv2,
+                            unsigned int nWords){
+    // a couple of independent accumulators help the CPU overlap the
+    // popcnt instructions:
+    boost::uint64_t r0=0,r1=0;
+    unsigned int i=0;
+    for(;i+1<nWords;i+=2){
+      r0+=__builtin_popcountll(Op::scalar(bv1[i],bv2[i]));
+      r1+=__builtin_popcountll(Op::scalar(bv1[i+1],bv2[i+1]));
+    }
+    if(i<nWords) r0+=__builtin_popcountll(Op::scalar(bv1[i],bv2[i]));
+    return static_cast<unsigned int>(r0+r1);
+  }
+
+  // popcount of each 64 bit lane, using the nibble lookup table approach
+  // from W. Mula, N. Kurz, D. Lemire, "Faster Population Counts Using AVX2
+  // Instructions", Comput. J. 61, 111-120 (2018)
+  __attribute__((target("avx2"),always_inline))
+  inline __m256i avx2LanePopcount(__m256i v){
+    const __m256i lookup=_mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+                                          0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+    const __m256i lowMask=_mm256_set1_epi8(0x0f);
+    __m256i lo=_mm256_and_si256(v,lowMask);
+    __m256i hi=_mm256_and_si256(_mm256_srli_epi16(v,4),lowMask);
+    __m256i cnt=_mm256_add_epi8(_mm256_shuffle_epi8(lookup,lo),
+                                _mm256_shuffle_epi8(lookup,hi));
+    return _mm256_sad_epu8(cnt,_mm256_setzero_si256());
+  }
+
+  template <typename Op>
+  __attribute__((target("avx2,popcnt")))
+  unsigned int avx2Kernel(const boost::uint64_t *bv1,const boost::uint64_t *bv2,
+                          unsigned int nWords){
+    __m256i acc=_mm256_setzero_si256();
+    unsigned int i=0;
+    for(;i+4<=nWords;i+=4){
+      __m256i v1=_mm256_loadu_si256(reinterpret_cast<const __m256i *>(bv1+i));
+      __m256i v2=_mm256_loadu_si256(reinterpret_cast<const __m256i *>(bv2+i));
+      acc=_mm256_add_epi64(acc,avx2LanePopcount(Op::vec256(v1,v2)));
+    }
+    boost::uint64_t res=_mm256_extract_epi64(acc,0)+_mm256_extract_epi64(acc,1)+
+      _mm256_extract_epi64(acc,2)+_mm256_extract_epi64(acc,3);
+    for(;i<nWords;++i){
+      res+=__builtin_popcountll(Op::scalar(bv1[i],bv2[i]));
+    }
+    // the compiler only does this itself when optimizing, without it
+    // the SSE code in the caller pays for AVX-SSE transitions:
+    _mm256_zeroupper();
+    return static_cast<unsigned int>(res);
+  }
+#endif
+
+#ifdef RDK_AVX512_BITMAP_KERNELS
+  template <typename Op>
+  __attribute__((target("avx512f,avx512vpopcntdq")))
+  unsigned int avx512Kernel(const boost::uint64_t *bv1,const boost::uint64_t *bv2,
+                            unsigned int nWords){
+    __m512i acc=_mm512_setzero_si512();
+    unsigned int i=0;
+    for(;i+8<=nWords;i+=8){
+      __m512i v1=_mm512_loadu_si512(bv1+i);
+      __m512i v2=_mm512_loadu_si512(bv2+i);
+      acc=_mm512_add_epi64(acc,_mm512_popcnt_epi64(Op::vec512(v1,v2)));
+    }
+    if(i<nWords){
+      // masked loads take care of the tail:
+      __mmask8 mask=static_cast<__mmask8>((1U<<(nWords-i))-1);
+      __m512i v1=_mm512_maskz_loadu_epi64(mask,bv1+i);
+      __m512i v2=_mm512_maskz_loadu_epi64(mask,bv2+i);
+      acc=_mm512_add_epi64(acc,_mm512_popcnt_epi64(Op::vec512(v1,v2)));
+    }
+    boost::uint64_t res=_mm512_reduce_add_epi64(acc);
+    _mm256_zeroupper();
+    return static_cast<unsigned int>(res);
+  }
+#endif
+
+  typedef unsigned int (*BitmapKernel)(const boost::uint64_t *,const boost::uint64_t *,
+                                       unsigned int);
+  struct BitmapKernelSet {
+    BitmapKernelType type;
+    BitmapKernel popcount,andCount,xorCount,orCount;
+  };
+
+  template <template <typename> class Kernel>
+  BitmapKernelSet makeKernelSet(BitmapKernelType type){
+    BitmapKernelSet res;
+    res.type=type;
+    res.popcount=Kernel<FirstOp>::run;
+    res.andCount=Kernel<AndOp>::run;
+    res.xorCount=Kernel<XorOp>::run;
+    res.orCount=Kernel<OrOp>::run;
+    return res;
+  }
+  template <typename Op> struct GenericKernel {
+    static unsigned int run(const boost::uint64_t *bv1,const boost::uint64_t *bv2,
+                            unsigned int nWords){
+      return genericKernel<Op>(bv1,bv2,nWords);
+    }
+  };
+#ifdef RDK_X86_BITMAP_KERNELS
+  template <typename Op> struct PopcntKernel {
+    static unsigned int run(const boost::uint64_t *bv1,const boost::uint64_t *bv2,
+                            unsigned int nWords){
+      return popcntKernel<Op>(bv1,bv2,nWords);
+    }
+  };
+  template <typename Op> struct AVX2Kernel {
+    static unsigned int run(const boost::uint64_t *bv1,const boost::uint64_t *bv2,
+                            unsigned int nWords){
+      return avx2Kernel<Op>(bv1,bv2,nWords);
+    }
+  };
+#endif
+#ifdef RDK_AVX512_BITMAP_KERNELS
+  template <typename Op> struct AVX512Kernel {
+    static unsigned int run(const boost::uint64_t *bv1,const boost::uint64_t *bv2,
+                            unsigned int nWords){
+      return avx512Kernel<Op>(bv1,bv2,nWords);
+    }
+  };
+#endif
+
+  bool kernelAvailable(BitmapKernelType which){
+    switch(which){
+    case GENERIC_BITMAP_KERNEL:
+      return true;
+#ifdef RDK_X86_BITMAP_KERNELS
+    case POPCNT_BITMAP_KERNEL:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("popcnt");
+    case AVX2_BITMAP_KERNEL:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+#ifdef RDK_AVX512_BITMAP_KERNELS
+    case AVX512_BITMAP_KERNEL:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512vpopcntdq");
+#endif
+    default:
+      return false;
+    }
+  }
+
+  // the kernel sets are built once and never modified, switching
+  // kernels just changes which one is pointed to:
+  const BitmapKernelSet &kernelSetFor(BitmapKernelType which){
+    static const BitmapKernelSet generic=makeKernelSet<GenericKernel>(GENERIC_BITMAP_KERNEL);
+    switch(which){
+#ifdef RDK_X86_BITMAP_KERNELS
+    case POPCNT_BITMAP_KERNEL:
+      {
+        static const BitmapKernelSet popcnt=makeKernelSet<PopcntKernel>(which);
+        return popcnt;
+      }
+    case AVX2_BITMAP_KERNEL:
+      {
+        static const BitmapKernelSet avx2=makeKernelSet<AVX2Kernel>(which);
+        return avx2;
+      }
+#endif
+#ifdef RDK_AVX512_BITMAP_KERNELS
+    case AVX512_BITMAP_KERNEL:
+      {
+        static const BitmapKernelSet avx512=makeKernelSet<AVX512Kernel>(which);
+        return avx512;
+      }
+#endif
+    default:
+      return generic;
+    }
+  }
+
+  const BitmapKernelSet &bestKernelSet(){
+    BitmapKernelType which=GENERIC_BITMAP_KERNEL;
+    if(kernelAvailable(AVX512_BITMAP_KERNEL)) which=AVX512_BITMAP_KERNEL;
+    else if(kernelAvailable(AVX2_BITMAP_KERNEL)) which=AVX2_BITMAP_KERNEL;
+    else if(kernelAvailable(POPCNT_BITMAP_KERNEL)) which=POPCNT_BITMAP_KERNEL;
+    return kernelSetFor(which);
+  }
+
+  // the active set is picked when the library is loaded, so the kernels
+  // don't need to check whether or not that has happened:
+  const BitmapKernelSet *activeKernelSet=&bestKernelSet();
+  inline const BitmapKernelSet &activeKernels(){
+    return *activeKernelSet;
+  }
+
+  // a copy of the blocks of an ExplicitBitVect for the kernels. The
+  // dynamic_bitset doesn't give access to its storage, so the blocks are
+  // copied out with to_block_range(); the usual fingerprint sizes fit in
+  // the fixed buffer.
+  class BitmapWords {
+  public:
+    //! returns false if the dynamic_bitset doesn't use 64 bit blocks
+    bool init(const ExplicitBitVect &bv){
+      typedef boost::dynamic_bitset<>::block_type block_type;
+      if(sizeof(block_type)!=sizeof(boost::uint64_t)) return false;
+      d_nWords=bv.dp_bits->num_blocks();
+      if(d_nWords<=bufferSize){
+        dp_words=d_buffer;
+      } else {
+        d_storage.resize(d_nWords);
+        dp_words=&d_storage[0];
+      }
+      boost::to_block_range(*bv.dp_bits,dp_words);
+      return true;
+    }
+    const boost::uint64_t *words() const { return dp_words; };
+    unsigned int size() const { return d_nWords; };
+  private:
+    static const unsigned int bufferSize=64;
+    boost::uint64_t d_buffer[bufferSize];
+    std::vector<boost::uint64_t> d_storage;
+    boost::uint64_t *dp_words;
+    unsigned int d_nWords;
+  };
+}
+
+BitmapKernelType getBitmapKernel(){
+  return activeKernels().type;
+}
+bool bitmapKernelAvailable(BitmapKernelType which){
+  return kernelAvailable(which);
+}
+bool setBitmapKernel(BitmapKernelType which){
+  if(!kernelAvailable(which)) return false;
+  activeKernelSet=&kernelSetFor(which);
+  return true;
+}
+
+unsigned int CalcBitmapPopcount(const boost::uint64_t *bv,unsigned int nWords){
+  return activeKernels().popcount(bv,bv,nWords);
+}
+unsigned int CalcBitmapNumOnBitsInCommon(const boost::uint64_t *bv1,
+                                         const boost::uint64_t *bv2,
+                                         unsigned int nWords){
+  return activeKernels().andCount(bv1,bv2,nWords);
+}
+unsigned int CalcBitmapNumBitsDifferent(const boost::uint64_t *bv1,
+                                        const boost::uint64_t *bv2,
+                                        unsigned int nWords){
+  return activeKernels().xorCount(bv1,bv2,nWords);
+}
+bool CalcBitmapAllProbeBitsMatch(const boost::uint64_t *probe,
+                                 const boost::uint64_t *ref,
+                                 unsigned int nWords){
+  for(unsigned int i=0;i<nWords;++i){
+    if(probe[i] & ~ref[i]) return false;
+  }
+  return true;
+}
+double CalcBitmapTanimoto(const boost::uint64_t *bv1,const boost::uint64_t *bv2,
+                          unsigned int nWords){
+  const BitmapKernelSet &kernels=activeKernels();
+  unsigned int denom=kernels.orCount(bv1,bv2,nWords);
+  if(!denom) return 1.0;
+  return static_cast<double>(kernels.andCount(bv1,bv2,nWords))/denom;
+}
+double CalcBitmapTversky(const boost::uint64_t *bv1,const boost::uint64_t *bv2,
+                         unsigned int nWords,double a,double b){
+  const BitmapKernelSet &kernels=activeKernels();
+  double x=kernels.andCount(bv1,bv2,nWords);
+  double y=kernels.popcount(bv1,bv1,nWords);
+  double z=kernels.popcount(bv2,bv2,nWords);
+  double denom = a*y + b*z + (1-a-b)*x;
+  if(denom==0.0) return 1.0;
+  return x/denom;
+}
+
 int getBitId(const char *&text,int format,int size,int curr){
   PRECONDITION(text,"no text");
   int res=-1;
@@ -177,6 +532,10 @@ template bool AllProbeBitsMatch(const SparseBitVect& bv1,const SparseBitVect& bv
 //template bool AllProbeBitsMatch(const ExplicitBitVect& bv1,const ExplicitBitVect &bv2);
 
 bool AllProbeBitsMatch(const ExplicitBitVect& probe,const ExplicitBitVect &ref){
+  BitmapWords w1,w2;
+  if(probe.getNumBits()==ref.getNumBits() && w1.init(probe) && w2.init(ref)){
+    return CalcBitmapAllProbeBitsMatch(w1.words(),w2.words(),w1.size());
+  }
   return probe.dp_bits->is_subset_of(*(ref.dp_bits));
 }
 
@@ -199,6 +558,10 @@ int
 NumOnBitsInCommon(const ExplicitBitVect& bv1,
                   const ExplicitBitVect& bv2)
 {
+  BitmapWords w1,w2;
+  if(bv1.getNumBits()==bv2.getNumBits() && w1.init(bv1) && w2.init(bv2)){
+    return CalcBitmapNumOnBitsInCommon(w1.words(),w2.words(),w1.size());
+  }
   return ((*bv1.dp_bits) & (*bv2.dp_bits)).count();
 }
 
@@ -435,7 +798,8 @@ OnBitSimilarity(const T1& bv1,
     throw ValueErrorException("BitVects must be same length");
 
   double num = NumOnBitsInCommon(bv1,bv2);
-  double denom=(bv1|bv2).getNumOnBits();
+  // (bv1|bv2)_o, without building the union:
+  double denom=bv1.getNumOnBits()+bv2.getNumOnBits()-num;
 
   if(denom>0){
     return num/denom;
@@ -472,6 +836,10 @@ int
 NumBitsInCommon(const ExplicitBitVect& bv1,
                   const ExplicitBitVect& bv2)
 {
+  BitmapWords w1,w2;
+  if(bv1.getNumBits()==bv2.getNumBits() && w1.init(bv1) && w2.init(bv2)){
+    return bv1.getNumBits() - CalcBitmapNumBitsDifferent(w1.words(),w2.words(),w1.size());
+  }
   return bv1.getNumBits() - ((*bv1.dp_bits) ^ (*bv2.dp_bits)).count();
 }
 
@@ -629,7 +997,9 @@ OffBitProjSimilarity(const T1& bv1,
   if(bv1.getNumBits()!=bv2.getNumBits())
     throw ValueErrorException("BitVects must be same length");
   DoubleVect res(2,0.0);
-  double num=(bv1|bv2).getNumOffBits();
+  // (bv1|bv2)_off, without building the union:
+  double num=bv1.getNumBits()-
+    (bv1.getNumOnBits()+bv2.getNumOnBits()-NumOnBitsInCommon(bv1,bv2));
   if(num){
     res[0] = num/bv1.getNumOffBits();
     res[1] = num/bv2.getNumOffBits();
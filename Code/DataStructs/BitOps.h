@@ -22,6 +22,7 @@
 
 #include "BitVects.h"
 #include <string>
+#include <boost/cstdint.hpp>
 
 
 //! general purpose wrapper for calculating the similarity between two bvs
@@ -331,5 +332,59 @@ void
 UpdateBitVectFromBinaryText(T1& bv1,const std::string &fps);
 
 
+//! \name Bitmap kernels
+/*!
+  These work directly on arrays of 64 bit words and never allocate. They
+  are used to implement the ExplicitBitVect operations above and are
+  available for code that keeps fingerprints in its own storage.
+
+  The implementation used is picked at runtime based on what the CPU
+  supports (see getBitmapKernel()).
+*/
+//@{
+//! the available kernel implementations, slowest first
+typedef enum {
+  GENERIC_BITMAP_KERNEL=0, //!< portable C++
+  POPCNT_BITMAP_KERNEL,    //!< uses the POPCNT instruction
+  AVX2_BITMAP_KERNEL,      //!< AVX2 nibble lookup (Mula's algorithm)
+  AVX512_BITMAP_KERNEL     //!< AVX-512 VPOPCNTDQ
+} BitmapKernelType;
+
+//! returns the kernel implementation currently in use
+BitmapKernelType getBitmapKernel();
+//! returns whether or not a kernel implementation can be used on this machine
+bool bitmapKernelAvailable(BitmapKernelType which);
+//! sets the kernel implementation to use, returns false if it's not available
+/*!
+  The default is the fastest available implementation, this is mostly
+  useful for testing and benchmarking.
+
+  <b>Note:</b> this is not thread safe, it shouldn't be called while
+  other threads are using the bitmap functions.
+*/
+bool setBitmapKernel(BitmapKernelType which);
+
+//! returns the number of bits set in \c bv
+unsigned int CalcBitmapPopcount(const boost::uint64_t *bv,unsigned int nWords);
+//! returns the number of bits set in both \c bv1 and \c bv2: <tt>(bv1&bv2)_o</tt>
+unsigned int CalcBitmapNumOnBitsInCommon(const boost::uint64_t *bv1,
+                                         const boost::uint64_t *bv2,
+                                         unsigned int nWords);
+//! returns the number of bits that differ between \c bv1 and \c bv2: <tt>(bv1^bv2)_o</tt>
+unsigned int CalcBitmapNumBitsDifferent(const boost::uint64_t *bv1,
+                                        const boost::uint64_t *bv2,
+                                        unsigned int nWords);
+//! returns whether or not every bit set in \c probe is also set in \c ref
+bool CalcBitmapAllProbeBitsMatch(const boost::uint64_t *probe,
+                                 const boost::uint64_t *ref,
+                                 unsigned int nWords);
+//! returns the Tanimoto similarity between \c bv1 and \c bv2
+double CalcBitmapTanimoto(const boost::uint64_t *bv1,const boost::uint64_t *bv2,
+                          unsigned int nWords);
+//! returns the Tversky similarity between \c bv1 and \c bv2
+double CalcBitmapTversky(const boost::uint64_t *bv1,const boost::uint64_t *bv2,
+                         unsigned int nWords,double a,double b);
+//@}
+
 
 #endif
@@ -12,13 +12,54 @@
 #include <RDGeneral/Invariant.h>
 #include <RDGeneral/StreamOps.h>
 #include "DatastructsException.h"
-#include "DiscreteDistMat.h"
 #include <RDBoost/Exceptions.h>
 #include <boost/cstdint.hpp>
 
 namespace RDKit {
   const int ci_DISCRETEVALUEVECTPICKLE_VERSION=0x1;
 
+  namespace {
+    // These work on all the values packed in a 32 bit int at once
+    // ("SIMD within a register").
+
+    // the lowest bit of every lane, for lanes of 1<<i bits:
+    const boost::uint32_t laneLowBits[6]={0xFFFFFFFF,0x55555555,0x11111111,
+                                          0x01010101,0x00010001,0x00000001};
+    // the low half of every lane, for lanes of 1<<(i+1) bits:
+    const boost::uint32_t laneLowHalf[5]={0x55555555,0x33333333,0x0F0F0F0F,
+                                          0x00FF00FF,0x0000FFFF};
+
+    // returns the sum of the lanes of 1<<logBits bits in v
+    inline unsigned int sumLanes(boost::uint32_t v,unsigned int logBits){
+      for(unsigned int i=logBits;i<5;++i){
+        v = (v & laneLowHalf[i]) + ((v >> (1<<i)) & laneLowHalf[i]);
+      }
+      return v;
+    }
+
+    // returns the sum of the absolute differences of the values of
+    // 1<<logBits (at most 8) bits in v1 and v2
+    inline unsigned int sumAbsDiffs(boost::uint32_t v1,boost::uint32_t v2,
+                                    unsigned int logBits){
+      unsigned int bits=1<<logBits;
+      // work on every other value so that each one has a lane of
+      // 2*bits, the top bit of the lane keeps the subtraction in the lane:
+      boost::uint32_t lowMask=laneLowHalf[logBits];
+      boost::uint32_t topBits=laneLowBits[logBits+1]<<(2*bits-1);
+      boost::uint32_t laneMask=(1<<(2*bits))-1;
+      boost::uint32_t res=0;
+      for(unsigned int half=0;half<2;++half){
+        boost::uint32_t a=(v1>>(half*bits)) & lowMask;
+        boost::uint32_t b=(v2>>(half*bits)) & lowMask;
+        // each lane now holds a-b in two's complement:
+        boost::uint32_t d=((a|topBits)-b)^topBits;
+        boost::uint32_t neg=(d>>(2*bits-1)) & laneLowBits[logBits+1];
+        res += (d ^ (neg*laneMask)) + neg;
+      }
+      return sumLanes(res,logBits+1);
+    }
+  }
+
   DiscreteValueVect::DiscreteValueVect(const DiscreteValueVect &other) {
     d_type = other.getValueType();
     d_bitsPerVal = other.getNumBitsPerVal();
@@ -57,11 +98,12 @@ namespace RDKit {
   }
 
   unsigned int DiscreteValueVect::getTotalVal() const {
-    unsigned int i, j, res = 0;
-  
-    for (i = 0; i < d_numInts; ++i) {
-      for (j = 0; j < d_valsPerInt; ++j) {
-        res += ((d_data[i] >> (j*d_bitsPerVal)) & d_mask);
+    unsigned int res = 0;
+    unsigned int logBits = static_cast<unsigned int>(d_type);
+    const boost::uint32_t *data = d_data.get();
+    for (unsigned int i = 0; i < d_numInts; ++i) {
+      if (data[i]) {
+        res += sumLanes(data[i], logBits);
       }
     }
     return res;
@@ -91,20 +133,13 @@ namespace RDKit {
 
     unsigned int res = 0;
     if (valType <= DiscreteValueVect::EIGHTBITVALUE) {
-      DiscreteDistMat *dmat = getDiscreteDistMat();
-    
-      unsigned char *cd1 = (unsigned char *)(data1);
-      unsigned char *cd2 = (unsigned char *)(data2);
-      const unsigned char *cend = cd1 + (v1.getNumInts()*4);
-      while (cd1 != cend) {
-        if (*cd1 == *cd2) {
-          cd1++;
-          cd2++;
-          continue;
+      unsigned int logBits = static_cast<unsigned int>(valType);
+      unsigned int nInts = v1.getNumInts();
+      for (unsigned int i = 0; i < nInts; ++i) {
+        // shape grids are mostly empty, so this is worth checking:
+        if (data1[i] != data2[i]) {
+          res += sumAbsDiffs(data1[i], data2[i], logBits);
         }
-        res += dmat->getDist(*cd1, *cd2, valType);
-        cd1++;
-        cd2++;
       }
     } else {
       // we have a sixteen bits per value type
@@ -0,0 +1,497 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//  @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include "FingerprintIndex.h"
+#include "ExplicitBitVect.h"
+#include "BitOps.h"
+#include <RDGeneral/Invariant.h>
+#include <RDGeneral/StreamOps.h>
+#include <RDGeneral/BadFileException.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <fstream>
+#include <cstring>
+
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread/mutex.hpp>
+#include <boost/thread.hpp>
+#endif
+
+namespace RDKit{
+  namespace detail {
+    // words per cache line; every arena entry starts on one
+    const unsigned int fpIndexAlignWords=8;
+    // number of arena entries handed to a search thread at once
+    const unsigned int fpIndexBlockSize=1024;
+    // protects the pruning decisions from rounding in the bounds
+    const double fpIndexBoundSlack=1e-9;
+
+    // the similarity as a function of the number of bits in common (x) and
+    // the number of bits set in the database fingerprint (z). These use
+    // the same arithmetic as TanimotoSimilarity() and TverskySimilarity(),
+    // so the results are identical.
+    struct SimilarityCalc {
+      double a,b,y;
+      bool tanimoto;
+      double operator()(unsigned int ix,unsigned int iz) const {
+        double x=ix,z=iz;
+        if(tanimoto){
+          if((y+z-x)==0.0) return 1.0;
+          return x / (y+z-x);
+        }
+        double denom = a*y + b*z + (1-a-b)*x;
+        if(denom==0.0) return 1.0;
+        return x / denom;
+      }
+      // the similarity grows with x, and x can't be larger than the
+      // smaller popcount. This is the Swamidass-Baldi bound.
+      double bound(unsigned int z) const {
+        return (*this)(std::min(static_cast<unsigned int>(y),z),z);
+      }
+    };
+
+    struct SearchBlock {
+      unsigned int begin,end; // arena positions
+      unsigned int count;     // popcount of everything in the block
+      double bound;
+    };
+
+    // the ordering of the results: better similarities first, then
+    // smaller ids
+    inline bool hitBetter(const FingerprintIndex::SimilarityHit &h1,
+                          const FingerprintIndex::SimilarityHit &h2){
+      if(h1.first!=h2.first) return h1.first>h2.first;
+      return h1.second<h2.second;
+    }
+
+    // hands out blocks to the search threads. In top-k searches the blocks
+    // come in order of decreasing bound, so once a block's bound falls
+    // below the worst similarity in a full result set, the search is done.
+    class SearchBlockQueue {
+    public:
+      SearchBlockQueue(const std::vector<SearchBlock> &blocks) :
+        d_blocks(blocks), d_next(0),
+        d_cutoff(-std::numeric_limits<double>::max()) {};
+      bool getBlock(SearchBlock &block){
+#ifdef RDK_THREADSAFE_SSS
+        boost::mutex::scoped_lock lock(d_mutex);
+#endif
+        if(d_next>=d_blocks.size() ||
+           d_blocks[d_next].bound+fpIndexBoundSlack<d_cutoff){
+          d_next=d_blocks.size();
+          return false;
+        }
+        block=d_blocks[d_next++];
+        return true;
+      }
+      void raiseCutoff(double cutoff){
+#ifdef RDK_THREADSAFE_SSS
+        boost::mutex::scoped_lock lock(d_mutex);
+#endif
+        d_cutoff=std::max(d_cutoff,cutoff);
+      }
+    private:
+      const std::vector<SearchBlock> &d_blocks;
+      unsigned int d_next;
+      double d_cutoff;
+#ifdef RDK_THREADSAFE_SSS
+      boost::mutex d_mutex;
+#endif
+    };
+
+    struct SearchContext {
+      const boost::uint64_t *arena;
+      unsigned int stride,nWords;
+      const unsigned int *ids;
+      const boost::uint64_t *query;
+      SimilarityCalc calc;
+      unsigned int k;  // zero for threshold searches
+      double threshold;
+    };
+
+    void searchWorker(const SearchContext &ctx,SearchBlockQueue &queue,
+                      FingerprintIndex::HitVect &hits){
+      SearchBlock block;
+      while(queue.getBlock(block)){
+        const boost::uint64_t *fp=ctx.arena+static_cast<size_t>(block.begin)*ctx.stride;
+        for(unsigned int pos=block.begin;pos<block.end;++pos,fp+=ctx.stride){
+          unsigned int common=CalcBitmapNumOnBitsInCommon(ctx.query,fp,ctx.nWords);
+          double sim=ctx.calc(common,block.count);
+          if(sim<ctx.threshold) continue;
+          FingerprintIndex::SimilarityHit hit(sim,ctx.ids[pos]);
+          if(!ctx.k){
+            hits.push_back(hit);
+          } else if(hits.size()<ctx.k){
+            // hits is a heap with the worst result on top
+            hits.push_back(hit);
+            std::push_heap(hits.begin(),hits.end(),hitBetter);
+            if(hits.size()==ctx.k) queue.raiseCutoff(hits.front().first);
+          } else if(hitBetter(hit,hits.front())){
+            std::pop_heap(hits.begin(),hits.end(),hitBetter);
+            hits.back()=hit;
+            std::push_heap(hits.begin(),hits.end(),hitBetter);
+            queue.raiseCutoff(hits.front().first);
+          }
+        }
+      }
+    }
+
+    // The fingerprint database format. Everything is little-endian.
+    //   header (fpDbHeaderSize bytes):
+    //     char[8]  magic
+    //     uint32   format version
+    //     uint32   header size
+    //     uint32   number of bits
+    //     uint32   number of words of data in each fingerprint
+    //     uint32   words per arena entry
+    //     uint32   byte-order mark
+    //     uint64   number of fingerprints
+    //     uint64   offset of the bin table
+    //     uint64   offset of the id table
+    //     uint64   offset of the arena
+    //   bin table: uint32[numBits+2], first arena entry for each popcount
+    //   id table: uint32[numFingerprints]
+    //   arena: uint64[numFingerprints*wordsPerEntry], aligned to 64 bytes
+    const char fpDbMagic[8]={'R','D','K','F','P','D','B','\0'};
+    const boost::uint32_t fpDbVersion=1;
+    const boost::uint32_t fpDbHeaderSize=64;
+    const boost::uint32_t fpDbByteOrderMark=0x01020304;
+
+    inline boost::uint64_t alignFileOffset(boost::uint64_t offset){
+      const boost::uint64_t align=fpIndexAlignWords*sizeof(boost::uint64_t);
+      return align*((offset+align-1)/align);
+    }
+    template <typename T>
+    T readMappedValue(const char *&ptr){
+      T res;
+      memcpy(&res,ptr,sizeof(T));
+      ptr+=sizeof(T);
+      return EndianSwapBytes<LITTLE_ENDIAN_ORDER,HOST_ENDIAN_ORDER>(res);
+    }
+
+    unsigned int getNumSearchThreads(unsigned int numThreads,unsigned int nBlocks){
+#ifdef RDK_THREADSAFE_SSS
+      if(!numThreads){
+        numThreads=boost::thread::hardware_concurrency();
+      }
+#else
+      numThreads=1;
+#endif
+      numThreads=std::min(numThreads,nBlocks);
+      return std::max(numThreads,1U);
+    }
+  } // end of namespace detail
+
+  void FingerprintIndex::initSizes(unsigned int numBits){
+    d_numBits=numBits;
+    d_numWords=(numBits+63)/64;
+    d_stride=detail::fpIndexAlignWords*
+      ((d_numWords+detail::fpIndexAlignWords-1)/detail::fpIndexAlignWords);
+  }
+
+  FingerprintIndex::FingerprintIndex(unsigned int numBits) :
+    d_numEntries(0), dp_arena(0), dp_ids(0) {
+    PRECONDITION(numBits>0,"fingerprints must have at least one bit");
+    initSizes(numBits);
+    d_binStarts.resize(numBits+2,0);
+    dp_binStarts=&d_binStarts[0];
+  }
+
+  FingerprintIndex::FingerprintIndex(const std::string &fileName) :
+    d_numEntries(0), dp_arena(0), dp_ids(0), dp_binStarts(0) {
+    if(HOST_ENDIAN_ORDER!=LITTLE_ENDIAN_ORDER){
+      throw BadFileException("fingerprint databases can only be opened on little-endian machines");
+    }
+    try {
+      boost::interprocess::file_mapping mapping(fileName.c_str(),
+                                                boost::interprocess::read_only);
+      dp_mapping.reset(new boost::interprocess::mapped_region(mapping,
+                                                              boost::interprocess::read_only));
+    } catch (boost::interprocess::interprocess_exception &) {
+      throw BadFileException("could not open fingerprint database "+fileName);
+    }
+    const char *base=static_cast<const char *>(dp_mapping->get_address());
+    boost::uint64_t fileSize=dp_mapping->get_size();
+    if(fileSize<detail::fpDbHeaderSize ||
+       memcmp(base,detail::fpDbMagic,sizeof(detail::fpDbMagic))){
+      throw BadFileException(fileName+" is not a fingerprint database");
+    }
+    const char *ptr=base+sizeof(detail::fpDbMagic);
+    boost::uint32_t version=detail::readMappedValue<boost::uint32_t>(ptr);
+    if(version!=detail::fpDbVersion){
+      throw BadFileException("unsupported fingerprint database version in "+fileName);
+    }
+    boost::uint32_t headerSize=detail::readMappedValue<boost::uint32_t>(ptr);
+    boost::uint32_t numBits=detail::readMappedValue<boost::uint32_t>(ptr);
+    boost::uint32_t numWords=detail::readMappedValue<boost::uint32_t>(ptr);
+    boost::uint32_t stride=detail::readMappedValue<boost::uint32_t>(ptr);
+    boost::uint32_t byteOrderMark=detail::readMappedValue<boost::uint32_t>(ptr);
+    boost::uint64_t numEntries=detail::readMappedValue<boost::uint64_t>(ptr);
+    boost::uint64_t binOffset=detail::readMappedValue<boost::uint64_t>(ptr);
+    boost::uint64_t idOffset=detail::readMappedValue<boost::uint64_t>(ptr);
+    boost::uint64_t arenaOffset=detail::readMappedValue<boost::uint64_t>(ptr);
+
+    // make sure everything we are going to look at is actually in the file:
+    initSizes(numBits);
+    if(headerSize!=detail::fpDbHeaderSize || byteOrderMark!=detail::fpDbByteOrderMark ||
+       !numBits || numWords!=d_numWords || stride!=d_stride ||
+       numEntries>std::numeric_limits<unsigned int>::max() ||
+       binOffset+(numBits+2)*sizeof(boost::uint32_t)>fileSize ||
+       idOffset+numEntries*sizeof(boost::uint32_t)>fileSize ||
+       arenaOffset!=detail::alignFileOffset(arenaOffset) ||
+       arenaOffset+numEntries*stride*sizeof(boost::uint64_t)>fileSize ||
+       binOffset%sizeof(boost::uint32_t) || idOffset%sizeof(boost::uint32_t)){
+      throw BadFileException("corrupt fingerprint database header in "+fileName);
+    }
+    d_numEntries=static_cast<unsigned int>(numEntries);
+    dp_binStarts=reinterpret_cast<const unsigned int *>(base+binOffset);
+    dp_ids=reinterpret_cast<const unsigned int *>(base+idOffset);
+    dp_arena=reinterpret_cast<const boost::uint64_t *>(base+arenaOffset);
+    if(dp_binStarts[0]!=0 || dp_binStarts[numBits+1]!=d_numEntries){
+      throw BadFileException("corrupt fingerprint database bin table in "+fileName);
+    }
+    for(unsigned int count=0;count<=numBits;++count){
+      if(dp_binStarts[count+1]<dp_binStarts[count]){
+        throw BadFileException("corrupt fingerprint database bin table in "+fileName);
+      }
+    }
+  }
+
+  void FingerprintIndex::writeToFile(const std::string &fileName) const {
+    PRECONDITION(isFinalized(),"finalize() must be called before writing");
+    std::ofstream outStream(fileName.c_str(),std::ios_base::binary);
+    if(!outStream || outStream.bad()){
+      throw BadFileException("could not open "+fileName+" for writing");
+    }
+    boost::uint64_t binOffset=detail::fpDbHeaderSize;
+    boost::uint64_t idOffset=binOffset+(d_numBits+2)*sizeof(boost::uint32_t);
+    boost::uint64_t arenaOffset=detail::alignFileOffset(idOffset+
+                                                        d_numEntries*sizeof(boost::uint32_t));
+
+    outStream.write(detail::fpDbMagic,sizeof(detail::fpDbMagic));
+    streamWrite(outStream,detail::fpDbVersion);
+    streamWrite(outStream,detail::fpDbHeaderSize);
+    streamWrite(outStream,static_cast<boost::uint32_t>(d_numBits));
+    streamWrite(outStream,static_cast<boost::uint32_t>(d_numWords));
+    streamWrite(outStream,static_cast<boost::uint32_t>(d_stride));
+    streamWrite(outStream,detail::fpDbByteOrderMark);
+    streamWrite(outStream,static_cast<boost::uint64_t>(d_numEntries));
+    streamWrite(outStream,binOffset);
+    streamWrite(outStream,idOffset);
+    streamWrite(outStream,arenaOffset);
+    for(unsigned int count=0;count<=d_numBits+1;++count){
+      streamWrite(outStream,static_cast<boost::uint32_t>(dp_binStarts[count]));
+    }
+    for(unsigned int i=0;i<d_numEntries;++i){
+      streamWrite(outStream,static_cast<boost::uint32_t>(dp_ids[i]));
+    }
+    boost::uint64_t pos=idOffset+d_numEntries*sizeof(boost::uint32_t);
+    for(;pos<arenaOffset;++pos){
+      outStream.put(0);
+    }
+    if(HOST_ENDIAN_ORDER==LITTLE_ENDIAN_ORDER){
+      if(d_numEntries){
+        outStream.write(reinterpret_cast<const char *>(dp_arena),
+                        static_cast<std::streamsize>(d_numEntries)*d_stride*
+                        sizeof(boost::uint64_t));
+      }
+    } else {
+      for(size_t i=0;i<static_cast<size_t>(d_numEntries)*d_stride;++i){
+        streamWrite(outStream,dp_arena[i]);
+      }
+    }
+    if(!outStream){
+      throw BadFileException("error writing "+fileName);
+    }
+  }
+
+  void FingerprintIndex::getWords(const ExplicitBitVect &fp,
+                                  std::vector<boost::uint64_t> &words) const {
+    PRECONDITION(fp.getNumBits()==d_numBits,"fingerprint has the wrong size");
+    typedef boost::dynamic_bitset<>::block_type block_type;
+    const unsigned int bitsPerBlock=std::numeric_limits<block_type>::digits;
+    std::vector<block_type> blocks;
+    blocks.reserve(fp.dp_bits->num_blocks());
+    boost::to_block_range(*fp.dp_bits,std::back_inserter(blocks));
+    words.assign(d_stride,0);
+    for(unsigned int i=0;i<blocks.size();++i){
+      unsigned int bit=i*bitsPerBlock;
+      words[bit/64] |= static_cast<boost::uint64_t>(blocks[i])<<(bit%64);
+    }
+  }
+
+  unsigned int FingerprintIndex::addFingerprint(const ExplicitBitVect &fp){
+    std::vector<boost::uint64_t> words;
+    getWords(fp,words);
+    d_pending.insert(d_pending.end(),words.begin(),words.begin()+d_numWords);
+    d_pendingCounts.push_back(fp.getNumOnBits());
+    return size()-1;
+  }
+
+  void FingerprintIndex::finalize(){
+    if(isFinalized()) return;
+    unsigned int nOld=d_numEntries;
+    unsigned int nTotal=size();
+
+    // counting sort on the popcounts:
+    std::vector<unsigned int> binStarts(d_numBits+2,0);
+    for(unsigned int count=0;count<=d_numBits;++count){
+      binStarts[count+1]=dp_binStarts[count+1]-dp_binStarts[count];
+    }
+    for(unsigned int i=0;i<d_pendingCounts.size();++i){
+      ++binStarts[d_pendingCounts[i]+1];
+    }
+    for(unsigned int count=0;count<=d_numBits;++count){
+      binStarts[count+1]+=binStarts[count];
+    }
+
+    std::vector<boost::uint64_t> storage(static_cast<size_t>(nTotal)*d_stride+
+                                         detail::fpIndexAlignWords,0);
+    unsigned int misalign=(reinterpret_cast<size_t>(&storage[0])/sizeof(boost::uint64_t))%
+      detail::fpIndexAlignWords;
+    unsigned int offset=misalign ? detail::fpIndexAlignWords-misalign : 0;
+    std::vector<unsigned int> ids(nTotal);
+
+    // the entries that are already in the arena go first in each bin. They
+    // all have smaller ids than the new ones, so the ids in each bin stay
+    // sorted.
+    std::vector<unsigned int> nextPos(binStarts.begin(),binStarts.end()-1);
+    for(unsigned int count=0;count<=d_numBits;++count){
+      for(unsigned int pos=dp_binStarts[count];pos<dp_binStarts[count+1];++pos){
+        unsigned int dest=nextPos[count]++;
+        memcpy(&storage[offset+static_cast<size_t>(dest)*d_stride],getArenaEntry(pos),
+               d_numWords*sizeof(boost::uint64_t));
+        ids[dest]=dp_ids[pos];
+      }
+    }
+    for(unsigned int i=0;i<d_pendingCounts.size();++i){
+      unsigned int dest=nextPos[d_pendingCounts[i]]++;
+      memcpy(&storage[offset+static_cast<size_t>(dest)*d_stride],
+             &d_pending[static_cast<size_t>(i)*d_numWords],
+             d_numWords*sizeof(boost::uint64_t));
+      ids[dest]=nOld+i;
+    }
+
+    // an index opened from a file is now entirely in memory:
+    dp_mapping.reset();
+    d_storage.swap(storage);
+    d_ids.swap(ids);
+    d_binStarts.swap(binStarts);
+    d_numEntries=nTotal;
+    dp_arena=&d_storage[offset];
+    dp_ids=nTotal ? &d_ids[0] : 0;
+    dp_binStarts=&d_binStarts[0];
+    std::vector<boost::uint64_t>().swap(d_pending);
+    std::vector<unsigned int>().swap(d_pendingCounts);
+  }
+
+  unsigned int FingerprintIndex::search(const ExplicitBitVect &query,double a,double b,
+                                        bool tanimoto,unsigned int k,double threshold,
+                                        HitVect &hits,unsigned int numThreads) const {
+    PRECONDITION(isFinalized(),"finalize() must be called before searching");
+    RANGE_CHECK(0,a,1);
+    RANGE_CHECK(0,b,1);
+    hits.clear();
+    std::vector<boost::uint64_t> qWords;
+    getWords(query,qWords);
+
+    detail::SearchContext ctx;
+    ctx.arena=dp_arena;
+    ctx.stride=d_stride;
+    ctx.nWords=d_numWords;
+    ctx.ids=dp_ids;
+    ctx.query=&qWords[0];
+    ctx.calc.a=a;
+    ctx.calc.b=b;
+    ctx.calc.y=query.getNumOnBits();
+    ctx.calc.tanimoto=tanimoto;
+    ctx.k=k;
+    ctx.threshold=threshold;
+
+    // collect the bins that can reach the threshold. Top-k searches look
+    // at the most promising bins first.
+    std::vector< std::pair<double,unsigned int> > bins;
+    for(unsigned int count=0;count<=d_numBits;++count){
+      if(dp_binStarts[count]==dp_binStarts[count+1]) continue;
+      double bound=ctx.calc.bound(count);
+      if(bound+detail::fpIndexBoundSlack<threshold) continue;
+      bins.push_back(std::make_pair(-bound,count));
+    }
+    if(k){
+      std::sort(bins.begin(),bins.end());
+    }
+    std::vector<detail::SearchBlock> blocks;
+    for(unsigned int i=0;i<bins.size();++i){
+      unsigned int count=bins[i].second;
+      for(unsigned int pos=dp_binStarts[count];pos<dp_binStarts[count+1];
+          pos+=detail::fpIndexBlockSize){
+        detail::SearchBlock block;
+        block.begin=pos;
+        block.end=std::min(pos+detail::fpIndexBlockSize,dp_binStarts[count+1]);
+        block.count=count;
+        block.bound=-bins[i].first;
+        blocks.push_back(block);
+      }
+    }
+
+    detail::SearchBlockQueue queue(blocks);
+    numThreads=detail::getNumSearchThreads(numThreads,blocks.size());
+    if(numThreads==1){
+      detail::searchWorker(ctx,queue,hits);
+    }
+#ifdef RDK_THREADSAFE_SSS
+    else {
+      std::vector<HitVect> threadHits(numThreads);
+      boost::thread_group tg;
+      for(unsigned int i=0;i<numThreads;++i){
+        tg.add_thread(new boost::thread(detail::searchWorker,boost::cref(ctx),
+                                        boost::ref(queue),boost::ref(threadHits[i])));
+      }
+      tg.join_all();
+      for(unsigned int i=0;i<numThreads;++i){
+        hits.insert(hits.end(),threadHits[i].begin(),threadHits[i].end());
+      }
+    }
+#endif
+    std::sort(hits.begin(),hits.end(),detail::hitBetter);
+    if(k && hits.size()>k){
+      hits.resize(k);
+    }
+    return hits.size();
+  }
+
+  unsigned int FingerprintIndex::getTanimotoNeighbors(const ExplicitBitVect &query,
+                                                      double threshold,HitVect &hits,
+                                                      unsigned int numThreads) const {
+    return search(query,1.0,1.0,true,0,threshold,hits,numThreads);
+  }
+  unsigned int FingerprintIndex::getTverskyNeighbors(const ExplicitBitVect &query,
+                                                     double a,double b,double threshold,
+                                                     HitVect &hits,
+                                                     unsigned int numThreads) const {
+    return search(query,a,b,false,0,threshold,hits,numThreads);
+  }
+  unsigned int FingerprintIndex::getTanimotoTopK(const ExplicitBitVect &query,
+                                                 unsigned int k,HitVect &hits,
+                                                 double threshold,
+                                                 unsigned int numThreads) const {
+    PRECONDITION(k>0,"k must be positive");
+    return search(query,1.0,1.0,true,k,threshold,hits,numThreads);
+  }
+  unsigned int FingerprintIndex::getTverskyTopK(const ExplicitBitVect &query,
+                                                double a,double b,unsigned int k,
+                                                HitVect &hits,double threshold,
+                                                unsigned int numThreads) const {
+    PRECONDITION(k>0,"k must be positive");
+    return search(query,a,b,false,k,threshold,hits,numThreads);
+  }
+}
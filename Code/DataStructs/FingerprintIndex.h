@@ -0,0 +1,163 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//  @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+/*! \file FingerprintIndex.h
+
+  \brief Defines the \c FingerprintIndex class, an in-memory store for
+  fast similarity searching of large fingerprint collections.
+
+*/
+#ifndef __RD_FINGERPRINTINDEX_H__
+#define __RD_FINGERPRINTINDEX_H__
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+class ExplicitBitVect;
+namespace boost {
+  namespace interprocess {
+    class mapped_region;
+  }
+}
+
+namespace RDKit{
+  //! an in-memory index for similarity searching over same-length fingerprints
+  /*!
+    The fingerprints are stored in a single contiguous arena, with each
+    fingerprint starting on a cache-line boundary. The arena is sorted by
+    the number of on bits. When the index searches, it uses the
+    Swamidass-Baldi bounds to skip every popcount bin that cannot reach the
+    similarity threshold, or cannot improve the current top-k result. The
+    remaining candidates go through the kernels from BitOps.h.
+
+    Usage:
+      - create the index and add fingerprints with \c addFingerprint().
+        The index assigns ids in insertion order, starting at zero.
+      - call \c finalize() to build the searchable arena.
+      - run any number of queries. The query methods are const and can be
+        called from several threads at once. They can also spread a single
+        query across several threads.
+
+    Search results are (similarity, id) pairs. They are sorted by
+    decreasing similarity, and ties are broken by increasing id.
+
+    An index can be saved with \c writeToFile(). When it is opened again,
+    the file is memory mapped and searched in place, so opening takes
+    about the same time no matter how large the file is.
+
+    <b>Notes:</b>
+      - Fingerprints added after \c finalize() are not searched until
+        \c finalize() is called again.
+      - In the Tversky searches the query is the first argument, so \c a
+        weights the query's bits and \c b weights the database's bits.
+      - The \c numThreads arguments only have an effect if the RDKit was
+        built with thread support. A value of zero uses all available
+        cores.
+  */
+  class FingerprintIndex {
+  public:
+    typedef std::pair<double,unsigned int> SimilarityHit;
+    typedef std::vector<SimilarityHit> HitVect;
+
+    //! create an empty index for fingerprints with \c numBits bits
+    explicit FingerprintIndex(unsigned int numBits);
+    //! open an index saved with \c writeToFile()
+    /*!
+      The file is memory mapped read-only and must not be modified while
+      the index is open. Fingerprints can still be added; the next
+      \c finalize() copies the arena into memory.
+
+      Throws a \c BadFileException if the file can't be opened or is not a
+      valid fingerprint database.
+    */
+    explicit FingerprintIndex(const std::string &fileName);
+
+    //! saves the index in the binary fingerprint database format
+    /*!
+      The file holds a versioned header, the popcount bin table, the id
+      table, and the arena exactly as it is laid out in memory. All values
+      are little-endian.
+    */
+    void writeToFile(const std::string &fileName) const;
+    //! returns whether or not the arena is memory mapped from a file
+    bool isMapped() const { return static_cast<bool>(dp_mapping); };
+
+    //! adds a fingerprint and returns its id
+    unsigned int addFingerprint(const ExplicitBitVect &fp);
+    //! sorts everything added so far into the searchable arena
+    void finalize();
+    //! returns whether or not everything that was added can be searched
+    bool isFinalized() const { return d_pendingCounts.empty(); };
+
+    //! returns the number of fingerprints added
+    unsigned int size() const { return d_numEntries+d_pendingCounts.size(); };
+    //! returns the number of bits in each fingerprint
+    unsigned int getNumBits() const { return d_numBits; };
+
+    //! \name Threshold searches
+    //! find every fingerprint with a similarity at or above \c threshold
+    //@{
+    unsigned int getTanimotoNeighbors(const ExplicitBitVect &query,double threshold,
+                                      HitVect &hits,unsigned int numThreads=1) const;
+    unsigned int getTverskyNeighbors(const ExplicitBitVect &query,double a,double b,
+                                     double threshold,HitVect &hits,
+                                     unsigned int numThreads=1) const;
+    //@}
+
+    //! \name Top-k searches
+    /*!
+      find the \c k most similar fingerprints. If \c threshold is given,
+      fingerprints below it are never returned, so fewer than \c k hits can
+      come back.
+    */
+    //@{
+    unsigned int getTanimotoTopK(const ExplicitBitVect &query,unsigned int k,
+                                 HitVect &hits,double threshold=0.0,
+                                 unsigned int numThreads=1) const;
+    unsigned int getTverskyTopK(const ExplicitBitVect &query,double a,double b,
+                                unsigned int k,HitVect &hits,double threshold=0.0,
+                                unsigned int numThreads=1) const;
+    //@}
+
+  private:
+    unsigned int d_numBits;
+    unsigned int d_numWords;  // words of data in each fingerprint
+    unsigned int d_stride;    // words per fingerprint in the arena, includes padding
+    unsigned int d_numEntries;  // number of fingerprints in the arena
+    // these point either into the vectors below or into the mapped file:
+    const boost::uint64_t *dp_arena;
+    const unsigned int *dp_ids;        // ids of the arena entries
+    const unsigned int *dp_binStarts;  // first arena entry for each popcount
+    std::vector<boost::uint64_t> d_storage; // the arena lives in here
+    std::vector<unsigned int> d_ids;
+    std::vector<unsigned int> d_binStarts;
+    boost::shared_ptr<boost::interprocess::mapped_region> dp_mapping;
+    std::vector<boost::uint64_t> d_pending; // added but not yet in the arena
+    std::vector<unsigned int> d_pendingCounts;
+
+    const boost::uint64_t *getArenaEntry(unsigned int pos) const {
+      return dp_arena+static_cast<size_t>(pos)*d_stride;
+    };
+    void initSizes(unsigned int numBits);
+    void getWords(const ExplicitBitVect &fp,std::vector<boost::uint64_t> &words) const;
+    unsigned int search(const ExplicitBitVect &query,double a,double b,bool tanimoto,
+                        unsigned int k,double threshold,HitVect &hits,
+                        unsigned int numThreads) const;
+
+    // the arena pointers refer to our own storage, so copying is not
+    // supported:
+    FingerprintIndex(const FingerprintIndex &);
+    FingerprintIndex &operator=(const FingerprintIndex &);
+  };
+}
+
+#endif
@@ -19,12 +19,17 @@
 #include "base64.h"
 #include <cmath>
 #include "DiscreteValueVect.h"
+#include "FingerprintIndex.h"
 #include <RDGeneral/Invariant.h>
 #include <RDGeneral/RDLog.h>
 #include <RDBoost/Exceptions.h>
+#include <RDGeneral/BadFileException.h>
 #include <DataStructs/SparseIntVect.h>
 
 #include <stdlib.h>
+#include <ctime>
+#include <iterator>
+#include <algorithm>
 
 using namespace std;
 using namespace RDKit;
@@ -1284,7 +1289,362 @@ void test12SimilaritiesSparseBV() {
 	TEST_ASSERT(feq(AllBitSimilarity(sbv,sbv2),0.6));
 }
 
-int main(){
+namespace {
+  // a small deterministic generator so that the test data are reproducible
+  unsigned int nextRand(unsigned int &state){
+    state = state*1103515245U + 12345U;
+    return (state>>16)&0x7fff;
+  }
+  void fillRandomBV(ExplicitBitVect &bv,double density,unsigned int &state){
+    for(unsigned int i=0;i<bv.getNumBits();++i){
+      if(nextRand(state) < density*0x8000) bv.setBit(i);
+    }
+  }
+  const char *kernelNames[]={"generic","popcnt","avx2","avx512"};
+}
+
+void test13BitmapKernels() {
+  BitmapKernelType origKernel=getBitmapKernel();
+  BOOST_LOG(rdInfoLog) << "  default kernel: " << kernelNames[origKernel] << std::endl;
+  TEST_ASSERT(bitmapKernelAvailable(GENERIC_BITMAP_KERNEL));
+  TEST_ASSERT(bitmapKernelAvailable(origKernel));
+
+  unsigned int sizes[]={1,10,63,64,65,127,192,255,256,257,520,1024,2048,2050,4096,5000,0};
+  unsigned int state=42;
+  for(unsigned int kernel=GENERIC_BITMAP_KERNEL;kernel<=AVX512_BITMAP_KERNEL;++kernel){
+    BitmapKernelType which=static_cast<BitmapKernelType>(kernel);
+    if(!bitmapKernelAvailable(which)){
+      TEST_ASSERT(!setBitmapKernel(which));
+      continue;
+    }
+    TEST_ASSERT(setBitmapKernel(which));
+    TEST_ASSERT(getBitmapKernel()==which);
+    for(unsigned int si=0;sizes[si];++si){
+      for(unsigned int iter=0;iter<10;++iter){
+        ExplicitBitVect bv1(sizes[si]),bv2(sizes[si]);
+        fillRandomBV(bv1,0.3,state);
+        fillRandomBV(bv2,iter<5 ? 0.3 : 0.05,state);
+        if(iter==9) bv2=bv1;
+
+        int nCommon=0,nSame=0;
+        bool allMatch=true;
+        for(unsigned int i=0;i<sizes[si];++i){
+          if(bv1[i] && bv2[i]) ++nCommon;
+          if(bv1[i] == bv2[i]) ++nSame;
+          if(bv2[i] && !bv1[i]) allMatch=false;
+        }
+        TEST_ASSERT(NumOnBitsInCommon(bv1,bv2)==nCommon);
+        TEST_ASSERT(NumBitsInCommon(bv1,bv2)==nSame);
+        TEST_ASSERT(AllProbeBitsMatch(bv2,bv1)==allMatch);
+        double denom=bv1.getNumOnBits()+bv2.getNumOnBits()-nCommon;
+        double tani = denom ? nCommon/denom : 1.0;
+        TEST_ASSERT(feq(TanimotoSimilarity(bv1,bv2),tani));
+        TEST_ASSERT(feq(OnBitSimilarity(bv1,bv2),denom ? nCommon/denom : 0.0));
+
+        // and the raw kernels:
+        std::vector<boost::dynamic_bitset<>::block_type> blocks1,blocks2;
+        boost::to_block_range(*bv1.dp_bits,std::back_inserter(blocks1));
+        boost::to_block_range(*bv2.dp_bits,std::back_inserter(blocks2));
+        const boost::uint64_t *w1=reinterpret_cast<const boost::uint64_t *>(&blocks1[0]);
+        const boost::uint64_t *w2=reinterpret_cast<const boost::uint64_t *>(&blocks2[0]);
+        unsigned int nWords=blocks1.size();
+        if(sizeof(boost::dynamic_bitset<>::block_type)==sizeof(boost::uint64_t)){
+          TEST_ASSERT(CalcBitmapPopcount(w1,nWords)==bv1.getNumOnBits());
+          TEST_ASSERT(CalcBitmapNumOnBitsInCommon(w1,w2,nWords)==nCommon);
+          TEST_ASSERT(CalcBitmapNumBitsDifferent(w1,w2,nWords)==sizes[si]-nSame);
+          TEST_ASSERT(CalcBitmapAllProbeBitsMatch(w2,w1,nWords)==allMatch);
+          TEST_ASSERT(feq(CalcBitmapTanimoto(w1,w2,nWords),tani));
+          TEST_ASSERT(feq(CalcBitmapTversky(w1,w2,nWords,1.0,1.0),tani));
+          if(bv1.getNumOnBits()+bv2.getNumOnBits()){
+            TEST_ASSERT(feq(CalcBitmapTversky(w1,w2,nWords,0.5,0.5),
+                            DiceSimilarity(bv1,bv2)));
+          }
+        }
+      }
+    }
+  }
+  TEST_ASSERT(setBitmapKernel(origKernel));
+}
+
+void benchBitmapKernels() {
+  // not really a test: reports how quickly each of the kernels
+  // does Tanimoto similarity on 2048 bit fingerprints
+  const unsigned int nFps=1000;
+  unsigned int state=23;
+  std::vector<ExplicitBitVect> fps(nFps,ExplicitBitVect(2048));
+  for(unsigned int i=0;i<nFps;++i){
+    fillRandomBV(fps[i],0.1,state);
+  }
+  BitmapKernelType origKernel=getBitmapKernel();
+  double refSum=-1;
+  for(unsigned int kernel=GENERIC_BITMAP_KERNEL;kernel<=AVX512_BITMAP_KERNEL;++kernel){
+    BitmapKernelType which=static_cast<BitmapKernelType>(kernel);
+    if(!setBitmapKernel(which)) continue;
+    double sum=0.0;
+    std::clock_t t0=std::clock();
+    for(unsigned int i=0;i<nFps;++i){
+      for(unsigned int j=0;j<nFps;++j){
+        sum+=TanimotoSimilarity(fps[i],fps[j]);
+      }
+    }
+    double secs=static_cast<double>(std::clock()-t0)/CLOCKS_PER_SEC;
+    if(refSum<0) refSum=sum;
+    TEST_ASSERT(feq(sum,refSum));
+    BOOST_LOG(rdInfoLog) << "  " << kernelNames[kernel] << ": "
+                         << nFps*nFps << " Tanimoto similarities in "
+                         << secs << "s" << std::endl;
+  }
+  TEST_ASSERT(setBitmapKernel(origKernel));
+}
+
+namespace {
+  void bruteForceHits(const std::vector<ExplicitBitVect> &fps,const ExplicitBitVect &query,
+                      bool tanimoto,double a,double b,double threshold,
+                      RDKit::FingerprintIndex::HitVect &hits){
+    hits.clear();
+    for(unsigned int i=0;i<fps.size();++i){
+      double sim= tanimoto ? TanimotoSimilarity(query,fps[i]) :
+        TverskySimilarity(query,fps[i],a,b);
+      if(sim>=threshold) hits.push_back(std::make_pair(-sim,i));
+    }
+    std::sort(hits.begin(),hits.end());
+    for(unsigned int i=0;i<hits.size();++i) hits[i].first*=-1;
+  }
+  bool sameHits(const RDKit::FingerprintIndex::HitVect &h1,
+                const RDKit::FingerprintIndex::HitVect &h2){
+    if(h1.size()!=h2.size()) return false;
+    for(unsigned int i=0;i<h1.size();++i){
+      if(h1[i].first!=h2[i].first || h1[i].second!=h2[i].second) return false;
+    }
+    return true;
+  }
+}
+
+void test14FingerprintIndex() {
+  using RDKit::FingerprintIndex;
+  const unsigned int nBits=520;
+  unsigned int state=17;
+  std::vector<ExplicitBitVect> fps;
+  FingerprintIndex index(nBits);
+  TEST_ASSERT(index.getNumBits()==nBits);
+  TEST_ASSERT(index.size()==0);
+  TEST_ASSERT(index.isFinalized());
+  for(unsigned int i=0;i<3000;++i){
+    ExplicitBitVect fp(nBits);
+    if(i%50==7){
+      // exact duplicates produce ties
+      fp=fps[i/2];
+    } else if(i%500){
+      fillRandomBV(fp,0.02+0.3*(i%13)/13.,state);
+    }
+    fps.push_back(fp);
+    TEST_ASSERT(index.addFingerprint(fp)==i);
+    // the arena also has to merge new fingerprints into an existing one:
+    if(i==1000) index.finalize();
+  }
+  TEST_ASSERT(index.size()==fps.size());
+  TEST_ASSERT(!index.isFinalized());
+
+  FingerprintIndex::HitVect hits,refHits;
+  {
+    bool ok=false;
+    try{
+      index.getTanimotoNeighbors(fps[0],0.5,hits);
+    } catch (Invar::Invariant &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+  }
+  index.finalize();
+  TEST_ASSERT(index.isFinalized());
+  {
+    bool ok=false;
+    try{
+      index.getTanimotoNeighbors(ExplicitBitVect(nBits+1),0.5,hits);
+    } catch (Invar::Invariant &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+  }
+
+  std::vector<ExplicitBitVect> queries;
+  queries.push_back(fps[14]);
+  queries.push_back(fps[500]); // empty
+  queries.push_back(ExplicitBitVect(nBits));
+  fillRandomBV(queries.back(),0.1,state);
+  queries.push_back(ExplicitBitVect(nBits));
+  fillRandomBV(queries.back(),0.25,state);
+  double thresholds[]={0.0,0.2,0.35,0.7,1.0};
+  unsigned int ks[]={1,5,40,5000};
+  unsigned int threadCounts[]={1,3,0};
+  for(unsigned int qi=0;qi<queries.size();++qi){
+    const ExplicitBitVect &query=queries[qi];
+    for(unsigned int ti=0;ti<sizeof(thresholds)/sizeof(double);++ti){
+      double threshold=thresholds[ti];
+      bruteForceHits(fps,query,true,1,1,threshold,refHits);
+      for(unsigned int nt=0;nt<3;++nt){
+        TEST_ASSERT(index.getTanimotoNeighbors(query,threshold,hits,threadCounts[nt])==
+                    refHits.size());
+        TEST_ASSERT(sameHits(hits,refHits));
+      }
+      for(unsigned int ki=0;ki<sizeof(ks)/sizeof(unsigned int);++ki){
+        FingerprintIndex::HitVect topHits;
+        for(unsigned int i=0;i<refHits.size() && i<ks[ki];++i) topHits.push_back(refHits[i]);
+        for(unsigned int nt=0;nt<3;++nt){
+          index.getTanimotoTopK(query,ks[ki],hits,threshold,threadCounts[nt]);
+          TEST_ASSERT(sameHits(hits,topHits));
+        }
+      }
+
+      bruteForceHits(fps,query,false,0.9,0.1,threshold,refHits);
+      FingerprintIndex::HitVect topHits(refHits.begin(),
+                                        refHits.begin()+std::min(refHits.size(),
+                                                                 static_cast<size_t>(10)));
+      for(unsigned int nt=0;nt<3;++nt){
+        index.getTverskyNeighbors(query,0.9,0.1,threshold,hits,threadCounts[nt]);
+        TEST_ASSERT(sameHits(hits,refHits));
+        index.getTverskyTopK(query,0.9,0.1,10,hits,threshold,threadCounts[nt]);
+        TEST_ASSERT(sameHits(hits,topHits));
+      }
+      bruteForceHits(fps,query,false,0.2,0.7,threshold,refHits);
+      index.getTverskyNeighbors(query,0.2,0.7,threshold,hits);
+      TEST_ASSERT(sameHits(hits,refHits));
+    }
+  }
+
+  // save the index, open it again and make sure the searches still work:
+  std::string dbName="fpindex_test.fpdb";
+  index.writeToFile(dbName);
+  {
+    FingerprintIndex mapped(dbName);
+    TEST_ASSERT(mapped.isMapped());
+    TEST_ASSERT(mapped.isFinalized());
+    TEST_ASSERT(mapped.size()==index.size());
+    TEST_ASSERT(mapped.getNumBits()==nBits);
+    for(unsigned int qi=0;qi<queries.size();++qi){
+      FingerprintIndex::HitVect mappedHits;
+      index.getTanimotoNeighbors(queries[qi],0.3,hits);
+      mapped.getTanimotoNeighbors(queries[qi],0.3,mappedHits,2);
+      TEST_ASSERT(sameHits(hits,mappedHits));
+      index.getTverskyTopK(queries[qi],0.7,0.3,20,hits);
+      mapped.getTverskyTopK(queries[qi],0.7,0.3,20,mappedHits);
+      TEST_ASSERT(sameHits(hits,mappedHits));
+    }
+
+    // adding to a mapped index moves it into memory:
+    ExplicitBitVect extra(queries[3]);
+    fps.push_back(extra);
+    TEST_ASSERT(mapped.addFingerprint(extra)==fps.size()-1);
+    mapped.finalize();
+    TEST_ASSERT(!mapped.isMapped());
+    mapped.getTanimotoTopK(extra,3,hits);
+    bruteForceHits(fps,extra,true,1,1,0.0,refHits);
+    refHits.resize(3);
+    TEST_ASSERT(sameHits(hits,refHits));
+    TEST_ASSERT(hits[0].second==fps.size()-1);
+    fps.pop_back();
+
+    // and an empty index:
+    FingerprintIndex empty(64);
+    empty.writeToFile(dbName);
+    FingerprintIndex mappedEmpty(dbName);
+    TEST_ASSERT(mappedEmpty.size()==0);
+    TEST_ASSERT(mappedEmpty.getNumBits()==64);
+    TEST_ASSERT(mappedEmpty.getTanimotoTopK(ExplicitBitVect(64),3,hits)==0);
+  }
+  {
+    std::ofstream garbage(dbName.c_str());
+    garbage << "this is not a fingerprint database" << std::endl;
+    garbage.close();
+    bool ok=false;
+    try{
+      FingerprintIndex bad(dbName);
+    } catch (RDKit::BadFileException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    ok=false;
+    try{
+      FingerprintIndex bad("does_not_exist.fpdb");
+    } catch (RDKit::BadFileException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+  }
+  std::remove(dbName.c_str());
+
+  // a quick timing comparison on a larger set:
+  FingerprintIndex bigIndex(1024);
+  std::vector<ExplicitBitVect> bigFps(20000,ExplicitBitVect(1024));
+  for(unsigned int i=0;i<bigFps.size();++i){
+    fillRandomBV(bigFps[i],0.02+0.2*(i%17)/17.,state);
+    bigIndex.addFingerprint(bigFps[i]);
+  }
+  bigIndex.finalize();
+  std::clock_t t0=std::clock();
+  for(unsigned int i=0;i<100;++i){
+    bruteForceHits(bigFps,bigFps[i*7],true,1,1,0.0,refHits);
+  }
+  double bruteSecs=static_cast<double>(std::clock()-t0)/CLOCKS_PER_SEC;
+  t0=std::clock();
+  for(unsigned int i=0;i<100;++i){
+    bigIndex.getTanimotoTopK(bigFps[i*7],10,hits);
+    TEST_ASSERT(hits.size()==10);
+    TEST_ASSERT(hits[0].first==1.0);
+  }
+  double indexSecs=static_cast<double>(std::clock()-t0)/CLOCKS_PER_SEC;
+  BOOST_LOG(rdInfoLog) << "  100 queries against 20000 fps: brute force "<< bruteSecs
+                       << "s, top-10 " << indexSecs << "s" << std::endl;
+  bigIndex.writeToFile(dbName);
+  t0=std::clock();
+  {
+    FingerprintIndex mapped(dbName);
+    mapped.getTanimotoTopK(bigFps[0],10,refHits);
+  }
+  double openSecs=static_cast<double>(std::clock()-t0)/CLOCKS_PER_SEC;
+  bigIndex.getTanimotoTopK(bigFps[0],10,hits);
+  TEST_ASSERT(sameHits(hits,refHits));
+  std::remove(dbName.c_str());
+  BOOST_LOG(rdInfoLog) << "  opening the saved index and running one query: "
+                       << openSecs << "s" << std::endl;
+}
+
+void test15DiscreteVectKernels() {
+  // compare the packed implementations to doing things one value at a time:
+  std::srand(0xbead);
+  DiscreteValueVect::DiscreteValueType types[5]={DiscreteValueVect::ONEBITVALUE,
+                                                 DiscreteValueVect::TWOBITVALUE,
+                                                 DiscreteValueVect::FOURBITVALUE,
+                                                 DiscreteValueVect::EIGHTBITVALUE,
+                                                 DiscreteValueVect::SIXTEENBITVALUE};
+  for(unsigned int ti=0;ti<5;++ti){
+    for(unsigned int length=1;length<200;length+=13){
+      DiscreteValueVect v1(types[ti],length),v2(types[ti],length);
+      unsigned int maxVal=(1<<(1<<ti))-1;
+      for(unsigned int i=0;i<length;++i){
+        // leave some of the values empty, like in shape grids:
+        if(std::rand()%3) v1.setVal(i,std::rand()%(maxVal+1));
+        if(std::rand()%3) v2.setVal(i,std::rand()%(maxVal+1));
+      }
+      // make sure we hit the extreme values too:
+      v1.setVal(0,maxVal);
+      v2.setVal(0,0);
+      unsigned int tot1=0,tot2=0,dist=0;
+      for(unsigned int i=0;i<length;++i){
+        tot1+=v1[i];
+        tot2+=v2[i];
+        dist+=(v1[i]>v2[i]) ? v1[i]-v2[i] : v2[i]-v1[i];
+      }
+      TEST_ASSERT(v1.getTotalVal()==tot1);
+      TEST_ASSERT(v2.getTotalVal()==tot2);
+      TEST_ASSERT(computeL1Norm(v1,v2)==dist);
+      TEST_ASSERT(computeL1Norm(v2,v1)==dist);
+      TEST_ASSERT(computeL1Norm(v1,v1)==0);
+    }
+  }
+}
+
+int main() {
   RDLog::InitLogs();
   try{
     throw IndexErrorException(3);
@@ -1348,6 +1708,16 @@ int main(){
   BOOST_LOG(rdInfoLog) << " Test Similarity Measures SparseBitVect -------------------------------" << std::endl;
     test12SimilaritiesSparseBV();
 
+  BOOST_LOG(rdInfoLog) << " Test bitmap kernels -------------------------------" << std::endl;
+  test13BitmapKernels();
+  benchBitmapKernels();
+
+  BOOST_LOG(rdInfoLog) << " Test FingerprintIndex -------------------------------" << std::endl;
+  test14FingerprintIndex();
+
+  BOOST_LOG(rdInfoLog) << " Test DiscreteValueVect kernels -------------------------------" << std::endl;
+  test15DiscreteVectKernels();
+
   return 0;
   
 }
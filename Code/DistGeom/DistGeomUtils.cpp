@@ -28,14 +28,21 @@ namespace DistGeom {
   double pickRandomDistMat(const BoundsMatrix &mmat, 
                            RDNumeric::SymmMatrix<double> &distMat,
                            int seed) {
-    // make sure the sizes match up
-    unsigned int npt = mmat.numRows();
-    CHECK_INVARIANT(npt == distMat.numRows(), "Size mismatch");
-
     RDKit::rng_type &generator = RDKit::getRandomGenerator();
     if (seed > 0) {
       generator.seed(seed);
     }
+    RDKit::uniform_double dist(0.0,1.0);
+    RDKit::double_source_type rng(generator,dist);
+    return pickRandomDistMat(mmat,distMat,rng);
+  }
+
+  double pickRandomDistMat(const BoundsMatrix &mmat, 
+                           RDNumeric::SymmMatrix<double> &distMat,
+                           RDKit::double_source_type &rng) {
+    // make sure the sizes match up
+    unsigned int npt = mmat.numRows();
+    CHECK_INVARIANT(npt == distMat.numRows(), "Size mismatch");
 
     double largestVal=-1.0;
     double *ddata = distMat.getData();
@@ -45,7 +52,7 @@ namespace DistGeom {
         double ub = mmat.getUpperBound(i,j);
         double lb = mmat.getLowerBound(i,j);
         CHECK_INVARIANT(ub >= lb, "");
-        double rval = RDKit::getRandomVal();
+        double rval = rng();
         double d = lb + (rval)*(ub - lb);
         ddata[id+j] = d;
         if(d>largestVal){
@@ -59,6 +66,15 @@ namespace DistGeom {
   bool computeInitialCoords(const RDNumeric::SymmMatrix<double> &distMat,  
                             RDGeom::PointPtrVect &positions, bool randNegEig, 
                             unsigned int numZeroFail) {
+    RDKit::uniform_double dist(0.0,1.0);
+    RDKit::double_source_type rng(RDKit::getRandomGenerator(),dist);
+    return computeInitialCoords(distMat,positions,rng,randNegEig,numZeroFail);
+  }
+
+  bool computeInitialCoords(const RDNumeric::SymmMatrix<double> &distMat,  
+                            RDGeom::PointPtrVect &positions,
+                            RDKit::double_source_type &rng,
+                            bool randNegEig, unsigned int numZeroFail) {
     unsigned int N = distMat.numRows();
     unsigned int nPt = positions.size();
     CHECK_INVARIANT(nPt == N, "Size mismatch");
@@ -131,7 +147,7 @@ namespace DistGeom {
         if (eigData[j] >= 0.0) {
           (*pt)[j] = eigData[j]*eigVecs.getVal(j,i);
         } else {
-          (*pt)[j] = 1.0 - 2.0*RDKit::getRandomVal();
+          (*pt)[j] = 1.0 - 2.0*rng();
         }
       }
     }
@@ -139,13 +155,20 @@ namespace DistGeom {
   }
 
   bool computeRandomCoords(RDGeom::PointPtrVect &positions, double boxSize){
+    RDKit::uniform_double dist(0.0,1.0);
+    RDKit::double_source_type rng(RDKit::getRandomGenerator(),dist);
+    return computeRandomCoords(positions,boxSize,rng);
+  }
+
+  bool computeRandomCoords(RDGeom::PointPtrVect &positions, double boxSize,
+                           RDKit::double_source_type &rng){
     CHECK_INVARIANT(boxSize>0.0, "bad boxSize");
 
     for(RDGeom::PointPtrVect::iterator ptIt=positions.begin();
         ptIt!=positions.end();++ptIt){
       RDGeom::Point *pt = *ptIt;
       for (unsigned int i = 0; i<pt->dimension(); ++i) {
-        (*pt)[i]=boxSize*(RDKit::getRandomVal()-0.5);
+        (*pt)[i]=boxSize*(rng()-0.5);
       }
     }
     return true;
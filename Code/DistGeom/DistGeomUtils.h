@@ -14,6 +14,7 @@
 #include <Numerics/SymmMatrix.h>
 #include <map>
 #include <Geometry/point.h>
+#include <RDGeneral/utils.h>
 #include "ChiralSet.h"
 
 namespace ForceFields {
@@ -34,6 +35,15 @@ namespace DistGeom {
   double pickRandomDistMat(const BoundsMatrix &mmat, 
                            RDNumeric::SymmMatrix<double> &distmat, int seed=-1);
 
+  //! \overload
+  /*!
+    the random values come from \c rng instead of the global generator,
+    this is what should be used when embedding from multiple threads
+   */
+  double pickRandomDistMat(const BoundsMatrix &mmat, 
+                           RDNumeric::SymmMatrix<double> &distmat,
+                           RDKit::double_source_type &rng);
+
   //! Compute an initial embedded in 3D based on a distance matrix
   /*! 
     This function follows the embed algorithm mentioned in 
@@ -52,6 +62,15 @@ namespace DistGeom {
                             RDGeom::PointPtrVect &positions, bool randNegEig=false, 
                             unsigned int numZeroFail=2);
 
+  //! \overload
+  /*!
+    the random values for negative eigenvalues come from \c rng
+   */
+  bool computeInitialCoords(const RDNumeric::SymmMatrix<double> &distmat,  
+                            RDGeom::PointPtrVect &positions,
+                            RDKit::double_source_type &rng,
+                            bool randNegEig=false, unsigned int numZeroFail=2);
+
   //! places atoms randomly in a box
   /*! 
     \param positions     A vector of pointers to Points to write out the resulting coordinates
@@ -62,6 +81,10 @@ namespace DistGeom {
   */
   bool computeRandomCoords(RDGeom::PointPtrVect &positions, double boxSize);
 
+  //! \overload
+  bool computeRandomCoords(RDGeom::PointPtrVect &positions, double boxSize,
+                           RDKit::double_source_type &rng);
+
   //! Setup the error function for violation of distance bounds as a forcefield
   /*! 
     This is based on function E3 on page 311 of "Distance Geometry in Molecular
@@ -10,49 +10,169 @@
 //
 #include "BoundsMatrix.h"
 #include "TriangleSmooth.h"
+#include <vector>
+#include <algorithm>
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread.hpp>
+#include <boost/thread/barrier.hpp>
+#endif
 
 namespace DistGeom {
-  bool triangleSmoothBounds(BoundsMatPtr boundsMat) {
-    return triangleSmoothBounds(boundsMat.get());
-  }
-  bool triangleSmoothBounds(BoundsMatrix *boundsMat) {
-    int npt = boundsMat->numRows();
-    int i, j, k;
-    double Uik, Lik, Ukj, sumUikUkj, diffLikUjk, diffLjkUik;
-    
-    for (k = 0; k < npt; k++) {
-      for (i = 0; i < npt-1; i++) {
-        if (i == k) {
-          continue;
+  namespace {
+    // The bounds are copied into two row-major arrays that hold the upper
+    // triangles, upper[i*npt+j] and lower[i*npt+j] for i<j, so that the
+    // inner loop over j touches contiguous memory.
+    //
+    // During the step for point k nothing in row or column k changes, so
+    // the updates of the other pairs are independent of each other. The
+    // rows can be handled in any order (or at the same time) without
+    // changing the results.
+    struct SmoothData {
+      unsigned int npt;
+      double *upper;
+      double *lower;
+    };
+
+    // gathers U(k,j) and L(j,k) for all j:
+    void gatherPivot(const SmoothData &data,unsigned int k,double *Uk,double *Lk){
+      unsigned int npt=data.npt;
+      for(unsigned int j=0;j<k;++j){
+        Uk[j] = data.upper[j*npt+k];
+        Lk[j] = data.lower[j*npt+k];
+      }
+      Uk[k]=Lk[k]=0.0;
+      for(unsigned int j=k+1;j<npt;++j){
+        Uk[j] = data.upper[k*npt+j];
+        Lk[j] = data.lower[k*npt+j];
+      }
+    }
+
+    // does the step for point k on row i, returns the column of the first
+    // violation or npt if there isn't one
+    unsigned int smoothRow(const SmoothData &data,unsigned int k,unsigned int i,
+                           const double *Uk,const double *Lk){
+      unsigned int npt=data.npt;
+      double Uik=Uk[i],Lik=Lk[i];
+      double *Ui=data.upper+i*npt,*Li=data.lower+i*npt;
+      for(unsigned int j=i+1;j<npt;++j){
+        if(j==k) continue;
+        double Ukj=Uk[j];
+        double sumUikUkj = Uik + Ukj;
+        if(Ui[j] > sumUikUkj){
+          Ui[j] = sumUikUkj;
         }
-        Uik = boundsMat->getUpperBound(i,k);
-        Lik = boundsMat->getLowerBound(i,k);
-        for (j = i+1; j < npt; j++) {
-          if (j == k) {
-            continue;
-          }
-          Ukj = boundsMat->getUpperBound(k,j);
-          sumUikUkj = Uik + Ukj;
-          if (boundsMat->getUpperBound(i,j) > sumUikUkj) {
-            boundsMat->setUpperBound(i,j, sumUikUkj);
-          } 
-          
-          diffLikUjk = Lik - Ukj;
-          diffLjkUik = boundsMat->getLowerBound(j,k) - Uik;
-          if (boundsMat->getLowerBound(i,j) < diffLikUjk) {
-            boundsMat->setLowerBound(i,j, diffLikUjk);
-          } else if (boundsMat->getLowerBound(i,j) < diffLjkUik) {
-            boundsMat->setLowerBound(i,j, diffLjkUik);
+        double diffLikUjk = Lik - Ukj;
+        double diffLjkUik = Lk[j] - Uik;
+        if(Li[j] < diffLikUjk){
+          Li[j] = diffLikUjk;
+        } else if(Li[j] < diffLjkUik){
+          Li[j] = diffLjkUik;
+        }
+        if(Li[j] > Ui[j]){
+          return j;
+        }
+      }
+      return npt;
+    }
+
+#ifdef RDK_THREADSAFE_SSS
+    void smoothThread(const SmoothData *data,unsigned int threadIdx,
+                      unsigned int numThreads,boost::barrier *barrier,
+                      boost::mutex *failMutex,int *failedStep){
+      unsigned int npt=data->npt;
+      std::vector<double> Uk(npt),Lk(npt);
+      for(unsigned int k=0;k<npt;++k){
+        gatherPivot(*data,k,&Uk.front(),&Lk.front());
+        // the rows get shorter as i increases, so interleave them to
+        // balance the work:
+        for(unsigned int i=threadIdx;i<npt-1;i+=numThreads){
+          if(i==k) continue;
+          if(smoothRow(*data,k,i,&Uk.front(),&Lk.front())<npt){
+            boost::mutex::scoped_lock lock(*failMutex);
+            if(*failedStep<0) *failedStep=k;
+            break;
           }
-           
-          if (boundsMat->getLowerBound(i,j) > boundsMat->getUpperBound(i,j)) {
-            //std::cout << boundsMat->getLowerBound(i,j) << " " << boundsMat->getUpperBound(i,j) << "\n";
-            return false;
+        }
+        // nobody starts on the next step until this one is finished:
+        barrier->wait();
+        int failed;
+        {
+          boost::mutex::scoped_lock lock(*failMutex);
+          failed=*failedStep;
+        }
+        // failedStep can only have been set in this step or the next one,
+        // so all threads stop after the same step:
+        if(failed>=0 && failed<=static_cast<int>(k)) break;
+      }
+    }
+#endif
+  }
+
+  bool triangleSmoothBounds(BoundsMatPtr boundsMat,unsigned int numThreads) {
+    return triangleSmoothBounds(boundsMat.get(),numThreads);
+  }
+  bool triangleSmoothBounds(BoundsMatrix *boundsMat,unsigned int numThreads) {
+    PRECONDITION(boundsMat,"bad bounds matrix");
+    unsigned int npt = boundsMat->numRows();
+    if(npt<2) return true;
+
+    std::vector<double> upper(npt*npt,0.0),lower(npt*npt,0.0);
+    for(unsigned int i=0;i<npt-1;++i){
+      for(unsigned int j=i+1;j<npt;++j){
+        upper[i*npt+j]=boundsMat->getVal(i,j);
+        lower[i*npt+j]=boundsMat->getVal(j,i);
+      }
+    }
+    SmoothData data;
+    data.npt=npt;
+    data.upper=&upper.front();
+    data.lower=&lower.front();
+
+#ifdef RDK_THREADSAFE_SSS
+    if(!numThreads){
+      numThreads=boost::thread::hardware_concurrency();
+    }
+    // threads don't pay off for small matrices:
+    numThreads=std::min(std::max(numThreads,1U),npt/64);
+#else
+    numThreads=1;
+#endif
+
+    bool res=true;
+    if(numThreads<=1){
+      std::vector<double> Uk(npt),Lk(npt);
+      for(unsigned int k=0;k<npt && res;++k){
+        gatherPivot(data,k,&Uk.front(),&Lk.front());
+        for(unsigned int i=0;i<npt-1;++i){
+          if(i==k) continue;
+          if(smoothRow(data,k,i,&Uk.front(),&Lk.front())<npt){
+            res=false;
+            break;
           }
         }
       }
     }
-    return true;
+#ifdef RDK_THREADSAFE_SSS
+    else {
+      boost::barrier barrier(numThreads);
+      boost::mutex failMutex;
+      int failedStep=-1;
+      boost::thread_group tg;
+      for(unsigned int ti=0;ti<numThreads;++ti){
+        tg.add_thread(new boost::thread(smoothThread,&data,ti,numThreads,
+                                        &barrier,&failMutex,&failedStep));
+      }
+      tg.join_all();
+      res=(failedStep<0);
+    }
+#endif
+
+    for(unsigned int i=0;i<npt-1;++i){
+      for(unsigned int j=i+1;j<npt;++j){
+        boundsMat->setVal(i,j,upper[i*npt+j]);
+        boundsMat->setVal(j,i,lower[i*npt+j]);
+      }
+    }
+    return res;
   }
 }
- 
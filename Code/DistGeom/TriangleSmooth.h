@@ -23,11 +23,20 @@ namespace DistGeom {
     (see pages 301-302 in the above book), but that is for later
 
     \param boundsMat  A pointer to the distance bounds matrix
+    \param numThreads the number of threads to use. If this is zero, the
+                      number of hardware threads is used. Small matrices
+                      are always smoothed using a single thread.
 
+    \return false if the bounds could not be smoothed (a lower bound ended
+            up larger than the corresponding upper bound).
+
+    The smoothed bounds do not depend on the number of threads. If smoothing
+    fails with more than one thread, the matrix may have been partially
+    smoothed further than it would have been with a single thread.
   */
-  bool triangleSmoothBounds(BoundsMatrix *boundsMat);
+  bool triangleSmoothBounds(BoundsMatrix *boundsMat,unsigned int numThreads=1);
   //! \overload
-  bool triangleSmoothBounds(BoundsMatPtr boundsMat);
+  bool triangleSmoothBounds(BoundsMatPtr boundsMat,unsigned int numThreads=1);
 }
 
 #endif
@@ -18,6 +18,8 @@
 #include <Numerics/SymmMatrix.h>
 #include "DistGeomUtils.h"
 #include <RDGeneral/utils.h>
+#include <vector>
+#include <cstdlib>
 
 using namespace DistGeom;
 using namespace RDNumeric;
@@ -99,6 +101,88 @@ void testIssue216() {
     }
   }
 }
+// the textbook implementation, used as a reference:
+bool referenceTriangleSmooth(BoundsMatrix *bm){
+  unsigned int npt=bm->numRows();
+  for(unsigned int k=0;k<npt;k++){
+    for(unsigned int i=0;i<npt-1;i++){
+      if(i==k) continue;
+      double Uik=bm->getUpperBound(i,k);
+      double Lik=bm->getLowerBound(i,k);
+      for(unsigned int j=i+1;j<npt;j++){
+        if(j==k) continue;
+        double Ukj=bm->getUpperBound(k,j);
+        if(bm->getUpperBound(i,j)>Uik+Ukj){
+          bm->setUpperBound(i,j,Uik+Ukj);
+        }
+        double diffLikUjk=Lik-Ukj;
+        double diffLjkUik=bm->getLowerBound(j,k)-Uik;
+        if(bm->getLowerBound(i,j)<diffLikUjk){
+          bm->setLowerBound(i,j,diffLikUjk);
+        } else if(bm->getLowerBound(i,j)<diffLjkUik){
+          bm->setLowerBound(i,j,diffLjkUik);
+        }
+        if(bm->getLowerBound(i,j)>bm->getUpperBound(i,j)){
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void testTriangleSmoothThreads() {
+  // bounds from random points, with some pairs left open:
+  unsigned int npt=300;
+  std::srand(23);
+  std::vector<double> pts(3*npt);
+  for(unsigned int i=0;i<3*npt;++i){
+    pts[i]=20.0*std::rand()/RAND_MAX;
+  }
+  BoundsMatrix ref(npt);
+  for(unsigned int i=0;i<npt;++i){
+    for(unsigned int j=i+1;j<npt;++j){
+      if(std::rand()%4){
+        ref.setUpperBound(i,j,1000.0);
+        ref.setLowerBound(i,j,0.0);
+      } else {
+        double d=0.0;
+        for(unsigned int l=0;l<3;++l){
+          d+=(pts[3*i+l]-pts[3*j+l])*(pts[3*i+l]-pts[3*j+l]);
+        }
+        d=sqrt(d);
+        ref.setUpperBound(i,j,1.1*d);
+        ref.setLowerBound(i,j,0.9*d);
+      }
+    }
+  }
+  BoundsMatrix bm1(ref),bm4(ref),bm0(ref);
+  CHECK_INVARIANT(referenceTriangleSmooth(&ref),"");
+  CHECK_INVARIANT(triangleSmoothBounds(&bm1),"");
+  CHECK_INVARIANT(triangleSmoothBounds(&bm4,4),"");
+  CHECK_INVARIANT(triangleSmoothBounds(&bm0,0),"");
+  for(unsigned int i=0;i<npt*npt;++i){
+    CHECK_INVARIANT(bm1.getData()[i]==ref.getData()[i],"");
+    CHECK_INVARIANT(bm4.getData()[i]==ref.getData()[i],"");
+    CHECK_INVARIANT(bm0.getData()[i]==ref.getData()[i],"");
+  }
+
+  // make the bounds inconsistent, smoothing has to fail:
+  BoundsMatrix bad(bm1);
+  bad.setUpperBound(0,1,0.1);
+  bad.setLowerBound(0,1,0.0);
+  bad.setLowerBound(0,2,bm1.getUpperBound(1,2)+1.0);
+  bad.setUpperBound(0,2,bm1.getUpperBound(1,2)+2.0);
+  BoundsMatrix badRef(bad),bad4(bad);
+  CHECK_INVARIANT(!referenceTriangleSmooth(&badRef),"");
+  CHECK_INVARIANT(!triangleSmoothBounds(&bad),"");
+  CHECK_INVARIANT(!triangleSmoothBounds(&bad4,4),"");
+  // with one thread the matrix is also the same when smoothing fails:
+  for(unsigned int i=0;i<npt*npt;++i){
+    CHECK_INVARIANT(bad.getData()[i]==badRef.getData()[i],"");
+  }
+}
+
 int main() {
   std::cout << "***********************************************************\n";
   std::cout << "   test1 \n";
@@ -107,6 +191,10 @@ int main() {
   std::cout << "***********************************************************\n";
   std::cout << "   testIssue216 \n";
   testIssue216();
+
+  std::cout << "***********************************************************\n";
+  std::cout << "   testTriangleSmoothThreads \n";
+  testTriangleSmoothThreads();
   std::cout << "***********************************************************\n\n";
   return 0;
 }
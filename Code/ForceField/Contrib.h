@@ -10,8 +10,15 @@
 #ifndef __RD_FFCONTRIB_H__
 #define __RD_FFCONTRIB_H__
 
+#include <vector>
+#include <math.h>
+#include <boost/shared_ptr.hpp>
+
 namespace ForceFields {
   class ForceField;
+  class ContribBatch;
+  typedef boost::shared_ptr<ContribBatch> ContribBatchPtr;
+  typedef std::vector<ContribBatchPtr> ContribBatchPtrVect;
 
   //! abstract base class for contributions to ForceFields
   class ForceFieldContrib {
@@ -24,11 +31,100 @@ namespace ForceFields {
 
     //! calculates our contribution to the gradients of a position
     virtual void getGrad(double *pos,double *grad) const = 0;
+
+    //! returns a copy of this contribution, used when a ForceField is copied
+    /*!
+      The default returns NULL: the contribution can't be copied, and
+      neither can ForceFields that contain it.
+    */
+    virtual ForceFieldContrib *copy() const { return 0; };
+
+    //! adds our parameters to the batch for our type of contribution
+    /*!
+      \param batches   the ForceField's batches, a batch is added if
+                       there isn't one for our type yet
+      \param batchIdx  used to return the index of our batch in \c batches
+
+      \return our index in the batch, or -1 if this type of contribution
+              can't be batched (the default)
+    */
+    virtual int addToBatch(ContribBatchPtrVect &batches,unsigned int &batchIdx) const {
+      return -1;
+    };
     
   protected:
+    friend class ForceField;
     ForceField *dp_forceField;  //!< our owning ForceField
   };
 
+  //! abstract base class for groups of contributions of a single type
+  //! that are evaluated together
+  /*!
+    A batch stores the parameters of its contributions in contiguous
+    arrays and evaluates all of them in a single loop. The results for
+    each contribution are returned separately so that the ForceField
+    can add them up in the order of its contribs, this ensures that the
+    energies and gradients are identical to those obtained by calling
+    the contributions one at a time.
+
+    Batches work with 3D positions.
+  */
+  class ContribBatch {
+  public:
+    //! \param numGradPoints the number of points each contribution's gradient touches
+    ContribBatch(unsigned int numGradPoints) : d_numGradPoints(numGradPoints) {};
+    virtual ~ContribBatch() {};
+
+    //! returns the number of contributions in the batch
+    unsigned int size() const { return d_gradPoints.size()/d_numGradPoints; };
+    //! returns the number of points each contribution's gradient touches
+    unsigned int numGradPoints() const { return d_numGradPoints; };
+    //! returns the points touched by the gradients, numGradPoints() per contribution
+    const std::vector<unsigned int> &gradPoints() const { return d_gradPoints; };
+
+    //! calculates the energy of each contribution
+    /*!
+      \param pos       the positions, \c 3*numPoints long
+      \param energies  used to return the energies, should be \c size() long
+    */
+    virtual void calcEnergies(const double *pos,double *energies) const = 0;
+
+    //! calculates each contribution's terms of the gradient
+    /*!
+      \param pos    the positions, \c 3*numPoints long
+      \param terms  used to return the terms, should be
+                    \c 3*numGradPoints()*size() long and zeroed. The terms
+                    for point \c k of contribution \c i start at
+                    \c terms[3*(i*numGradPoints()+k)]
+    */
+    virtual void calcGradTerms(const double *pos,double *terms) const = 0;
+
+    //! the same calculation as ForceField::distance()
+    static double distance(const double *pos,unsigned int i,unsigned int j) {
+      double res=0.0;
+      for(unsigned int idx=0;idx<3;idx++){
+        double tmp=pos[3*i+idx]-pos[3*j+idx];
+        res += tmp*tmp;
+      }
+      return sqrt(res);
+    }
+
+  protected:
+    unsigned int d_numGradPoints;
+    std::vector<unsigned int> d_gradPoints;
+  };
+
+  //! returns the batch of type \c T in \c batches, adding it if necessary
+  template <class T>
+  T *getContribBatch(ContribBatchPtrVect &batches,unsigned int &batchIdx){
+    for(batchIdx=0;batchIdx<batches.size();++batchIdx){
+      T *res=dynamic_cast<T *>(batches[batchIdx].get());
+      if(res) return res;
+    }
+    T *res=new T();
+    batches.push_back(ContribBatchPtr(res));
+    return res;
+  }
 }
 
 #endif
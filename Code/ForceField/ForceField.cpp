@@ -12,7 +12,10 @@
 #include "Contrib.h"
 
 #include <RDGeneral/Invariant.h>
+#include <RDBoost/Exceptions.h>
 #include <Numerics/Optimizer/BFGSOpt.h>
+#include <Numerics/Optimizer/LBFGSOpt.h>
+#include <algorithm>
 
 namespace ForceFieldsHelper {
   class calcEnergy {
@@ -69,6 +72,22 @@ namespace ForceFieldsHelper {
 }
 
 namespace ForceFields {
+  ForceField::ForceField(const ForceField &other) :
+    d_dimension(other.d_dimension), df_init(false), d_numPoints(0), dp_distMat(0),
+    d_positions(other.d_positions), d_fixedPoints(other.d_fixedPoints), d_matSize(0),
+    d_minimizer(other.d_minimizer) {
+    d_contribs.reserve(other.d_contribs.size());
+    for(ContribPtrVect::const_iterator contrib=other.d_contribs.begin();
+        contrib != other.d_contribs.end();contrib++){
+      ForceFieldContrib *ncontrib=(*contrib)->copy();
+      if(!ncontrib){
+        throw ValueErrorException("ForceField contains a contribution that can't be copied");
+      }
+      ncontrib->dp_forceField=this;
+      d_contribs.push_back(ContribPtr(ncontrib));
+    }
+  }
+
   ForceField::~ForceField(){
     d_numPoints=0;
     d_positions.clear();
@@ -88,6 +107,11 @@ namespace ForceFields {
     }
     unsigned int idx=i+j*(j+1)/2;
     CHECK_INVARIANT(idx<d_matSize,"Bad index");
+    if(!dp_distMat){
+      // the matrix is only allocated if some contrib actually uses it:
+      dp_distMat = new double[d_matSize];
+      std::fill(dp_distMat,dp_distMat+d_matSize,-1.0);
+    }
     double &res=dp_distMat[idx];
     if(res<0.0){
       // we need to calculate this distance:
@@ -106,6 +130,7 @@ namespace ForceFields {
       }
       res = sqrt(res);
       dp_distMat[idx]=res;
+      d_distMatSetIdxs.push_back(idx);
     }
     return res;
   }
@@ -145,11 +170,44 @@ namespace ForceFields {
     
     d_numPoints = d_positions.size();
     d_matSize=d_numPoints*(d_numPoints+1)/2;
-    dp_distMat = new double[d_matSize];
+    d_distMatSetIdxs.clear();
     this->initDistanceMatrix();
+    this->initBatches();
     df_init=true;
   }
 
+  void ForceField::initBatches(){
+    d_batches.clear();
+    d_batchPositions.clear();
+    d_batchEnergyOffsets.clear();
+    d_batchGradOffsets.clear();
+    // the batches all work in 3D:
+    if(d_dimension!=3) return;
+
+    d_batchPositions.reserve(d_contribs.size());
+    for(ContribPtrVect::const_iterator contrib=d_contribs.begin();
+        contrib != d_contribs.end();contrib++){
+      unsigned int batchIdx=0;
+      int idx=(*contrib)->addToBatch(d_batches,batchIdx);
+      if(idx<0){
+        d_batchPositions.push_back(std::make_pair(-1,0));
+      } else {
+        d_batchPositions.push_back(std::make_pair(static_cast<int>(batchIdx),
+                                                  static_cast<unsigned int>(idx)));
+      }
+    }
+    unsigned int nEnergies=0,nGradTerms=0;
+    for(ContribBatchPtrVect::const_iterator batch=d_batches.begin();
+        batch!=d_batches.end();++batch){
+      d_batchEnergyOffsets.push_back(nEnergies);
+      d_batchGradOffsets.push_back(nGradTerms);
+      nEnergies += (*batch)->size();
+      nGradTerms += 3*(*batch)->numGradPoints()*(*batch)->size();
+    }
+    d_batchEnergies.resize(nEnergies);
+    d_batchGradTerms.resize(nGradTerms);
+  }
+
   int ForceField::minimize(unsigned int maxIts,double forceTol,double energyTol){
     PRECONDITION(df_init,"not initialized");
     PRECONDITION(static_cast<unsigned int>(d_numPoints)==d_positions.size(),"size mismatch");
@@ -164,9 +222,16 @@ namespace ForceFields {
     ForceFieldsHelper::calcEnergy eCalc(this);
     ForceFieldsHelper::calcGradient gCalc(this);
     
-    int res = BFGSOpt::minimize(dim,points,forceTol,numIters,finalForce,
-                                eCalc,gCalc,
-                                energyTol,maxIts);
+    int res;
+    if(d_minimizer==LBFGS){
+      res = LBFGSOpt::minimize(dim,points,forceTol,numIters,finalForce,
+                               eCalc,gCalc,
+                               energyTol,maxIts);
+    } else {
+      res = BFGSOpt::minimize(dim,points,forceTol,numIters,finalForce,
+                              eCalc,gCalc,
+                              energyTol,maxIts);
+    }
     this->gather(points);
 
     delete [] points;
@@ -198,10 +263,28 @@ namespace ForceFields {
     this->initDistanceMatrix();
     if(d_contribs.empty()) return res;
 
-    // now loop over the contribs
-    for(ContribPtrVect::const_iterator contrib=d_contribs.begin();
-        contrib != d_contribs.end();contrib++){
-      double E=(*contrib)->getEnergy(pos);
+    if(!this->useBatches()){
+      // now loop over the contribs
+      for(ContribPtrVect::const_iterator contrib=d_contribs.begin();
+          contrib != d_contribs.end();contrib++){
+        double E=(*contrib)->getEnergy(pos);
+        res += E;
+      }
+      return res;
+    }
+
+    for(unsigned int bi=0;bi<d_batches.size();++bi){
+      d_batches[bi]->calcEnergies(pos,&d_batchEnergies[d_batchEnergyOffsets[bi]]);
+    }
+    // add everything up in the same order as above:
+    for(unsigned int ci=0;ci<d_contribs.size();++ci){
+      const std::pair<int,unsigned int> &bpos=d_batchPositions[ci];
+      double E;
+      if(bpos.first<0){
+        E=d_contribs[ci]->getEnergy(pos);
+      } else {
+        E=d_batchEnergies[d_batchEnergyOffsets[bpos.first]+bpos.second];
+      }
       res += E;
     }
     return res;
@@ -236,9 +319,35 @@ namespace ForceFields {
     PRECONDITION(grad,"bad gradient vector");
     if(d_contribs.empty()) return;
 
-    for(ContribPtrVect::const_iterator contrib=d_contribs.begin();
-        contrib != d_contribs.end();contrib++){
-      (*contrib)->getGrad(pos,grad);
+    if(!this->useBatches()){
+      for(ContribPtrVect::const_iterator contrib=d_contribs.begin();
+          contrib != d_contribs.end();contrib++){
+        (*contrib)->getGrad(pos,grad);
+      }
+    } else {
+      std::fill(d_batchGradTerms.begin(),d_batchGradTerms.end(),0.0);
+      for(unsigned int bi=0;bi<d_batches.size();++bi){
+        d_batches[bi]->calcGradTerms(pos,&d_batchGradTerms[d_batchGradOffsets[bi]]);
+      }
+      // accumulate in contrib order so that the sums are the same as above:
+      for(unsigned int ci=0;ci<d_contribs.size();++ci){
+        const std::pair<int,unsigned int> &bpos=d_batchPositions[ci];
+        if(bpos.first<0){
+          d_contribs[ci]->getGrad(pos,grad);
+          continue;
+        }
+        const ContribBatch *batch=d_batches[bpos.first].get();
+        unsigned int nPts=batch->numGradPoints();
+        const unsigned int *pts=&(batch->gradPoints()[bpos.second*nPts]);
+        const double *terms=&d_batchGradTerms[d_batchGradOffsets[bpos.first]+
+                                              3*bpos.second*nPts];
+        for(unsigned int pi=0;pi<nPts;++pi){
+          double *g=&grad[3*pts[pi]];
+          g[0] += terms[3*pi];
+          g[1] += terms[3*pi+1];
+          g[2] += terms[3*pi+2];
+        }
+      }
     }
 
     for(INT_VECT::const_iterator it=d_fixedPoints.begin();
@@ -281,11 +390,16 @@ namespace ForceFields {
 
   void ForceField::initDistanceMatrix(){
     PRECONDITION(d_numPoints,"no points");
-    PRECONDITION(dp_distMat,"no distance matrix");
     PRECONDITION(static_cast<unsigned int>(d_numPoints*(d_numPoints+1)/2)<=d_matSize,"matrix size mismatch");
-    for(unsigned int i=0;i<d_numPoints*(d_numPoints+1)/2;i++){
-      dp_distMat[i]=-1.0;
+    if(!dp_distMat) return;
+    // only the distances that were calculated need to be cleared, this
+    // keeps the cost proportional to the number of terms rather than
+    // the number of pairs of points:
+    for(std::vector<unsigned int>::const_iterator it=d_distMatSetIdxs.begin();
+        it!=d_distMatSetIdxs.end();++it){
+      dp_distMat[*it]=-1.0;
     }
+    d_distMatSetIdxs.clear();
   }
   
 
@@ -16,9 +16,12 @@
 
 namespace ForceFields {
   class ForceFieldContrib;
+  class ContribBatch;
   typedef std::vector<int> INT_VECT;
   typedef boost::shared_ptr<ForceFieldContrib> ContribPtr;
   typedef std::vector<ContribPtr> ContribPtrVect;
+  typedef boost::shared_ptr<ContribBatch> ContribBatchPtr;
+  typedef std::vector<ContribBatchPtr> ContribBatchPtrVect;
   
   //-------------------------------------------------------
   //! A class to store forcefields and handle minimization
@@ -50,13 +53,37 @@ namespace ForceFields {
        - Distance calculations are currently lazy; the full distance matrix is
          never generated.  In systems where the distance matrix is not sparse,
          this is almost certainly inefficient.
+       - Contributions that support it (see ForceFieldContrib::addToBatch())
+         are grouped by type in initialize() and evaluated in batches by
+         calcEnergy(double *) and calcGrad(double *,double *), which
+         are what the minimizer uses. The results are identical to those
+         obtained by evaluating the contributions one at a time.
 
   */
   class ForceField {
   public:
+    //! the minimizers that minimize() can use
+    typedef enum {
+      BFGS=0,  //!< BFGS with a full inverse hessian (the default)
+      LBFGS    //!< limited-memory BFGS, this scales much better to large systems
+    } MinimizerType;
+
     //! construct with a dimension
     ForceField(unsigned int dimension=3) : d_dimension(dimension), df_init(false),
-                                           d_numPoints(0), dp_distMat(0) {};
+                                           d_numPoints(0), dp_distMat(0),
+                                           d_minimizer(BFGS) {};
+
+    //! copy constructor
+    /*!
+      The contributions are copied, the positions are not: the copy
+      points at the same positions as \c other. Typically the positions
+      are replaced before the copy is used. The copy needs to be
+      initialized.
+
+      A ValueErrorException is thrown if one of the contributions
+      can't be copied.
+    */
+    ForceField(const ForceField &other);
 
     ~ForceField();
 
@@ -122,9 +149,18 @@ namespace ForceFields {
               criteria were achieved:
         - 0: indicates success
         - 1: the minimization did not converge in \c maxIts iterations.
+
+      The minimizer used is set with setMinimizer(). BFGS needs memory
+      and time per iteration proportional to the square of the number
+      of points, so LBFGS should be used for large systems.
     */
     int minimize(unsigned int maxIts=200,double forceTol=1e-4,double energyTol=1e-6);
 
+    //! sets the minimizer used by minimize()
+    void setMinimizer(MinimizerType which) { d_minimizer=which; };
+    //! returns the minimizer used by minimize()
+    MinimizerType getMinimizer() const { return d_minimizer; };
+
     // ---------------------------
     // setters and getters
 
@@ -182,11 +218,13 @@ namespace ForceFields {
     unsigned int d_dimension;
     bool df_init;              //!< whether or not we've been initialized
     unsigned int d_numPoints;  //!< the number of active points
-    double *dp_distMat;        //!< our internal distance matrix
+    double *dp_distMat;        //!< our internal distance matrix, allocated when first used
     RDGeom::PointPtrVect d_positions;  //!< pointers to the points we're using
     ContribPtrVect d_contribs; //!< contributions to the energy
     INT_VECT d_fixedPoints;
     unsigned int d_matSize;
+    std::vector<unsigned int> d_distMatSetIdxs; //!< the entries of dp_distMat that are set
+    MinimizerType d_minimizer;
     //! scatter our positions into an array
     /*!
         \param pos     should be \c 3*this->numPoints() long;
@@ -201,6 +239,24 @@ namespace ForceFields {
 
     //! initializes our internal distance matrix
     void initDistanceMatrix();
+
+    // the batched contributions:
+    ContribBatchPtrVect d_batches;
+    //! for each of our contribs: the index of its batch (-1 if it's not
+    //! batched) and its index in the batch
+    std::vector< std::pair<int,unsigned int> > d_batchPositions;
+    std::vector<unsigned int> d_batchEnergyOffsets,d_batchGradOffsets;
+    std::vector<double> d_batchEnergies,d_batchGradTerms;
+
+    //! sorts our contribs into batches
+    void initBatches();
+    //! returns whether or not the batches can be used
+    bool useBatches() const {
+      return !d_batches.empty() && d_batchPositions.size()==d_contribs.size();
+    };
+
+  private:
+    ForceField &operator=(const ForceField &); // disable assignment
   };
 }
 #endif
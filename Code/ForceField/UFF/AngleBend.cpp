@@ -69,169 +69,216 @@ namespace ForceFields {
 	this->d_C2 = 1./(4.*std::max(sinTheta0*sinTheta0,1e-8));
 	this->d_C1 = -4.*this->d_C2*cosTheta0;
 	this->d_C0 = this->d_C2*(2.*cosTheta0*cosTheta0 + 1.);
+      } else {
+	this->d_C0 = this->d_C1 = this->d_C2 = 0.0;
       }
     }
 
-    double AngleBendContrib::getEnergy(double *pos) const {
-      PRECONDITION(dp_forceField,"no owner");
-      PRECONDITION(pos,"bad vector");
+    namespace {
+      // these are shared by the contribs and the batches so that they
+      // give identical results:
+      inline double angleEnergyTerm(unsigned int order,double C0,double C1,double C2,
+                                    double cosTheta,double sinThetaSq){
+	// cos(2x) = cos^2(x) - sin^2(x);
+	double cos2Theta = cosTheta*cosTheta - sinThetaSq;
 
-      double dist1=this->dp_forceField->distance(this->d_at1Idx,this->d_at2Idx,pos);
-      double dist2=this->dp_forceField->distance(this->d_at2Idx,this->d_at3Idx,pos);
+	double res=0.0;
+	if(order==0){
+	  res=C0 + C1*cosTheta + C2*cos2Theta;
+	} else {
+	  switch(order){
+	  case 1:
+	    res=cosTheta;
+	    break;
+	  case 2:
+	    res=cos2Theta;
+	    break;
+	  case 3:
+	    // cos(3x) = cos^3(x) - 3*cos(x)*sin^2(x)
+	    res = cosTheta*(cosTheta*cosTheta-3*sinThetaSq);
+	    break;
+	  case 4:
+	    // cos(4x) = cos^4(x) - 6*cos^2(x)*sin^2(x)+sin^4(x)
+	    res = int_pow<4>(cosTheta) - 6*cosTheta*cosTheta*sinThetaSq + sinThetaSq*sinThetaSq;
+	    break;
+	  }
+	  res = 1-res;
+	  res /= (order*order);
+	}
+	return res;
+      }
+
+      inline double angleThetaDeriv(unsigned int order,double forceConstant,
+                                    double C1,double C2,
+                                    double cosTheta,double sinTheta){
+	double dE_dTheta=0.0;
+	double sin2Theta = 2*sinTheta*cosTheta;
+
+	if(order==0){
+	  dE_dTheta =  -1*forceConstant*(C1*sinTheta + 2.*C2*sin2Theta);
+	} else {
+	  // E = k/n^2 [1-cos(n theta)]
+	  // dE = - k/n^2 * d cos(n theta)
 
-      RDGeom::Point3D p1(pos[3*this->d_at1Idx],
-			 pos[3*this->d_at1Idx+1],
-			 pos[3*this->d_at1Idx+2]);
-      RDGeom::Point3D p2(pos[3*this->d_at2Idx],
-			 pos[3*this->d_at2Idx+1],
-			 pos[3*this->d_at2Idx+2]);
-      RDGeom::Point3D p3(pos[3*this->d_at3Idx],
-			 pos[3*this->d_at3Idx+1],
-			 pos[3*this->d_at3Idx+2]);
-      RDGeom::Point3D p12=p1-p2;
-      RDGeom::Point3D p32=p3-p2;
-      double cosTheta = p12.dotProduct(p32)/(dist1*dist2);
-      // we need sin^2(theta) to get cos(2*theta), so compute that:
-      double sinThetaSq = 1-cosTheta*cosTheta;
+	  // these all use:
+	  // d cos(ax) = -a sin(ax)
+      
+	  switch(order){
+	  case 1:
+	    dE_dTheta = sinTheta;
+	    break;
+	  case 2:
+	    // sin(2*x) = 2*cos(x)*sin(x)
+	    dE_dTheta = sin2Theta;
+	    break;
+	  case 3:
+	    // sin(3*x) = 3*sin(x) - 4*sin^3(x)
+	    dE_dTheta = sinTheta*(3-4*sinTheta*sinTheta);
+	    break;
+	  case 4:
+	    // sin(4*x) = cos(x)*(4*sin(x) - 8*sin^3(x))
+	    dE_dTheta = cosTheta*sinTheta*(4-8*sinTheta*sinTheta);
+	    break;
+	  }
+	  dE_dTheta *= forceConstant/order;
+	}
+	return dE_dTheta;
+      }
+
+      inline double angleEnergy(const double *pos1,const double *pos2,const double *pos3,
+                                double dist1,double dist2,unsigned int order,
+                                double forceConstant,double C0,double C1,double C2){
+	RDGeom::Point3D p1(pos1[0],pos1[1],pos1[2]);
+	RDGeom::Point3D p2(pos2[0],pos2[1],pos2[2]);
+	RDGeom::Point3D p3(pos3[0],pos3[1],pos3[2]);
+	RDGeom::Point3D p12=p1-p2;
+	RDGeom::Point3D p32=p3-p2;
+	double cosTheta = p12.dotProduct(p32)/(dist1*dist2);
+	// we need sin^2(theta) to get cos(2*theta), so compute that:
+	double sinThetaSq = 1-cosTheta*cosTheta;
     
-      double angleTerm = this->getEnergyTerm(cosTheta,sinThetaSq);
-      double res = this->d_forceConstant*angleTerm;
+	double angleTerm = angleEnergyTerm(order,C0,C1,C2,cosTheta,sinThetaSq);
+	return forceConstant*angleTerm;
+      }
 
-      return res;
-    }
+      inline void angleGrad(const double *pos1,const double *pos2,const double *pos3,
+                            double dist1,double dist2,unsigned int order,
+                            double forceConstant,double C1,double C2,
+                            double *g1,double *g2,double *g3){
+	RDGeom::Point3D p1(pos1[0],pos1[1],pos1[2]);
+	RDGeom::Point3D p2(pos2[0],pos2[1],pos2[2]);
+	RDGeom::Point3D p3(pos3[0],pos3[1],pos3[2]);
 
-    void AngleBendContrib::getGrad(double *pos,double *grad) const {
-      PRECONDITION(dp_forceField,"no owner");
-      PRECONDITION(pos,"bad vector");
-      PRECONDITION(grad,"bad vector");
+	RDGeom::Point3D p12=p1-p2;
+	RDGeom::Point3D p32=p3-p2;
+	double cosTheta = p12.dotProduct(p32)/(dist1*dist2);
+	double sinTheta = std::max(sqrt(1.0-cosTheta*cosTheta),1e-8);
 
-      double dist1=this->dp_forceField->distance(this->d_at1Idx,this->d_at2Idx,pos);
-      double dist2=this->dp_forceField->distance(this->d_at2Idx,this->d_at3Idx,pos);
+	// use the chain rule:
+	// dE/dx = dE/dTheta * dTheta/dx
 
-      //std::cout << "\tAngle("<<this->d_at1Idx<<","<<this->d_at2Idx<<","<<this->d_at3Idx<<") " << dist1 << " " << dist2 << std::endl;
-      
-      RDGeom::Point3D p1(pos[3*this->d_at1Idx],
-			 pos[3*this->d_at1Idx+1],
-			 pos[3*this->d_at1Idx+2]);
-      RDGeom::Point3D p2(pos[3*this->d_at2Idx],
-			 pos[3*this->d_at2Idx+1],
-			 pos[3*this->d_at2Idx+2]);
-      RDGeom::Point3D p3(pos[3*this->d_at3Idx],
-			 pos[3*this->d_at3Idx+1],
-			 pos[3*this->d_at3Idx+2]);
-      double *g1=&(grad[3*this->d_at1Idx]);
-      double *g2=&(grad[3*this->d_at2Idx]);
-      double *g3=&(grad[3*this->d_at3Idx]);
-
-      RDGeom::Point3D p12=p1-p2;
-      RDGeom::Point3D p32=p3-p2;
-      double cosTheta = p12.dotProduct(p32)/(dist1*dist2);
-      double sinTheta = std::max(sqrt(1.0-cosTheta*cosTheta),1e-8);
-
-      //std::cerr << "GRAD: " << cosTheta << " (" << acos(cosTheta)<< "), ";
-      //std::cerr << sinTheta << " (" << asin(sinTheta)<< ")" << std::endl;
+	// dE/dTheta is independent of cartesians:
+	double dE_dTheta=angleThetaDeriv(order,forceConstant,C1,C2,cosTheta,sinTheta);
     
-      // use the chain rule:
-      // dE/dx = dE/dTheta * dTheta/dx
+	// -------
+	// dTheta/dx is trickier:
+	double dCos_dS1=1./dist1 * (p32.x/dist2 - cosTheta*p12.x/dist1);
+	double dCos_dS2=1./dist1 * (p32.y/dist2 - cosTheta*p12.y/dist1);
+	double dCos_dS3=1./dist1 * (p32.z/dist2 - cosTheta*p12.z/dist1);
 
-      // dE/dTheta is independent of cartesians:
-      double dE_dTheta=getThetaDeriv(cosTheta,sinTheta);
-    
-      // -------
-      // dTheta/dx is trickier:
-      double dCos_dS1=1./dist1 * (p32.x/dist2 - cosTheta*p12.x/dist1);
-      double dCos_dS2=1./dist1 * (p32.y/dist2 - cosTheta*p12.y/dist1);
-      double dCos_dS3=1./dist1 * (p32.z/dist2 - cosTheta*p12.z/dist1);
+	double dCos_dS4=1./dist2 * (p12.x/dist1 - cosTheta*p32.x/dist2);
+	double dCos_dS5=1./dist2 * (p12.y/dist1 - cosTheta*p32.y/dist2);
+	double dCos_dS6=1./dist2 * (p12.z/dist1 - cosTheta*p32.z/dist2);
 
-      double dCos_dS4=1./dist2 * (p12.x/dist1 - cosTheta*p32.x/dist2);
-      double dCos_dS5=1./dist2 * (p12.y/dist1 - cosTheta*p32.y/dist2);
-      double dCos_dS6=1./dist2 * (p12.z/dist1 - cosTheta*p32.z/dist2);
+	g1[0] += dE_dTheta*dCos_dS1/(-sinTheta);
+	g1[1] += dE_dTheta*dCos_dS2/(-sinTheta);
+	g1[2] += dE_dTheta*dCos_dS3/(-sinTheta);
 
+	g2[0] += dE_dTheta*(-dCos_dS1 - dCos_dS4)/(-sinTheta);
+	g2[1] += dE_dTheta*(-dCos_dS2 - dCos_dS5)/(-sinTheta);
+	g2[2] += dE_dTheta*(-dCos_dS3 - dCos_dS6)/(-sinTheta);
     
-      g1[0] += dE_dTheta*dCos_dS1/(-sinTheta);
-      g1[1] += dE_dTheta*dCos_dS2/(-sinTheta);
-      g1[2] += dE_dTheta*dCos_dS3/(-sinTheta);
+	g3[0] += dE_dTheta*dCos_dS4/(-sinTheta);
+	g3[1] += dE_dTheta*dCos_dS5/(-sinTheta);
+	g3[2] += dE_dTheta*dCos_dS6/(-sinTheta);
+      }
+    }
 
-      g2[0] += dE_dTheta*(-dCos_dS1 - dCos_dS4)/(-sinTheta);
-      g2[1] += dE_dTheta*(-dCos_dS2 - dCos_dS5)/(-sinTheta);
-      g2[2] += dE_dTheta*(-dCos_dS3 - dCos_dS6)/(-sinTheta);
-    
-      g3[0] += dE_dTheta*dCos_dS4/(-sinTheta);
-      g3[1] += dE_dTheta*dCos_dS5/(-sinTheta);
-      g3[2] += dE_dTheta*dCos_dS6/(-sinTheta);
+    double AngleBendContrib::getEnergy(double *pos) const {
+      PRECONDITION(dp_forceField,"no owner");
+      PRECONDITION(pos,"bad vector");
+      PRECONDITION(this->d_order==0||this->d_order==1||this->d_order==2||this->d_order==3||this->d_order==4,"bad order");
 
-    }
+      double dist1=this->dp_forceField->distance(this->d_at1Idx,this->d_at2Idx,pos);
+      double dist2=this->dp_forceField->distance(this->d_at2Idx,this->d_at3Idx,pos);
 
+      return angleEnergy(&pos[3*this->d_at1Idx],&pos[3*this->d_at2Idx],
+                         &pos[3*this->d_at3Idx],dist1,dist2,this->d_order,
+                         this->d_forceConstant,this->d_C0,this->d_C1,this->d_C2);
+    }
 
-    double AngleBendContrib::getEnergyTerm(double cosTheta,double sinThetaSq) const {
+    void AngleBendContrib::getGrad(double *pos,double *grad) const {
+      PRECONDITION(dp_forceField,"no owner");
+      PRECONDITION(pos,"bad vector");
+      PRECONDITION(grad,"bad vector");
       PRECONDITION(this->d_order==0||this->d_order==1||this->d_order==2||this->d_order==3||this->d_order==4,"bad order");
-      // cos(2x) = cos^2(x) - sin^2(x);
-      double cos2Theta = cosTheta*cosTheta - sinThetaSq;
 
-      double res=0.0;
-      if(this->d_order==0){
-	res=this->d_C0 + this->d_C1*cosTheta + this->d_C2*cos2Theta;
-      } else {
-	switch(this->d_order){
-	case 1:
-	  res=cosTheta;
-	  break;
-	case 2:
-	  res=cos2Theta;
-	  break;
-	case 3:
-	  // cos(3x) = cos^3(x) - 3*cos(x)*sin^2(x)
-	  res = cosTheta*(cosTheta*cosTheta-3*sinThetaSq);
-	  break;
-	case 4:
-	  // cos(4x) = cos^4(x) - 6*cos^2(x)*sin^2(x)+sin^4(x)
-	  res = int_pow<4>(cosTheta) - 6*cosTheta*cosTheta*sinThetaSq + sinThetaSq*sinThetaSq;
-	  break;
-	}
-	res = 1-res;
-	res /= (this->d_order*this->d_order);
-      }
-      return res;
+      double dist1=this->dp_forceField->distance(this->d_at1Idx,this->d_at2Idx,pos);
+      double dist2=this->dp_forceField->distance(this->d_at2Idx,this->d_at3Idx,pos);
+
+      angleGrad(&pos[3*this->d_at1Idx],&pos[3*this->d_at2Idx],&pos[3*this->d_at3Idx],
+                dist1,dist2,this->d_order,this->d_forceConstant,this->d_C1,this->d_C2,
+                &grad[3*this->d_at1Idx],&grad[3*this->d_at2Idx],&grad[3*this->d_at3Idx]);
     }
 
 
-  
-    double AngleBendContrib::getThetaDeriv(double cosTheta,double sinTheta) const {
+    int AngleBendContrib::addToBatch(ContribBatchPtrVect &batches,
+                                     unsigned int &batchIdx) const {
       PRECONDITION(this->d_order==0||this->d_order==1||this->d_order==2||this->d_order==3||this->d_order==4,"bad order");
+      AngleBendBatch *batch=getContribBatch<AngleBendBatch>(batches,batchIdx);
+      return batch->addContrib(d_at1Idx,d_at2Idx,d_at3Idx,d_order,d_forceConstant,
+                               d_C0,d_C1,d_C2);
+    }
 
-      double dE_dTheta=0.0;
-      double sin2Theta = 2*sinTheta*cosTheta;
+    unsigned int AngleBendBatch::addContrib(unsigned int idx1,unsigned int idx2,
+                                            unsigned int idx3,unsigned int order,
+                                            double forceConstant,
+                                            double C0,double C1,double C2){
+      d_gradPoints.push_back(idx1);
+      d_gradPoints.push_back(idx2);
+      d_gradPoints.push_back(idx3);
+      d_orders.push_back(order);
+      d_forceConstants.push_back(forceConstant);
+      d_C0s.push_back(C0);
+      d_C1s.push_back(C1);
+      d_C2s.push_back(C2);
+      return d_orders.size()-1;
+    }
 
-      if(this->d_order==0){
-	dE_dTheta =  -1*this->d_forceConstant*(this->d_C1*sinTheta +
-					       2.*this->d_C2*sin2Theta);
-      } else {
-	// E = k/n^2 [1-cos(n theta)]
-	// dE = - k/n^2 * d cos(n theta)
+    void AngleBendBatch::calcEnergies(const double *pos,double *energies) const {
+      const unsigned int *idx=&d_gradPoints.front();
+      unsigned int n=d_orders.size();
+      for(unsigned int i=0;i<n;++i){
+        unsigned int i1=idx[3*i],i2=idx[3*i+1],i3=idx[3*i+2];
+        double dist1=distance(pos,i1,i2);
+        double dist2=distance(pos,i2,i3);
+        energies[i]=angleEnergy(&pos[3*i1],&pos[3*i2],&pos[3*i3],dist1,dist2,
+                                d_orders[i],d_forceConstants[i],
+                                d_C0s[i],d_C1s[i],d_C2s[i]);
+      }
+    }
 
-	// these all use:
-	// d cos(ax) = -a sin(ax)
-      
-	switch(this->d_order){
-	case 1:
-	  dE_dTheta = sinTheta;
-	  break;
-	case 2:
-	  // sin(2*x) = 2*cos(x)*sin(x)
-	  dE_dTheta = sin2Theta;
-	  break;
-	case 3:
-	  // sin(3*x) = 3*sin(x) - 4*sin^3(x)
-	  dE_dTheta = sinTheta*(3-4*sinTheta*sinTheta);
-	  break;
-	case 4:
-	  // sin(4*x) = cos(x)*(4*sin(x) - 8*sin^3(x))
-	  dE_dTheta = cosTheta*sinTheta*(4-8*sinTheta*sinTheta);
-	  break;
-	}
-	dE_dTheta *= this->d_forceConstant/this->d_order;
+    void AngleBendBatch::calcGradTerms(const double *pos,double *terms) const {
+      const unsigned int *idx=&d_gradPoints.front();
+      unsigned int n=d_orders.size();
+      for(unsigned int i=0;i<n;++i){
+        unsigned int i1=idx[3*i],i2=idx[3*i+1],i3=idx[3*i+2];
+        double dist1=distance(pos,i1,i2);
+        double dist2=distance(pos,i2,i3);
+        angleGrad(&pos[3*i1],&pos[3*i2],&pos[3*i3],dist1,dist2,
+                  d_orders[i],d_forceConstants[i],d_C1s[i],d_C2s[i],
+                  &terms[9*i],&terms[9*i+3],&terms[9*i+6]);
       }
-      return dE_dTheta;
     }
   
   }
@@ -51,14 +51,29 @@ namespace ForceFields {
 		       unsigned int order=0);
       double getEnergy(double *pos) const;
       void getGrad(double *pos,double *grad) const;
+      virtual AngleBendContrib *copy() const { return new AngleBendContrib(*this); };
+
+      int addToBatch(ContribBatchPtrVect &batches,unsigned int &batchIdx) const;
     
     private:
       int d_at1Idx,d_at2Idx,d_at3Idx;
       unsigned int d_order;
       double d_forceConstant,d_theta0,d_C0,d_C1,d_C2;
+    };
 
-      double getEnergyTerm(double cosTheta,double sinThetaSq) const;
-      double getThetaDeriv(double cosTheta,double sinTheta) const;
+    //! a batch of AngleBendContribs
+    class AngleBendBatch : public ContribBatch {
+    public:
+      AngleBendBatch() : ContribBatch(3) {};
+      //! adds an angle, returns its index in the batch
+      unsigned int addContrib(unsigned int idx1,unsigned int idx2,unsigned int idx3,
+                              unsigned int order,double forceConstant,
+                              double C0,double C1,double C2);
+      void calcEnergies(const double *pos,double *energies) const;
+      void calcGradTerms(const double *pos,double *terms) const;
+    private:
+      std::vector<unsigned int> d_orders;
+      std::vector<double> d_forceConstants,d_C0s,d_C1s,d_C2s;
     };
   
     namespace Utils {
@@ -69,14 +69,37 @@ namespace ForceFields {
 							   end1Params,end2Params);
     }
 
+    namespace {
+      // these are shared by the contribs and the batches so that they
+      // give identical results:
+      inline double bondEnergy(double dist,double restLen,double forceConstant){
+        double distTerm=dist-restLen;
+        return 0.5*forceConstant*distTerm*distTerm;
+      }
+      inline void bondGrad(const double *end1Coords,const double *end2Coords,
+                           double dist,double restLen,double forceConstant,
+                           double *g1,double *g2){
+        double preFactor = forceConstant*(dist-restLen);
+        for(int i=0;i<3;i++){
+          double dGrad;
+          if(dist>0.0){
+            dGrad=preFactor * (end1Coords[i]-end2Coords[i])/dist;
+          } else {
+            // move a small amount in an arbitrary direction
+            dGrad=forceConstant*.01;
+          }
+          g1[i] += dGrad;
+          g2[i] -= dGrad;
+        }    
+      }
+    }
+
     double BondStretchContrib::getEnergy(double *pos) const {
       PRECONDITION(dp_forceField,"no owner");
       PRECONDITION(pos,"bad vector");
 
-      double distTerm=this->dp_forceField->distance(this->d_end1Idx,this->d_end2Idx,pos) -
-	this->d_restLen;
-      double res = 0.5*this->d_forceConstant*distTerm*distTerm;
-      return res;
+      double dist=this->dp_forceField->distance(this->d_end1Idx,this->d_end2Idx,pos);
+      return bondEnergy(dist,this->d_restLen,this->d_forceConstant);
     }
     void BondStretchContrib::getGrad(double *pos,double *grad) const {
       PRECONDITION(dp_forceField,"no owner");
@@ -85,22 +108,44 @@ namespace ForceFields {
 
 
       double dist=this->dp_forceField->distance(this->d_end1Idx,this->d_end2Idx,pos);
-      double preFactor = this->d_forceConstant*(dist-this->d_restLen);
-
-      //std::cout << "\tDist("<<this->d_end1Idx<<","<<this->d_end2Idx<<") " << dist << std::endl;
-      double *end1Coords = &(pos[3*this->d_end1Idx]);
-      double *end2Coords = &(pos[3*this->d_end2Idx]);
-      for(int i=0;i<3;i++){
-	double dGrad;
-	if(dist>0.0){
-	  dGrad=preFactor * (end1Coords[i]-end2Coords[i])/dist;
-	} else {
-	  // move a small amount in an arbitrary direction
-	  dGrad=this->d_forceConstant*.01;
-	}
-	grad[3*this->d_end1Idx+i] += dGrad;
-	grad[3*this->d_end2Idx+i] -= dGrad;
-      }    
+      bondGrad(&(pos[3*this->d_end1Idx]),&(pos[3*this->d_end2Idx]),dist,
+               this->d_restLen,this->d_forceConstant,
+               &(grad[3*this->d_end1Idx]),&(grad[3*this->d_end2Idx]));
+    }
+
+    int BondStretchContrib::addToBatch(ContribBatchPtrVect &batches,
+                                       unsigned int &batchIdx) const {
+      BondStretchBatch *batch=getContribBatch<BondStretchBatch>(batches,batchIdx);
+      return batch->addContrib(d_end1Idx,d_end2Idx,d_restLen,d_forceConstant);
+    }
+
+    unsigned int BondStretchBatch::addContrib(unsigned int idx1,unsigned int idx2,
+                                              double restLen,double forceConstant){
+      d_gradPoints.push_back(idx1);
+      d_gradPoints.push_back(idx2);
+      d_restLens.push_back(restLen);
+      d_forceConstants.push_back(forceConstant);
+      return d_restLens.size()-1;
+    }
+
+    void BondStretchBatch::calcEnergies(const double *pos,double *energies) const {
+      const unsigned int *idx=&d_gradPoints.front();
+      unsigned int n=d_restLens.size();
+      for(unsigned int i=0;i<n;++i){
+        double dist=distance(pos,idx[2*i],idx[2*i+1]);
+        energies[i]=bondEnergy(dist,d_restLens[i],d_forceConstants[i]);
+      }
+    }
+
+    void BondStretchBatch::calcGradTerms(const double *pos,double *terms) const {
+      const unsigned int *idx=&d_gradPoints.front();
+      unsigned int n=d_restLens.size();
+      for(unsigned int i=0;i<n;++i){
+        double dist=distance(pos,idx[2*i],idx[2*i+1]);
+        bondGrad(&pos[3*idx[2*i]],&pos[3*idx[2*i+1]],dist,
+                 d_restLens[i],d_forceConstants[i],
+                 &terms[6*i],&terms[6*i+3]);
+      }
     }
   
   }
@@ -37,6 +37,9 @@ namespace ForceFields {
       double getEnergy(double *pos) const;
 
       void getGrad(double *pos,double *grad) const;
+      virtual BondStretchContrib *copy() const { return new BondStretchContrib(*this); };
+
+      int addToBatch(ContribBatchPtrVect &batches,unsigned int &batchIdx) const;
     
     private:
       int d_end1Idx,d_end2Idx; //!< indices of end points
@@ -44,6 +47,19 @@ namespace ForceFields {
       double d_forceConstant;  //!< force constant of the bond
 
     };
+
+    //! a batch of BondStretchContribs
+    class BondStretchBatch : public ContribBatch {
+    public:
+      BondStretchBatch() : ContribBatch(2) {};
+      //! adds a bond, returns its index in the batch
+      unsigned int addContrib(unsigned int idx1,unsigned int idx2,
+                              double restLen,double forceConstant);
+      void calcEnergies(const double *pos,double *energies) const;
+      void calcGradTerms(const double *pos,double *terms) const;
+    private:
+      std::vector<double> d_restLens,d_forceConstants;
+    };
   
     namespace Utils {
       //! calculates and returns the UFF rest length for a bond 
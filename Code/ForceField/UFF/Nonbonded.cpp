@@ -14,6 +14,7 @@
 #include <ForceField/ForceField.h>
 #include <RDGeneral/Invariant.h>
 #include <RDGeneral/utils.h>
+#include <algorithm>
 
 namespace ForceFields {
   namespace UFF {
@@ -52,19 +53,51 @@ namespace ForceFields {
       //std::cerr << "  non-bonded: " << idx1 << "-" << idx2 << " " << this->d_xij << " " << this->d_wellDepth << " " << this->d_thresh << std::endl;
     }
 
+    namespace {
+      // these are shared by the contribs and the batches so that they
+      // give identical results:
+      inline double vdWEnergy(double dist,double xij,double wellDepth,double thresh){
+        if(dist>thresh || dist<=0.0) return 0.0;
+
+        double r=xij/dist;
+        double r6=int_pow<6>(r);
+        double r12=r6*r6;
+        return wellDepth*(r12 - 2.0*r6);
+      }
+      inline void vdWGrad(const double *at1Coords,const double *at2Coords,
+                          double dist,double xij,double wellDepth,double thresh,
+                          double *g1,double *g2){
+        if(dist>thresh) return;
+
+        if(dist<=0){
+          for(int i=0;i<3;i++){
+            // move in an arbitrary direction
+            double dGrad=100.0;
+            g1[i] += dGrad;
+            g2[i] -= dGrad;
+          }    
+          return;
+        }
+      
+        double r = xij/dist;
+        double r7 = int_pow<7>(r);
+        double r13= int_pow<13>(r);
+        double preFactor = 12.*wellDepth/xij * (r7-r13);
+    
+        for(int i=0;i<3;i++){
+          double dGrad=preFactor * (at1Coords[i]-at2Coords[i])/dist;
+          g1[i] += dGrad;
+          g2[i] -= dGrad;
+        }    
+      }
+    }
+
     double vdWContrib::getEnergy(double *pos) const {
       PRECONDITION(dp_forceField,"no owner");
       PRECONDITION(pos,"bad vector");
 
       double dist=this->dp_forceField->distance(this->d_at1Idx,this->d_at2Idx,pos);
-      if(dist>this->d_thresh || dist<=0.0) return 0.0;
-
-      double r=this->d_xij/dist;
-      double r6=int_pow<6>(r);
-      double r12=r6*r6;
-      double res = this->d_wellDepth*(r12 - 2.0*r6);
-      //if(d_at1Idx==12 && d_at2Idx==21 ) std::cerr << "     >: " << d_at1Idx << "-" << d_at2Idx << " " << r << " = " << res << std::endl;
-      return res;
+      return vdWEnergy(dist,this->d_xij,this->d_wellDepth,this->d_thresh);
     }
     void vdWContrib::getGrad(double *pos,double *grad) const {
       PRECONDITION(dp_forceField,"no owner");
@@ -72,30 +105,226 @@ namespace ForceFields {
       PRECONDITION(grad,"bad vector");
 
       double dist=this->dp_forceField->distance(this->d_at1Idx,this->d_at2Idx,pos);
-      if(dist>this->d_thresh) return;
+      vdWGrad(&(pos[3*this->d_at1Idx]),&(pos[3*this->d_at2Idx]),dist,
+              this->d_xij,this->d_wellDepth,this->d_thresh,
+              &(grad[3*this->d_at1Idx]),&(grad[3*this->d_at2Idx]));
+    }
 
-      if(dist<=0){
-        for(int i=0;i<3;i++){
-          // move in an arbitrary direction
-          double dGrad=100.0;
-          grad[3*this->d_at1Idx+i] += dGrad;
-          grad[3*this->d_at2Idx+i] -= dGrad;
-        }    
-        return;
+    int vdWContrib::addToBatch(ContribBatchPtrVect &batches,
+                               unsigned int &batchIdx) const {
+      vdWBatch *batch=getContribBatch<vdWBatch>(batches,batchIdx);
+      return batch->addContrib(d_at1Idx,d_at2Idx,d_xij,d_wellDepth,d_thresh);
+    }
+
+    unsigned int vdWBatch::addContrib(unsigned int idx1,unsigned int idx2,
+                                      double xij,double wellDepth,double thresh){
+      d_gradPoints.push_back(idx1);
+      d_gradPoints.push_back(idx2);
+      d_xijs.push_back(xij);
+      d_wellDepths.push_back(wellDepth);
+      d_threshs.push_back(thresh);
+      return d_xijs.size()-1;
+    }
+
+    void vdWBatch::calcEnergies(const double *pos,double *energies) const {
+      const unsigned int *idx=&d_gradPoints.front();
+      unsigned int n=d_xijs.size();
+      for(unsigned int i=0;i<n;++i){
+        double dist=distance(pos,idx[2*i],idx[2*i+1]);
+        energies[i]=vdWEnergy(dist,d_xijs[i],d_wellDepths[i],d_threshs[i]);
+      }
+    }
+
+    void vdWBatch::calcGradTerms(const double *pos,double *terms) const {
+      const unsigned int *idx=&d_gradPoints.front();
+      unsigned int n=d_xijs.size();
+      for(unsigned int i=0;i<n;++i){
+        double dist=distance(pos,idx[2*i],idx[2*i+1]);
+        vdWGrad(&pos[3*idx[2*i]],&pos[3*idx[2*i+1]],dist,
+                d_xijs[i],d_wellDepths[i],d_threshs[i],
+                &terms[6*i],&terms[6*i+3]);
+      }
+    }
+
+    vdWListContrib::vdWListContrib(ForceField *owner,
+                                   const std::vector<const AtomicParams *> &params,
+                                   double cutoff,double skin,double threshMultiplier) :
+      d_params(params), d_cutoff(cutoff), d_skin(skin),
+      d_threshMultiplier(threshMultiplier), df_built(false), d_numBuilds(0) {
+      PRECONDITION(owner,"bad owner");
+      PRECONDITION(owner->dimension()==3,"vdWListContrib requires 3D positions");
+      PRECONDITION(params.size()==owner->positions().size(),"bad parameters");
+      PRECONDITION(cutoff>0.0,"bad cutoff");
+      PRECONDITION(skin>=0.0,"bad skin");
+      dp_forceField = owner;
+      d_exclusions.resize(params.size());
+    }
+
+    void vdWListContrib::addExclusion(unsigned int idx1,unsigned int idx2){
+      RANGE_CHECK(0,idx1,d_params.size()-1);
+      RANGE_CHECK(0,idx2,d_params.size()-1);
+      if(idx2<idx1) std::swap(idx1,idx2);
+      std::vector<unsigned int> &excl=d_exclusions[idx1];
+      std::vector<unsigned int>::iterator it=std::lower_bound(excl.begin(),excl.end(),idx2);
+      if(it==excl.end() || *it!=idx2){
+        excl.insert(it,idx2);
+      }
+      df_built=false;
+    }
+
+    void vdWListContrib::setFragments(const std::vector<int> &fragIds){
+      PRECONDITION(fragIds.empty() || fragIds.size()==d_params.size(),"bad fragment ids");
+      d_fragIds=fragIds;
+      df_built=false;
+    }
+
+    bool vdWListContrib::isExcluded(unsigned int idx1,unsigned int idx2) const {
+      if(!d_fragIds.empty() && d_fragIds[idx1]!=d_fragIds[idx2]) return true;
+      const std::vector<unsigned int> &excl=d_exclusions[idx1];
+      return std::binary_search(excl.begin(),excl.end(),idx2);
+    }
+
+    void vdWListContrib::updateNeighbors(const double *pos) const {
+      if(df_built){
+        // the list is still good as long as no point has moved more than
+        // half the skin since it was built:
+        double maxDisp2=0.25*d_skin*d_skin;
+        bool ok=true;
+        for(unsigned int i=0;i<d_buildPos.size();i+=3){
+          double dx=pos[i]-d_buildPos[i];
+          double dy=pos[i+1]-d_buildPos[i+1];
+          double dz=pos[i+2]-d_buildPos[i+2];
+          if(dx*dx+dy*dy+dz*dz>maxDisp2){
+            ok=false;
+            break;
+          }
+        }
+        if(ok) return;
+      }
+      buildNeighbors(pos);
+    }
+
+    void vdWListContrib::buildNeighbors(const double *pos) const {
+      unsigned int nPts=d_params.size();
+      double listDist=d_cutoff+d_skin;
+      double listDist2=listDist*listDist;
+
+      // find the extent of the points:
+      double minPt[3],maxPt[3];
+      bool first=true;
+      for(unsigned int i=0;i<nPts;++i){
+        if(!d_params[i]) continue;
+        for(unsigned int j=0;j<3;++j){
+          if(first || pos[3*i+j]<minPt[j]) minPt[j]=pos[3*i+j];
+          if(first || pos[3*i+j]>maxPt[j]) maxPt[j]=pos[3*i+j];
+        }
+        first=false;
+      }
+
+      std::vector<std::pair<unsigned int,unsigned int> > pairs;
+      if(!first){
+        // set up the cell grid. The cells are at least listDist on a side,
+        // so all neighbors of a point are in its cell or the adjacent ones.
+        // Sparse systems would need a lot of empty cells, so the cells are
+        // allowed to grow:
+        double cellSize=listDist;
+        unsigned int dims[3];
+        while(1){
+          double nCells=1.0;
+          for(unsigned int j=0;j<3;++j){
+            dims[j]=static_cast<unsigned int>((maxPt[j]-minPt[j])/cellSize)+1;
+            nCells*=dims[j];
+          }
+          if(nCells<=8.0*nPts+27) break;
+          cellSize*=2;
+        }
+        std::vector<int> cellHeads(dims[0]*dims[1]*dims[2],-1);
+        std::vector<int> cellNext(nPts,-1);
+        std::vector<unsigned int> cellIdx(3*nPts,0);
+        for(unsigned int i=0;i<nPts;++i){
+          if(!d_params[i]) continue;
+          for(unsigned int j=0;j<3;++j){
+            cellIdx[3*i+j]=std::min(static_cast<unsigned int>((pos[3*i+j]-minPt[j])/cellSize),
+                                    dims[j]-1);
+          }
+          unsigned int cell=(cellIdx[3*i]*dims[1]+cellIdx[3*i+1])*dims[2]+cellIdx[3*i+2];
+          cellNext[i]=cellHeads[cell];
+          cellHeads[cell]=i;
+        }
+
+        for(unsigned int i=0;i<nPts;++i){
+          if(!d_params[i]) continue;
+          unsigned int lo[3],hi[3];
+          for(unsigned int j=0;j<3;++j){
+            lo[j]=cellIdx[3*i+j]>0 ? cellIdx[3*i+j]-1 : 0;
+            hi[j]=std::min(cellIdx[3*i+j]+1,dims[j]-1);
+          }
+          for(unsigned int cx=lo[0];cx<=hi[0];++cx){
+            for(unsigned int cy=lo[1];cy<=hi[1];++cy){
+              for(unsigned int cz=lo[2];cz<=hi[2];++cz){
+                int j=cellHeads[(cx*dims[1]+cy)*dims[2]+cz];
+                for(;j>=0;j=cellNext[j]){
+                  if(static_cast<unsigned int>(j)<=i || isExcluded(i,j)) continue;
+                  double dx=pos[3*i]-pos[3*j];
+                  double dy=pos[3*i+1]-pos[3*j+1];
+                  double dz=pos[3*i+2]-pos[3*j+2];
+                  if(dx*dx+dy*dy+dz*dz<=listDist2){
+                    pairs.push_back(std::make_pair(i,static_cast<unsigned int>(j)));
+                  }
+                }
+              }
+            }
+          }
+        }
+        // the order in which the contacts are found depends on the grid,
+        // sort them so that the sums don't:
+        std::sort(pairs.begin(),pairs.end());
+      }
+
+      d_pairs.resize(2*pairs.size());
+      d_xijs.resize(pairs.size());
+      d_wellDepths.resize(pairs.size());
+      d_threshs.resize(pairs.size());
+      for(unsigned int pi=0;pi<pairs.size();++pi){
+        const AtomicParams *p1=d_params[pairs[pi].first];
+        const AtomicParams *p2=d_params[pairs[pi].second];
+        d_pairs[2*pi]=pairs[pi].first;
+        d_pairs[2*pi+1]=pairs[pi].second;
+        d_xijs[pi]=Utils::calcNonbondedMinimum(p1,p2);
+        d_wellDepths[pi]=Utils::calcNonbondedDepth(p1,p2);
+        d_threshs[pi]=std::min(d_threshMultiplier*d_xijs[pi],d_cutoff);
+      }
+      d_buildPos.assign(pos,pos+3*nPts);
+      df_built=true;
+      ++d_numBuilds;
+    }
+
+    double vdWListContrib::getEnergy(double *pos) const {
+      PRECONDITION(dp_forceField,"no owner");
+      PRECONDITION(pos,"bad vector");
+
+      updateNeighbors(pos);
+      double res=0.0;
+      for(unsigned int pi=0;pi<d_xijs.size();++pi){
+        double dist=ContribBatch::distance(pos,d_pairs[2*pi],d_pairs[2*pi+1]);
+        res+=vdWEnergy(dist,d_xijs[pi],d_wellDepths[pi],d_threshs[pi]);
+      }
+      return res;
+    }
+
+    void vdWListContrib::getGrad(double *pos,double *grad) const {
+      PRECONDITION(dp_forceField,"no owner");
+      PRECONDITION(pos,"bad vector");
+      PRECONDITION(grad,"bad vector");
+
+      updateNeighbors(pos);
+      for(unsigned int pi=0;pi<d_xijs.size();++pi){
+        unsigned int i=d_pairs[2*pi],j=d_pairs[2*pi+1];
+        double dist=ContribBatch::distance(pos,i,j);
+        vdWGrad(&(pos[3*i]),&(pos[3*j]),dist,
+                d_xijs[pi],d_wellDepths[pi],d_threshs[pi],
+                &(grad[3*i]),&(grad[3*j]));
       }
-      
-      double r = this->d_xij/dist;
-      double r7 = int_pow<7>(r);
-      double r13= int_pow<13>(r);
-      double preFactor = 12.*this->d_wellDepth/this->d_xij * (r7-r13);
-    
-      double *at1Coords = &(pos[3*this->d_at1Idx]);
-      double *at2Coords = &(pos[3*this->d_at2Idx]);
-      for(int i=0;i<3;i++){
-        double dGrad=preFactor * (at1Coords[i]-at2Coords[i])/dist;
-        grad[3*this->d_at1Idx+i] += dGrad;
-        grad[3*this->d_at2Idx+i] -= dGrad;
-      }    
     }
   
   }
@@ -10,6 +10,7 @@
 #ifndef __RD_NONBONDED_H__
 #define __RD_NONBONDED_H__
 #include <ForceField/Contrib.h>
+#include <vector>
 
 namespace ForceFields {
   namespace UFF {
@@ -48,6 +49,9 @@ namespace ForceFields {
 		 double threshMultiplier=2.0);
       double getEnergy(double *pos) const;
       void getGrad(double *pos,double *grad) const;
+      virtual vdWContrib *copy() const { return new vdWContrib(*this); };
+
+      int addToBatch(ContribBatchPtrVect &batches,unsigned int &batchIdx) const;
     
     private:
       int d_at1Idx,d_at2Idx;
@@ -56,6 +60,87 @@ namespace ForceFields {
       double d_thresh;    //!< the distance threshold
 
     };
+
+    //! a batch of vdWContribs
+    class vdWBatch : public ContribBatch {
+    public:
+      vdWBatch() : ContribBatch(2) {};
+      //! adds a contact, returns its index in the batch
+      unsigned int addContrib(unsigned int idx1,unsigned int idx2,
+                              double xij,double wellDepth,double thresh);
+      void calcEnergies(const double *pos,double *energies) const;
+      void calcGradTerms(const double *pos,double *terms) const;
+    private:
+      std::vector<double> d_xijs,d_wellDepths,d_threshs;
+    };
+
+    //! the van der Waals terms for all of the nonbonded contacts in a system
+    /*!
+      Rather than having one vdWContrib for every contact, this keeps a
+      neighbor list of the contacts that are within \c cutoff + \c skin
+      of each other. The list is built using a cell grid, so the time and
+      memory required scale linearly with the number of atoms.
+
+      The list is rebuilt whenever an atom has moved more than half of
+      \c skin since the last build, so during a minimization it is
+      updated as required. Since this guarantees that every contact within
+      \c cutoff is in the list, the energy doesn't depend on when the
+      list was built.
+
+      Contacts longer than \c cutoff, or longer than the threshold
+      described for vdWContrib, make no contribution.
+     */
+    class vdWListContrib : public ForceFieldContrib {
+    public:
+      //! Constructor
+      /*!
+	\param owner       pointer to the owning ForceField
+	\param params      the parameters for each of the ForceField's positions,
+	                   points with null parameters have no vdW interactions
+	\param cutoff      the distance beyond which contacts are ignored
+	\param skin        the extra distance to include in the neighbor list
+	\param threshMultiplier (optional) multiplier for the threshold
+	       calculation. See the vdWContrib documentation for details.
+
+      */
+      vdWListContrib(ForceField *owner,
+                     const std::vector<const AtomicParams *> &params,
+                     double cutoff=8.0,double skin=1.0,
+                     double threshMultiplier=2.0);
+
+      //! the contact between two points will not be included
+      void addExclusion(unsigned int idx1,unsigned int idx2);
+      //! only contacts between points with the same fragment id will be included
+      void setFragments(const std::vector<int> &fragIds);
+
+      double getEnergy(double *pos) const;
+      void getGrad(double *pos,double *grad) const;
+      virtual vdWListContrib *copy() const { return new vdWListContrib(*this); };
+
+      //! returns the number of contacts in the current neighbor list
+      unsigned int numNeighbors() const { return d_xijs.size(); };
+      //! returns the number of times the neighbor list has been built
+      unsigned int numBuilds() const { return d_numBuilds; };
+      //! forces the neighbor list to be rebuilt on the next evaluation
+      void reset() { df_built=false; };
+
+    private:
+      std::vector<const AtomicParams *> d_params;
+      std::vector<std::vector<unsigned int> > d_exclusions; //!< sorted, larger indices only
+      std::vector<int> d_fragIds;
+      double d_cutoff,d_skin,d_threshMultiplier;
+
+      // the neighbor list is updated when we are evaluated:
+      mutable bool df_built;
+      mutable unsigned int d_numBuilds;
+      mutable std::vector<double> d_buildPos;  //!< the positions at the last build
+      mutable std::vector<unsigned int> d_pairs;
+      mutable std::vector<double> d_xijs,d_wellDepths,d_threshs;
+
+      void updateNeighbors(const double *pos) const;
+      void buildNeighbors(const double *pos) const;
+      bool isExcluded(unsigned int idx1,unsigned int idx2) const;
+    };
     namespace Utils {
       //! calculates and returns the UFF minimum position for a vdW contact
       /*!
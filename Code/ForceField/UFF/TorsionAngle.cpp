@@ -129,165 +129,197 @@ namespace ForceFields {
         }
       }
     }
-    double TorsionAngleContrib::getEnergy(double *pos) const {
-      PRECONDITION(dp_forceField,"no owner");
-      PRECONDITION(pos,"bad vector");
-      PRECONDITION(this->d_order==2||this->d_order==3||this->d_order==6,"bad order");
+    namespace {
+      // these are shared by the contribs and the batches so that they
+      // give identical results:
+      inline double torsionEnergy(const double *pos1,const double *pos2,
+                                  const double *pos3,const double *pos4,
+                                  unsigned int order,double forceConstant,double cosTerm){
+        RDGeom::Point3D p1(pos1[0],pos1[1],pos1[2]);
+        RDGeom::Point3D p2(pos2[0],pos2[1],pos2[2]);
+        RDGeom::Point3D p3(pos3[0],pos3[1],pos3[2]);
+        RDGeom::Point3D p4(pos4[0],pos4[1],pos4[2]);
 
-      RDGeom::Point3D p1(pos[3*this->d_at1Idx],
-                         pos[3*this->d_at1Idx+1],
-                         pos[3*this->d_at1Idx+2]);
-      RDGeom::Point3D p2(pos[3*this->d_at2Idx],
-                         pos[3*this->d_at2Idx+1],
-                         pos[3*this->d_at2Idx+2]);
-      RDGeom::Point3D p3(pos[3*this->d_at3Idx],
-                         pos[3*this->d_at3Idx+1],
-                         pos[3*this->d_at3Idx+2]);
-      RDGeom::Point3D p4(pos[3*this->d_at4Idx],
-                         pos[3*this->d_at4Idx+1],
-                         pos[3*this->d_at4Idx+2]);
+        double cosPhi=Utils::calculateCosTorsion(p1,p2,p3,p4);
+        double sinPhiSq=1-cosPhi*cosPhi;
 
-      double cosPhi=Utils::calculateCosTorsion(p1,p2,p3,p4);
-      double sinPhiSq=1-cosPhi*cosPhi;
-
-      // E(phi) = V/2 * (1 - cos(n*phi_0)*cos(n*phi))
-      double cosNPhi=0.0;
-      switch(this->d_order){
-      case 2:
-        cosNPhi = cosPhi*cosPhi - sinPhiSq;
-        break;
-      case 3:
-        // cos(3x) = cos^3(x) - 3*cos(x)*sin^2(x)
-        cosNPhi = cosPhi*(cosPhi*cosPhi - 3*sinPhiSq);
-        break;
-      case 6:
-        // cos(6x) = 1 - 32*sin^6(x) + 48*sin^4(x) - 18*sin^2(x)
-        cosNPhi = 1 + sinPhiSq*(-32*sinPhiSq*sinPhiSq + 48*sinPhiSq - 18);
-        break;
+        // E(phi) = V/2 * (1 - cos(n*phi_0)*cos(n*phi))
+        double cosNPhi=0.0;
+        switch(order){
+        case 2:
+          cosNPhi = cosPhi*cosPhi - sinPhiSq;
+          break;
+        case 3:
+          // cos(3x) = cos^3(x) - 3*cos(x)*sin^2(x)
+          cosNPhi = cosPhi*(cosPhi*cosPhi - 3*sinPhiSq);
+          break;
+        case 6:
+          // cos(6x) = 1 - 32*sin^6(x) + 48*sin^4(x) - 18*sin^2(x)
+          cosNPhi = 1 + sinPhiSq*(-32*sinPhiSq*sinPhiSq + 48*sinPhiSq - 18);
+          break;
+        }
+        return forceConstant/2.0 * (1 - cosTerm*cosNPhi);
       }
-      double res=this->d_forceConstant/2.0 * (1 - this->d_cosTerm*cosNPhi);
-      //std::cout << " torsion(" << this->d_at1Idx << "," << this->d_at2Idx << "," << this->d_at3Idx << "," << this->d_at4Idx << "): " << cosPhi << "(" << acos(cosPhi) << ")" << " -> " << res << std::endl;
-      //if(this->d_at2Idx==5&&this->d_at3Idx==6) std::cerr << " torsion(" << this->d_at1Idx << "," << this->d_at2Idx << "," << this->d_at3Idx << "," << this->d_at4Idx << "): " << cosPhi << "(" << acos(cosPhi) << ")" << " -> " << res << std::endl;
-      return res;
-    }
 
-    void TorsionAngleContrib::getGrad(double *pos,double *grad) const {
-      PRECONDITION(dp_forceField,"no owner");
-      PRECONDITION(pos,"bad vector");
-      PRECONDITION(grad,"bad vector");
+      inline double torsionThetaDeriv(unsigned int order,double forceConstant,double cosTerm,
+                                      double cosTheta,double sinTheta){
+        double sinThetaSq=sinTheta*sinTheta;
+        // cos(6x) = 1 - 32*sin^6(x) + 48*sin^4(x) - 18*sin^2(x)
 
-      RDGeom::Point3D p1(pos[3*this->d_at1Idx],
-                         pos[3*this->d_at1Idx+1],
-                         pos[3*this->d_at1Idx+2]);
-      RDGeom::Point3D p2(pos[3*this->d_at2Idx],
-                         pos[3*this->d_at2Idx+1],
-                         pos[3*this->d_at2Idx+2]);
-      RDGeom::Point3D p3(pos[3*this->d_at3Idx],
-                         pos[3*this->d_at3Idx+1],
-                         pos[3*this->d_at3Idx+2]);
-      RDGeom::Point3D p4(pos[3*this->d_at4Idx],
-                         pos[3*this->d_at4Idx+1],
-                         pos[3*this->d_at4Idx+2]);
-      double *g1=&(grad[3*this->d_at1Idx]);
-      double *g2=&(grad[3*this->d_at2Idx]);
-      double *g3=&(grad[3*this->d_at3Idx]);
-      double *g4=&(grad[3*this->d_at4Idx]);
+        double res=0.0;
+        switch(order){
+        case 2:
+          res = 2*sinTheta*cosTheta;
+          break;
+        case 3:
+          // sin(3*x) = 3*sin(x) - 4*sin^3(x)
+          res = sinTheta*(3-4*sinThetaSq);
+          break;
+        case 6:
+          // sin(6x) = cos(x) * [ 32*sin^5(x) - 32*sin^3(x) + 6*sin(x) ]
+          res = cosTheta*sinTheta * (32*sinThetaSq * (sinThetaSq-1) + 6);
+          break;
+        }
+        res *= forceConstant/2.0 * cosTerm * -1 * order;
 
-      RDGeom::Point3D r1=p1-p2,r2=p3-p2,r3=p2-p3,r4=p4-p3;
-      RDGeom::Point3D t1=r1.crossProduct(r2);
-      RDGeom::Point3D t2=r3.crossProduct(r4);
-      double d1=t1.length(),d2=t2.length();
-      if(d1==0.0 || d2==0.0){
-        return;
-      }
-      
-      double cosPhi=t1.dotProduct(t2)/(d1*d2);
-      double sinPhi=1-cosPhi*cosPhi;
-      if(sinPhi>=0.0) {
-        sinPhi=sqrt(sinPhi);
-      } else {
-        sinPhi=0.0;
+        return res;
       }
-      // dE/dPhi is independent of cartesians:
-      double dE_dPhi=getThetaDeriv(cosPhi,sinPhi);
-#if 0
-      if(dE_dPhi!=dE_dPhi){
-        std::cout << "\tNaN in Torsion("<<this->d_at1Idx<<","<<this->d_at2Idx<<","<<this->d_at3Idx<<","<<this->d_at4Idx<<")"<< std::endl;
-        std::cout << "sin: " << sinPhi << std::endl;
-        std::cout << "cos: " << cosPhi << std::endl;
-      } 
+
+      inline void torsionGrad(const double *pos1,const double *pos2,
+                              const double *pos3,const double *pos4,
+                              unsigned int order,double forceConstant,double cosTerm,
+                              double *g1,double *g2,double *g3,double *g4){
+        RDGeom::Point3D p1(pos1[0],pos1[1],pos1[2]);
+        RDGeom::Point3D p2(pos2[0],pos2[1],pos2[2]);
+        RDGeom::Point3D p3(pos3[0],pos3[1],pos3[2]);
+        RDGeom::Point3D p4(pos4[0],pos4[1],pos4[2]);
+
+        RDGeom::Point3D r1=p1-p2,r2=p3-p2,r3=p2-p3,r4=p4-p3;
+        RDGeom::Point3D t1=r1.crossProduct(r2);
+        RDGeom::Point3D t2=r3.crossProduct(r4);
+        double d1=t1.length(),d2=t2.length();
+        if(d1==0.0 || d2==0.0){
+          return;
+        }
       
-#endif
+        double cosPhi=t1.dotProduct(t2)/(d1*d2);
+        double sinPhi=1-cosPhi*cosPhi;
+        if(sinPhi>=0.0) {
+          sinPhi=sqrt(sinPhi);
+        } else {
+          sinPhi=0.0;
+        }
+        // dE/dPhi is independent of cartesians:
+        double dE_dPhi=torsionThetaDeriv(order,forceConstant,cosTerm,cosPhi,sinPhi);
       
-      // -------
-      // dTheta/dx is trickier:
-      double dCos_dT1=1./d1 * (t2.x/d2 - cosPhi*t1.x/d1);
-      double dCos_dT2=1./d1 * (t2.y/d2 - cosPhi*t1.y/d1);
-      double dCos_dT3=1./d1 * (t2.z/d2 - cosPhi*t1.z/d1);
+        // -------
+        // dTheta/dx is trickier:
+        double dCos_dT1=1./d1 * (t2.x/d2 - cosPhi*t1.x/d1);
+        double dCos_dT2=1./d1 * (t2.y/d2 - cosPhi*t1.y/d1);
+        double dCos_dT3=1./d1 * (t2.z/d2 - cosPhi*t1.z/d1);
                                                     
-      double dCos_dT4=1./d2 * (t1.x/d1 - cosPhi*t2.x/d2);
-      double dCos_dT5=1./d2 * (t1.y/d1 - cosPhi*t2.y/d2);
-      double dCos_dT6=1./d2 * (t1.z/d1 - cosPhi*t2.z/d2);
+        double dCos_dT4=1./d2 * (t1.x/d1 - cosPhi*t2.x/d2);
+        double dCos_dT5=1./d2 * (t1.y/d1 - cosPhi*t2.y/d2);
+        double dCos_dT6=1./d2 * (t1.z/d1 - cosPhi*t2.z/d2);
     
-      double sinTerm;
-      // FIX: use a tolerance here:
-      if(sinPhi==0.0){
-        // this is hacky, but it's per the
-        // recommendation from Niketic and Rasmussen:
-        sinTerm = 1/cosPhi; 
-      } else {
-        sinTerm = 1/sinPhi;
-      }
+        double sinTerm;
+        // FIX: use a tolerance here:
+        if(sinPhi==0.0){
+          // this is hacky, but it's per the
+          // recommendation from Niketic and Rasmussen:
+          sinTerm = 1/cosPhi; 
+        } else {
+          sinTerm = 1/sinPhi;
+        }
 
-      g1[0] += dE_dPhi*sinTerm*(dCos_dT3*r2.y - dCos_dT2*r2.z);
-      g1[1] += dE_dPhi*sinTerm*(dCos_dT1*r2.z - dCos_dT3*r2.x);
-      g1[2] += dE_dPhi*sinTerm*(dCos_dT2*r2.x - dCos_dT1*r2.y);
+        g1[0] += dE_dPhi*sinTerm*(dCos_dT3*r2.y - dCos_dT2*r2.z);
+        g1[1] += dE_dPhi*sinTerm*(dCos_dT1*r2.z - dCos_dT3*r2.x);
+        g1[2] += dE_dPhi*sinTerm*(dCos_dT2*r2.x - dCos_dT1*r2.y);
 
-      g2[0] += dE_dPhi*sinTerm*(dCos_dT2*(r2.z-r1.z) + dCos_dT3*(r1.y-r2.y) +
-                                dCos_dT5*(-1*r4.z) + dCos_dT6*(r4.y));
-      g2[1] += dE_dPhi*sinTerm*(dCos_dT1*(r1.z-r2.z) + dCos_dT3*(r2.x-r1.x) +
-                                dCos_dT4*(r4.z) + dCos_dT6*(-1*r4.x));
-      g2[2] += dE_dPhi*sinTerm*(dCos_dT1*(r2.y-r1.y) + dCos_dT2*(r1.x-r2.x) +
-                                dCos_dT4*(-1*r4.y) + dCos_dT5*(r4.x));
+        g2[0] += dE_dPhi*sinTerm*(dCos_dT2*(r2.z-r1.z) + dCos_dT3*(r1.y-r2.y) +
+                                  dCos_dT5*(-1*r4.z) + dCos_dT6*(r4.y));
+        g2[1] += dE_dPhi*sinTerm*(dCos_dT1*(r1.z-r2.z) + dCos_dT3*(r2.x-r1.x) +
+                                  dCos_dT4*(r4.z) + dCos_dT6*(-1*r4.x));
+        g2[2] += dE_dPhi*sinTerm*(dCos_dT1*(r2.y-r1.y) + dCos_dT2*(r1.x-r2.x) +
+                                  dCos_dT4*(-1*r4.y) + dCos_dT5*(r4.x));
     
-      g3[0] += dE_dPhi*sinTerm*(dCos_dT2*(r1.z) + dCos_dT3*(-1*r1.y) +
-                                dCos_dT5*(r4.z-r3.z) + dCos_dT6*(r3.y-r4.y));
-      g3[1] += dE_dPhi*sinTerm*(dCos_dT1*(-1*r1.z) + dCos_dT3*(r1.x) +
-                                dCos_dT4*(r3.z-r4.z) + dCos_dT6*(r4.x-r3.x));
-      g3[2] += dE_dPhi*sinTerm*(dCos_dT1*(r1.y) + dCos_dT2*(-1*r1.x) +
-                                dCos_dT4*(r4.y-r3.y) + dCos_dT5*(r3.x-r4.x));
+        g3[0] += dE_dPhi*sinTerm*(dCos_dT2*(r1.z) + dCos_dT3*(-1*r1.y) +
+                                  dCos_dT5*(r4.z-r3.z) + dCos_dT6*(r3.y-r4.y));
+        g3[1] += dE_dPhi*sinTerm*(dCos_dT1*(-1*r1.z) + dCos_dT3*(r1.x) +
+                                  dCos_dT4*(r3.z-r4.z) + dCos_dT6*(r4.x-r3.x));
+        g3[2] += dE_dPhi*sinTerm*(dCos_dT1*(r1.y) + dCos_dT2*(-1*r1.x) +
+                                  dCos_dT4*(r4.y-r3.y) + dCos_dT5*(r3.x-r4.x));
 
-    
-      g4[0] += dE_dPhi*sinTerm*(dCos_dT5*r3.z - dCos_dT6*r3.y);
-      g4[1] += dE_dPhi*sinTerm*(dCos_dT6*r3.x - dCos_dT4*r3.z);
-      g4[2] += dE_dPhi*sinTerm*(dCos_dT4*r3.y - dCos_dT5*r3.x);
+        g4[0] += dE_dPhi*sinTerm*(dCos_dT5*r3.z - dCos_dT6*r3.y);
+        g4[1] += dE_dPhi*sinTerm*(dCos_dT6*r3.x - dCos_dT4*r3.z);
+        g4[2] += dE_dPhi*sinTerm*(dCos_dT4*r3.y - dCos_dT5*r3.x);
+      }
+    }
 
+    double TorsionAngleContrib::getEnergy(double *pos) const {
+      PRECONDITION(dp_forceField,"no owner");
+      PRECONDITION(pos,"bad vector");
+      PRECONDITION(this->d_order==2||this->d_order==3||this->d_order==6,"bad order");
+
+      return torsionEnergy(&pos[3*this->d_at1Idx],&pos[3*this->d_at2Idx],
+                           &pos[3*this->d_at3Idx],&pos[3*this->d_at4Idx],
+                           this->d_order,this->d_forceConstant,this->d_cosTerm);
     }
 
+    void TorsionAngleContrib::getGrad(double *pos,double *grad) const {
+      PRECONDITION(dp_forceField,"no owner");
+      PRECONDITION(pos,"bad vector");
+      PRECONDITION(grad,"bad vector");
+      PRECONDITION(this->d_order==2||this->d_order==3||this->d_order==6,"bad order");
 
-  
-    double TorsionAngleContrib::getThetaDeriv(double cosTheta,double sinTheta) const {
+      torsionGrad(&pos[3*this->d_at1Idx],&pos[3*this->d_at2Idx],
+                  &pos[3*this->d_at3Idx],&pos[3*this->d_at4Idx],
+                  this->d_order,this->d_forceConstant,this->d_cosTerm,
+                  &grad[3*this->d_at1Idx],&grad[3*this->d_at2Idx],
+                  &grad[3*this->d_at3Idx],&grad[3*this->d_at4Idx]);
+    }
+
+    int TorsionAngleContrib::addToBatch(ContribBatchPtrVect &batches,
+                                        unsigned int &batchIdx) const {
       PRECONDITION(this->d_order==2||this->d_order==3||this->d_order==6,"bad order");
-      double sinThetaSq=sinTheta*sinTheta;
-      // cos(6x) = 1 - 32*sin^6(x) + 48*sin^4(x) - 18*sin^2(x)
+      TorsionAngleBatch *batch=getContribBatch<TorsionAngleBatch>(batches,batchIdx);
+      return batch->addContrib(d_at1Idx,d_at2Idx,d_at3Idx,d_at4Idx,
+                               d_order,d_forceConstant,d_cosTerm);
+    }
+
+    unsigned int TorsionAngleBatch::addContrib(unsigned int idx1,unsigned int idx2,
+                                               unsigned int idx3,unsigned int idx4,
+                                               unsigned int order,double forceConstant,
+                                               double cosTerm){
+      d_gradPoints.push_back(idx1);
+      d_gradPoints.push_back(idx2);
+      d_gradPoints.push_back(idx3);
+      d_gradPoints.push_back(idx4);
+      d_orders.push_back(order);
+      d_forceConstants.push_back(forceConstant);
+      d_cosTerms.push_back(cosTerm);
+      return d_orders.size()-1;
+    }
 
-      double res=0.0;
-      switch(this->d_order){
-      case 2:
-        res = 2*sinTheta*cosTheta;
-        break;
-      case 3:
-        // sin(3*x) = 3*sin(x) - 4*sin^3(x)
-        res = sinTheta*(3-4*sinThetaSq);
-        break;
-      case 6:
-        // sin(6x) = cos(x) * [ 32*sin^5(x) - 32*sin^3(x) + 6*sin(x) ]
-        res = cosTheta*sinTheta * (32*sinThetaSq * (sinThetaSq-1) + 6);
-        break;
+    void TorsionAngleBatch::calcEnergies(const double *pos,double *energies) const {
+      const unsigned int *idx=&d_gradPoints.front();
+      unsigned int n=d_orders.size();
+      for(unsigned int i=0;i<n;++i){
+        energies[i]=torsionEnergy(&pos[3*idx[4*i]],&pos[3*idx[4*i+1]],
+                                  &pos[3*idx[4*i+2]],&pos[3*idx[4*i+3]],
+                                  d_orders[i],d_forceConstants[i],d_cosTerms[i]);
       }
-      res *= this->d_forceConstant/2.0 * this->d_cosTerm * -1 * this->d_order;
+    }
 
-      return res;
+    void TorsionAngleBatch::calcGradTerms(const double *pos,double *terms) const {
+      const unsigned int *idx=&d_gradPoints.front();
+      unsigned int n=d_orders.size();
+      for(unsigned int i=0;i<n;++i){
+        torsionGrad(&pos[3*idx[4*i]],&pos[3*idx[4*i+1]],
+                    &pos[3*idx[4*i+2]],&pos[3*idx[4*i+3]],
+                    d_orders[i],d_forceConstants[i],d_cosTerms[i],
+                    &terms[12*i],&terms[12*i+3],&terms[12*i+6],&terms[12*i+9]);
+      }
     }
   }
 }
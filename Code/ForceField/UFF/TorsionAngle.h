@@ -67,15 +67,15 @@ namespace ForceFields {
 			  bool endAtomIsSP2=false);
       double getEnergy(double *pos) const;
       void getGrad(double *pos,double *grad) const;
+      virtual TorsionAngleContrib *copy() const { return new TorsionAngleContrib(*this); };
       void scaleForceConstant(unsigned int count) { this->d_forceConstant /= static_cast<double>(count); };
+
+      int addToBatch(ContribBatchPtrVect &batches,unsigned int &batchIdx) const;
     private:
       int d_at1Idx,d_at2Idx,d_at3Idx,d_at4Idx;
       unsigned int d_order;
       double d_forceConstant,d_cosTerm;
 
-      //! returns dE/dTheta
-      double getThetaDeriv(double cosTheta,double sinTheta) const;
-
       //! calculate default values of the torsion parameters.
       /*!
 	 see the constructor for an explanation of the arguments
@@ -90,6 +90,21 @@ namespace ForceFields {
 
     };
 
+    //! a batch of TorsionAngleContribs
+    class TorsionAngleBatch : public ContribBatch {
+    public:
+      TorsionAngleBatch() : ContribBatch(4) {};
+      //! adds a torsion, returns its index in the batch
+      unsigned int addContrib(unsigned int idx1,unsigned int idx2,
+                              unsigned int idx3,unsigned int idx4,
+                              unsigned int order,double forceConstant,double cosTerm);
+      void calcEnergies(const double *pos,double *energies) const;
+      void calcGradTerms(const double *pos,double *terms) const;
+    private:
+      std::vector<unsigned int> d_orders;
+      std::vector<double> d_forceConstants,d_cosTerms;
+    };
+
     namespace Utils {
       //! calculates and returns the cosine of a torsion angle
       double calculateCosTorsion(const RDGeom::Point3D &p1,const RDGeom::Point3D &p2,
@@ -1265,6 +1265,122 @@ void testUFFDistanceConstraints(){
   std::cerr << "  done" << std::endl;
 }
 
+void testUFFNonbondedList(){
+  std::cerr << "-------------------------------------" << std::endl;
+  std::cerr << "Unit tests for UFF neighbor-list nonbonded terms." << std::endl;
+
+  ForceFields::UFF::ParamCollection *params=ForceFields::UFF::ParamCollection::getParams();
+  const ForceFields::UFF::AtomicParams *param1=(*params)("C_3");
+  TEST_ASSERT(param1);
+
+  // a lattice of points, the list terms are compared to the sum
+  // of the individual terms:
+  std::vector<Point3D> pts;
+  for(unsigned int i=0;i<4;++i){
+    for(unsigned int j=0;j<4;++j){
+      for(unsigned int k=0;k<4;++k){
+        pts.push_back(Point3D(3.0*i+0.1*j,3.2*j+0.1*k,3.4*k+0.1*i));
+      }
+    }
+  }
+  unsigned int nPts=pts.size();
+  ForceFields::ForceField ff,refFF;
+  for(unsigned int i=0;i<nPts;++i){
+    ff.positions().push_back(&pts[i]);
+    refFF.positions().push_back(&pts[i]);
+  }
+  std::vector<const ForceFields::UFF::AtomicParams *> atParams(nPts,param1);
+  // the last point doesn't interact at all:
+  atParams[nPts-1]=0;
+
+  double cutoff=7.0;
+  ForceFields::UFF::vdWListContrib *listContrib;
+  listContrib=new ForceFields::UFF::vdWListContrib(&ff,atParams,cutoff,1.0);
+  listContrib->addExclusion(1,0);
+  listContrib->addExclusion(5,6);
+  ff.contribs().push_back(ForceFields::ContribPtr(listContrib));
+  ff.initialize();
+
+  double threshMult=cutoff/ForceFields::UFF::Utils::calcNonbondedMinimum(param1,param1);
+  for(unsigned int i=0;i<nPts-1;++i){
+    for(unsigned int j=i+1;j<nPts-1;++j){
+      if((i==0 && j==1) || (i==5 && j==6)) continue;
+      ForceFields::ForceFieldContrib *contrib;
+      contrib = new ForceFields::UFF::vdWContrib(&refFF,i,j,param1,param1,threshMult);
+      refFF.contribs().push_back(ForceFields::ContribPtr(contrib));
+    }
+  }
+  refFF.initialize();
+
+  double *pos=new double[3*nPts];
+  double *grad=new double[3*nPts];
+  double *refGrad=new double[3*nPts];
+  for(unsigned int iter=0;iter<3;++iter){
+    for(unsigned int i=0;i<nPts;++i){
+      pos[3*i]=pts[i].x;
+      pos[3*i+1]=pts[i].y;
+      pos[3*i+2]=pts[i].z;
+    }
+    for(unsigned int i=0;i<3*nPts;++i){
+      grad[i]=0.0;
+      refGrad[i]=0.0;
+    }
+    double e=ff.calcEnergy(pos);
+    double refE=refFF.calcEnergy(pos);
+    TEST_ASSERT(RDKit::feq(e,refE,1e-8));
+    ff.calcGrad(pos,grad);
+    refFF.calcGrad(pos,refGrad);
+    for(unsigned int i=0;i<3*nPts;++i){
+      TEST_ASSERT(RDKit::feq(grad[i],refGrad[i],1e-8));
+    }
+    TEST_ASSERT(listContrib->numNeighbors()>0);
+    TEST_ASSERT(listContrib->numNeighbors()<refFF.contribs().size());
+
+    if(iter==0){
+      // a small move doesn't require a new list:
+      TEST_ASSERT(listContrib->numBuilds()==1);
+      pts[10].x+=0.3;
+    } else if(iter==1){
+      TEST_ASSERT(listContrib->numBuilds()==1);
+      // but a larger one does:
+      pts[20].y+=2.5;
+      pts[30].z-=1.5;
+    } else {
+      TEST_ASSERT(listContrib->numBuilds()==2);
+    }
+  }
+  // points in different fragments don't interact:
+  std::vector<int> fragIds(nPts,0);
+  fragIds[2]=1;
+  listContrib->setFragments(fragIds);
+  double e=ff.calcEnergy();
+  for(unsigned int i=0;i<nPts-1;++i){
+    if(i==2) continue;
+    ForceFields::UFF::vdWContrib contrib(&refFF,i,2,param1,param1,threshMult);
+    e += contrib.getEnergy(pos);
+  }
+  TEST_ASSERT(RDKit::feq(e,refFF.calcEnergy(),1e-8));
+  listContrib->setFragments(std::vector<int>());
+
+  // and a bit of minimization, the neighbor list needs to be updated
+  // as things move:
+  e=ff.calcEnergy();
+  ff.minimize(200,1e-4,1e-6);
+  TEST_ASSERT(ff.calcEnergy()<e);
+  TEST_ASSERT(listContrib->numBuilds()>3);
+  for(unsigned int i=0;i<nPts;++i){
+    pos[3*i]=pts[i].x;
+    pos[3*i+1]=pts[i].y;
+    pos[3*i+2]=pts[i].z;
+  }
+  TEST_ASSERT(RDKit::feq(ff.calcEnergy(pos),refFF.calcEnergy(pos),1e-8));
+
+  delete [] pos;
+  delete [] grad;
+  delete [] refGrad;
+  std::cerr << "  done" << std::endl;
+}
+
 int main(){
 #if 1
   test1();
@@ -1281,4 +1397,5 @@ int main(){
   
 #endif
   testUFFDistanceConstraints();
+  testUFFNonbondedList();
 }
@@ -196,7 +196,7 @@ namespace RDKit{
         // Three other neighbors:
         // --------------------------------------------------------------------------
         boost::tie(nbrIdx,endNbrs) = mol->getAtomNeighbors(heavyAtom);
-        if(heavyAtom->hasProp("_CIPCode")){
+        if(heavyAtom->hasProp(common_properties::_CIPCode)){
           // if the central atom is chiral, we'll order the neighbors
           // by CIP rank:
           std::vector< std::pair<int,int> >  nbrs;
@@ -204,8 +204,8 @@ namespace RDKit{
             if(*nbrIdx != hydIdx){
               const Atom *tAtom=mol->getAtomWithIdx(*nbrIdx);
               int cip=0;
-              if(tAtom->hasProp("_CIPRank")){
-                tAtom->getProp("_CIPRank",cip);
+              if(tAtom->hasProp(common_properties::_CIPRank)){
+                tAtom->getProp(common_properties::_CIPRank,cip);
               }
               nbrs.push_back(std::make_pair(cip,*nbrIdx));
             }
@@ -246,7 +246,7 @@ namespace RDKit{
           if(fabs(nbr3Vect.dotProduct(nbr1Vect.crossProduct(nbr2Vect)))<0.1){
             // compute the normal:
             dirVect = nbr1Vect.crossProduct(nbr2Vect);
-            if(heavyAtom->hasProp("_CIPCode")){
+            if(heavyAtom->hasProp(common_properties::_CIPCode)){
               // the heavy atom is a chiral center, make sure
               // that we went go the right direction to preserve
               // its chirality. We use the chiral volume for this:
@@ -255,7 +255,7 @@ namespace RDKit{
               RDGeom::Point3D v3=nbr2Vect-nbr3Vect;
               double vol = v1.dotProduct(v2.crossProduct(v3));
               std::string cipCode;
-              heavyAtom->getProp("_CIPCode", cipCode);
+              heavyAtom->getProp(common_properties::_CIPCode, cipCode);
               if( (cipCode=="S" && vol<0) || (cipCode=="R" && vol>0) ){
                 dirVect*=-1;
               }
@@ -334,12 +334,12 @@ namespace RDKit{
             res->addBond((*at)->getIdx(),newIdx,Bond::SINGLE);
             // set the isImplicit label so that we can strip these back
             // off later if need be.
-            res->getAtomWithIdx(newIdx)->setProp("isImplicit",1, true);
+            res->getAtomWithIdx(newIdx)->setProp(common_properties::isImplicit,1, true);
             res->getAtomWithIdx(newIdx)->updatePropertyCache();
             if(addCoords) setHydrogenCoords(res,newIdx,(*at)->getIdx());
           }
           // be very clear about implicits not being allowed in this representation
-          newAt->setProp("origNoImplicit",(*at)->getNoImplicit(), true);
+          newAt->setProp(common_properties::origNoImplicit,(*at)->getNoImplicit(), true);
           newAt->setNoImplicit(true);
         }
         // update the atom's derived properties (valence count, etc.)
@@ -372,7 +372,7 @@ namespace RDKit{
         if(atom->getAtomicNum()==1){
           bool removeIt=false;
 
-          if(atom->hasProp("isImplicit")){
+          if(atom->hasProp(common_properties::isImplicit)){
             removeIt=true;
           } else if(!implicitOnly && !atom->getIsotope() && atom->getDegree()==1){
             ROMol::ADJ_ITER begin,end;
@@ -440,14 +440,14 @@ namespace RDKit{
         } else {
           // only increment the atom idx if we don't remove the atom
           currIdx++;
-          if(atom->hasProp("origNoImplicit")){
+          if(atom->hasProp(common_properties::origNoImplicit)){
             // we'll get in here if we haven't already processed the atom's implicit
             //  hydrogens. (this is protection for the case that removeHs() is called
             //  multiple times on a single molecule without intervening addHs() calls)
             bool tmpBool;
-            atom->getProp("origNoImplicit",tmpBool);    
+            atom->getProp(common_properties::origNoImplicit,tmpBool);    
             atom->setNoImplicit(tmpBool);
-            atom->clearProp("origNoImplicit");
+            atom->clearProp(common_properties::origNoImplicit);
           }
         }
       }
@@ -468,7 +468,7 @@ namespace RDKit{
 
         }
 #if 0 // the fix to github issue 8 makes this redundant
-        if(mol.hasProp("_StereochemDone")){
+        if(mol.hasProp(common_properties::_StereochemDone)){
           // stereochem had been perceived in the original molecule,
           // loop over the bonds and fix their stereoAtoms fields:
           for(ROMol::BondIterator bondIt=res->beginBonds();
@@ -610,7 +610,7 @@ namespace RDKit {
     
       // first find the all the simple rings in the molecule
       VECT_INT_VECT srings;
-      if(mol.getRingInfo()->isInitialized()){
+      if(mol.getRingInfo()->getPerceptionType()==RingInfo::SSSR){
         srings = mol.getRingInfo()->atomRings();
       } else {
         MolOps::symmetrizeSSSR(mol, srings);
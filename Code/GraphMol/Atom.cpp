@@ -64,7 +64,7 @@ Atom::Atom( const Atom & other){
   } else {
     dp_props = new Dict();
     STR_VECT computed;
-    dp_props->setVal("__computedProps", computed);
+    dp_props->setVal(common_properties::__computedProps, computed);
   }
 }
 void Atom::initAtom(){
@@ -124,10 +124,10 @@ void Atom::setOwningMol(ROMol *other)
 std::string Atom::getSymbol() const {
   std::string res;
   // handle dummies differently:
-  if(d_atomicNum != 0 || !hasProp("dummyLabel") ){
+  if(d_atomicNum != 0 || !hasProp(common_properties::dummyLabel) ){
     res = PeriodicTable::getTable()->getElementSymbol(d_atomicNum);
   } else {
-    getProp("dummyLabel",res);
+    getProp(common_properties::dummyLabel,res);
   }
   return res;
 }
@@ -412,6 +412,16 @@ void Atom::setIsotope(unsigned int what){
   } else {
     d_mass = PeriodicTable::getTable()->getAtomicWeight(d_atomicNum);
   }
+  updateOwningMolVersion();
+}
+
+void Atom::updateOwningMolVersion(){
+  // atoms can hang on to a molecule they are no longer part of, only
+  // change the version if we really belong to it:
+  if(dp_mol && d_index<dp_mol->getNumAtoms() &&
+     dp_mol->getAtomWithIdx(d_index)==this){
+    dp_mol->updateStructureVersion();
+  }
 }
 
 void Atom::setQuery(Atom::QUERYATOM_QUERY *what) {
@@ -110,7 +110,7 @@ namespace RDKit{
     //! returns our atomic number
     int getAtomicNum() const { return d_atomicNum; };
     //! sets our atomic number
-    void setAtomicNum(int newNum) { d_atomicNum = newNum; };
+    void setAtomicNum(int newNum) { d_atomicNum = newNum; updateOwningMolVersion(); };
 
     //! returns our symbol (determined by our atomic number)
     std::string getSymbol() const;
@@ -175,27 +175,27 @@ namespace RDKit{
         - requires an owning molecule
     */
     unsigned int getNumRadicalElectrons() const { return d_numRadicalElectrons; };
-    void setNumRadicalElectrons(unsigned int num) { d_numRadicalElectrons=num; };
+    void setNumRadicalElectrons(unsigned int num) { d_numRadicalElectrons=num; updateOwningMolVersion(); };
 
 
     //! returns the formal charge of this atom
     int getFormalCharge() const { return d_formalCharge; };
     //! set's the formal charge of this atom
-    void setFormalCharge(int what) { d_formalCharge = what;} ;
+    void setFormalCharge(int what) { d_formalCharge = what; updateOwningMolVersion(); };
 
     //! \brief sets our \c noImplicit flag, indicating whether or not
     //!  we are allowed to have implicit Hs
-    void setNoImplicit( bool what ) { df_noImplicit = what; };
+    void setNoImplicit( bool what ) { df_noImplicit = what; updateOwningMolVersion(); };
     //! returns the \c noImplicit flag
     bool getNoImplicit() const { return df_noImplicit; };
     
     //! sets our number of explict Hs
-    void setNumExplicitHs(unsigned int what) { d_numExplicitHs = what; };
+    void setNumExplicitHs(unsigned int what) { d_numExplicitHs = what; updateOwningMolVersion(); };
     //! returns our number of explict Hs
     unsigned int getNumExplicitHs() const { return d_numExplicitHs; };
   
     //! sets our \c isAromatic flag, indicating whether or not we are aromatic
-    void setIsAromatic( bool what ) { df_isAromatic = what; };
+    void setIsAromatic( bool what ) { df_isAromatic = what; updateOwningMolVersion(); };
     //! returns our \c isAromatic flag
     bool getIsAromatic() const { return df_isAromatic; };
 
@@ -228,7 +228,7 @@ namespace RDKit{
     void clearDativeFlag(){ d_dativeFlag = 0; };
 
     //! sets our \c chiralTag
-    void setChiralTag(ChiralType what) { d_chiralTag = what; };
+    void setChiralTag(ChiralType what) { d_chiralTag = what; updateOwningMolVersion(); };
     //! inverts our \c chiralTag
     void invertChirality();
     //! returns our \c chiralTag
@@ -313,24 +313,28 @@ namespace RDKit{
      */
     template <typename T>
     void setProp(const char *key, T val, bool computed=false) const{
-    
-      //if(!dp_props) dp_props = new Dict();
-      std::string what(key);
-      setProp(what,val, computed);
+      setProp(getPropKey(key),val,computed);
     }
-
     //! \overload
     template <typename T>
     void setProp(const std::string key, T val, bool computed=false) const {
+      setProp(getPropKey(key),val,computed);
+    }
+    //! \overload
+    template <typename T>
+    void setProp(PropKey key, T val, bool computed=false) const {
       if (computed) {
-	STR_VECT compLst;
-	if(hasProp("__computedProps")) getProp("__computedProps", compLst);
-	if (std::find(compLst.begin(), compLst.end(), key) == compLst.end()) {
-	  compLst.push_back(key);
-	  dp_props->setVal("__computedProps", compLst);
-	}
+        STR_VECT *compLst=dp_props->getValPtr<STR_VECT>(common_properties::__computedProps);
+        if (!compLst) {
+          STR_VECT tmp;
+          dp_props->setVal(common_properties::__computedProps, tmp);
+          compLst=dp_props->getValPtr<STR_VECT>(common_properties::__computedProps);
+        }
+        const std::string &name=key.getName();
+        if (std::find(compLst->begin(), compLst->end(), name) == compLst->end()) {
+          compLst->push_back(name);
+        }
       }
-      //setProp(key.c_str(),val);
       dp_props->setVal(key, val);
     }
 
@@ -339,46 +343,65 @@ namespace RDKit{
 
        \param key the name under which the \c property should be stored.
            If a \c property is already stored under this name, it will be
-	   replaced.
+           replaced.
        \param res a reference to the storage location for the value.
 
        <b>Notes:</b>
          - if no \c property with name \c key exists, a KeyErrorException will be thrown.
-	 - the \c boost::lexical_cast machinery is used to attempt type conversions.
-	   If this fails, a \c boost::bad_lexical_cast exception will be thrown.
+         - the \c boost::lexical_cast machinery is used to attempt type conversions.
+           If this fails, a \c boost::bad_lexical_cast exception will be thrown.
 
     */
     template <typename T>
     void getProp(const char *key,T &res) const {
-      //PRECONDITION(dp_props,"getProp called on empty property dict");
       dp_props->getVal(key,res);
     }
     //! \overload
     template <typename T>
     void getProp(const std::string key,T &res) const {
-      //return getProp(key.c_str(),res);
       dp_props->getVal(key,res);
     }
+    //! \overload
+    template <typename T>
+    void getProp(PropKey key,T &res) const {
+      dp_props->getVal(key,res);
+    }
+
+    //! retrieves a property value if we have it
+    /*!
+       This is faster than calling hasProp() and then getProp().
+
+       \return whether or not we have a \c property with name \c key
+    */
+    template <typename T>
+    bool getPropIfPresent(PropKey key,T &res) const {
+      if (!dp_props) return false;
+      return dp_props->getValIfPresent(key,res);
+    }
 
     //! returns whether or not we have a \c property with name \c key
     bool hasProp(const char *key) const {
-      if(!dp_props) return false;
+      if (!dp_props) return false;
       return dp_props->hasVal(key);
     };
     //! \overload
     bool hasProp(const std::string key) const {
-      if(!dp_props) return false;
+      if (!dp_props) return false;
+      return dp_props->hasVal(key);
+    };
+    //! \overload
+    bool hasProp(PropKey key) const {
+      if (!dp_props) return false;
       return dp_props->hasVal(key);
     };
 
-    
     //! clears the value of a \c property
     /*!
        <b>Notes:</b>
          - if no \c property with name \c key exists, a KeyErrorException
-	   will be thrown.
-	 - if the \c property is marked as \c computed, it will also be removed
-	   from our list of \c computedProperties
+           will be thrown.
+         - if the \c property is marked as \c computed, it will also be removed
+           from our list of \c computedProperties
     */
     void clearProp(const char *key) const {
       std::string what(key);
@@ -386,28 +409,32 @@ namespace RDKit{
     };
     //! \overload
     void clearProp(const std::string key) const {
-      if(hasProp("__computedProps")){
-	STR_VECT compLst;
-	getProp("__computedProps", compLst);
-	STR_VECT_I svi = std::find(compLst.begin(), compLst.end(), key);
-	if (svi != compLst.end()) {
-	  compLst.erase(svi);
-	  dp_props->setVal("__computedProps", compLst);
-	}
-      }    
+      if (!dp_props->hasVal(key)) throw KeyErrorException(key);
+      clearProp(getPropKey(key));
+    };
+    //! \overload
+    void clearProp(PropKey key) const {
+      STR_VECT *compLst=dp_props->getValPtr<STR_VECT>(common_properties::__computedProps);
+      if (compLst) {
+        STR_VECT_I svi = std::find(compLst->begin(), compLst->end(), key.getName());
+        if (svi != compLst->end()) {
+          compLst->erase(svi);
+        }
+      }
       dp_props->clearVal(key);
     };
 
     //! clears all of our \c computed \c properties
     void clearComputedProps() const {
-      if(!hasProp("__computedProps")) return;
+      STR_VECT *compLstPtr=dp_props->getValPtr<STR_VECT>(common_properties::__computedProps);
+      if (!compLstPtr) return;
+      // empty the list before clearing the values, clearing them
+      // rearranges the Dict's storage:
       STR_VECT compLst;
-      getProp("__computedProps", compLst);
+      compLst.swap(*compLstPtr);
       BOOST_FOREACH(const std::string &sv,compLst){
-	dp_props->clearVal(sv);
+        dp_props->clearVal(sv);
       }
-      compLst.clear();
-      dp_props->setVal("__computedProps", compLst);
     }
 
     //! returns the perturbation order for a list of integers
@@ -463,6 +490,9 @@ namespace RDKit{
     void setOwningMol(ROMol *other);
     //! sets our owning molecule
     void setOwningMol(ROMol &other) {setOwningMol(&other);};
+    //! changes the structure version of our owning molecule, this is
+    //! called by the setters for everything that defines the structure
+    void updateOwningMolVersion();
 
     bool df_isAromatic; 
     bool df_noImplicit;
@@ -51,7 +51,8 @@ Bond::~Bond()
 }
 
 Bond &Bond::operator=(const Bond &other){
-  dp_mol = other.dp_mol;
+  // NOTE: as with the copy constructor, ownership is *not* copied
+  dp_mol = 0;
   d_bondType = other.d_bondType;
   d_beginAtomIdx = other.d_beginAtomIdx;
   d_endAtomIdx = other.d_endAtomIdx;
@@ -82,6 +83,13 @@ void Bond::setOwningMol(ROMol *other)
   dp_mol = other;
 }
 
+void Bond::updateOwningMolVersion(){
+  // this is called by setters in some of the hottest code we have, so
+  // there's no search for the bond here: copies of a bond don't have an
+  // owning molecule, so if dp_mol is set the bond belongs to it.
+  if(dp_mol) dp_mol->updateStructureVersion();
+}
+
 unsigned int Bond::getOtherAtomIdx(const unsigned int thisIdx) const
 {
   PRECONDITION(d_beginAtomIdx == thisIdx ||
@@ -15,6 +15,7 @@
 
 // Ours
 // FIX: grn...
+#include <boost/foreach.hpp>
 #include <Query/QueryObjects.h>
 #include <RDGeneral/types.h>
 
@@ -44,6 +45,7 @@ namespace RDKit{
   class Bond {
     friend class RWMol;
     friend class ROMol;
+    friend class MolPickler; //!< the pickler needs access to our privates
   public:
     typedef boost::shared_ptr<Bond>    BOND_SPTR;
     // FIX: grn...
@@ -101,6 +103,7 @@ namespace RDKit{
     explicit Bond(BondType bT);
     Bond(const Bond &other);
     virtual ~Bond();
+    //! the owning molecule is not copied, the same as with the copy constructor
     Bond &operator=(const Bond &other);
 
     //! returns a copy
@@ -113,7 +116,7 @@ namespace RDKit{
     //! returns our \c bondType
     BondType getBondType() const { return d_bondType; };
     //! sets our \c bondType
-    void setBondType(BondType bT) { d_bondType = bT; };
+    void setBondType(BondType bT) { d_bondType = bT; updateOwningMolVersion(); };
     //! \brief returns our \c bondType as a double
     //!   (e.g. SINGLE->1.0, AROMATIC->1.5, etc.)
     double getBondTypeAsDouble() const;
@@ -128,7 +131,7 @@ namespace RDKit{
     double getValenceContrib(ATOM_SPTR at) const;
 
     //! sets our \c isAromatic flag
-    void setIsAromatic( bool what ) { df_isAromatic = what; };
+    void setIsAromatic( bool what ) { df_isAromatic = what; updateOwningMolVersion(); };
     //! returns the status of our \c isAromatic flag
     bool getIsAromatic() const { return df_isAromatic; };
 
@@ -261,12 +264,12 @@ namespace RDKit{
     virtual bool Match(const Bond::BOND_SPTR what) const;
   
     //! sets our direction
-    void setBondDir(BondDir what) { d_dirTag = what; };
+    void setBondDir(BondDir what) { d_dirTag = what; updateOwningMolVersion(); };
     //! returns our direction
     BondDir getBondDir() const { return d_dirTag; };
   
     //! sets our stereo code
-    void setStereo(BondStereo what) { d_stereo = what; };
+    void setStereo(BondStereo what) { d_stereo = what; updateOwningMolVersion(); };
     //! returns our stereo code
     BondStereo getStereo() const { return d_stereo; };
 
@@ -294,24 +297,30 @@ namespace RDKit{
            \c computed.
      */
     template <typename T>
-    void setProp(const char *key,T val, bool computed=false) const{
-      //if(!dp_props) dp_props = new Dict();
-      std::string what(key);
-      setProp(what,val, computed);
+    void setProp(const char *key, T val, bool computed=false) const{
+      setProp(getPropKey(key),val,computed);
+    }
+    //! \overload
+    template <typename T>
+    void setProp(const std::string key, T val, bool computed=false) const {
+      setProp(getPropKey(key),val,computed);
     }
     //! \overload
     template <typename T>
-    void setProp(const std::string key,T val, bool computed=false ) const{
-      //setProp(key.c_str(),val);
+    void setProp(PropKey key, T val, bool computed=false) const {
       if (computed) {
-	STR_VECT compLst;
-	if(hasProp("__computedProps")) getProp("__computedProps", compLst);
-	if (std::find(compLst.begin(), compLst.end(), key) == compLst.end()) {
-	  compLst.push_back(key);
-	  dp_props->setVal("__computedProps", compLst);
-	}
+        STR_VECT *compLst=dp_props->getValPtr<STR_VECT>(common_properties::__computedProps);
+        if (!compLst) {
+          STR_VECT tmp;
+          dp_props->setVal(common_properties::__computedProps, tmp);
+          compLst=dp_props->getValPtr<STR_VECT>(common_properties::__computedProps);
+        }
+        const std::string &name=key.getName();
+        if (std::find(compLst->begin(), compLst->end(), name) == compLst->end()) {
+          compLst->push_back(name);
+        }
       }
-      dp_props->setVal(key,val);
+      dp_props->setVal(key, val);
     }
 
     //! allows retrieval of a particular property value
@@ -319,13 +328,13 @@ namespace RDKit{
 
        \param key the name under which the \c property should be stored.
            If a \c property is already stored under this name, it will be
-	   replaced.
+           replaced.
        \param res a reference to the storage location for the value.
 
        <b>Notes:</b>
          - if no \c property with name \c key exists, a KeyErrorException will be thrown.
-	 - the \c boost::lexical_cast machinery is used to attempt type conversions.
-	   If this fails, a \c boost::bad_lexical_cast exception will be thrown.
+         - the \c boost::lexical_cast machinery is used to attempt type conversions.
+           If this fails, a \c boost::bad_lexical_cast exception will be thrown.
 
     */
     template <typename T>
@@ -338,17 +347,39 @@ namespace RDKit{
     void getProp(const std::string key,T &res) const {
       PRECONDITION(dp_props,"getProp called on empty property dict");
       dp_props->getVal(key,res);
-    
+    }
+    //! \overload
+    template <typename T>
+    void getProp(PropKey key,T &res) const {
+      PRECONDITION(dp_props,"getProp called on empty property dict");
+      dp_props->getVal(key,res);
+    }
+
+    //! retrieves a property value if we have it
+    /*!
+       This is faster than calling hasProp() and then getProp().
+
+       \return whether or not we have a \c property with name \c key
+    */
+    template <typename T>
+    bool getPropIfPresent(PropKey key,T &res) const {
+      if (!dp_props) return false;
+      return dp_props->getValIfPresent(key,res);
     }
 
     //! returns whether or not we have a \c property with name \c key
     bool hasProp(const char *key) const {
-      if(!dp_props) return false;
+      if (!dp_props) return false;
       return dp_props->hasVal(key);
     };
     //! \overload
     bool hasProp(const std::string key) const {
-      if(!dp_props) return false;
+      if (!dp_props) return false;
+      return dp_props->hasVal(key);
+    };
+    //! \overload
+    bool hasProp(PropKey key) const {
+      if (!dp_props) return false;
       return dp_props->hasVal(key);
     };
 
@@ -356,9 +387,9 @@ namespace RDKit{
     /*!
        <b>Notes:</b>
          - if no \c property with name \c key exists, a KeyErrorException
-	   will be thrown.
-	 - if the \c property is marked as \c computed, it will also be removed
-	   from our list of \c computedProperties
+           will be thrown.
+         - if the \c property is marked as \c computed, it will also be removed
+           from our list of \c computedProperties
     */
     void clearProp(const char *key) const {
       std::string what(key);
@@ -366,29 +397,32 @@ namespace RDKit{
     };
     //! \overload
     void clearProp(const std::string key) const {
-      if(hasProp("__computedProps")){
-	STR_VECT compLst;
-	getProp("__computedProps", compLst);
-	STR_VECT_I svi = std::find(compLst.begin(), compLst.end(), key);
-	if (svi != compLst.end()) {
-	  compLst.erase(svi);
-	  dp_props->setVal("__computedProps", compLst);
-	}
+      if (!dp_props->hasVal(key)) throw KeyErrorException(key);
+      clearProp(getPropKey(key));
+    };
+    //! \overload
+    void clearProp(PropKey key) const {
+      STR_VECT *compLst=dp_props->getValPtr<STR_VECT>(common_properties::__computedProps);
+      if (compLst) {
+        STR_VECT_I svi = std::find(compLst->begin(), compLst->end(), key.getName());
+        if (svi != compLst->end()) {
+          compLst->erase(svi);
+        }
       }
       dp_props->clearVal(key);
     };
 
     //! clears all of our \c computed \c properties
     void clearComputedProps() const {
-      if(!hasProp("__computedProps")) return;
+      STR_VECT *compLstPtr=dp_props->getValPtr<STR_VECT>(common_properties::__computedProps);
+      if (!compLstPtr) return;
+      // empty the list before clearing the values, clearing them
+      // rearranges the Dict's storage:
       STR_VECT compLst;
-      getProp("__computedProps", compLst);
-      STR_VECT_CI svi;
-      for (svi = compLst.begin(); svi != compLst.end(); svi++) {
-	dp_props->clearVal(*svi);
+      compLst.swap(*compLstPtr);
+      BOOST_FOREACH(const std::string &sv,compLst){
+        dp_props->clearVal(sv);
       }
-      compLst.clear();
-      dp_props->setVal("__computedProps", compLst);
     }
 
     //! calculates any of our lazy \c properties
@@ -403,6 +437,9 @@ namespace RDKit{
     //void setOwningMol(ROMol *other);
     //! sets our owning molecule
     //void setOwningMol(ROMol &other) {setOwningMol(&other);};
+    //! changes the structure version of our owning molecule, this is
+    //! called by the setters for everything that defines the structure
+    void updateOwningMolVersion();
     BondType d_bondType;
     ROMol *dp_mol;
     bool df_isAromatic;
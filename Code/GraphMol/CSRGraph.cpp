@@ -0,0 +1,63 @@
+// $Id$
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include "CSRGraph.h"
+#include <GraphMol/ROMol.h>
+#include <GraphMol/Atom.h>
+#include <GraphMol/Bond.h>
+#include <RDGeneral/Invariant.h>
+
+namespace RDKit{
+  void CSRGraph::initFromMol(const ROMol &mol){
+    unsigned int nAtoms=mol.getNumAtoms();
+    unsigned int nBonds=mol.getNumBonds();
+
+    d_offsets.resize(nAtoms+1);
+    d_nbrAtoms.resize(2*nBonds);
+    d_nbrBonds.resize(2*nBonds);
+    d_slotSources.resize(2*nBonds);
+    d_bondAtoms.resize(2*nBonds);
+    d_atoms.resize(nAtoms);
+    d_bonds.resize(nBonds);
+
+    ROMol::EDGE_ITER firstB,lastB;
+    boost::tie(firstB,lastB) = mol.getEdges();
+    while(firstB!=lastB){
+      const Bond *bond=mol[*firstB].get();
+      unsigned int bIdx=bond->getIdx();
+      CHECK_INVARIANT(bIdx<nBonds,"bad bond index");
+      d_bonds[bIdx]=bond;
+      d_bondAtoms[2*bIdx]=bond->getBeginAtomIdx();
+      d_bondAtoms[2*bIdx+1]=bond->getEndAtomIdx();
+      ++firstB;
+    }
+
+    // walk the atoms in order and pick up their bonds in the same order the
+    // BGL adjacency list hands them out:
+    unsigned int slot=0;
+    for(unsigned int i=0;i<nAtoms;++i){
+      const Atom *atom=mol.getAtomWithIdx(i);
+      d_atoms[i]=atom;
+      d_offsets[i]=slot;
+      ROMol::OEDGE_ITER beg,end;
+      boost::tie(beg,end) = mol.getAtomBonds(atom);
+      while(beg!=end){
+        unsigned int bIdx=mol[*beg]->getIdx();
+        d_nbrBonds[slot]=bIdx;
+        d_nbrAtoms[slot]=getOtherAtomIdx(bIdx,i);
+        d_slotSources[slot]=i;
+        ++slot;
+        ++beg;
+      }
+    }
+    d_offsets[nAtoms]=slot;
+    POSTCONDITION(slot==2*nBonds,"bad slot count");
+  }
+}
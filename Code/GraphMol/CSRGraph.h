@@ -0,0 +1,178 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+/*! \file CSRGraph.h
+
+  \brief Defines the \c CSRGraph class, a compact read-only view of a
+  molecule's topology.
+
+*/
+#ifndef __RD_CSRGRAPH_H__
+#define __RD_CSRGRAPH_H__
+
+#include <vector>
+#include <utility>
+#include <boost/iterator/counting_iterator.hpp>
+
+namespace RDKit{
+  class ROMol;
+  class Atom;
+  class Bond;
+
+  //! A frozen, compressed-sparse-row representation of a molecular graph
+  /*!
+    The neighbors of each atom (and the bonds connecting to them) are
+    stored in two contiguous arrays indexed through an offset table, so
+    walking the graph does not require touching the \c Atom or \c Bond
+    objects (or their reference counts) at all.
+
+    The neighbor ordering is identical to that of \c ROMol::getAtomBonds(),
+    so algorithms converted to use the CSRGraph produce the same results
+    as before.
+
+    The CSRGraph is normally not constructed directly; use
+    \c ROMol::getCSRGraph(), which builds it lazily and caches it on the
+    molecule.
+
+    <b>Notes:</b>
+      - the view is invalidated (and rebuilt on demand) when the topology
+        of the molecule is changed through the \c RWMol API.
+      - the class also provides the subset of the BGL graph interface
+        needed by the matching code in Substruct/vf2.hpp. Edge descriptors
+        are slots in the adjacency arrays, so each bond shows up twice:
+        once in the neighbor list of each of its atoms.
+  */
+  class CSRGraph {
+  public:
+    //! \cond TYPEDEFS
+    typedef std::vector<unsigned int> IDX_VECT;
+    typedef IDX_VECT::const_iterator IDX_ITER;
+    typedef std::pair<IDX_ITER,IDX_ITER> IDX_ITER_PAIR;
+
+    // BGL-style typedefs:
+    typedef unsigned int vertex_descriptor;
+    typedef unsigned int edge_descriptor;
+    typedef boost::counting_iterator<unsigned int> vertex_iterator;
+    typedef boost::counting_iterator<unsigned int> out_edge_iterator;
+    //! \endcond
+
+    CSRGraph() {};
+    //! construct from a molecule
+    explicit CSRGraph(const ROMol &mol) { initFromMol(mol); };
+
+    //! (re)initializes from a molecule
+    void initFromMol(const ROMol &mol);
+
+    //! \name Atoms
+    //@{
+    unsigned int getNumAtoms() const { return d_atoms.size(); };
+    //! returns the Atom with a particular index
+    const Atom *getAtom(unsigned int idx) const { return d_atoms[idx]; };
+    //! returns the number of neighbors of an atom
+    unsigned int getDegree(unsigned int idx) const {
+      return d_offsets[idx+1]-d_offsets[idx];
+    };
+    //! returns iterators over the indices of an atom's neighbors
+    IDX_ITER_PAIR getAtomNeighbors(unsigned int idx) const {
+      return std::make_pair(d_nbrAtoms.begin()+d_offsets[idx],
+                            d_nbrAtoms.begin()+d_offsets[idx+1]);
+    };
+    //! returns iterators over the indices of an atom's bonds
+    /*!
+      the bond at a given position is the one connecting the atom to the
+      neighbor at the same position in \c getAtomNeighbors()
+    */
+    IDX_ITER_PAIR getAtomBonds(unsigned int idx) const {
+      return std::make_pair(d_nbrBonds.begin()+d_offsets[idx],
+                            d_nbrBonds.begin()+d_offsets[idx+1]);
+    };
+    //@}
+
+    //! \name Bonds
+    //@{
+    unsigned int getNumBonds() const { return d_bonds.size(); };
+    //! returns the Bond with a particular index
+    const Bond *getBond(unsigned int idx) const { return d_bonds[idx]; };
+    unsigned int getBondBeginAtomIdx(unsigned int idx) const { return d_bondAtoms[2*idx]; };
+    unsigned int getBondEndAtomIdx(unsigned int idx) const { return d_bondAtoms[2*idx+1]; };
+    //! returns the index of the atom on the other end of a bond
+    unsigned int getOtherAtomIdx(unsigned int bondIdx,unsigned int atomIdx) const {
+      return d_bondAtoms[2*bondIdx]==atomIdx ? d_bondAtoms[2*bondIdx+1] : d_bondAtoms[2*bondIdx];
+    };
+    //! returns the index of the bond between two atoms, -1 if there isn't one
+    int getBondIdxBetweenAtoms(unsigned int idx1,unsigned int idx2) const {
+      for(unsigned int i=d_offsets[idx1];i<d_offsets[idx1+1];++i){
+        if(d_nbrAtoms[i]==idx2) return d_nbrBonds[i];
+      }
+      return -1;
+    }
+    //@}
+
+    //! \name Adjacency slots
+    //! these are used to provide the BGL interface
+    //@{
+    unsigned int getNumSlots() const { return d_nbrAtoms.size(); };
+    unsigned int getSlotBegin(unsigned int atomIdx) const { return d_offsets[atomIdx]; };
+    unsigned int getSlotEnd(unsigned int atomIdx) const { return d_offsets[atomIdx+1]; };
+    unsigned int getSlotSource(unsigned int slot) const { return d_slotSources[slot]; };
+    unsigned int getSlotTarget(unsigned int slot) const { return d_nbrAtoms[slot]; };
+    unsigned int getSlotBondIdx(unsigned int slot) const { return d_nbrBonds[slot]; };
+    //! returns the slot connecting two atoms, -1 if there isn't one
+    int getSlotBetweenAtoms(unsigned int idx1,unsigned int idx2) const {
+      for(unsigned int i=d_offsets[idx1];i<d_offsets[idx1+1];++i){
+        if(d_nbrAtoms[i]==idx2) return static_cast<int>(i);
+      }
+      return -1;
+    }
+    //@}
+
+  private:
+    IDX_VECT d_offsets;      // size nAtoms+1
+    IDX_VECT d_nbrAtoms;     // size 2*nBonds
+    IDX_VECT d_nbrBonds;     // size 2*nBonds
+    IDX_VECT d_slotSources;  // size 2*nBonds
+    IDX_VECT d_bondAtoms;    // size 2*nBonds: begin,end pairs
+    std::vector<const Atom *> d_atoms;
+    std::vector<const Bond *> d_bonds;
+  };
+
+  //! \name BGL interface
+  //! these are found by argument-dependent lookup
+  //@{
+  inline unsigned int num_vertices(const CSRGraph &g){
+    return g.getNumAtoms();
+  }
+  inline std::pair<CSRGraph::vertex_iterator,CSRGraph::vertex_iterator>
+  vertices(const CSRGraph &g){
+    return std::make_pair(CSRGraph::vertex_iterator(0),
+                          CSRGraph::vertex_iterator(g.getNumAtoms()));
+  }
+  inline unsigned int out_degree(CSRGraph::vertex_descriptor v,const CSRGraph &g){
+    return g.getDegree(v);
+  }
+  inline std::pair<CSRGraph::out_edge_iterator,CSRGraph::out_edge_iterator>
+  out_edges(CSRGraph::vertex_descriptor v,const CSRGraph &g){
+    return std::make_pair(CSRGraph::out_edge_iterator(g.getSlotBegin(v)),
+                          CSRGraph::out_edge_iterator(g.getSlotEnd(v)));
+  }
+  inline CSRGraph::vertex_descriptor source(CSRGraph::edge_descriptor e,const CSRGraph &g){
+    return g.getSlotSource(e);
+  }
+  inline CSRGraph::vertex_descriptor target(CSRGraph::edge_descriptor e,const CSRGraph &g){
+    return g.getSlotTarget(e);
+  }
+  inline std::pair<CSRGraph::edge_descriptor,bool>
+  edge(CSRGraph::vertex_descriptor u,CSRGraph::vertex_descriptor v,const CSRGraph &g){
+    int slot=g.getSlotBetweenAtoms(u,v);
+    if(slot<0) return std::make_pair(CSRGraph::edge_descriptor(0),false);
+    return std::make_pair(CSRGraph::edge_descriptor(slot),true);
+  }
+  //@}
+}
+#endif
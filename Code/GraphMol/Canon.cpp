@@ -339,7 +339,7 @@ namespace Canon {
         // Here we set the bond direction to be opposite the other one (since
         // both come after the atom connected to the double bond).
         Bond::BondDir otherDir;
-        if(!secondFromAtom2->hasProp("_TraversalRingClosureBond")){
+        if(!secondFromAtom2->hasProp(common_properties::_TraversalRingClosureBond)){
           otherDir = (firstFromAtom2->getBondDir()==Bond::ENDUPRIGHT) ? Bond::ENDDOWNRIGHT : Bond::ENDUPRIGHT;
         } else {
           // another one those irritating little reversal things due to
@@ -371,7 +371,7 @@ namespace Canon {
       if( bondVisitOrders[atom1ControllingBond->getIdx()] >
           atomVisitOrders[atom1->getIdx()]){
         if(bondDirCounts[atom1ControllingBond->getIdx()]==1){
-          if(!atom1ControllingBond->hasProp("_TraversalRingClosureBond") ){
+          if(!atom1ControllingBond->hasProp(common_properties::_TraversalRingClosureBond) ){
             //std::cerr<<"  switcheroo 1"<<std::endl;
             switchBondDir(atom1ControllingBond);
           }
@@ -546,8 +546,8 @@ namespace Canon {
         // -----
 
         // it might have some residual data from earlier calls, clean that up:
-        if(otherAtom->hasProp("_TraversalBondIndexOrder")){
-          otherAtom->clearProp("_TraversalBondIndexOrder");
+        if(otherAtom->hasProp(common_properties::_TraversalBondIndexOrder)){
+          otherAtom->clearProp(common_properties::_TraversalBondIndexOrder);
         }
 
         directTravList.push_back(bond->getIdx());
@@ -574,7 +574,7 @@ namespace Canon {
         cycles[possibleIdx].push_back(lowestRingIdx);
         ++lowestRingIdx;
 
-        bond->setProp("_TraversalRingClosureBond",lowestRingIdx);
+        bond->setProp(common_properties::_TraversalRingClosureBond,lowestRingIdx);
         molStack.push_back(MolStackElem(bond,
                                         atom->getIdx()));
         molStack.push_back(MolStackElem(lowestRingIdx));
@@ -828,16 +828,16 @@ namespace Canon {
     boost::dynamic_bitset<> ringStereoChemAdjusted(nAtoms);
     
     // make sure that we've done the stereo perception:
-    if(!mol.hasProp("_StereochemDone")){
+    if(!mol.hasProp(common_properties::_StereochemDone)){
       MolOps::assignStereochemistry(mol,false);
     }
 
     // we need ring information; make sure findSSSR has been called before
     // if not call now
-    if ( !mol.getRingInfo()->isInitialized() ) {
+    if ( mol.getRingInfo()->getPerceptionType()!=RingInfo::SSSR ) {
       MolOps::findSSSR(mol);
     }
-    mol.getAtomWithIdx(atomIdx)->setProp("_TraversalStartPoint",true);
+    mol.getAtomWithIdx(atomIdx)->setProp(common_properties::_TraversalStartPoint,true);
 
     VECT_INT_VECT atomRingClosures(nAtoms);
     std::vector<INT_LIST> atomTraversalBondOrder(nAtoms);
@@ -849,7 +849,7 @@ namespace Canon {
     // used later in SMILES generation:
     for(ROMol::AtomIterator atomIt=mol.beginAtoms();atomIt!=mol.endAtoms();++atomIt){
       if((*atomIt)->getChiralTag()!=Atom::CHI_UNSPECIFIED){
-        (*atomIt)->setProp("_TraversalBondIndexOrder",atomTraversalBondOrder[(*atomIt)->getIdx()]);
+        (*atomIt)->setProp(common_properties::_TraversalBondIndexOrder,atomTraversalBondOrder[(*atomIt)->getIdx()]);
       }
     }
 
@@ -894,13 +894,13 @@ namespace Canon {
         }
       }
       if(msI->type == MOL_STACK_ATOM &&
-         msI->obj.atom->hasProp("_ringStereoAtoms")){
+         msI->obj.atom->hasProp(common_properties::_ringStereoAtoms)){
         if(!ringStereoChemAdjusted[msI->obj.atom->getIdx()]){
           msI->obj.atom->setChiralTag(Atom::CHI_TETRAHEDRAL_CW);
           ringStereoChemAdjusted.set(msI->obj.atom->getIdx());
         }
         INT_VECT ringStereoAtoms;
-        msI->obj.atom->getProp("_ringStereoAtoms",ringStereoAtoms);
+        msI->obj.atom->getProp(common_properties::_ringStereoAtoms,ringStereoAtoms);
         BOOST_FOREACH(int nbrV,ringStereoAtoms){
           int nbrIdx=abs(nbrV)-1;
           if(!ringStereoChemAdjusted[nbrIdx] &&
@@ -284,7 +284,7 @@ namespace RDKit{
 
       // copy the ranks onto the atoms:
       for(int i=0;i<numAtoms;i++){
-        mol.getAtomWithIdx(i)->setProp("_CIPRank",ranks[i],1);
+        mol.getAtomWithIdx(i)->setProp(common_properties::_CIPRank,ranks[i],1);
       }
     }
    
@@ -385,8 +385,8 @@ namespace RDKit{
     bool atomIsCandidateForRingStereochem(const ROMol &mol,const Atom *atom){
       PRECONDITION(atom,"bad atom");
       bool res=false;
-      if(atom->hasProp("_ringStereochemCand")){
-        atom->getProp("_ringStereochemCand",res);
+      if(atom->hasProp(common_properties::_ringStereochemCand)){
+        atom->getProp(common_properties::_ringStereochemCand,res);
       } else {
         const RingInfo *ringInfo=mol.getRingInfo();
         if(ringInfo->isInitialized() &&
@@ -415,10 +415,10 @@ namespace RDKit{
             if(ringNbrs.size()==2) res=true;
             break;
           case 2:
-            if( nonRingNbrs[0]->hasProp("_CIPRank") &&
-                nonRingNbrs[1]->hasProp("_CIPRank") ){
-              nonRingNbrs[0]->getProp("_CIPRank",rank1);
-              nonRingNbrs[1]->getProp("_CIPRank",rank2);
+            if( nonRingNbrs[0]->hasProp(common_properties::_CIPRank) &&
+                nonRingNbrs[1]->hasProp(common_properties::_CIPRank) ){
+              nonRingNbrs[0]->getProp(common_properties::_CIPRank,rank1);
+              nonRingNbrs[1]->getProp(common_properties::_CIPRank,rank2);
               if(rank1==rank2){
                 res=false;
               } else {
@@ -430,7 +430,7 @@ namespace RDKit{
             res=false;
           }
         }
-        atom->setProp("_ringStereochemCand",res,1);
+        atom->setProp(common_properties::_ringStereochemCand,res,1);
       }
       return res;
     }
@@ -439,7 +439,7 @@ namespace RDKit{
     bool checkChiralAtomSpecialCases(ROMol &mol,const Atom *atom){
       PRECONDITION(atom,"bad atom");
 
-      if(!mol.getRingInfo()->isInitialized()){
+      if(mol.getRingInfo()->getPerceptionType()!=RingInfo::SSSR){
         VECT_INT_VECT sssrs;
         MolOps::symmetrizeSSSR(mol, sssrs);
       }
@@ -453,8 +453,8 @@ namespace RDKit{
         // check for another chiral tagged
         // atom without stereochem in this atom's rings:
         INT_VECT ringStereoAtoms(0);
-        if(atom->hasProp("_ringStereoAtoms")){
-          atom->getProp("_ringStereoAtoms",ringStereoAtoms);
+        if(atom->hasProp(common_properties::_ringStereoAtoms)){
+          atom->getProp(common_properties::_ringStereoAtoms,ringStereoAtoms);
         }
         const VECT_INT_VECT atomRings=ringInfo->atomRings();
         for(VECT_INT_VECT::const_iterator ringIt=atomRings.begin();
@@ -466,7 +466,7 @@ namespace RDKit{
               int same=1;
               if(*idxIt!=static_cast<int>(atom->getIdx()) &&
                  mol.getAtomWithIdx(*idxIt)->getChiralTag()!=Atom::CHI_UNSPECIFIED &&
-                 !mol.getAtomWithIdx(*idxIt)->hasProp("_CIPCode") &&
+                 !mol.getAtomWithIdx(*idxIt)->hasProp(common_properties::_CIPCode) &&
                  atomIsCandidateForRingStereochem(mol,mol.getAtomWithIdx(*idxIt)) ){
                 // we get to keep the stereochem specification on this atom:
                 if(mol.getAtomWithIdx(*idxIt)->getChiralTag()!=atom->getChiralTag()){
@@ -474,17 +474,17 @@ namespace RDKit{
                 }
                 ringStereoAtoms.push_back(same*(*idxIt+1));
                 INT_VECT oAtoms(0);
-                if(mol.getAtomWithIdx(*idxIt)->hasProp("_ringStereoAtoms")){
-                  mol.getAtomWithIdx(*idxIt)->getProp("_ringStereoAtoms",oAtoms);
+                if(mol.getAtomWithIdx(*idxIt)->hasProp(common_properties::_ringStereoAtoms)){
+                  mol.getAtomWithIdx(*idxIt)->getProp(common_properties::_ringStereoAtoms,oAtoms);
                 }
                 oAtoms.push_back(same*(atom->getIdx()+1));
-                mol.getAtomWithIdx(*idxIt)->setProp("_ringStereoAtoms",oAtoms,true);
+                mol.getAtomWithIdx(*idxIt)->setProp(common_properties::_ringStereoAtoms,oAtoms,true);
               }
             }
           }
         }
         if(ringStereoAtoms.size()){
-          atom->setProp("_ringStereoAtoms",ringStereoAtoms,true);
+          atom->setProp(common_properties::_ringStereoAtoms,ringStereoAtoms,true);
           return true;
         }
       }
@@ -568,7 +568,7 @@ namespace RDKit{
         // we understand:
         if(flagPossibleStereoCenters || (tag != Atom::CHI_UNSPECIFIED &&
                                          tag != Atom::CHI_OTHER) ){
-          if(atom->hasProp("_CIPCode")){
+          if(atom->hasProp(common_properties::_CIPCode)){
             continue;
           }
 
@@ -583,7 +583,7 @@ namespace RDKit{
             ++unassignedAtoms;
           }
           if(legalCenter && !hasDupes && flagPossibleStereoCenters){
-            atom->setProp("_ChiralityPossible",1);
+            atom->setProp(common_properties::_ChiralityPossible,1);
           }
 
           if( legalCenter && !hasDupes &&
@@ -620,7 +620,7 @@ namespace RDKit{
             std::string cipCode;
             if(tag==Atom::CHI_TETRAHEDRAL_CCW) cipCode="S";
             else cipCode="R";
-            atom->setProp("_CIPCode",cipCode,true);
+            atom->setProp(common_properties::_CIPCode,cipCode,true);
           }
         }
       }
@@ -744,9 +744,9 @@ namespace RDKit{
         invars[i] = ranks[i]*factor;
         const Atom *atom=mol.getAtomWithIdx(i);
         // Priority order: R > S > nothing
-        if(atom->hasProp("_CIPCode")){
+        if(atom->hasProp(common_properties::_CIPCode)){
           std::string cipCode;
-          atom->getProp("_CIPCode",cipCode);
+          atom->getProp(common_properties::_CIPCode,cipCode);
           if(cipCode=="S"){
             invars[i]+=10;
           } else if(cipCode=="R"){
@@ -770,7 +770,7 @@ namespace RDKit{
       iterateCIPRanks(mol,invars,ranks,true);
       // copy the ranks onto the atoms:
       for(unsigned int i=0;i<mol.getNumAtoms();i++){
-        mol.getAtomWithIdx(i)->setProp("_CIPRank",ranks[i],1);
+        mol.getAtomWithIdx(i)->setProp(common_properties::_CIPRank,ranks[i],1);
       }
 
 #ifdef VERBOSE_CANON
@@ -794,13 +794,13 @@ namespace RDKit{
              repeat the above steps as necessary
      */
     void assignStereochemistry(ROMol &mol,bool cleanIt,bool force,bool flagPossibleStereoCenters){
-      if(!force && mol.hasProp("_StereochemDone")){
+      if(!force && mol.hasProp(common_properties::_StereochemDone)){
         return;
       }
 
       // later we're going to need ring information, get it now if we don't
       // have it already:
-      if(!mol.getRingInfo()->isInitialized()){
+      if(mol.getRingInfo()->getPerceptionType()!=RingInfo::SSSR){
         MolOps::symmetrizeSSSR(mol);
       }
 
@@ -814,8 +814,8 @@ namespace RDKit{
       if(cleanIt){
         for(ROMol::AtomIterator atIt=mol.beginAtoms();
             atIt!=mol.endAtoms();++atIt){
-          if((*atIt)->hasProp("_CIPCode")){
-            (*atIt)->clearProp("_CIPCode");
+          if((*atIt)->hasProp(common_properties::_CIPCode)){
+            (*atIt)->clearProp(common_properties::_CIPCode);
           }
         }        
         for(ROMol::BondIterator bondIt=mol.beginBonds();
@@ -860,14 +860,14 @@ namespace RDKit{
       if(cleanIt){
         for(ROMol::AtomIterator atIt=mol.beginAtoms();
             atIt!=mol.endAtoms();++atIt){
-          if((*atIt)->hasProp("_ringStereochemCand")) (*atIt)->clearProp("_ringStereochemCand");
-          if((*atIt)->hasProp("_ringStereoAtoms")) (*atIt)->clearProp("_ringStereoAtoms");
+          if((*atIt)->hasProp(common_properties::_ringStereochemCand)) (*atIt)->clearProp(common_properties::_ringStereochemCand);
+          if((*atIt)->hasProp(common_properties::_ringStereoAtoms)) (*atIt)->clearProp(common_properties::_ringStereoAtoms);
         }
         for(ROMol::AtomIterator atIt=mol.beginAtoms();
             atIt!=mol.endAtoms();++atIt){
           Atom *atom=*atIt;
           if(atom->getChiralTag()!=Atom::CHI_UNSPECIFIED
-             && !atom->hasProp("_CIPCode") &&
+             && !atom->hasProp(common_properties::_CIPCode) &&
              !Chirality::checkChiralAtomSpecialCases(mol,atom) ){
             atom->setChiralTag(Atom::CHI_UNSPECIFIED);
             
@@ -886,7 +886,7 @@ namespace RDKit{
           }
         }        
       }
-      mol.setProp("_StereochemDone",1,true);
+      mol.setProp(common_properties::_StereochemDone,1,true);
 
 #if 0
       std::cerr<<"---\n";
@@ -1033,8 +1033,8 @@ namespace RDKit{
       // perceived, remove the flags that indicate
       // this... what we're about to do will require
       // that we go again.
-      if(mol.hasProp("_StereochemDone")){
-        mol.clearProp("_StereochemDone");
+      if(mol.hasProp(common_properties::_StereochemDone)){
+        mol.clearProp(common_properties::_StereochemDone);
       }
       
       for(ROMol::AtomIterator atomIt=mol.beginAtoms();atomIt!=mol.endAtoms();++atomIt){
@@ -1077,17 +1077,17 @@ namespace RDKit{
     }
 
     void removeStereochemistry(ROMol &mol){
-      if(mol.hasProp("_StereochemDone")){
-        mol.clearProp("_StereochemDone");
+      if(mol.hasProp(common_properties::_StereochemDone)){
+        mol.clearProp(common_properties::_StereochemDone);
       }
       for(ROMol::AtomIterator atIt=mol.beginAtoms();
           atIt!=mol.endAtoms();++atIt){
         (*atIt)->setChiralTag(Atom::CHI_UNSPECIFIED);
-        if((*atIt)->hasProp("_CIPCode")){
-          (*atIt)->clearProp("_CIPCode");
+        if((*atIt)->hasProp(common_properties::_CIPCode)){
+          (*atIt)->clearProp(common_properties::_CIPCode);
         }
-        if((*atIt)->hasProp("_CIPRank")){
-          (*atIt)->clearProp("_CIPRank");
+        if((*atIt)->hasProp(common_properties::_CIPRank)){
+          (*atIt)->clearProp(common_properties::_CIPRank);
         }
 
       }        
@@ -0,0 +1,289 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_CONFORMERARENA_H
+#define _RD_CONFORMERARENA_H
+
+#include <GraphMol/ROMol.h>
+#include <GraphMol/Conformer.h>
+#include <RDGeneral/Invariant.h>
+#include <RDBoost/Exceptions.h>
+#include <RDGeneral/StreamOps.h>
+#include <boost/cstdint.hpp>
+#include <vector>
+#include <string>
+#include <sstream>
+
+namespace RDKit {
+  const int ci_CONFORMERARENA_VERSION=0x0001; //!< version number to use in pickles
+
+  //! Compact storage for many conformers of a molecule
+  /*!
+    The coordinates of all conformers are stored in a single contiguous
+    block of \c numConformers*numAtoms*3 values of type \c T (\c float or
+    \c double), conformer \c i starts at \c getCoords(i). Conformers are
+    accessed by index in constant time and are only turned into Conformer
+    objects when getConformer() is called.
+
+    A float arena uses 12 bytes per atom position, compared to the
+    separately allocated RDGeom::Point3D objects used by Conformer. The
+    arena can be pickled, the coordinates are written and read as a
+    single block.
+
+    <b>Notes:</b>
+      - the arena is not attached to a molecule, changes to the arena
+        do not affect the molecule's conformers and vice versa.
+  */
+  template <typename T>
+  class ConformerArena {
+  public:
+    ConformerArena() : d_numAtoms(0) {};
+
+    //! construct an empty arena for conformers with \c numAtoms atoms
+    explicit ConformerArena(unsigned int numAtoms) : d_numAtoms(numAtoms) {};
+
+    //! construct an arena holding all of the conformers of a molecule
+    explicit ConformerArena(const ROMol &mol) : d_numAtoms(mol.getNumAtoms()) {
+      reserve(mol.getNumConformers());
+      for(ROMol::ConstConformerIterator ci=mol.beginConformers();
+          ci!=mol.endConformers();++ci){
+        addConformer(**ci);
+      }
+    };
+
+    //! construct from a pickle
+    explicit ConformerArena(const std::string &pkl) : d_numAtoms(0) {
+      initFromString(pkl);
+    };
+
+    //! returns the number of atoms in each conformer
+    unsigned int getNumAtoms() const { return d_numAtoms; };
+
+    //! returns the number of conformers
+    unsigned int getNumConformers() const { return d_confIds.size(); };
+
+    //! reserves space for \c numConfs conformers
+    void reserve(unsigned int numConfs) {
+      d_coords.reserve(3*static_cast<size_t>(numConfs)*d_numAtoms);
+      d_confIds.reserve(numConfs);
+      d_is3D.reserve(numConfs);
+    };
+
+    //! removes all conformers
+    void clear() {
+      d_coords.clear();
+      d_confIds.clear();
+      d_is3D.clear();
+    };
+
+    //! adds a copy of a conformer to the end of the arena
+    /*!
+      \return the index of the new conformer
+
+      If the number of conformers is known in advance, calling reserve()
+      first avoids reallocating the storage as the arena grows.
+    */
+    unsigned int addConformer(const Conformer &conf) {
+      PRECONDITION(conf.getNumAtoms()==d_numAtoms,"bad number of atoms in conformer");
+      const RDGeom::POINT3D_VECT &pts=conf.getPositions();
+      for(RDGeom::POINT3D_VECT_CI pti=pts.begin();pti!=pts.end();++pti){
+        d_coords.push_back(static_cast<T>(pti->x));
+        d_coords.push_back(static_cast<T>(pti->y));
+        d_coords.push_back(static_cast<T>(pti->z));
+      }
+      d_confIds.push_back(conf.getId());
+      d_is3D.push_back(conf.is3D());
+      return d_confIds.size()-1;
+    };
+
+    //! returns the ID of the conformer at an index
+    unsigned int getConformerId(unsigned int idx) const {
+      PRECONDITION(idx<d_confIds.size(),"bad conformer index");
+      return d_confIds[idx];
+    };
+
+    //! returns the index of the conformer with an ID, or -1 if it isn't present
+    int getConformerIndex(unsigned int confId) const {
+      // conformer IDs are usually their position:
+      if(confId<d_confIds.size() && d_confIds[confId]==confId) return confId;
+      for(unsigned int i=0;i<d_confIds.size();++i){
+        if(d_confIds[i]==confId) return i;
+      }
+      return -1;
+    };
+
+    //! returns whether or not the conformer at an index is 3D
+    bool is3D(unsigned int idx) const {
+      PRECONDITION(idx<d_is3D.size(),"bad conformer index");
+      return d_is3D[idx];
+    };
+
+    //! returns a pointer to the coordinates of the conformer at an index
+    const T *getCoords(unsigned int idx) const {
+      PRECONDITION(idx<d_confIds.size(),"bad conformer index");
+      return d_numAtoms ? &d_coords[3*static_cast<size_t>(idx)*d_numAtoms] : 0;
+    };
+    //! \overload
+    T *getCoords(unsigned int idx) {
+      PRECONDITION(idx<d_confIds.size(),"bad conformer index");
+      return d_numAtoms ? &d_coords[3*static_cast<size_t>(idx)*d_numAtoms] : 0;
+    };
+
+    //! returns the position of an atom in the conformer at an index
+    RDGeom::Point3D getAtomPos(unsigned int idx,unsigned int atomId) const {
+      PRECONDITION(atomId<d_numAtoms,"bad atom index");
+      const T *coords=getCoords(idx)+3*atomId;
+      return RDGeom::Point3D(coords[0],coords[1],coords[2]);
+    };
+
+    //! sets the position of an atom in the conformer at an index
+    void setAtomPos(unsigned int idx,unsigned int atomId,const RDGeom::Point3D &pos) {
+      PRECONDITION(atomId<d_numAtoms,"bad atom index");
+      T *coords=getCoords(idx)+3*atomId;
+      coords[0]=static_cast<T>(pos.x);
+      coords[1]=static_cast<T>(pos.y);
+      coords[2]=static_cast<T>(pos.z);
+    };
+
+    //! returns a new Conformer with the coordinates at an index
+    /*!
+      <b>Note:</b> the caller is responsible for \c delete'ing the result
+    */
+    Conformer *getConformer(unsigned int idx) const {
+      Conformer *res=new Conformer(d_numAtoms);
+      res->setId(getConformerId(idx));
+      res->set3D(is3D(idx));
+      const T *coords=getCoords(idx);
+      RDGeom::POINT3D_VECT &pts=res->getPositions();
+      for(unsigned int i=0;i<d_numAtoms;++i){
+        pts[i].x=coords[3*i];
+        pts[i].y=coords[3*i+1];
+        pts[i].z=coords[3*i+2];
+      }
+      return res;
+    };
+
+    //! adds all of the conformers in the arena to a molecule
+    /*!
+      The conformer IDs are preserved, any conformers already on the
+      molecule are left in place.
+    */
+    void addConformersToMol(ROMol &mol) const {
+      PRECONDITION(mol.getNumAtoms()==d_numAtoms,"bad number of atoms in molecule");
+      for(unsigned int i=0;i<d_confIds.size();++i){
+        mol.addConformer(getConformer(i),false);
+      }
+    };
+
+    //! returns the coordinate block
+    const std::vector<T> &getData() const { return d_coords; };
+
+    //! returns a binary string representation (pickle)
+    std::string toString() const {
+      std::stringstream ss(std::ios_base::binary|std::ios_base::out|std::ios_base::in);
+      boost::uint32_t tInt;
+      tInt=ci_CONFORMERARENA_VERSION;
+      streamWrite(ss,tInt);
+      tInt=sizeof(T);
+      streamWrite(ss,tInt);
+      tInt=d_numAtoms;
+      streamWrite(ss,tInt);
+      tInt=d_confIds.size();
+      streamWrite(ss,tInt);
+      for(unsigned int i=0;i<d_confIds.size();++i){
+        tInt=d_confIds[i];
+        streamWrite(ss,tInt);
+        char tChr=d_is3D[i];
+        streamWrite(ss,tChr);
+      }
+      if(d_coords.size()){
+        streamWriteArray(ss,&d_coords[0],d_coords.size());
+      }
+      return ss.str();
+    };
+
+    //! initializes from a pickle
+    void initFromString(const std::string &pkl) {
+      clear();
+      std::stringstream ss(std::ios_base::binary|std::ios_base::out|std::ios_base::in);
+      ss.write(pkl.c_str(),pkl.length());
+      boost::uint32_t vers;
+      streamRead(ss,vers);
+      if(vers!=static_cast<boost::uint32_t>(ci_CONFORMERARENA_VERSION)){
+        throw ValueErrorException("bad version in ConformerArena pickle");
+      }
+      boost::uint32_t valSize,nConfs,tInt;
+      streamRead(ss,valSize);
+      streamRead(ss,tInt);
+      d_numAtoms=tInt;
+      streamRead(ss,nConfs);
+      if(!ss.good()){
+        throw ValueErrorException("truncated ConformerArena pickle");
+      }
+      if(valSize!=sizeof(float) && valSize!=sizeof(double)){
+        throw ValueErrorException("unreadable format");
+      }
+      // make sure the counts are consistent with the length of the
+      // pickle before allocating anything:
+      size_t remaining=pkl.length()-4*sizeof(boost::uint32_t);
+      const size_t confSize=sizeof(boost::uint32_t)+sizeof(char);
+      if(nConfs>remaining/confSize){
+        throw ValueErrorException("truncated ConformerArena pickle");
+      }
+      remaining-=nConfs*confSize;
+      if(nConfs && d_numAtoms>remaining/(3*static_cast<size_t>(valSize)*nConfs)){
+        throw ValueErrorException("truncated ConformerArena pickle");
+      }
+      d_confIds.resize(nConfs);
+      d_is3D.resize(nConfs);
+      for(unsigned int i=0;i<nConfs;++i){
+        streamRead(ss,tInt);
+        d_confIds[i]=tInt;
+        char tChr;
+        streamRead(ss,tChr);
+        d_is3D[i]=tChr;
+      }
+      if(valSize==sizeof(float)){
+        readCoords<float>(ss);
+      } else {
+        readCoords<double>(ss);
+      }
+      if(!ss.good()){
+        throw ValueErrorException("truncated ConformerArena pickle");
+      }
+    };
+
+  private:
+    unsigned int d_numAtoms;
+    std::vector<T> d_coords;
+    std::vector<unsigned int> d_confIds;
+    std::vector<bool> d_is3D;
+
+    template <typename U>
+    void readCoords(std::istream &ss){
+      size_t nVals=3*static_cast<size_t>(d_numAtoms)*d_confIds.size();
+      d_coords.resize(nVals);
+      if(!nVals) return;
+      if(sizeof(U)==sizeof(T)){
+        streamReadArray(ss,reinterpret_cast<U *>(&d_coords[0]),nVals);
+      } else {
+        std::vector<U> tmp(nVals);
+        streamReadArray(ss,&tmp[0],nVals);
+        for(size_t i=0;i<nVals;++i){
+          d_coords[i]=static_cast<T>(tmp[i]);
+        }
+      }
+    };
+  };
+
+  typedef ConformerArena<float> FloatConformerArena;
+  typedef ConformerArena<double> DoubleConformerArena;
+}
+
+#endif
@@ -27,7 +27,12 @@
 #include <Numerics/Alignment/AlignPoints.h>
 #include <DistGeom/ChiralSet.h>
 #include <GraphMol/MolOps.h>
-#include <boost/dynamic_bitset.hpp>
+#include <RDGeneral/utils.h>
+#include <algorithm>
+
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread.hpp>
+#endif
 
 #define ERROR_TOL 0.00001
 
@@ -42,7 +47,8 @@ namespace RDKit {
                       bool randNegEig, 
                       unsigned int numZeroFail, double optimizerForceTol,
                       double basinThresh, int seed, unsigned int maxIterations,
-                      const DistGeom::VECT_CHIRALSET &chiralCenters){
+                      const DistGeom::VECT_CHIRALSET &chiralCenters,
+                      RDKit::rng_type &generator){
       unsigned int nat = positions.size();
       if(maxIterations==0){
         maxIterations=10*nat;
@@ -55,18 +61,20 @@ namespace RDKit {
       // conformations for large flexible molecules
       if(useRandomCoords) basinThresh=1e8;
       
+      RDKit::uniform_double dist(0.0,1.0);
+      RDKit::double_source_type randSource(generator,dist);
+
       bool gotCoords = false;
       unsigned int iter = 0;
       double largestDistance=-1.0;
       while ((gotCoords == false) && (iter < maxIterations)) {
         ++iter;
         if(!useRandomCoords){
-          if (seed > 0) {
-            largestDistance=DistGeom::pickRandomDistMat(*mmat, distMat, iter*seed);
-          } else {
-            largestDistance=DistGeom::pickRandomDistMat(*mmat, distMat);
+          if (seed > 0 && static_cast<int>(iter*seed) > 0) {
+            generator.seed(iter*seed);
           }
-          gotCoords = DistGeom::computeInitialCoords(distMat, positions,
+          largestDistance=DistGeom::pickRandomDistMat(*mmat, distMat, randSource);
+          gotCoords = DistGeom::computeInitialCoords(distMat, positions, randSource,
                                                      randNegEig, numZeroFail);
         } else {
           double boxSize;
@@ -75,11 +83,10 @@ namespace RDKit {
           } else {
             boxSize=-1*boxSizeMult;
           }
-          if (seed > 0) {
-            RDKit::rng_type &generator = RDKit::getRandomGenerator();
-            generator.seed(seed*iter);
+          if (seed > 0 && static_cast<int>(iter*seed) > 0) {
+            generator.seed(iter*seed);
           }
-          gotCoords = DistGeom::computeRandomCoords(positions,boxSize);
+          gotCoords = DistGeom::computeRandomCoords(positions,boxSize,randSource);
         }
       }
       if (gotCoords) {
@@ -125,6 +132,83 @@ namespace RDKit {
       return gotCoords;
     }
     
+    // what's needed to embed the conformers of one fragment
+    struct EmbedFragArgs {
+      DistGeom::BoundsMatPtr mmat;
+      const DistGeom::VECT_CHIRALSET *chiralCenters;
+      bool fourD;
+      const INT_VECT *fragAtoms; // the atoms of the fragment in the molecule
+      std::vector<Conformer *> *confs;
+      std::vector<char> *confsOk;
+      // if this is set, the generator is re-seeded with these before
+      // each conformer is started:
+      const std::vector<unsigned int> *confSeeds;
+      bool useRandomCoords;
+      double boxSizeMult;
+      bool randNegEig;
+      unsigned int numZeroFail;
+      double optimizerForceTol;
+      double basinThresh;
+      int seed;
+      unsigned int maxIterations;
+    };
+
+    // embeds conformers threadIdx, threadIdx+numThreads, ... of a fragment
+    void _embedFragConfs(const EmbedFragArgs *args,RDKit::rng_type *generator,
+                         unsigned int threadIdx,unsigned int numThreads){
+      unsigned int nAtoms=args->fragAtoms->size();
+      RDGeom::PointPtrVect positions;
+      for (unsigned int i = 0; i < nAtoms; ++i) {
+        if(args->fourD){
+          positions.push_back(new RDGeom::PointND(4));
+        } else {
+          positions.push_back(new RDGeom::Point3D());
+        }
+      }
+      for (unsigned int ci=threadIdx; ci<args->confs->size(); ci+=numThreads) {
+        if(!(*args->confsOk)[ci]){
+          // if one of the fragments here has already failed, there's no
+          // sense in embedding this one
+          continue;
+        }
+        if(args->confSeeds){
+          generator->seed((*args->confSeeds)[ci]);
+        }
+        bool gotCoords = _embedPoints(positions, args->mmat,
+                                      args->useRandomCoords,args->boxSizeMult,
+                                      args->randNegEig, args->numZeroFail,
+                                      args->optimizerForceTol,
+                                      args->basinThresh, (ci+1)*args->seed,
+                                      args->maxIterations, *args->chiralCenters,
+                                      *generator);
+        if (gotCoords) {
+          Conformer *conf = (*args->confs)[ci];
+          for (unsigned int i = 0; i < nAtoms; ++i){
+            conf->setAtomPos((*args->fragAtoms)[i],
+                             RDGeom::Point3D((*positions[i])[0],
+                                             (*positions[i])[1],
+                                             (*positions[i])[2]));
+          }
+        } else {
+          (*args->confsOk)[ci]=0;
+        }
+      }
+      for (unsigned int i = 0; i < nAtoms; ++i) {
+        delete positions[i];
+      }
+    }
+
+#ifdef RDK_THREADSAFE_SSS
+    void _embedFragConfsThread(const EmbedFragArgs *args,
+                               unsigned int threadIdx,unsigned int numThreads){
+      // each thread gets its own generator, the conformers are
+      // seeded individually so the results don't depend on the number
+      // of threads:
+      RDKit::rng_type generator(42u);
+      _embedFragConfs(args,&generator,threadIdx,numThreads);
+    }
+#endif
+
     void _findChiralSets(const ROMol &mol, DistGeom::VECT_CHIRALSET &chiralCenters) {
       ROMol::ConstAtomIterator ati;
       INT_PAIR_VECT nbrs;
@@ -189,14 +273,27 @@ namespace RDKit {
       } // for loop over atoms
     } // end of _findChiralSets
 
-    void _fillAtomPositions(RDGeom::Point3DConstPtrVect &pts, const Conformer &conf) {
+    // puts the centered coordinates of a conformation in a contiguous
+    // array and returns the sum of their squared lengths
+    double _fillCenteredCoords(std::vector<double> &coords, const Conformer &conf) {
       unsigned int na = conf.getNumAtoms();
-      pts.clear();
-      unsigned int ai;
-      pts.reserve(na);
-      for (ai = 0; ai < na; ++ai) {
-        pts.push_back(&conf.getAtomPos(ai));
+      RDGeom::Point3D ctr;
+      for (unsigned int ai = 0; ai < na; ++ai) {
+        ctr += conf.getAtomPos(ai);
+      }
+      if (na) {
+        ctr /= na;
+      }
+      coords.resize(3*na);
+      double lenSq = 0.0;
+      for (unsigned int ai = 0; ai < na; ++ai) {
+        RDGeom::Point3D pt = conf.getAtomPos(ai) - ctr;
+        coords[3*ai] = pt.x;
+        coords[3*ai+1] = pt.y;
+        coords[3*ai+2] = pt.z;
+        lenSq += pt.lengthSq();
       }
+      return lenSq;
     }
         
     bool _isConfFarFromRest(const ROMol &mol, const Conformer &conf,
@@ -208,18 +305,20 @@ namespace RDKit {
       // over all conformation until we find a match
       ROMol::ConstConformerIterator confi;
 
-      RDGeom::Point3DConstPtrVect refPoints, prbPoints;
-      _fillAtomPositions(refPoints, conf);
+      std::vector<double> refCoords, prbCoords;
+      double refLenSq = _fillCenteredCoords(refCoords, conf);
 
       bool res = true;
       unsigned int na = conf.getNumAtoms();
+      if (!na) return res;
       double ssrThres = na*threshold*threshold;
 
-      RDGeom::Transform3D trans;
       double ssr;
       for (confi = mol.beginConformers(); confi != mol.endConformers(); confi++) {
-        _fillAtomPositions(prbPoints, *(*confi));
-        ssr = RDNumeric::Alignments::AlignPoints(refPoints, prbPoints, trans);
+        double prbLenSq = _fillCenteredCoords(prbCoords, *(*confi));
+        ssr = RDNumeric::Alignments::AlignCenteredPointsSSR(na, &refCoords.front(),
+                                                            &prbCoords.front(),
+                                                            refLenSq, prbLenSq);
         if (ssr < ssrThres) {
           res = false;
           break;
@@ -280,7 +379,8 @@ namespace RDKit {
                                 const std::map<int,RDGeom::Point3D>  *coordMap,
                                 double optimizerForceTol,
                                 bool ignoreSmoothingFailures,
-                                double basinThresh){
+                                double basinThresh,
+                                unsigned int numThreads){
       INT_VECT fragMapping;
       std::vector<ROMOL_SPTR> molFrags=MolOps::getMolFrags(mol,true,&fragMapping);
       if(molFrags.size()>1 && coordMap){
@@ -292,8 +392,16 @@ namespace RDKit {
       for(unsigned int i=0;i<numConfs;++i){
         confs.push_back(new Conformer(mol.getNumAtoms()));
       }
-      boost::dynamic_bitset<> confsOk(numConfs);
-      confsOk.set();
+      std::vector<char> confsOk(numConfs,1);
+
+#ifdef RDK_THREADSAFE_SSS
+      if(!numThreads){
+        numThreads=boost::thread::hardware_concurrency();
+      }
+      numThreads=std::min(std::max(numThreads,1U),std::max(numConfs,1U));
+#else
+      numThreads=1;
+#endif
 
       if (clearConfs) {
         mol.clearConformers();
@@ -312,7 +420,7 @@ namespace RDKit {
           adjustBoundsMatFromCoordMap(mmat,nAtoms,coordMap);
         }
         
-        if (!DistGeom::triangleSmoothBounds(mmat)) {
+        if (!DistGeom::triangleSmoothBounds(mmat,numThreads)) {
           // ok this bound matrix failed to triangle smooth - re-compute the bounds matrix 
           // without 15 bounds and with VDW scaling
           initBoundsMat(mmat);
@@ -323,7 +431,7 @@ namespace RDKit {
           }
 
           // try triangle smoothing again 
-          if (!DistGeom::triangleSmoothBounds(mmat)) {
+          if (!DistGeom::triangleSmoothBounds(mmat,numThreads)) {
             // ok, we're not going to be able to smooth this,
             if(ignoreSmoothingFailures){
               // proceed anyway with the more relaxed bounds matrix
@@ -357,45 +465,56 @@ namespace RDKit {
         if (useRandomCoords || chiralCenters.size() > 0) {
           fourD = true;
         }
-        RDGeom::PointPtrVect positions;
-        for (unsigned int i = 0; i < nAtoms; ++i) {
-          if(fourD){
-            positions.push_back(new RDGeom::PointND(4));
-          } else {
-            positions.push_back(new RDGeom::Point3D());
+        INT_VECT fragAtoms;
+        fragAtoms.reserve(nAtoms);
+        for (unsigned int i = 0; i < mol.getNumAtoms();++i){
+          if(fragMapping[i]==static_cast<int>(fragIdx) ){
+            fragAtoms.push_back(i);
           }
         }
-        for (unsigned int ci=0; ci<numConfs; ci++) {
-          if(!confsOk[ci]){
-            // if one of the fragments here has already failed, there's no
-            // sense in embedding this one
-            continue;
-          }
-          bool gotCoords = _embedPoints(positions, mmat,
-                                        useRandomCoords,boxSizeMult,
-                                        randNegEig, numZeroFail,
-                                        optimizerForceTol,
-                                        basinThresh, (ci+1)*seed,
-                                        maxIterations, chiralCenters);
-          if (gotCoords) {
-            Conformer *conf = confs[ci];
-            unsigned int fragAtomIdx=0;
-            for (unsigned int i = 0; i < mol.getNumAtoms();++i){
-              if(fragMapping[i]==static_cast<int>(fragIdx) ){
-                conf->setAtomPos(i, RDGeom::Point3D((*positions[fragAtomIdx])[0],
-                                                    (*positions[fragAtomIdx])[1],
-                                                    (*positions[fragAtomIdx])[2]));
-                ++fragAtomIdx;
-              }
+
+        EmbedFragArgs args;
+        args.mmat=mmat;
+        args.chiralCenters=&chiralCenters;
+        args.fourD=fourD;
+        args.fragAtoms=&fragAtoms;
+        args.confs=&confs;
+        args.confsOk=&confsOk;
+        args.confSeeds=0;
+        args.useRandomCoords=useRandomCoords;
+        args.boxSizeMult=boxSizeMult;
+        args.randNegEig=randNegEig;
+        args.numZeroFail=numZeroFail;
+        args.optimizerForceTol=optimizerForceTol;
+        args.basinThresh=basinThresh;
+        args.seed=seed;
+        args.maxIterations=maxIterations;
+        if(numThreads==1){
+          _embedFragConfs(&args,&RDKit::getRandomGenerator(),0,1);
+        }
+#ifdef RDK_THREADSAFE_SSS
+        else {
+          std::vector<unsigned int> confSeeds;
+          if(seed<=0){
+            // no seed was provided, so the conformers' seeds come from
+            // the global generator:
+            RDKit::rng_type &generator=RDKit::getRandomGenerator();
+            confSeeds.reserve(numConfs);
+            for(unsigned int ci=0;ci<numConfs;++ci){
+              confSeeds.push_back(generator());
             }
-          } else {
-            confsOk[ci]=0;
+            args.confSeeds=&confSeeds;
           }
+          boost::thread_group tg;
+          for(unsigned int ti=0;ti<numThreads;++ti){
+            tg.add_thread(new boost::thread(_embedFragConfsThread,&args,ti,numThreads));
+          }
+          tg.join_all();
         }
-        for (unsigned int i = 0; i < nAtoms; ++i) {
-          delete positions[i];
-        }
+#endif
       }
+      // the pruning is done here, in conformer order, so the results
+      // don't depend on the order in which the conformers were finished:
       for(unsigned int ci=0;ci<confs.size();++ci){
         Conformer *conf = confs[ci];
         if(confsOk[ci]){
@@ -132,6 +132,12 @@ namespace RDKit {
       \param basinThresh    set the basin threshold for the DGeom force field,
                             (this shouldn't normally be altered in client code).
 
+      \param numThreads     number of threads to use while smoothing the bounds
+                            and embedding. If this is
+                            zero, the number of hardware threads is used. When a
+                            positive \c seed is provided the conformers do not depend
+                            on the number of threads. This is ignored if the RDKit
+                            was not built with thread support.
 
       \return an INT_VECT of conformer ids
 
@@ -145,7 +151,8 @@ namespace RDKit {
                                 const std::map<int,RDGeom::Point3D> *coordMap=0,
                                 double optimizerForceTol=1e-3,
                                 bool ignoreSmoothingFailures=false,
-                                double basinThresh=5.0);
+                                double basinThresh=5.0,
+                                unsigned int numThreads=1);
 
   }
 }
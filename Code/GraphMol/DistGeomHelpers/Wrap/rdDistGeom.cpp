@@ -57,7 +57,8 @@ namespace RDKit {
                               bool randNegEig, unsigned int numZeroFail,
 			      double pruneRmsThresh,python::dict &coordMap,
                               double forceTol,
-                              bool ignoreSmoothingFailures) {
+                              bool ignoreSmoothingFailures,
+                              unsigned int numThreads) {
 
     std::map<int,RDGeom::Point3D> pMap;
     python::list ks = coordMap.keys();
@@ -76,7 +77,8 @@ namespace RDKit {
 						    useRandomCoords,boxSizeMult, 
                                                     randNegEig, numZeroFail,
                                                     pruneRmsThresh,pMapPtr,forceTol,
-                                                    ignoreSmoothingFailures);
+                                                    ignoreSmoothingFailures,5.0,
+                                                    numThreads);
 
     return res;
   } 
@@ -194,6 +196,9 @@ BOOST_PYTHON_MODULE(rdDistGeom) {
                  the distance geometry force field.\n\
     - ignoreSmoothingFailures : try to embed the molecule even if triangle smoothing\n\
                  of the bounds matrix fails.\n\
+    - numThreads : number of threads to use while embedding. If this is 0,\n\
+                 the number of hardware threads is used. With a positive\n\
+                 randomSeed the results don't depend on the number of threads.\n\
  RETURNS:\n\n\
     List of new conformation IDs \n\
 \n";
@@ -207,7 +212,8 @@ BOOST_PYTHON_MODULE(rdDistGeom) {
 	       python::arg("pruneRmsThresh")=-1.0,
                python::arg("coordMap")=python::dict(),
                python::arg("forceTol")=1e-3,
-               python::arg("ignoreSmoothingFailures")=false),
+               python::arg("ignoreSmoothingFailures")=false,
+               python::arg("numThreads")=1),
               docString.c_str());
 
   docString = "Returns the distance bounds matrix for a molecule\n\
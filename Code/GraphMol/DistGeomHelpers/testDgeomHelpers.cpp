@@ -1177,6 +1177,52 @@ void testIssue3483968() {
   }
 }
 
+void testParallelEmbedding(){
+  std::string smis[]={"c1ccc2c(c1)C1C3C2C13",
+                      "C[C@H](F)C(=O)NCC(O)CCOC(C)C",
+                      "OCCC.CCN",
+                      ""};
+  for(unsigned int si=0;smis[si]!="";++si){
+    RWMol *m = SmilesToMol(smis[si]);
+    TEST_ASSERT(m);
+    for(unsigned int useRandom=0;useRandom<2;++useRandom){
+      // with a seed the results don't depend on the number of threads:
+      INT_VECT refIds=DGeomHelpers::EmbedMultipleConfs(*m,12,30,23,true,useRandom,2.0,
+                                                       true,1,-1.0,0,1e-3,false,5.0,1);
+      TEST_ASSERT(refIds.size()==12);
+      ROMol ref(*m);
+      unsigned int threadCounts[]={2,3,0};
+      for(unsigned int ti=0;ti<3;++ti){
+        INT_VECT cids=DGeomHelpers::EmbedMultipleConfs(*m,12,30,23,true,useRandom,2.0,
+                                                       true,1,-1.0,0,1e-3,false,5.0,
+                                                       threadCounts[ti]);
+        TEST_ASSERT(cids==refIds);
+        for(unsigned int ci=0;ci<cids.size();++ci){
+          const Conformer &conf1=ref.getConformer(refIds[ci]);
+          const Conformer &conf2=m->getConformer(cids[ci]);
+          for(unsigned int i=0;i<m->getNumAtoms();++i){
+            TEST_ASSERT((conf1.getAtomPos(i)-conf2.getAtomPos(i)).length()<1e-8);
+          }
+        }
+      }
+
+      // the pruning doesn't depend on the number of threads either:
+      refIds=DGeomHelpers::EmbedMultipleConfs(*m,12,30,23,true,useRandom,2.0,
+                                              true,1,0.5,0,1e-3,false,5.0,1);
+      TEST_ASSERT(refIds.size()>0);
+      INT_VECT cids=DGeomHelpers::EmbedMultipleConfs(*m,12,30,23,true,useRandom,2.0,
+                                                     true,1,0.5,0,1e-3,false,5.0,4);
+      TEST_ASSERT(cids==refIds);
+    }
+
+    // no seed:
+    INT_VECT cids=DGeomHelpers::EmbedMultipleConfs(*m,12,30,-1,true,false,2.0,
+                                                   true,1,-1.0,0,1e-3,false,5.0,4);
+    TEST_ASSERT(cids.size()==12);
+    delete m;
+  }
+}
+
 #ifdef RDK_TEST_MULTITHREADED
 namespace {
   void runblock(const std::vector<ROMol *> &mols,unsigned int count,unsigned int idx){
@@ -1341,6 +1387,10 @@ int main() {
   BOOST_LOG(rdInfoLog) << "\t test sf.net issue 3483968 \n\n";
   testIssue3483968();
 
+  BOOST_LOG(rdInfoLog) << "\t---------------------------------\n";
+  BOOST_LOG(rdInfoLog) << "\t test parallel embedding \n\n";
+  testParallelEmbedding();
+
   BOOST_LOG(rdInfoLog) << "\t---------------------------------\n";
   BOOST_LOG(rdInfoLog) << "\t test multi-threading \n\n";
   testMultiThread();
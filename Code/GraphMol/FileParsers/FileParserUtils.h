@@ -31,6 +31,13 @@ namespace RDKit{
     }
     int toInt(const std::string &input,bool acceptSpaces=false);
     double toDouble(const std::string &input,bool acceptSpaces=true);
+    //! \brief parse the fixed-width field that starts at \c pos in \c text
+    //!  without copying it. The field is truncated at the end of \c text,
+    //!  a FileParseException is thrown if it starts past the end.
+    int toInt(const std::string &text,unsigned int pos,unsigned int len,
+              bool acceptSpaces=false);
+    double toDouble(const std::string &text,unsigned int pos,unsigned int len,
+                    bool acceptSpaces=true);
 
 
     // reads a line from an MDL v3K CTAB
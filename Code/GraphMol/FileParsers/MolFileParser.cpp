@@ -28,7 +28,12 @@
 #include <exception>
 #include <sstream>
 #include <locale>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
 #include <stdlib.h>
+#include <limits>
+#include <boost/cstdint.hpp>
 
 
 namespace RDKit{
@@ -46,25 +51,123 @@ namespace RDKit{
   };
 
   namespace FileParserUtils {
-    int toInt(const std::string &input,bool acceptSpaces){
-      int res=0;
-      // don't need to worry about locale stuff here because
-      // we're not going to have delimiters
-      res=strtol(input.c_str(),NULL,10);
-      if(!res && !acceptSpaces && input[0]==' '){
-	std::string trimmed=boost::trim_copy(input);
-	if(trimmed.length()==0) throw boost::bad_lexical_cast();
+    namespace {
+      inline bool isBlank(const char *text,unsigned int len){
+        for(unsigned int i=0;i<len;++i){
+          if(!isspace(static_cast<unsigned char>(text[i]))) return false;
+        }
+        return true;
+      }
+
+      // The fixed-column parsers work directly on the character data so that
+      // the atom and bond blocks can be parsed without creating a string for
+      // every field. They give the same results as strtol() and atof(),
+      // integers that don't fit in an int are clamped to INT_MIN/INT_MAX.
+      int parseInt(const char *text,unsigned int len,bool acceptSpaces){
+        const char *ptr=text,*end=text+len;
+        while(ptr<end && isspace(static_cast<unsigned char>(*ptr))) ++ptr;
+        bool negate=false;
+        if(ptr<end && (*ptr=='-' || *ptr=='+')){
+          negate = *ptr=='-';
+          ++ptr;
+        }
+        int res=0;
+        bool overflow=false;
+        while(ptr<end && *ptr>='0' && *ptr<='9'){
+          int digit=*ptr-'0';
+          if(res>(std::numeric_limits<int>::max()-digit)/10){
+            overflow=true;
+          } else if(!overflow){
+            res = res*10 + digit;
+          }
+          ++ptr;
+        }
+        if(overflow){
+          res = negate ? std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+        } else if(negate){
+          res=-res;
+        }
+        if(!res && !acceptSpaces && len && text[0]==' ' && isBlank(text,len)){
+          throw boost::bad_lexical_cast();
+        }
+        return res;
+      }
+
+      double parseDouble(const char *text,unsigned int len,bool acceptSpaces){
+        // powers of ten that can be represented exactly:
+        static const double exactPowers[]={1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,
+                                           1e11,1e12,1e13,1e14,1e15};
+        const char *ptr=text,*end=text+len;
+        while(ptr<end && isspace(static_cast<unsigned char>(*ptr))) ++ptr;
+        bool negate=false;
+        if(ptr<end && (*ptr=='-' || *ptr=='+')){
+          negate = *ptr=='-';
+          ++ptr;
+        }
+        boost::uint64_t mantissa=0;
+        unsigned int nDigits=0,nFracDigits=0;
+        while(ptr<end && *ptr>='0' && *ptr<='9'){
+          mantissa = mantissa*10 + (*ptr-'0');
+          ++nDigits;
+          ++ptr;
+        }
+        if(ptr<end && *ptr=='.'){
+          ++ptr;
+          while(ptr<end && *ptr>='0' && *ptr<='9'){
+            mantissa = mantissa*10 + (*ptr-'0');
+            ++nDigits;
+            ++nFracDigits;
+            ++ptr;
+          }
+        }
+        double res;
+        if(nDigits && nDigits<=15 && (ptr==end || isspace(static_cast<unsigned char>(*ptr)))){
+          // both the mantissa and the power of ten are exact, so a single
+          // division gives the correctly rounded result, just like atof()
+          res = static_cast<double>(mantissa)/exactPowers[nFracDigits];
+          if(negate) res=-res;
+        } else {
+          // exponents, very long numbers and garbage go the slow way:
+          char buff[64];
+          unsigned int n=std::min(len,static_cast<unsigned int>(sizeof(buff)-1));
+          memcpy(buff,text,n);
+          buff[n]=0;
+          res=atof(buff);
+        }
+        if(res==0.0 && !acceptSpaces && len && text[0]==' ' && isBlank(text,len)){
+          throw boost::bad_lexical_cast();
+        }
+        return res;
       }
-      return res;
     }
 
+    int toInt(const std::string &input,bool acceptSpaces){
+      return parseInt(input.c_str(),input.size(),acceptSpaces);
+    }
     double toDouble(const std::string &input,bool acceptSpaces){
-      double res=atof(input.c_str());
-      if(res==0.0 && !acceptSpaces && input[0]==' '){
-	std::string trimmed=boost::trim_copy(input);
-	if(trimmed.length()==0) throw boost::bad_lexical_cast();
+      return parseDouble(input.c_str(),input.size(),acceptSpaces);
+    }
+    namespace {
+      // a field that starts past the end of the line is missing
+      void checkFieldStart(const std::string &text,unsigned int pos){
+        if(pos>text.size()){
+          std::ostringstream errout;
+          errout << "field at column " << pos+1 << " is past the end of line '" << text << "'";
+          throw FileParseException(errout.str());
+        }
       }
-      return res;
+    }
+    int toInt(const std::string &text,unsigned int pos,unsigned int len,
+              bool acceptSpaces){
+      checkFieldStart(text,pos);
+      return parseInt(text.c_str()+pos,std::min(len,static_cast<unsigned int>(text.size())-pos),
+                      acceptSpaces);
+    }
+    double toDouble(const std::string &text,unsigned int pos,unsigned int len,
+                    bool acceptSpaces){
+      checkFieldStart(text,pos);
+      return parseDouble(text.c_str()+pos,std::min(len,static_cast<unsigned int>(text.size())-pos),
+                         acceptSpaces);
     }
 
     std::string getV3000Line(std::istream *inStream,unsigned int &line){
@@ -739,7 +842,7 @@ namespace RDKit{
       at->setProp("molFileValue",text.substr(7,text.length()-7));
     };
 
-    Atom *ParseMolFileAtomLine(const std::string text, RDGeom::Point3D &pos,unsigned int line) {
+    Atom *ParseMolFileAtomLine(const std::string &text, RDGeom::Point3D &pos,unsigned int line) {
       Atom *res = new Atom;
       std::string symb;
       int massDiff,chg,hCount;
@@ -751,9 +854,9 @@ namespace RDKit{
       }
 
       try {
-        pos.x = FileParserUtils::toDouble(text.substr(0,10));
-        pos.y = FileParserUtils::toDouble(text.substr(10,10));
-        pos.z = FileParserUtils::toDouble(text.substr(20,10));
+        pos.x = FileParserUtils::toDouble(text,0,10);
+        pos.y = FileParserUtils::toDouble(text,10,10);
+        pos.z = FileParserUtils::toDouble(text,20,10);
       }
       catch (boost::bad_lexical_cast &) {
         std::ostringstream errout;
@@ -765,9 +868,9 @@ namespace RDKit{
     
       // REVIEW: should we handle missing fields at the end of the line?
       massDiff=0;
-      if(text.size()>=36 && text.substr(34,2)!=" 0"){
+      if(text.size()>=36 && text.compare(34,2," 0")){
         try {
-          massDiff = FileParserUtils::toInt(text.substr(34,2),true);
+          massDiff = FileParserUtils::toInt(text,34,2,true);
         }
         catch (boost::bad_lexical_cast &) {
           std::ostringstream errout;
@@ -776,9 +879,9 @@ namespace RDKit{
         }
       }    
       chg=0;
-      if(text.size()>=39 && text.substr(36,3)!="  0"){
+      if(text.size()>=39 && text.compare(36,3,"  0")){
         try {
-          chg = FileParserUtils::toInt(text.substr(36,3),true);
+          chg = FileParserUtils::toInt(text,36,3,true);
         }
         catch (boost::bad_lexical_cast &) {
           std::ostringstream errout;
@@ -787,9 +890,9 @@ namespace RDKit{
         }
       }
       hCount = 0;
-      if(text.size()>=45 && text.substr(42,3)!="  0"){
+      if(text.size()>=45 && text.compare(42,3,"  0")){
         try {
-          hCount = FileParserUtils::toInt(text.substr(42,3),true);
+          hCount = FileParserUtils::toInt(text,42,3,true);
         }
         catch (boost::bad_lexical_cast &) {
           std::ostringstream errout;
@@ -864,10 +967,10 @@ namespace RDKit{
 	res->setProp("_hasMassQuery",true);
       }
     
-      if(text.size()>=42 && text.substr(39,3)!="  0"){
+      if(text.size()>=42 && text.compare(39,3,"  0")){
         int parity=0;
         try {
-          parity = FileParserUtils::toInt(text.substr(39,3),true);
+          parity = FileParserUtils::toInt(text,39,3,true);
         }
         catch (boost::bad_lexical_cast &) {
           std::ostringstream errout;
@@ -877,10 +980,10 @@ namespace RDKit{
         res->setProp("molParity",parity);
       }
 
-      if(text.size()>=48 && text.substr(45,3)!="  0"){
+      if(text.size()>=48 && text.compare(45,3,"  0")){
         int stereoCare=0;
         try {
-          stereoCare = FileParserUtils::toInt(text.substr(45,3),true);
+          stereoCare = FileParserUtils::toInt(text,45,3,true);
         }
         catch (boost::bad_lexical_cast &) {
           std::ostringstream errout;
@@ -889,10 +992,10 @@ namespace RDKit{
         }
         res->setProp("molStereoCare",stereoCare);
       }
-      if(text.size()>=51 && text.substr(48,3)!="  0"){
+      if(text.size()>=51 && text.compare(48,3,"  0")){
         int totValence=0;
         try {
-          totValence= FileParserUtils::toInt(text.substr(48,3),true);
+          totValence= FileParserUtils::toInt(text,48,3,true);
         }
         catch (boost::bad_lexical_cast &) {
           std::ostringstream errout;
@@ -901,10 +1004,10 @@ namespace RDKit{
         }
         res->setProp("molTotValence",totValence);
       }
-      if(text.size()>=63 && text.substr(60,3)!="  0"){
+      if(text.size()>=63 && text.compare(60,3,"  0")){
         int atomMapNumber=0;
         try {
-          atomMapNumber = FileParserUtils::toInt(text.substr(60,3),true);
+          atomMapNumber = FileParserUtils::toInt(text,60,3,true);
         }
         catch (boost::bad_lexical_cast &) {
           std::ostringstream errout;
@@ -913,10 +1016,10 @@ namespace RDKit{
         }
         res->setProp("molAtomMapNumber",atomMapNumber);
       }
-      if(text.size()>=66 && text.substr(63,3)!="  0"){
+      if(text.size()>=66 && text.compare(63,3,"  0")){
         int inversionFlag=0;
         try {
-          inversionFlag= FileParserUtils::toInt(text.substr(63,3),true);
+          inversionFlag= FileParserUtils::toInt(text,63,3,true);
         }
         catch (boost::bad_lexical_cast &) {
           std::ostringstream errout;
@@ -925,10 +1028,10 @@ namespace RDKit{
         }
         res->setProp("molInversionFlag",inversionFlag);
       }
-      if(text.size()>=69 && text.substr(66,3)!="  0"){
+      if(text.size()>=69 && text.compare(66,3,"  0")){
         int exactChangeFlag=0;
         try {
-          exactChangeFlag = FileParserUtils::toInt(text.substr(66,3),true);
+          exactChangeFlag = FileParserUtils::toInt(text,66,3,true);
         }
         catch (boost::bad_lexical_cast &) {
           std::ostringstream errout;
@@ -951,11 +1054,11 @@ namespace RDKit{
       }
 
       try {
-        idx1 = FileParserUtils::toInt(text.substr(spos,3));
+        idx1 = FileParserUtils::toInt(text,spos,3);
         spos += 3;
-        idx2 = FileParserUtils::toInt(text.substr(spos,3));
+        idx2 = FileParserUtils::toInt(text,spos,3);
         spos += 3;
-        bType = FileParserUtils::toInt(text.substr(spos,3));  
+        bType = FileParserUtils::toInt(text,spos,3);  
       }
       catch (boost::bad_lexical_cast &) {
         std::ostringstream errout;
@@ -1018,9 +1121,9 @@ namespace RDKit{
       res->setEndAtomIdx(idx2);
       res->setBondType(type);
 
-      if( text.size() >= 12 && text.substr(9,3)!="  0"){
+      if( text.size() >= 12 && text.compare(9,3,"  0")){
         try {
-          stereo = FileParserUtils::toInt(text.substr(9,3));
+          stereo = FileParserUtils::toInt(text,9,3);
           switch(stereo){
           case 0:
             res->setBondDir(Bond::NONE);
@@ -1043,9 +1146,9 @@ namespace RDKit{
           ;
         }
       }
-      if( text.size() >= 18 && text.substr(15,3)!="  0"){
+      if( text.size() >= 18 && text.compare(15,3,"  0")){
         try {
-          int topology = FileParserUtils::toInt(text.substr(15,3));
+          int topology = FileParserUtils::toInt(text,15,3);
           QueryBond *qBond=new QueryBond(*res);
           BOND_EQUALS_QUERY *q=makeBondIsInRingQuery();
           switch(topology){
@@ -1066,9 +1169,9 @@ namespace RDKit{
           ;
         }
       }
-      if( text.size() >= 21 && text.substr(18,3)!="  0"){
+      if( text.size() >= 21 && text.compare(18,3,"  0")){
         try {
-          int reactStatus = FileParserUtils::toInt(text.substr(18,3));
+          int reactStatus = FileParserUtils::toInt(text,18,3);
           res->setProp("molReactStatus",reactStatus);
         } catch (boost::bad_lexical_cast) {
           ;
@@ -1841,9 +1944,9 @@ namespace RDKit{
     // this needs to go into a try block because if the lexical_cast throws an
     // exception we want to catch and delete mol before leaving this function
     try {
-      nAtoms = FileParserUtils::toInt(tempStr.substr(spos,3));
+      nAtoms = FileParserUtils::toInt(tempStr,spos,3);
       spos = 3;
-      nBonds = FileParserUtils::toInt(tempStr.substr(spos,3));
+      nBonds = FileParserUtils::toInt(tempStr,spos,3);
       spos = 6;
     } catch (boost::bad_lexical_cast &) {
       if(res){
@@ -1857,31 +1960,31 @@ namespace RDKit{
     try {
       spos = 6;
       if(tempStr.size()>=9)
-        nLists = FileParserUtils::toInt(tempStr.substr(spos,3));
+        nLists = FileParserUtils::toInt(tempStr,spos,3);
 
       spos = 12;
       if(tempStr.size()>=spos+3)
-        chiralFlag = FileParserUtils::toInt(tempStr.substr(spos,3));
+        chiralFlag = FileParserUtils::toInt(tempStr,spos,3);
 
       spos = 15;
       if(tempStr.size()>=spos+3)
-        nsText = FileParserUtils::toInt(tempStr.substr(spos,3));
+        nsText = FileParserUtils::toInt(tempStr,spos,3);
 
       spos = 18;
       if(tempStr.size()>=spos+3)
-        nRxnComponents = FileParserUtils::toInt(tempStr.substr(spos,3));
+        nRxnComponents = FileParserUtils::toInt(tempStr,spos,3);
 
       spos = 21;
       if(tempStr.size()>=spos+3)
-        nReactants   = FileParserUtils::toInt(tempStr.substr(spos,3));
+        nReactants   = FileParserUtils::toInt(tempStr,spos,3);
 
       spos = 24;
       if(tempStr.size()>=spos+3)
-        nProducts   = FileParserUtils::toInt(tempStr.substr(spos,3));
+        nProducts   = FileParserUtils::toInt(tempStr,spos,3);
 
       spos = 27;
       if(tempStr.size()>=spos+3)
-        nIntermediates = FileParserUtils::toInt(tempStr.substr(spos,3));
+        nIntermediates = FileParserUtils::toInt(tempStr,spos,3);
 
     } catch (boost::bad_lexical_cast &) {
       // some SD files (such as some from NCI) lack all the extra information
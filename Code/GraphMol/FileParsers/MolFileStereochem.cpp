@@ -355,7 +355,7 @@ namespace RDKit {
   INT_MAP_INT pickBondsToWedge(const ROMol &mol) {
     // we need ring information; make sure findSSSR has been called before
     // if not call now
-    if ( !mol.getRingInfo()->isInitialized() ) {
+    if ( mol.getRingInfo()->getPerceptionType()!=RingInfo::SSSR ) {
       MolOps::findSSSR(mol);
     }
 
@@ -159,6 +159,26 @@ namespace RDKit {
      */
     void setStreamIndices(const std::vector<std::streampos> &locs);
 
+    /*! \brief saves the positions of the molecules in the stream to an index file
+     *
+     *   \param fileName - the name of the index file
+     *
+     *  This calls length(), so the whole stream is scanned if that hasn't
+     *  already happened. Reading the index back in with readStreamIndices()
+     *  allows random access to the molecules without scanning the stream.
+     */
+    void writeStreamIndices(const std::string &fileName);
+    /*! \brief reads molecule positions from an index file
+     *
+     *   \param fileName - the name of the index file, this should have been
+     *     written by writeStreamIndices()
+     *
+     *  The index records the size of the stream it was built from. If that
+     *  doesn't match the size of our stream, the index is out of date and a
+     *  BadFileException is thrown.
+     */
+    void readStreamIndices(const std::string &fileName);
+
   private:
     void checkForEnd();
     int d_len; // total number of mol blocks in the file (initialized to -1)
@@ -167,6 +187,71 @@ namespace RDKit {
 
   };
 
+  namespace detail {
+    class SDParsePipeline;
+    class SmilesParsePipeline;
+    struct RecordBatch;
+  }
+  //! a forward-only supplier from an SD file that parses records on multiple threads
+  class MultithreadedSDMolSupplier : public MolSupplier {
+    /*************************************************************************
+     * One thread reads the stream and splits it into records at the $$$$
+     * lines. The records are collected in batches and the batches are
+     * parsed on worker threads.
+     *  - Molecules come out in file order if "ordered" is set. Otherwise
+     *    they come out in the order in which their batches finish, and
+     *    getLastRecordIdx() gives the position of each one in the file.
+     *  - Records that can't be parsed give NULL molecules, as they do
+     *    with the other SD suppliers.
+     *  - The reader stops when it is a fixed number of batches ahead of
+     *    the consumer, so memory use does not depend on the size of the file.
+     ***********************************************************************************/
+  public:
+    /*! 
+     *   \param fileName - the name of the SD file
+     *   \param sanitize - if true sanitize the molecule before returning it
+     *   \param removeHs - if true remove Hs from the molecule before returning it
+     *                     (triggers sanitization)
+     *   \param strictParsing - if not set, the parser is more lax about correctness
+     *                          of the contents.
+     *   \param numThreads - the number of parser threads, zero uses all cores.
+     *                       Only has an effect if the RDKit was built with
+     *                       thread support.
+     *   \param ordered - if true the molecules are returned in file order
+     *   \param batchSize - the number of records handed to a thread at once
+     */
+    explicit MultithreadedSDMolSupplier(const std::string &fileName, bool sanitize=true,
+                                        bool removeHs=true,bool strictParsing=true,
+                                        unsigned int numThreads=0,bool ordered=true,
+                                        unsigned int batchSize=32);
+    explicit MultithreadedSDMolSupplier(std::istream *inStream, bool takeOwnership=true,
+                                        bool sanitize=true,bool removeHs=true,
+                                        bool strictParsing=true,unsigned int numThreads=0,
+                                        bool ordered=true,unsigned int batchSize=32);
+    ~MultithreadedSDMolSupplier();
+
+    void init();
+    void reset();
+    ROMol *next();
+    bool atEnd();
+
+    //! returns the index of the last record returned by next()
+    unsigned int getLastRecordIdx() const { return d_lastRecordIdx; };
+    //! returns the text of the last record returned by next()
+    const std::string &getLastItemText() const { return d_lastItemText; };
+
+  private:
+    void startPipeline(bool sanitize,bool removeHs,bool strictParsing,
+                       unsigned int numThreads,bool ordered,unsigned int batchSize);
+    bool fillCurrentBatch();
+    detail::SDParsePipeline *dp_pipeline;
+    detail::RecordBatch *dp_currentBatch;
+    unsigned int d_currentPos; // next molecule to hand out from dp_currentBatch
+    bool df_end;
+    unsigned int d_lastRecordIdx;
+    std::string d_lastItemText;
+  };
+
   //! lazy file parser for Smiles tables
   class SmilesMolSupplier : public MolSupplier {
     /**************************************************************************
@@ -257,6 +342,91 @@ namespace RDKit {
     int d_name; // column id for the name
   };
 
+  //! a forward-only supplier from a SMILES file that parses lines on multiple threads
+  class MultithreadedSmilesMolSupplier : public MolSupplier {
+    /*************************************************************************
+     * One thread reads the stream and collects the lines in batches, the
+     * batches are parsed and sanitized on worker threads. The file format
+     * and the molecules are the same as with SmilesMolSupplier.
+     *  - Molecules come out in file order if "ordered" is set. Otherwise
+     *    they come out in the order in which their batches finish, and
+     *    getLastRecordIdx() gives the position of each one in the file.
+     *  - Lines that can't be parsed give NULL molecules, as they do with
+     *    SmilesMolSupplier. nextBatch() also describes what went wrong.
+     *  - The reader stops when it is a fixed number of batches ahead of
+     *    the consumer, so memory use does not depend on the size of the file.
+     ***********************************************************************************/
+  public:
+    //! describes a line that could not be converted to a molecule
+    struct RecordError {
+      unsigned int recordIdx; //!< index of the record (not counting comments and the title)
+      int lineNum;            //!< line number in the file, starting from zero
+      std::string text;       //!< the text of the line
+      std::string message;    //!< what went wrong
+    };
+
+    /*! 
+     *   \param fileName - the name of smiles table file
+     *   \param delimiter, smilesColumn, nameColumn, titleLine, sanitize -
+     *          as for SmilesMolSupplier
+     *   \param numThreads - the number of parser threads, zero uses all cores.
+     *                       Only has an effect if the RDKit was built with
+     *                       thread support.
+     *   \param ordered - if true the molecules are returned in file order
+     *   \param batchSize - the number of lines handed to a thread at once
+     */
+    explicit MultithreadedSmilesMolSupplier(const std::string &fileName,
+                                            const std::string &delimiter=" \t",
+                                            int smilesColumn=0,int nameColumn=1,
+                                            bool titleLine=true,bool sanitize=true,
+                                            unsigned int numThreads=0,bool ordered=true,
+                                            unsigned int batchSize=256);
+    explicit MultithreadedSmilesMolSupplier(std::istream *inStream,bool takeOwnership=true,
+                                            const std::string &delimiter=" \t",
+                                            int smilesColumn=0,int nameColumn=1,
+                                            bool titleLine=true,bool sanitize=true,
+                                            unsigned int numThreads=0,bool ordered=true,
+                                            unsigned int batchSize=256);
+    ~MultithreadedSmilesMolSupplier();
+
+    void init();
+    void reset();
+    ROMol *next();
+    bool atEnd();
+
+    //! returns the molecules from the next batch of lines
+    /*!
+      \param mols   - used to return the molecules, one per line. Lines that
+                      can't be parsed give NULL entries. The caller is
+                      responsible for deleting the molecules.
+      \param errors - used to return one entry for each NULL molecule
+
+      \return false (and empty vectors) if there are no more molecules.
+
+      The lines in a batch are consecutive in the file; afterwards
+      getLastRecordIdx() returns the index of the last one. If next() has
+      already been called, the rest of the current batch is returned.
+    */
+    bool nextBatch(std::vector<ROMol *> &mols,std::vector<RecordError> &errors);
+
+    //! returns the index of the last record returned
+    unsigned int getLastRecordIdx() const { return d_lastRecordIdx; };
+    //! returns the text of the last record returned by next()
+    const std::string &getLastItemText() const { return d_lastItemText; };
+
+  private:
+    void startPipeline(const std::string &delimiter,int smilesColumn,int nameColumn,
+                       bool titleLine,bool sanitize,unsigned int numThreads,
+                       bool ordered,unsigned int batchSize);
+    bool fillCurrentBatch();
+    detail::SmilesParsePipeline *dp_pipeline;
+    detail::RecordBatch *dp_currentBatch;
+    unsigned int d_currentPos; // next molecule to hand out from dp_currentBatch
+    bool df_end;
+    unsigned int d_lastRecordIdx;
+    std::string d_lastItemText;
+  };
+
   //! lazy file parser for TDT files
   class TDTMolSupplier : public MolSupplier {
     /**************************************************************************
@@ -0,0 +1,208 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include <RDGeneral/FileParseException.h>
+#include <RDGeneral/BadFileException.h>
+#include <RDGeneral/RDLog.h>
+#include "MolSupplier.h"
+#include "ParsePipeline.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+
+namespace RDKit {
+  namespace detail {
+    // splits an SD stream into records at the $$$$ lines
+    class SDParsePipeline : public ParsePipeline {
+    public:
+      SDParsePipeline(std::istream *inStream,bool sanitize,bool removeHs,
+                      bool strictParsing,unsigned int numThreads,bool ordered,
+                      unsigned int batchSize) :
+        ParsePipeline(numThreads,ordered,batchSize),
+        dp_inStream(inStream), df_sanitize(sanitize), df_removeHs(removeHs),
+        df_strictParsing(strictParsing), df_inputDone(false), d_lineNum(0) {
+        start();
+      };
+      ~SDParsePipeline() {
+        stop();
+      };
+
+    private:
+      std::istream *dp_inStream;
+      bool df_sanitize,df_removeHs,df_strictParsing;
+      bool df_inputDone;
+      int d_lineNum;
+
+      // reads the text of the next record, including its $$$$ line.
+      // Returns false when there are no more records.
+      bool readRecord(std::string &text,int &lineNum){
+        if(df_inputDone) return false;
+        text.clear();
+        lineNum=d_lineNum;
+        std::string line;
+        bool nonBlank=false;
+        unsigned int nLines=0;
+        while(1){
+          std::getline(*dp_inStream,line);
+          bool hitEOF=!dp_inStream->good();
+          // this is the same test SDMolSupplier::checkForEnd() uses: a
+          // record needs four more lines and they can't all be blank
+          if(nLines<4){
+            if(hitEOF){
+              df_inputDone=true;
+              return false;
+            }
+            if(line.find_first_not_of(" \t\r\n")!=std::string::npos) nonBlank=true;
+            if(nLines==3 && !nonBlank){
+              df_inputDone=true;
+              return false;
+            }
+          }
+          ++nLines;
+          ++d_lineNum;
+          text+=line;
+          if(hitEOF){
+            df_inputDone=true;
+            return true;
+          }
+          text+='\n';
+          if(line.size()>=4 && line[0]=='$' && line.compare(0,4,"$$$$")==0){
+            return true;
+          }
+        }
+      }
+      void parseRecord(RecordBatch *batch,unsigned int which) const {
+        // the forward supplier does the parsing and error handling
+        // exactly the way the other SD suppliers do
+        ForwardSDMolSupplier sup(new std::istringstream(batch->texts[which]),true,
+                                 df_sanitize,df_removeHs,df_strictParsing);
+        try {
+          batch->mols[which]=sup.next();
+        } catch (...) {
+          BOOST_LOG(rdErrorLog) << "ERROR: could not parse record "
+                                << batch->firstRecord+which << std::endl;
+          batch->mols[which]=0;
+          batch->errors[which]="could not parse record";
+        }
+      }
+    };
+  } // end of namespace detail
+
+  MultithreadedSDMolSupplier::MultithreadedSDMolSupplier(const std::string &fileName,
+                                                         bool sanitize,bool removeHs,
+                                                         bool strictParsing,
+                                                         unsigned int numThreads,
+                                                         bool ordered,unsigned int batchSize){
+    init();
+    std::istream *tmpStream=0;
+    tmpStream = static_cast<std::istream *>(new std::ifstream(fileName.c_str(), std::ios_base::binary));
+    if (!tmpStream || (!(*tmpStream)) || (tmpStream->bad()) ) {
+      delete tmpStream;
+      std::ostringstream errout;
+      errout << "Bad input file " << fileName;
+      throw BadFileException(errout.str());
+    }
+    dp_inStream = tmpStream;
+    df_owner=true;
+    startPipeline(sanitize,removeHs,strictParsing,numThreads,ordered,batchSize);
+    POSTCONDITION(dp_inStream,"bad instream");
+  }
+
+  MultithreadedSDMolSupplier::MultithreadedSDMolSupplier(std::istream *inStream,
+                                                         bool takeOwnership,
+                                                         bool sanitize,bool removeHs,
+                                                         bool strictParsing,
+                                                         unsigned int numThreads,
+                                                         bool ordered,unsigned int batchSize){
+    PRECONDITION(inStream,"bad stream");
+    init();
+    dp_inStream = inStream;
+    df_owner=takeOwnership;
+    startPipeline(sanitize,removeHs,strictParsing,numThreads,ordered,batchSize);
+    POSTCONDITION(dp_inStream,"bad instream");
+  }
+
+  MultithreadedSDMolSupplier::~MultithreadedSDMolSupplier(){
+    // the pipeline's threads use the stream, so they have to go first:
+    if(dp_pipeline){
+      if(dp_currentBatch) dp_pipeline->releaseBatch(dp_currentBatch);
+      delete dp_pipeline;
+    }
+    if (df_owner && dp_inStream) {
+      delete dp_inStream;
+    }
+  }
+
+  void MultithreadedSDMolSupplier::init(){
+    dp_inStream=0;
+    df_owner=false;
+    dp_pipeline=0;
+    dp_currentBatch=0;
+    d_currentPos=0;
+    df_end=false;
+    d_lastRecordIdx=0;
+    d_lastItemText="";
+  }
+
+  void MultithreadedSDMolSupplier::startPipeline(bool sanitize,bool removeHs,
+                                                 bool strictParsing,
+                                                 unsigned int numThreads,bool ordered,
+                                                 unsigned int batchSize){
+#ifdef RDK_THREADSAFE_SSS
+    if(!numThreads){
+      numThreads=boost::thread::hardware_concurrency();
+    }
+#else
+    numThreads=1;
+#endif
+    dp_pipeline=new detail::SDParsePipeline(dp_inStream,sanitize,removeHs,strictParsing,
+                                            std::max(numThreads,1U),ordered,batchSize);
+  }
+
+  void MultithreadedSDMolSupplier::reset() {
+    UNDER_CONSTRUCTION("reset() not supported for MultithreadedSDMolSuppliers();");
+  }
+
+  bool MultithreadedSDMolSupplier::fillCurrentBatch(){
+    while(!dp_currentBatch || d_currentPos>=dp_currentBatch->mols.size()){
+      if(dp_currentBatch){
+        dp_pipeline->releaseBatch(dp_currentBatch);
+        dp_currentBatch=0;
+      }
+      if(df_end) return false;
+      dp_currentBatch=dp_pipeline->getBatch();
+      d_currentPos=0;
+      if(!dp_currentBatch){
+        df_end=true;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool MultithreadedSDMolSupplier::atEnd(){
+    PRECONDITION(dp_pipeline,"no stream");
+    return !fillCurrentBatch();
+  }
+
+  ROMol *MultithreadedSDMolSupplier::next(){
+    PRECONDITION(dp_pipeline,"no stream");
+    if(!fillCurrentBatch()){
+      throw FileParseException("EOF hit.");
+    }
+    ROMol *res=dp_currentBatch->mols[d_currentPos];
+    dp_currentBatch->mols[d_currentPos]=0;
+    d_lastRecordIdx=dp_currentBatch->firstRecord+d_currentPos;
+    d_lastItemText.swap(dp_currentBatch->texts[d_currentPos]);
+    ++d_currentPos;
+    return res;
+  }
+}
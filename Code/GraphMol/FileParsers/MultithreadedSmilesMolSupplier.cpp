@@ -0,0 +1,243 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include <RDGeneral/FileParseException.h>
+#include <RDGeneral/BadFileException.h>
+#include <RDGeneral/RDLog.h>
+#include <GraphMol/SmilesParse/SmilesParse.h>
+#include <GraphMol/SanitException.h>
+#include "MolSupplier.h"
+#include "ParsePipeline.h"
+#include <boost/tokenizer.hpp>
+typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+
+namespace RDKit {
+  namespace detail {
+    // each non-blank line that doesn't start with '#' is a record
+    class SmilesParsePipeline : public ParsePipeline {
+    public:
+      SmilesParsePipeline(std::istream *inStream,const std::string &delimiter,
+                          int smilesColumn,int nameColumn,bool titleLine,bool sanitize,
+                          unsigned int numThreads,bool ordered,unsigned int batchSize) :
+        ParsePipeline(numThreads,ordered,batchSize),
+        dp_inStream(inStream), d_delim(delimiter), d_smi(smilesColumn),
+        d_name(nameColumn), df_sanitize(sanitize), d_lineNum(-1) {
+        if(titleLine){
+          // the property names are needed by all the workers, so read them
+          // before they start:
+          std::string text;
+          int lineNum;
+          if(readRecord(text,lineNum)){
+            boost::char_separator<char> sep(d_delim.c_str(),"",boost::keep_empty_tokens);
+            tokenizer tokens(text,sep);
+            for(tokenizer::iterator tokIter=tokens.begin();
+                tokIter!=tokens.end();++tokIter){
+              d_props.push_back(strip(*tokIter));
+            }
+          }
+        }
+        start();
+      };
+      ~SmilesParsePipeline() {
+        stop();
+      };
+
+    private:
+      std::istream *dp_inStream;
+      std::string d_delim;
+      int d_smi,d_name;
+      bool df_sanitize;
+      STR_VECT d_props;
+      int d_lineNum;
+
+      bool readRecord(std::string &text,int &lineNum){
+        while(std::getline(*dp_inStream,text)){
+          ++d_lineNum;
+          if(!text.empty() && text[text.size()-1]=='\r') text.erase(text.size()-1);
+          // skip comments and blank lines, as SmilesMolSupplier does:
+          if(text.empty() || text[0]=='#' || strip(text).empty()) continue;
+          lineNum=d_lineNum;
+          return true;
+        }
+        return false;
+      }
+      void parseRecord(RecordBatch *batch,unsigned int which) const {
+        int lineNum=batch->lineNums[which];
+        std::ostringstream errout;
+        try {
+          batch->mols[which]=SmilesLineToMol(batch->texts[which],d_delim,d_smi,d_name,
+                                             d_props,df_sanitize,lineNum);
+          return;
+        } catch(const SmilesParseException &pe) {
+          BOOST_LOG(rdErrorLog) << "ERROR: Smiles parse error on line " << lineNum << "\n";
+          BOOST_LOG(rdErrorLog) << "ERROR: " << pe.message() << "\n";
+          errout << "Smiles parse error: " << pe.message();
+        } catch(const MolSanitizeException &se) {
+          BOOST_LOG(rdErrorLog) << "ERROR: Could not sanitize molecule on line " << lineNum << std::endl;
+          BOOST_LOG(rdErrorLog) << "ERROR: " << se.message() << "\n";
+          errout << "Could not sanitize molecule: " << se.message();
+        } catch(const FileParseException &fe) {
+          BOOST_LOG(rdErrorLog) << "ERROR: Could not process molecule on line " << lineNum << std::endl;
+          errout << fe.message();
+        } catch(...) {
+          BOOST_LOG(rdErrorLog) << "ERROR: Could not process molecule on line " << lineNum << std::endl;
+          errout << "Could not process molecule";
+        }
+        batch->mols[which]=0;
+        batch->errors[which]=errout.str();
+      }
+    };
+  } // end of namespace detail
+
+  MultithreadedSmilesMolSupplier::MultithreadedSmilesMolSupplier(const std::string &fileName,
+                                                                 const std::string &delimiter,
+                                                                 int smilesColumn,int nameColumn,
+                                                                 bool titleLine,bool sanitize,
+                                                                 unsigned int numThreads,
+                                                                 bool ordered,unsigned int batchSize){
+    init();
+    std::istream *tmpStream=0;
+    tmpStream = static_cast<std::istream *>(new std::ifstream(fileName.c_str(), std::ios_base::binary));
+    if (!tmpStream || (!(*tmpStream)) || (tmpStream->bad()) ) {
+      delete tmpStream;
+      std::ostringstream errout;
+      errout << "Bad input file " << fileName;
+      throw BadFileException(errout.str());
+    }
+    dp_inStream = tmpStream;
+    df_owner=true;
+    startPipeline(delimiter,smilesColumn,nameColumn,titleLine,sanitize,numThreads,
+                  ordered,batchSize);
+    POSTCONDITION(dp_inStream,"bad instream");
+  }
+
+  MultithreadedSmilesMolSupplier::MultithreadedSmilesMolSupplier(std::istream *inStream,
+                                                                 bool takeOwnership,
+                                                                 const std::string &delimiter,
+                                                                 int smilesColumn,int nameColumn,
+                                                                 bool titleLine,bool sanitize,
+                                                                 unsigned int numThreads,
+                                                                 bool ordered,unsigned int batchSize){
+    PRECONDITION(inStream,"bad stream");
+    init();
+    dp_inStream = inStream;
+    df_owner=takeOwnership;
+    startPipeline(delimiter,smilesColumn,nameColumn,titleLine,sanitize,numThreads,
+                  ordered,batchSize);
+    POSTCONDITION(dp_inStream,"bad instream");
+  }
+
+  MultithreadedSmilesMolSupplier::~MultithreadedSmilesMolSupplier(){
+    // the pipeline's threads use the stream, so they have to go first:
+    if(dp_pipeline){
+      if(dp_currentBatch) dp_pipeline->releaseBatch(dp_currentBatch);
+      delete dp_pipeline;
+    }
+    if (df_owner && dp_inStream) {
+      delete dp_inStream;
+    }
+  }
+
+  void MultithreadedSmilesMolSupplier::init(){
+    dp_inStream=0;
+    df_owner=false;
+    dp_pipeline=0;
+    dp_currentBatch=0;
+    d_currentPos=0;
+    df_end=false;
+    d_lastRecordIdx=0;
+    d_lastItemText="";
+  }
+
+  void MultithreadedSmilesMolSupplier::startPipeline(const std::string &delimiter,
+                                                     int smilesColumn,int nameColumn,
+                                                     bool titleLine,bool sanitize,
+                                                     unsigned int numThreads,bool ordered,
+                                                     unsigned int batchSize){
+#ifdef RDK_THREADSAFE_SSS
+    if(!numThreads){
+      numThreads=boost::thread::hardware_concurrency();
+    }
+#else
+    numThreads=1;
+#endif
+    dp_pipeline=new detail::SmilesParsePipeline(dp_inStream,delimiter,smilesColumn,nameColumn,
+                                                titleLine,sanitize,std::max(numThreads,1U),
+                                                ordered,batchSize);
+  }
+
+  void MultithreadedSmilesMolSupplier::reset() {
+    UNDER_CONSTRUCTION("reset() not supported for MultithreadedSmilesMolSuppliers();");
+  }
+
+  bool MultithreadedSmilesMolSupplier::fillCurrentBatch(){
+    while(!dp_currentBatch || d_currentPos>=dp_currentBatch->mols.size()){
+      if(dp_currentBatch){
+        dp_pipeline->releaseBatch(dp_currentBatch);
+        dp_currentBatch=0;
+      }
+      if(df_end) return false;
+      dp_currentBatch=dp_pipeline->getBatch();
+      d_currentPos=0;
+      if(!dp_currentBatch){
+        df_end=true;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool MultithreadedSmilesMolSupplier::atEnd(){
+    PRECONDITION(dp_pipeline,"no stream");
+    return !fillCurrentBatch();
+  }
+
+  ROMol *MultithreadedSmilesMolSupplier::next(){
+    PRECONDITION(dp_pipeline,"no stream");
+    if(!fillCurrentBatch()){
+      throw FileParseException("EOF hit.");
+    }
+    ROMol *res=dp_currentBatch->mols[d_currentPos];
+    dp_currentBatch->mols[d_currentPos]=0;
+    d_lastRecordIdx=dp_currentBatch->firstRecord+d_currentPos;
+    d_lastItemText.swap(dp_currentBatch->texts[d_currentPos]);
+    ++d_currentPos;
+    return res;
+  }
+
+  bool MultithreadedSmilesMolSupplier::nextBatch(std::vector<ROMol *> &mols,
+                                                 std::vector<RecordError> &errors){
+    PRECONDITION(dp_pipeline,"no stream");
+    mols.clear();
+    errors.clear();
+    if(!fillCurrentBatch()) return false;
+    detail::RecordBatch *batch=dp_currentBatch;
+    mols.reserve(batch->mols.size()-d_currentPos);
+    for(unsigned int i=d_currentPos;i<batch->mols.size();++i){
+      mols.push_back(batch->mols[i]);
+      batch->mols[i]=0;
+      if(!batch->errors[i].empty()){
+        RecordError err;
+        err.recordIdx=batch->firstRecord+i;
+        err.lineNum=batch->lineNums[i];
+        err.text=batch->texts[i];
+        err.message=batch->errors[i];
+        errors.push_back(err);
+      }
+    }
+    d_lastRecordIdx=batch->firstRecord+batch->mols.size()-1;
+    d_currentPos=batch->mols.size();
+    return true;
+  }
+}
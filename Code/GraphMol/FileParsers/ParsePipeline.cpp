@@ -0,0 +1,255 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include <RDGeneral/Invariant.h>
+#include <RDGeneral/FileParseException.h>
+#include <RDGeneral/BadFileException.h>
+#include <RDBoost/Exceptions.h>
+#include <GraphMol/ROMol.h>
+#include <GraphMol/PeriodicTable.h>
+#include "ParsePipeline.h"
+
+namespace RDKit {
+  namespace detail {
+    namespace {
+      // must be called from inside a catch block.
+      // boost::current_exception() slices anything derived from
+      // std::runtime_error, so our own exceptions are copied explicitly
+      boost::exception_ptr captureException(){
+        try {
+          throw;
+        } catch (const FileParseException &e) {
+          return boost::copy_exception(e);
+        } catch (const BadFileException &e) {
+          return boost::copy_exception(e);
+        } catch (const ValueErrorException &e) {
+          return boost::copy_exception(e);
+        } catch (const IndexErrorException &e) {
+          return boost::copy_exception(e);
+        } catch (const KeyErrorException &e) {
+          return boost::copy_exception(e);
+        } catch (const Invar::Invariant &e) {
+          return boost::copy_exception(e);
+        } catch (...) {
+          return boost::current_exception();
+        }
+      }
+    }
+
+    RecordBatch::~RecordBatch() {
+      for(unsigned int i=0;i<mols.size();++i){
+        delete mols[i];
+      }
+    }
+
+    ParsePipeline::ParsePipeline(unsigned int numThreads,bool ordered,
+                                 unsigned int batchSize) :
+      df_ordered(ordered), d_batchSize(batchSize), d_numThreads(numThreads),
+      d_nBatchesRead(0), d_nRecordsRead(0) {
+      PRECONDITION(batchSize>0,"batchSize must be positive");
+#ifdef RDK_THREADSAFE_SSS
+      d_nBatchesQueued=0;
+      d_nBatchesHandedOut=0;
+      d_nOutstanding=0;
+      // enough to keep the workers busy while the consumer is waiting
+      // for a slow batch:
+      d_maxOutstanding=4*numThreads;
+      df_readDone=false;
+      df_stop=false;
+#endif
+    };
+
+    ParsePipeline::~ParsePipeline() {
+#ifdef RDK_THREADSAFE_SSS
+      // stop() has been called by now, so we own everything in the queues:
+      for(unsigned int i=0;i<d_toParse.size();++i){
+        delete d_toParse[i];
+      }
+      for(std::map<unsigned int,RecordBatch *>::iterator it=d_parsed.begin();
+          it!=d_parsed.end();++it){
+        delete it->second;
+      }
+#endif
+    };
+
+    void ParsePipeline::start(){
+#ifdef RDK_THREADSAFE_SSS
+      if(d_numThreads>1){
+        // make sure the lazily constructed globals exist before the
+        // threads start using them:
+        PeriodicTable::getTable();
+        d_threads.add_thread(new boost::thread(&ParsePipeline::readerLoop,this));
+        for(unsigned int i=0;i<d_numThreads;++i){
+          d_threads.add_thread(new boost::thread(&ParsePipeline::workerLoop,this));
+        }
+      }
+#endif
+    }
+
+    void ParsePipeline::stop(){
+#ifdef RDK_THREADSAFE_SSS
+      if(d_numThreads>1){
+        {
+          boost::mutex::scoped_lock lock(d_mutex);
+          df_stop=true;
+        }
+        d_readerCond.notify_all();
+        d_workerCond.notify_all();
+        d_threads.join_all();
+      }
+#endif
+    }
+
+    RecordBatch *ParsePipeline::getBatch(){
+#ifdef RDK_THREADSAFE_SSS
+      if(d_numThreads>1){
+        boost::mutex::scoped_lock lock(d_mutex);
+        while(1){
+          std::map<unsigned int,RecordBatch *>::iterator it;
+          it = df_ordered ? d_parsed.find(d_nBatchesHandedOut) : d_parsed.begin();
+          if(it!=d_parsed.end()){
+            RecordBatch *res=it->second;
+            d_parsed.erase(it);
+            ++d_nBatchesHandedOut;
+            return res;
+          }
+          if(df_readDone && d_nBatchesHandedOut>=d_nBatchesQueued){
+            if(d_readError){
+              boost::exception_ptr err=d_readError;
+              d_readError=boost::exception_ptr();
+              boost::rethrow_exception(err);
+            }
+            return 0;
+          }
+          d_consumerCond.wait(lock);
+        }
+      }
+#endif
+      RecordBatch *res=readBatch();
+      if(res) parseBatch(res);
+      return res;
+    }
+
+    void ParsePipeline::releaseBatch(RecordBatch *batch){
+      delete batch;
+#ifdef RDK_THREADSAFE_SSS
+      if(d_numThreads>1){
+        {
+          boost::mutex::scoped_lock lock(d_mutex);
+          --d_nOutstanding;
+        }
+        d_readerCond.notify_one();
+      }
+#endif
+    }
+
+#ifdef RDK_THREADSAFE_SSS
+    void ParsePipeline::readerLoop(){
+      while(1){
+        {
+          boost::mutex::scoped_lock lock(d_mutex);
+          while(d_nOutstanding>=d_maxOutstanding && !df_stop){
+            d_readerCond.wait(lock);
+          }
+          if(df_stop) return;
+        }
+        RecordBatch *batch=0;
+        boost::exception_ptr err;
+        try {
+          batch=readBatch();
+        } catch (...) {
+          // exceptions can't be allowed to escape the thread, hold on to
+          // it so that getBatch() can rethrow it on the consumer's thread:
+          err=captureException();
+        }
+        {
+          boost::mutex::scoped_lock lock(d_mutex);
+          if(err) d_readError=err;
+          if(!batch){
+            df_readDone=true;
+          } else {
+            d_toParse.push_back(batch);
+            ++d_nBatchesQueued;
+            ++d_nOutstanding;
+          }
+        }
+        if(!batch){
+          d_workerCond.notify_all();
+          d_consumerCond.notify_all();
+          return;
+        }
+        d_workerCond.notify_one();
+      }
+    }
+
+    void ParsePipeline::workerLoop(){
+      while(1){
+        RecordBatch *batch;
+        {
+          boost::mutex::scoped_lock lock(d_mutex);
+          while(d_toParse.empty() && !df_readDone && !df_stop){
+            d_workerCond.wait(lock);
+          }
+          if(df_stop || d_toParse.empty()) return;
+          batch=d_toParse.front();
+          d_toParse.pop_front();
+        }
+        parseBatch(batch);
+        {
+          boost::mutex::scoped_lock lock(d_mutex);
+          d_parsed[batch->idx]=batch;
+        }
+        d_consumerCond.notify_all();
+      }
+    }
+#endif
+
+    RecordBatch *ParsePipeline::readBatch(){
+      if(d_pendingError){
+        boost::exception_ptr err=d_pendingError;
+        d_pendingError=boost::exception_ptr();
+        boost::rethrow_exception(err);
+      }
+      RecordBatch *res=new RecordBatch();
+      res->idx=d_nBatchesRead;
+      res->firstRecord=d_nRecordsRead;
+      std::string text;
+      int lineNum;
+      try {
+        while(res->texts.size()<d_batchSize && readRecord(text,lineNum)){
+          res->texts.push_back(text);
+          res->lineNums.push_back(lineNum);
+        }
+      } catch (...) {
+        if(res->texts.empty()){
+          delete res;
+          throw;
+        }
+        // hand out the records we did get, the error is thrown by the
+        // next call:
+        d_pendingError=captureException();
+      }
+      if(res->texts.empty()){
+        delete res;
+        return 0;
+      }
+      ++d_nBatchesRead;
+      d_nRecordsRead+=res->texts.size();
+      return res;
+    }
+
+    void ParsePipeline::parseBatch(RecordBatch *batch) const {
+      batch->mols.resize(batch->texts.size(),0);
+      batch->errors.resize(batch->texts.size());
+      for(unsigned int i=0;i<batch->texts.size();++i){
+        parseRecord(batch,i);
+      }
+    }
+  } // end of namespace detail
+}
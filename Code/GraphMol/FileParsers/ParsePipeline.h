@@ -0,0 +1,111 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+// This is an internal header used by the multithreaded suppliers, it is not
+// installed.
+//
+#ifndef _RD_PARSEPIPELINE_H
+#define _RD_PARSEPIPELINE_H
+
+#include <RDGeneral/types.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <boost/exception_ptr.hpp>
+
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread.hpp>
+#endif
+
+namespace RDKit {
+  class ROMol;
+  namespace detail {
+    struct RecordBatch {
+      unsigned int idx;          // position of the batch in the stream
+      unsigned int firstRecord;  // index of the first record in the batch
+      std::vector<std::string> texts;
+      std::vector<int> lineNums;     // line number of the start of each record
+      std::vector<ROMol *> mols;
+      std::vector<std::string> errors; // empty for records that were parsed
+      ~RecordBatch();
+    };
+
+    // splits a stream into batches of records and parses them. With more
+    // than one thread a reader thread keeps a queue of batches filled and
+    // the worker threads parse them; otherwise everything happens on the
+    // caller's thread when a batch is requested.
+    //
+    // Derived classes provide readRecord() and parseRecord(). Since the
+    // threads call those, derived classes must call start() at the end of
+    // their constructor and stop() at the beginning of their destructor.
+    class ParsePipeline {
+    public:
+      ParsePipeline(unsigned int numThreads,bool ordered,unsigned int batchSize);
+      virtual ~ParsePipeline();
+
+      //! returns the next parsed batch, NULL when the stream is exhausted
+      /*!
+        If reading the stream failed, the exception thrown by the reader
+        is rethrown here once the batches read before the failure have
+        been handed out.
+      */
+      RecordBatch *getBatch();
+      //! called when the consumer is done with a batch
+      void releaseBatch(RecordBatch *batch);
+
+    protected:
+      void start();
+      void stop();
+      //! reads the text of the next record, returns false at the end of the input.
+      //! This is never called from two threads at once.
+      virtual bool readRecord(std::string &text,int &lineNum)=0;
+      //! parses a record, this is called from the worker threads
+      virtual void parseRecord(RecordBatch *batch,unsigned int which) const=0;
+
+    private:
+      bool df_ordered;
+      unsigned int d_batchSize,d_numThreads;
+      // only touched by whoever is reading the stream:
+      unsigned int d_nBatchesRead,d_nRecordsRead;
+      boost::exception_ptr d_pendingError; // thrown by the next readBatch()
+      RecordBatch *readBatch();
+      void parseBatch(RecordBatch *batch) const;
+#ifdef RDK_THREADSAFE_SSS
+      // everything below is protected by d_mutex:
+      std::deque<RecordBatch *> d_toParse;
+      std::map<unsigned int,RecordBatch *> d_parsed;
+      unsigned int d_nBatchesQueued,d_nBatchesHandedOut;
+      unsigned int d_nOutstanding,d_maxOutstanding;
+      bool df_readDone,df_stop;
+      boost::exception_ptr d_readError; // set if the reader thread failed
+      boost::mutex d_mutex;
+      boost::condition_variable d_readerCond,d_workerCond,d_consumerCond;
+      boost::thread_group d_threads;
+
+      void readerLoop();
+      void workerLoop();
+#endif
+    };
+
+    //! builds a molecule from a line of a SMILES file; this is shared by
+    //! SmilesMolSupplier and MultithreadedSmilesMolSupplier.
+    /*!
+      Throws a SmilesParseException, MolSanitizeException or
+      FileParseException if the line can't be handled.
+    */
+    ROMol *SmilesLineToMol(const std::string &line,const std::string &delimiter,
+                           int smilesColumn,int nameColumn,const STR_VECT &props,
+                           bool sanitize,int lineNum);
+  } // end of namespace detail
+}
+
+#endif
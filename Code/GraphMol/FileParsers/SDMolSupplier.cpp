@@ -16,6 +16,7 @@
 
 
 #include <boost/algorithm/string.hpp>
+#include <boost/cstdint.hpp>
 #include "MolSupplier.h"
 #include "FileParsers.h"
 
@@ -23,6 +24,7 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <cstring>
 
 namespace RDKit {
   
@@ -279,9 +281,102 @@ namespace RDKit {
     this->reset();
     d_len = d_molpos.size();
   }
-}
- 
 
+  namespace {
+    // the stream index format. Everything is little-endian:
+    //   char[8]  magic
+    //   uint32   format version
+    //   uint64   size of the stream the index was built from
+    //   uint64   number of molecules
+    //   uint64   position of each molecule
+    const char sdIndexMagic[8]={'R','D','K','S','D','I','D','X'};
+    const boost::uint32_t sdIndexVersion=1;
 
+    boost::uint64_t getStreamSize(std::istream *inStream){
+      inStream->clear();
+      std::streampos holder=inStream->tellg();
+      inStream->seekg(0,std::ios_base::end);
+      boost::uint64_t res=static_cast<std::streamoff>(inStream->tellg());
+      inStream->seekg(holder);
+      return res;
+    }
+  }
 
+  void SDMolSupplier::writeStreamIndices(const std::string &fileName){
+    PRECONDITION(dp_inStream,"no stream");
+    unsigned int nMols=length();
+    std::ofstream outStream(fileName.c_str(),std::ios_base::binary);
+    if(!outStream || outStream.bad()){
+      std::ostringstream errout;
+      errout << "Bad output file " << fileName;
+      throw BadFileException(errout.str());
+    }
+    outStream.write(sdIndexMagic,sizeof(sdIndexMagic));
+    streamWrite(outStream,sdIndexVersion);
+    streamWrite(outStream,getStreamSize(dp_inStream));
+    streamWrite(outStream,static_cast<boost::uint64_t>(nMols));
+    for(unsigned int i=0;i<nMols;++i){
+      streamWrite(outStream,static_cast<boost::uint64_t>(static_cast<std::streamoff>(d_molpos[i])));
+    }
+    if(!outStream){
+      std::ostringstream errout;
+      errout << "Error writing index file " << fileName;
+      throw BadFileException(errout.str());
+    }
+  }
 
+  void SDMolSupplier::readStreamIndices(const std::string &fileName){
+    PRECONDITION(dp_inStream,"no stream");
+    std::ifstream inStream(fileName.c_str(),std::ios_base::binary);
+    if(!inStream || inStream.bad()){
+      std::ostringstream errout;
+      errout << "Bad index file " << fileName;
+      throw BadFileException(errout.str());
+    }
+    char magic[sizeof(sdIndexMagic)];
+    inStream.read(magic,sizeof(magic));
+    boost::uint32_t version=0;
+    boost::uint64_t streamSize=0,nMols=0;
+    streamRead(inStream,version);
+    streamRead(inStream,streamSize);
+    streamRead(inStream,nMols);
+    if(!inStream || memcmp(magic,sdIndexMagic,sizeof(magic)) || version!=sdIndexVersion){
+      std::ostringstream errout;
+      errout << fileName << " is not an SD index file";
+      throw BadFileException(errout.str());
+    }
+    if(streamSize!=getStreamSize(dp_inStream)){
+      std::ostringstream errout;
+      errout << "Index file " << fileName << " does not match the input stream";
+      throw BadFileException(errout.str());
+    }
+    // every molecule starts at a different position in the input and
+    // needs an entry in the index, so a bigger count can't be right:
+    std::streampos dataStart=inStream.tellg();
+    inStream.seekg(0,std::ios_base::end);
+    boost::uint64_t dataSize=static_cast<std::streamoff>(inStream.tellg()-dataStart);
+    inStream.seekg(dataStart);
+    if(nMols>streamSize || nMols>dataSize/sizeof(boost::uint64_t)){
+      std::ostringstream errout;
+      errout << "Corrupt index file " << fileName;
+      throw BadFileException(errout.str());
+    }
+    std::vector<std::streampos> locs;
+    locs.reserve(nMols);
+    for(boost::uint64_t i=0;i<nMols;++i){
+      boost::uint64_t pos;
+      streamRead(inStream,pos);
+      if(!inStream || pos>=streamSize){
+        std::ostringstream errout;
+        errout << "Corrupt index file " << fileName;
+        throw BadFileException(errout.str());
+      }
+      locs.push_back(static_cast<std::streamoff>(pos));
+    }
+    // an empty index goes with an empty stream, and we already know that
+    // we're at the end of that:
+    if(!locs.empty()){
+      setStreamIndices(locs);
+    }
+  }
+}
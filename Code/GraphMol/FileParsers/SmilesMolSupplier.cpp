@@ -14,6 +14,7 @@
 #include <RDGeneral/RDLog.h>
 #include "MolSupplier.h"
 #include "FileParsers.h"
+#include "ParsePipeline.h"
 #include <GraphMol/SmilesParse/SmilesParse.h>
 #include <boost/tokenizer.hpp>
 typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
@@ -160,64 +161,65 @@ namespace RDKit {
     }
   }
 
-  ROMol *SmilesMolSupplier::processLine(std::string inLine) {
-    ROMol *res = NULL;
+  namespace detail {
+    ROMol *SmilesLineToMol(const std::string &line,const std::string &delimiter,
+                           int smilesColumn,int nameColumn,const STR_VECT &props,
+                           bool sanitize,int lineNum){
+      ROMol *res = NULL;
 
-    try{
       // -----------
       // tokenize the input line:
       // -----------
-      boost::char_separator<char> sep(d_delim.c_str(),"",boost::keep_empty_tokens);
-      tokenizer tokens(inLine,sep);
+      boost::char_separator<char> sep(delimiter.c_str(),"",boost::keep_empty_tokens);
+      tokenizer tokens(line,sep);
       STR_VECT recs;
       for(tokenizer::iterator tokIter=tokens.begin();
           tokIter!=tokens.end();++tokIter){
         std::string rec = strip(*tokIter);
         recs.push_back(rec);
       }
-      if(recs.size()<=static_cast<unsigned int>(d_smi)){
+      if(recs.size()<=static_cast<unsigned int>(smilesColumn)){
         std::ostringstream errout;
-        errout << "ERROR: line #" << d_line  << "does not contain enough tokens\n";
+        errout << "ERROR: line #" << lineNum  << "does not contain enough tokens\n";
         throw FileParseException(errout.str());
       }
 
       // -----------
       // get the smiles and create a molecule
       // -----------
-      res = SmilesToMol(recs[d_smi], 0, df_sanitize);
+      res = SmilesToMol(recs[smilesColumn], 0, sanitize);
       if (!res) {
         std::stringstream errout;
-        errout << "Cannot create molecule from : '" << recs[d_smi] << "'";
+        errout << "Cannot create molecule from : '" << recs[smilesColumn] << "'";
         throw SmilesParseException(errout.str());
       }
 
       // -----------
       // get the name (if there's a name column)
       // -----------
-      if (d_name == -1) {
+      if (nameColumn == -1) {
         // if no name defaults it to the line number we read it from string
         std::ostringstream tstr;
-        tstr << d_line;
+        tstr << lineNum;
         std::string mname = tstr.str();
         res->setProp("_Name", mname);
       }
       else {
-        if(d_name>=static_cast<int>(recs.size())){
-          BOOST_LOG(rdWarningLog)<<"WARNING: no name column found on line "<<d_line<<std::endl;
+        if(nameColumn>=static_cast<int>(recs.size())){
+          BOOST_LOG(rdWarningLog)<<"WARNING: no name column found on line "<<lineNum<<std::endl;
         } else {
-          res->setProp("_Name", recs[d_name]);
+          res->setProp("_Name", recs[nameColumn]);
         }
       }
 
       // -----------
       // read in the properties 
       // -----------
-      unsigned int iprop = 0;
       for (unsigned int col = 0; col < recs.size(); col++) {
-        if(static_cast<int>(col)==d_smi || static_cast<int>(col)==d_name) continue;
+        if(static_cast<int>(col)==smilesColumn || static_cast<int>(col)==nameColumn) continue;
         std::string pname, pval;
-        if (d_props.size() > col) {
-          pname = d_props[col];
+        if (props.size() > col) {
+          pname = props[col];
         }
         else {
           pname = "Column_";
@@ -228,9 +230,16 @@ namespace RDKit {
 
         pval = recs[col];
         res->setProp(pname, pval);
-        iprop++;
       }
-            
+      return res;
+    }
+  } // end of namespace detail
+
+  ROMol *SmilesMolSupplier::processLine(std::string inLine) {
+    ROMol *res = NULL;
+
+    try{
+      res = detail::SmilesLineToMol(inLine,d_delim,d_smi,d_name,d_props,df_sanitize,d_line);
     }
     catch(const SmilesParseException &pe) {
       // Couldn't parse the passed in smiles
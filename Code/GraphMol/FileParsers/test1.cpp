@@ -13,6 +13,7 @@
 #include <GraphMol/Canon.h> 
 #include "FileParsers.h"
 #include "MolFileStereochem.h"
+#include "FileParserUtils.h"
 #include <GraphMol/SmilesParse/SmilesParse.h>
 #include <GraphMol/SmilesParse/SmilesWrite.h>
 #include <GraphMol/SmilesParse/SmartsWrite.h>
@@ -21,6 +22,7 @@
 #include <RDGeneral/BadFileException.h>
 
 #include <string>
+#include <limits>
 #include <fstream>
 #include <boost/lexical_cast.hpp>
 
@@ -2932,6 +2934,99 @@ void  testIssue269(){
   BOOST_LOG(rdInfoLog) << "done" << std::endl;
 }
 
+void testFixedColumnParsing(){
+  BOOST_LOG(rdInfoLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdInfoLog) << "Testing fixed-column number parsing" << std::endl;
+
+  {
+    const char *fields[]={"    0.0000","   -1.2990","    1.5000"," 12345.6789",
+                          "-0.1234567890123","  2.5e-3 ","1.0000000000000000001",
+                          "     .5","   -0.","  +3.25","1e5"};
+    for(unsigned int i=0;i<sizeof(fields)/sizeof(fields[0]);++i){
+      std::string field(fields[i]);
+      TEST_ASSERT(FileParserUtils::toDouble(field)==atof(field.c_str()));
+    }
+  }
+  {
+    const char *fields[]={"  0","  1"," -1","999","+12","1 2","12a"};
+    for(unsigned int i=0;i<sizeof(fields)/sizeof(fields[0]);++i){
+      std::string field(fields[i]);
+      TEST_ASSERT(FileParserUtils::toInt(field)==strtol(field.c_str(),NULL,10));
+    }
+  }
+  {
+    // values that don't fit are clamped, like strtol() does:
+    TEST_ASSERT(FileParserUtils::toInt("99999999999")==std::numeric_limits<int>::max());
+    TEST_ASSERT(FileParserUtils::toInt("-99999999999")==std::numeric_limits<int>::min());
+    TEST_ASSERT(FileParserUtils::toInt("2147483647")==2147483647);
+    TEST_ASSERT(FileParserUtils::toInt("-2147483647")==-2147483647);
+  }
+  {
+    // fields are read in place and truncated at the end of the line:
+    std::string text="    1.2500   -0.7500    0.0000 C   0  3";
+    TEST_ASSERT(feq(FileParserUtils::toDouble(text,0,10),1.25));
+    TEST_ASSERT(feq(FileParserUtils::toDouble(text,10,10),-0.75));
+    TEST_ASSERT(FileParserUtils::toInt(text,36,3,true)==3);
+    TEST_ASSERT(FileParserUtils::toInt(text,37,3,true)==3);
+    TEST_ASSERT(FileParserUtils::toInt(text,text.size(),3,true)==0);
+    // but a field that starts past the end is missing:
+    bool ok=false;
+    try {
+      FileParserUtils::toInt(text,50,3,true);
+    } catch (FileParseException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    ok=false;
+    try {
+      FileParserUtils::toDouble(text,50,10);
+    } catch (FileParseException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+  }
+  {
+    // blank fields are only accepted if we ask for it:
+    TEST_ASSERT(FileParserUtils::toInt("   ",true)==0);
+    TEST_ASSERT(FileParserUtils::toDouble("   ")==0.0);
+    bool ok=false;
+    try {
+      FileParserUtils::toInt("   ");
+    } catch (boost::bad_lexical_cast &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    ok=false;
+    try {
+      FileParserUtils::toDouble("   ",false);
+    } catch (boost::bad_lexical_cast &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+  }
+  {
+    std::string rdbase = getenv("RDBASE");
+    std::string fName = rdbase + "/Code/GraphMol/FileParsers/test_data/ChiralityAndBondDir1a.mol";
+    RWMol *m = MolFileToMol(fName);
+    TEST_ASSERT(m);
+    std::string mb=MolToMolBlock(*m);
+    RWMol *m2 = MolBlockToMol(mb);
+    TEST_ASSERT(m2);
+    TEST_ASSERT(m2->getNumAtoms()==m->getNumAtoms());
+    TEST_ASSERT(m2->getNumBonds()==m->getNumBonds());
+    for(unsigned int i=0;i<m->getNumAtoms();++i){
+      RDGeom::Point3D p1=m->getConformer().getAtomPos(i);
+      RDGeom::Point3D p2=m2->getConformer().getAtomPos(i);
+      TEST_ASSERT(feq(p1.x,p2.x));
+      TEST_ASSERT(feq(p1.y,p2.y));
+      TEST_ASSERT(feq(p1.z,p2.z));
+    }
+    delete m;
+    delete m2;
+  }
+
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
 
 
 int main(int argc,char *argv[]){
@@ -2992,6 +3087,7 @@ int main(int argc,char *argv[]){
   testSkipLines();
 #endif
   testIssue269();
+  testFixedColumnParsing();
 
   return 0;
 }
@@ -12,6 +12,8 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <cstdio>
 #include <map>
 
 #include "MolSupplier.h"
@@ -1872,6 +1874,370 @@ void testGitHub23() {
 
 
 
+void testStreamIndexFiles() {
+  std::string rdbase = getenv("RDBASE");
+  std::string fname = rdbase + "/Code/GraphMol/FileParsers/test_data/NCI_aids_few.sdf";
+  std::string iname = rdbase + "/Code/GraphMol/FileParsers/test_data/NCI_aids_few.sdf.idx";
+
+  std::vector<std::string> smis;
+  {
+    SDMolSupplier sdsup(fname);
+    sdsup.writeStreamIndices(iname);
+    TEST_ASSERT(sdsup.length()==16);
+    for(unsigned int i=0;i<16;++i){
+      ROMol *mol=sdsup[i];
+      TEST_ASSERT(mol);
+      smis.push_back(MolToSmiles(*mol,true));
+      delete mol;
+    }
+  }
+  {
+    SDMolSupplier sdsup(fname);
+    sdsup.readStreamIndices(iname);
+    TEST_ASSERT(sdsup.length()==16);
+    // random access first:
+    for(unsigned int i=16;i>0;--i){
+      ROMol *mol=sdsup[i-1];
+      TEST_ASSERT(mol);
+      TEST_ASSERT(MolToSmiles(*mol,true)==smis[i-1]);
+      delete mol;
+    }
+    sdsup.reset();
+    unsigned int count=0;
+    while(!sdsup.atEnd()){
+      ROMol *mol=sdsup.next();
+      TEST_ASSERT(mol);
+      TEST_ASSERT(MolToSmiles(*mol,true)==smis[count]);
+      delete mol;
+      ++count;
+    }
+    TEST_ASSERT(count==16);
+  }
+  {
+    // the index doesn't go with this file:
+    SDMolSupplier sdsup(rdbase + "/Code/GraphMol/FileParsers/test_data/Issue381.sdf");
+    bool ok=false;
+    try{
+      sdsup.readStreamIndices(iname);
+    } catch (BadFileException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    // and this isn't an index:
+    ok=false;
+    try{
+      sdsup.readStreamIndices(fname);
+    } catch (BadFileException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+  }
+  {
+    // an index with a bad molecule count:
+    std::string badName = iname+".bad";
+    std::string text;
+    {
+      std::ifstream inf(iname.c_str(),std::ios_base::binary);
+      std::stringstream tmp;
+      tmp<<inf.rdbuf();
+      text=tmp.str();
+    }
+    // the count follows the magic number, version and stream size:
+    for(unsigned int i=0;i<8;++i) text[8+4+8+i]=static_cast<char>(0x7f);
+    {
+      std::ofstream outf(badName.c_str(),std::ios_base::binary);
+      outf.write(text.c_str(),text.size());
+    }
+    SDMolSupplier sdsup(fname);
+    bool ok=false;
+    try{
+      sdsup.readStreamIndices(badName);
+    } catch (BadFileException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    std::remove(badName.c_str());
+  }
+  std::remove(iname.c_str());
+}
+
+void testMultithreadedSDSupplier() {
+  std::string rdbase = getenv("RDBASE");
+  std::string fnames[]={"NCI_aids_few.sdf","Issue381.sdf","sdErrors2.sdf","earlyEOF.sdf",
+                        "esters_end.sdf","Issue3525673.sdf","withHs.sdf","BlankPropLines.sdf",
+                        ""};
+  for(unsigned int fi=0;fnames[fi]!="";++fi){
+    std::string fname = rdbase + "/Code/GraphMol/FileParsers/test_data/"+fnames[fi];
+    // what the regular supplier gives us:
+    std::vector<std::string> refSmis,refNames,refTexts;
+    {
+      SDMolSupplier sdsup(fname);
+      while(!sdsup.atEnd()){
+        ROMol *mol=sdsup.next();
+        if(mol){
+          refSmis.push_back(MolToSmiles(*mol,true));
+          std::string name="";
+          if(mol->hasProp("_Name")) mol->getProp("_Name",name);
+          refNames.push_back(name);
+          delete mol;
+        } else {
+          refSmis.push_back("NULL");
+          refNames.push_back("");
+        }
+      }
+      for(unsigned int i=0;i<refSmis.size();++i){
+        refTexts.push_back(sdsup.getItemText(i));
+      }
+    }
+    unsigned int threadCounts[]={1,2,4};
+    unsigned int batchSizes[]={1,3,32};
+    for(unsigned int ti=0;ti<3;++ti){
+      for(unsigned int bi=0;bi<3;++bi){
+        for(unsigned int ordered=0;ordered<2;++ordered){
+          MultithreadedSDMolSupplier sdsup(fname,true,true,true,threadCounts[ti],
+                                           ordered,batchSizes[bi]);
+          std::vector<bool> seen(refSmis.size(),false);
+          unsigned int count=0;
+          while(!sdsup.atEnd()){
+            ROMol *mol=sdsup.next();
+            unsigned int idx=sdsup.getLastRecordIdx();
+            if(ordered) TEST_ASSERT(idx==count);
+            TEST_ASSERT(idx<refSmis.size());
+            TEST_ASSERT(!seen[idx]);
+            seen[idx]=true;
+            // (getItemText() includes any blank lines at the end of the file
+            // in the last record, the multithreaded supplier doesn't)
+            TEST_ASSERT(strip(sdsup.getLastItemText())==strip(refTexts[idx]));
+            if(mol){
+              TEST_ASSERT(MolToSmiles(*mol,true)==refSmis[idx]);
+              std::string name="";
+              if(mol->hasProp("_Name")) mol->getProp("_Name",name);
+              TEST_ASSERT(name==refNames[idx]);
+              delete mol;
+            } else {
+              TEST_ASSERT(refSmis[idx]=="NULL");
+            }
+            ++count;
+          }
+          TEST_ASSERT(count==refSmis.size());
+          bool ok=false;
+          try{
+            sdsup.next();
+          } catch (FileParseException &) {
+            ok=true;
+          }
+          TEST_ASSERT(ok);
+        }
+      }
+    }
+  }
+  {
+    // stop reading before the end:
+    std::string fname = rdbase + "/Code/GraphMol/FileParsers/test_data/NCI_aids_few.sdf";
+    MultithreadedSDMolSupplier sdsup(fname,true,true,true,3,false,1);
+    ROMol *mol=sdsup.next();
+    delete mol;
+  }
+  {
+    std::istringstream *inStream=new std::istringstream("");
+    MultithreadedSDMolSupplier sdsup(inStream,true,true,true,2);
+    TEST_ASSERT(sdsup.atEnd());
+  }
+}
+
+// a stream buffer that throws instead of reporting the end of its data
+class failingStreamBuf : public std::stringbuf {
+public:
+  failingStreamBuf(const std::string &text) : std::stringbuf(text) {};
+protected:
+  int_type underflow() {
+    int_type res=std::stringbuf::underflow();
+    if(traits_type::eq_int_type(res,traits_type::eof())){
+      throw ValueErrorException("read failed");
+    }
+    return res;
+  }
+};
+
+void testMultithreadedSmilesSupplier() {
+  std::string rdbase = getenv("RDBASE");
+  std::string fnames[]={rdbase+"/Code/GraphMol/FileParsers/test_data/first_200.tpsa.csv",
+                        rdbase+"/Data/NCI/first_5K.smi",
+                        ""};
+  std::string delims[]={",","\t"};
+  int smiCols[]={0,0};
+  int nameCols[]={-1,1};
+  bool titles[]={true,false};
+  for(unsigned int fi=0;fnames[fi]!="";++fi){
+    // what the regular supplier gives us:
+    std::vector<std::string> refSmis,refNames,refTPSAs;
+    {
+      SmilesMolSupplier smisup(fnames[fi],delims[fi],smiCols[fi],nameCols[fi],titles[fi]);
+      while(!smisup.atEnd()){
+        ROMol *mol=smisup.next();
+        if(mol){
+          refSmis.push_back(MolToSmiles(*mol,true));
+          std::string name="",tpsa="";
+          if(mol->hasProp("_Name")) mol->getProp("_Name",name);
+          if(mol->hasProp("TPSA")) mol->getProp("TPSA",tpsa);
+          refNames.push_back(name);
+          refTPSAs.push_back(tpsa);
+          delete mol;
+        } else {
+          refSmis.push_back("NULL");
+          refNames.push_back("");
+          refTPSAs.push_back("");
+        }
+      }
+    }
+    TEST_ASSERT(refSmis.size()>0);
+    if(fi==0) TEST_ASSERT(refTPSAs[0]=="34.14");
+    unsigned int threadCounts[]={1,2,4};
+    unsigned int batchSizes[]={1,7,256};
+    for(unsigned int ti=0;ti<3;++ti){
+      for(unsigned int bi=0;bi<3;++bi){
+        for(unsigned int ordered=0;ordered<2;++ordered){
+          MultithreadedSmilesMolSupplier smisup(fnames[fi],delims[fi],smiCols[fi],
+                                                nameCols[fi],titles[fi],true,
+                                                threadCounts[ti],ordered,batchSizes[bi]);
+          std::vector<bool> seen(refSmis.size(),false);
+          unsigned int count=0;
+          while(!smisup.atEnd()){
+            ROMol *mol=smisup.next();
+            unsigned int idx=smisup.getLastRecordIdx();
+            if(ordered) TEST_ASSERT(idx==count);
+            TEST_ASSERT(idx<refSmis.size());
+            TEST_ASSERT(!seen[idx]);
+            seen[idx]=true;
+            if(mol){
+              TEST_ASSERT(MolToSmiles(*mol,true)==refSmis[idx]);
+              std::string name="",tpsa="";
+              if(mol->hasProp("_Name")) mol->getProp("_Name",name);
+              if(mol->hasProp("TPSA")) mol->getProp("TPSA",tpsa);
+              TEST_ASSERT(name==refNames[idx]);
+              TEST_ASSERT(tpsa==refTPSAs[idx]);
+              delete mol;
+            } else {
+              TEST_ASSERT(refSmis[idx]=="NULL");
+            }
+            ++count;
+          }
+          TEST_ASSERT(count==refSmis.size());
+          bool ok=false;
+          try{
+            smisup.next();
+          } catch (FileParseException &) {
+            ok=true;
+          }
+          TEST_ASSERT(ok);
+        }
+      }
+    }
+    {
+      // the batch interface:
+      MultithreadedSmilesMolSupplier smisup(fnames[fi],delims[fi],smiCols[fi],
+                                            nameCols[fi],titles[fi],true,2,true,100);
+      std::vector<ROMol *> mols;
+      std::vector<MultithreadedSmilesMolSupplier::RecordError> errors;
+      unsigned int count=0;
+      while(smisup.nextBatch(mols,errors)){
+        TEST_ASSERT(mols.size()<=100);
+        unsigned int nErrors=0;
+        for(unsigned int i=0;i<mols.size();++i){
+          if(mols[i]){
+            TEST_ASSERT(MolToSmiles(*mols[i],true)==refSmis[count]);
+            delete mols[i];
+          } else {
+            TEST_ASSERT(refSmis[count]=="NULL");
+            TEST_ASSERT(nErrors<errors.size());
+            TEST_ASSERT(errors[nErrors].recordIdx==count);
+            ++nErrors;
+          }
+          ++count;
+        }
+        TEST_ASSERT(nErrors==errors.size());
+        TEST_ASSERT(smisup.getLastRecordIdx()==count-1);
+      }
+      TEST_ASSERT(count==refSmis.size());
+      TEST_ASSERT(smisup.atEnd());
+    }
+  }
+  {
+    // errors are reported per record:
+    std::string text="smiles name\n"
+      "CCO ethanol\n"
+      "# a comment\n"
+      "\n"
+      "c1cccc1 bad_aromatic\n"
+      "C1CC bad_ring\n"
+      "c1ccccc1 benzene\n";
+    for(unsigned int nt=1;nt<3;++nt){
+      std::istringstream *inStream=new std::istringstream(text);
+      MultithreadedSmilesMolSupplier smisup(inStream,true," \t",0,1,true,true,nt,true,3);
+      std::vector<ROMol *> mols;
+      std::vector<MultithreadedSmilesMolSupplier::RecordError> errors;
+      TEST_ASSERT(smisup.nextBatch(mols,errors));
+      TEST_ASSERT(mols.size()==3);
+      TEST_ASSERT(mols[0]);
+      TEST_ASSERT(!mols[1]);
+      TEST_ASSERT(!mols[2]);
+      delete mols[0];
+      TEST_ASSERT(errors.size()==2);
+      TEST_ASSERT(errors[0].recordIdx==1);
+      TEST_ASSERT(errors[0].lineNum==4);
+      TEST_ASSERT(errors[0].text=="c1cccc1 bad_aromatic");
+      TEST_ASSERT(errors[0].message.find("Could not sanitize")==0);
+      TEST_ASSERT(errors[1].recordIdx==2);
+      TEST_ASSERT(errors[1].lineNum==5);
+      TEST_ASSERT(errors[1].message.find("Smiles parse error")==0);
+
+      TEST_ASSERT(smisup.nextBatch(mols,errors));
+      TEST_ASSERT(mols.size()==1);
+      TEST_ASSERT(errors.empty());
+      TEST_ASSERT(mols[0]);
+      std::string name;
+      mols[0]->getProp("_Name",name);
+      TEST_ASSERT(name=="benzene");
+      delete mols[0];
+      TEST_ASSERT(!smisup.nextBatch(mols,errors));
+      TEST_ASSERT(mols.empty());
+    }
+  }
+  {
+    std::istringstream *inStream=new std::istringstream("");
+    MultithreadedSmilesMolSupplier smisup(inStream,true," \t",0,1,false,true,2);
+    TEST_ASSERT(smisup.atEnd());
+  }
+  {
+    // errors reading the stream are passed on to the caller, even when
+    // they happen on the reader thread. The records read before the
+    // error are returned first, including those in a partial batch:
+    for(unsigned int nt=1;nt<3;++nt){
+      for(unsigned int batchSize=1;batchSize<=8;batchSize*=8){
+        failingStreamBuf buf("CCO ethanol\nCCN ethylamine\n");
+        std::istream inStream(&buf);
+        inStream.exceptions(std::ios_base::badbit);
+        MultithreadedSmilesMolSupplier smisup(&inStream,false," \t",0,1,false,true,nt,true,
+                                              batchSize);
+        unsigned int nRead=0;
+        bool ok=false;
+        try {
+          while(!smisup.atEnd()){
+            ROMol *mol=smisup.next();
+            TEST_ASSERT(mol);
+            delete mol;
+            ++nRead;
+          }
+        } catch (const ValueErrorException &) {
+          ok=true;
+        }
+        TEST_ASSERT(ok);
+        TEST_ASSERT(nRead==2);
+      }
+    }
+  }
+}
+
 int main() {
   RDLog::InitLogs();
 
@@ -1973,6 +2339,21 @@ int main() {
   BOOST_LOG(rdErrorLog) << "-----------------------------------------\n\n";
 
   
+  BOOST_LOG(rdErrorLog) << "-----------------------------------------\n";
+  testStreamIndexFiles();
+  BOOST_LOG(rdErrorLog) <<"Finished: testStreamIndexFiles()\n";
+  BOOST_LOG(rdErrorLog) << "-----------------------------------------\n\n";
+
+  BOOST_LOG(rdErrorLog) << "-----------------------------------------\n";
+  testMultithreadedSDSupplier();
+  BOOST_LOG(rdErrorLog) <<"Finished: testMultithreadedSDSupplier()\n";
+  BOOST_LOG(rdErrorLog) << "-----------------------------------------\n\n";
+
+  BOOST_LOG(rdErrorLog) << "-----------------------------------------\n";
+  testMultithreadedSmilesSupplier();
+  BOOST_LOG(rdErrorLog) <<"Finished: testMultithreadedSmilesSupplier()\n";
+  BOOST_LOG(rdErrorLog) << "-----------------------------------------\n\n";
+
   BOOST_LOG(rdErrorLog) << "-----------------------------------------\n";
   testMixIterAndRandom();
   BOOST_LOG(rdErrorLog) <<"Finished: testMixIterAndRandom()\n";
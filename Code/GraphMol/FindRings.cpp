@@ -35,19 +35,20 @@ namespace RingUtils {
   }
 
   void convertToBonds(const VECT_INT_VECT &res, VECT_INT_VECT &brings, const ROMol &mol) {
+    const CSRGraph &g=mol.getCSRGraph();
     for (VECT_INT_VECT_CI ri=res.begin(); ri!=res.end(); ++ri) {
       unsigned int rsiz = ri->size();
       INT_VECT bring(rsiz);
       for (unsigned int i = 0; i < (rsiz-1); i++) {
-        const Bond *bnd=mol.getBondBetweenAtoms((*ri)[i],(*ri)[i+1]);
-        if(!bnd) throw ValueErrorException("expected bond not found");
-        bring[i]=bnd->getIdx();
+        int bIdx=g.getBondIdxBetweenAtoms((*ri)[i],(*ri)[i+1]);
+        if(bIdx<0) throw ValueErrorException("expected bond not found");
+        bring[i]=bIdx;
       }
       // bond from last to first atom
-      const Bond *bnd=mol.getBondBetweenAtoms((*ri)[rsiz-1],(*ri)[0]);
-      if(!bnd) throw ValueErrorException("expected bond not found");
+      int bIdx=g.getBondIdxBetweenAtoms((*ri)[rsiz-1],(*ri)[0]);
+      if(bIdx<0) throw ValueErrorException("expected bond not found");
 
-      bring[rsiz-1]=bnd->getIdx();
+      bring[rsiz-1]=bIdx;
       brings.push_back(bring);
     }
   }
@@ -62,19 +63,20 @@ namespace FindRings {
   void trimBonds(unsigned int cand, const ROMol &tMol, INT_SET &changed,
                  INT_VECT &atomDegrees,boost::dynamic_bitset<> &activeBonds);
   void storeRingInfo(const ROMol &mol, const INT_VECT &ring) {
+    const CSRGraph &g=mol.getCSRGraph();
     INT_VECT bondIndices;
     INT_VECT_CI lastRai;
     for(INT_VECT_CI rai=ring.begin();rai != ring.end();rai++){
       if(rai!=ring.begin()){
-        const Bond *bnd=mol.getBondBetweenAtoms(*rai,*lastRai);
-        if(!bnd) throw ValueErrorException("expected bond not found");
-        bondIndices.push_back(bnd->getIdx());
+        int bIdx=g.getBondIdxBetweenAtoms(*rai,*lastRai);
+        if(bIdx<0) throw ValueErrorException("expected bond not found");
+        bondIndices.push_back(bIdx);
       }
       lastRai = rai;
     }
-    const Bond *bnd=mol.getBondBetweenAtoms(*lastRai,*(ring.begin()));
-    if(!bnd) throw ValueErrorException("expected bond not found");
-    bondIndices.push_back(bnd->getIdx());
+    int bIdx=g.getBondIdxBetweenAtoms(*lastRai,*(ring.begin()));
+    if(bIdx<0) throw ValueErrorException("expected bond not found");
+    bondIndices.push_back(bIdx);
     mol.getRingInfo()->addRing(ring,bondIndices);
   }
 
@@ -88,13 +90,13 @@ namespace FindRings {
                       const INT_VECT &atomDegrees, const boost::dynamic_bitset<> &activeBonds) {
     // recursive function to mark any degree 2 nodes that are already represnted 
     // by root for the purpose of finding smallest rings.
-    ROMol::OEDGE_ITER beg,end;
-    boost::tie(beg,end) = tMol.getAtomBonds(tMol.getAtomWithIdx(root));
-    while(beg!=end){
-      BOND_SPTR bond=tMol[*beg];
-      ++beg;
-      if(!activeBonds[bond->getIdx()]) continue;
-      unsigned int oIdx=bond->getOtherAtomIdx(root);
+    const CSRGraph &g=tMol.getCSRGraph();
+    CSRGraph::IDX_ITER nbr=g.getAtomNeighbors(root).first;
+    CSRGraph::IDX_ITER beg,end;
+    boost::tie(beg,end) = g.getAtomBonds(root);
+    for(;beg!=end;++beg,++nbr){
+      if(!activeBonds[*beg]) continue;
+      unsigned int oIdx=*nbr;
       if(!forb[oIdx] && atomDegrees[oIdx]==2){
         forb[oIdx]=1;
         markUselessD2s(oIdx,tMol,forb,atomDegrees,activeBonds);
@@ -252,6 +254,7 @@ namespace FindRings {
     RINGINVAR_INT_VECT_MAP dupD2Cands;
     int cand, nsmall;
     INT_VECT_CI d2i;
+    const CSRGraph &g=tMol.getCSRGraph();
 
     INT_INT_VECT_MAP dupMap;
     // here is an example of molecule where the this scheme of finding other node that 
@@ -281,11 +284,11 @@ namespace FindRings {
           res.push_back(nring);
           invars.insert(invr);
           for(unsigned int i=0;i<nring.size()-1;++i){
-            unsigned int bIdx=tMol.getBondBetweenAtoms(nring[i],nring[i+1])->getIdx();
+            unsigned int bIdx=g.getBondIdxBetweenAtoms(nring[i],nring[i+1]);
             ringBonds.set(bIdx);
             ringAtoms.set(nring[i]);
           }
-          ringBonds.set(tMol.getBondBetweenAtoms(nring[0],nring[nring.size()-1])->getIdx());
+          ringBonds.set(g.getBondIdxBetweenAtoms(nring[0],nring[nring.size()-1]));
           ringAtoms.set(nring[nring.size()-1]);
 #if 0
           std::cerr<<"    res: "<<invr<<" | ";
@@ -363,21 +366,21 @@ namespace FindRings {
     if (nsmall < 3) {
       int n1=-1, n2=-1, n3=-1;
 
-      ROMol::OEDGE_ITER beg,end;
-      boost::tie(beg,end) = tMol.getAtomBonds(tMol.getAtomWithIdx(cand));
-      while(beg!=end && !activeBonds[tMol[*beg]->getIdx()]) ++beg;
+      const CSRGraph &g=tMol.getCSRGraph();
+      unsigned int beg=g.getSlotBegin(cand),end=g.getSlotEnd(cand);
+      while(beg!=end && !activeBonds[g.getSlotBondIdx(beg)]) ++beg;
       CHECK_INVARIANT(beg!=end,"neighbor not found");
-      n1 = tMol[*beg]->getOtherAtomIdx(cand);
+      n1 = g.getSlotTarget(beg);
 
       ++beg;
-      while(beg!=end && !activeBonds[tMol[*beg]->getIdx()]) ++beg;
+      while(beg!=end && !activeBonds[g.getSlotBondIdx(beg)]) ++beg;
       CHECK_INVARIANT(beg!=end,"neighbor not found");
-      n2 = tMol[*beg]->getOtherAtomIdx(cand);
+      n2 = g.getSlotTarget(beg);
 
       ++beg;
-      while(beg!=end && !activeBonds[tMol[*beg]->getIdx()]) ++beg;
+      while(beg!=end && !activeBonds[g.getSlotBondIdx(beg)]) ++beg;
       CHECK_INVARIANT(beg!=end,"neighbor not found");
-      n3 = tMol[*beg]->getOtherAtomIdx(cand);
+      n3 = g.getSlotTarget(beg);
 
       if (nsmall == 2) {
         // we found two rings find the third one
@@ -502,15 +505,13 @@ namespace FindRings {
   void trimBonds(unsigned int cand, const ROMol &tMol, INT_SET &changed,
                  INT_VECT &atomDegrees,boost::dynamic_bitset<> &activeBonds) {
 
-    ROMol::OEDGE_ITER beg,end;
-    boost::tie(beg,end) = tMol.getAtomBonds(tMol.getAtomWithIdx(cand));
-    while(beg!=end){
-      BOND_SPTR bond=tMol[*beg];
-      ++beg;
-      if(!activeBonds[bond->getIdx()]) continue;
-      unsigned int oIdx=bond->getOtherAtomIdx(cand);
+    const CSRGraph &g=tMol.getCSRGraph();
+    for(unsigned int slot=g.getSlotBegin(cand);slot!=g.getSlotEnd(cand);++slot){
+      unsigned int bIdx=g.getSlotBondIdx(slot);
+      if(!activeBonds[bIdx]) continue;
+      unsigned int oIdx=g.getSlotTarget(slot);
       if(atomDegrees[oIdx]<=2) changed.insert(oIdx);
-      activeBonds[bond->getIdx()]=0;
+      activeBonds[bIdx]=0;
       atomDegrees[oIdx]-=1;
       atomDegrees[cand]-=1;
     }
@@ -556,6 +557,7 @@ namespace FindRings {
     INT_VECT rpath(1,root);
     atPaths[root] = rpath;
 
+    const CSRGraph &g=mol.getCSRGraph();
     std::deque<int> bfsq;
     bfsq.push_back(root);
     int curr=-1;
@@ -568,13 +570,9 @@ namespace FindRings {
 
       INT_VECT &cpath = atPaths[curr];
 
-      ROMol::OEDGE_ITER beg,end;
-      boost::tie(beg,end) = mol.getAtomBonds(mol.getAtomWithIdx(curr));
-      while(beg!=end){
-        BOND_SPTR bond=mol[*beg];
-        ++beg;
-        if(!activeBonds[bond->getIdx()]) continue;
-        int nbrIdx=bond->getOtherAtomIdx(curr);
+      for(unsigned int slot=g.getSlotBegin(curr);slot!=g.getSlotEnd(curr);++slot){
+        if(!activeBonds[g.getSlotBondIdx(slot)]) continue;
+        int nbrIdx=g.getSlotTarget(slot);
         if ((std::find(cpath.begin(), cpath.end(), nbrIdx) == cpath.end())
             && done[nbrIdx]!=BLACK ){
           // i.e. we are not at a node that is making up the current path
@@ -646,6 +644,7 @@ namespace FindRings {
                       INT_VECT &res,
                       RINGINVAR_SET &invars){
     res.clear();
+    const CSRGraph &g=tMol.getCSRGraph();
     std::deque<INT_VECT> bfsq;
 
     INT_VECT tv;
@@ -656,8 +655,8 @@ namespace FindRings {
       bfsq.pop_front();
 
       unsigned int currAtomIdx=tv.back();
-      ROMol::ADJ_ITER nbrIdx,endNbrs;
-      boost::tie(nbrIdx,endNbrs) = tMol.getAtomNeighbors(tMol.getAtomWithIdx(currAtomIdx));
+      CSRGraph::IDX_ITER nbrIdx,endNbrs;
+      boost::tie(nbrIdx,endNbrs) = g.getAtomNeighbors(currAtomIdx);
       while(nbrIdx!=endNbrs){
         if(*nbrIdx==endAtomIdx) {
           if(currAtomIdx!=startAtomIdx){
@@ -697,6 +696,7 @@ namespace FindRings {
     PRECONDITION(ringAtoms[bond->getBeginAtomIdx()],"not a ring atom");
     PRECONDITION(ringAtoms[bond->getEndAtomIdx()],"not a ring atom");
 
+    const CSRGraph &g=tMol.getCSRGraph();
     INT_VECT nring;
     if(_atomSearchBFS(tMol,bond->getBeginAtomIdx(),bond->getEndAtomIdx(),
                       ringAtoms,nring,invars)){
@@ -710,11 +710,11 @@ namespace FindRings {
         std::cerr<<std::endl;
 #endif
         for(unsigned int i=0;i<nring.size()-1;++i){
-          unsigned int bIdx=tMol.getBondBetweenAtoms(nring[i],nring[i+1])->getIdx();
+          unsigned int bIdx=g.getBondIdxBetweenAtoms(nring[i],nring[i+1]);
           ringBonds.set(bIdx);
           ringAtoms.set(nring[i]);
         }
-        ringBonds.set(tMol.getBondBetweenAtoms(nring[0],nring[nring.size()-1])->getIdx());
+        ringBonds.set(g.getBondIdxBetweenAtoms(nring[0],nring[nring.size()-1]));
         ringAtoms.set(nring[nring.size()-1]);
       }
     } else {
@@ -741,11 +741,14 @@ namespace RDKit {
     int findSSSR(const ROMol &mol, VECT_INT_VECT &res) {
       res.resize(0);
       // check if SSSR's are already on the molecule
-      if(mol.getRingInfo()->isInitialized()){
+      if(mol.getRingInfo()->getPerceptionType()==RingInfo::SSSR){
         res = mol.getRingInfo()->atomRings();
         return res.size();
       } else {
-        mol.getRingInfo()->initialize();
+        // the molecule may only have ring membership information from
+        // fastFindRings(), that gets replaced:
+        mol.getRingInfo()->reset();
+        mol.getRingInfo()->initialize(RingInfo::SSSR);
       }
 
       RINGINVAR_SET invars;
@@ -759,9 +762,10 @@ namespace RDKit {
       boost::dynamic_bitset<> ringBonds(nbnds);
       boost::dynamic_bitset<> ringAtoms(nats);
 
+      const CSRGraph &g=mol.getCSRGraph();
       INT_VECT atomDegrees(nats);
       for(unsigned int i=0;i<nats;++i){
-        atomDegrees[i] = mol.getAtomWithIdx(i)->getDegree();
+        atomDegrees[i] = g.getDegree(i);
       }
       
       // find the number of fragments in the molecule - we will loop over them
@@ -949,7 +953,7 @@ namespace RDKit {
 
       // FIX: need to set flag here the symmetrization has been done in order to avoid
       //    repeating this work
-      if(!mol.getRingInfo()->isInitialized()){
+      if(mol.getRingInfo()->getPerceptionType()!=RingInfo::SSSR){
         nsssr = findSSSR(mol, sssrs);
       } else {
         sssrs = mol.getRingInfo()->atomRings();
@@ -1026,48 +1030,47 @@ namespace RDKit {
     }
 
     namespace {
-      void _DFS(const ROMol &mol,const Atom *atom,INT_VECT &atomColors,std::vector<const Atom *> &traversalOrder,
-                VECT_INT_VECT &res,const Atom *fromAtom=0){
-        //std::cerr<<"  dfs: "<<atom->getIdx()<<" from "<<(fromAtom?fromAtom->getIdx():-1)<<std::endl;
-        PRECONDITION(atom,"bad atom");
-        PRECONDITION(atomColors[atom->getIdx()]==0,"bad color");
-        atomColors[atom->getIdx()]=1;
-        traversalOrder.push_back(atom);
+      void _DFS(const CSRGraph &g,unsigned int atomIdx,INT_VECT &atomColors,INT_VECT &traversalOrder,
+                VECT_INT_VECT &res,int fromAtomIdx=-1){
+        //std::cerr<<"  dfs: "<<atomIdx<<" from "<<fromAtomIdx<<std::endl;
+        PRECONDITION(atomColors[atomIdx]==0,"bad color");
+        atomColors[atomIdx]=1;
+        traversalOrder.push_back(atomIdx);
 
 
-        ROMol::ADJ_ITER nbrIter,endNbrs;
-        boost::tie(nbrIter,endNbrs) = mol.getAtomNeighbors(atom);
+        CSRGraph::IDX_ITER nbrIter,endNbrs;
+        boost::tie(nbrIter,endNbrs) = g.getAtomNeighbors(atomIdx);
         while(nbrIter!=endNbrs){
-          const Atom *nbr=mol[*nbrIter].get();
-          unsigned int nbrIdx=nbr->getIdx();
-          //std::cerr<<"   "<<atom->getIdx()<<"       consider: "<<nbrIdx<<"  "<<atomColors[nbrIdx]<<std::endl;
+          unsigned int nbrIdx=*nbrIter;
+          //std::cerr<<"   "<<atomIdx<<"       consider: "<<nbrIdx<<"  "<<atomColors[nbrIdx]<<std::endl;
           if(atomColors[nbrIdx]==0){
-            if(nbr->getDegree()<2){
-              atomColors[nbr->getIdx()]=2;
+            if(g.getDegree(nbrIdx)<2){
+              atomColors[nbrIdx]=2;
             } else {
-              _DFS(mol,nbr,atomColors,traversalOrder,res,atom);
+              _DFS(g,nbrIdx,atomColors,traversalOrder,res,atomIdx);
             }
           } else if(atomColors[nbrIdx]==1){
-            if(fromAtom && nbrIdx!=fromAtom->getIdx()){
+            if(fromAtomIdx>=0 && nbrIdx!=static_cast<unsigned int>(fromAtomIdx)){
               INT_VECT cycle;
-              std::vector<const Atom *>::reverse_iterator lastElem=std::find(traversalOrder.rbegin(),traversalOrder.rend(),atom);
-              for(std::vector<const Atom *>::reverse_iterator rIt=lastElem;//traversalOrder.rbegin();
-                  rIt!=traversalOrder.rend() && (*rIt)->getIdx()!=nbrIdx;
+              INT_VECT::reverse_iterator lastElem=std::find(traversalOrder.rbegin(),traversalOrder.rend(),
+                                                            static_cast<int>(atomIdx));
+              for(INT_VECT::reverse_iterator rIt=lastElem;//traversalOrder.rbegin();
+                  rIt!=traversalOrder.rend() && static_cast<unsigned int>(*rIt)!=nbrIdx;
                   ++rIt){
-                cycle.push_back((*rIt)->getIdx());
+                cycle.push_back(*rIt);
               }
               cycle.push_back(nbrIdx);
               res.push_back(cycle);
-              //std::cerr<<"    cycle from "<<atom->getIdx()<<" :";
+              //std::cerr<<"    cycle from "<<atomIdx<<" :";
               //std::copy(cycle.begin(),cycle.end(),std::ostream_iterator<int>(std::cerr," "));
               //std::cerr<<std::endl;
             }
           }
           ++nbrIter;
         }
-        atomColors[atom->getIdx()]=2;
+        atomColors[atomIdx]=2;
         traversalOrder.pop_back();
-        //std::cerr<<"  done "<<atom->getIdx()<<std::endl;
+        //std::cerr<<"  done "<<atomIdx<<std::endl;
       }
     } // end of anonymous namespace
     void fastFindRings(const ROMol &mol){
@@ -1078,26 +1081,41 @@ namespace RDKit {
       if(mol.getRingInfo()->isInitialized()){
         return;
       } else {
-        mol.getRingInfo()->initialize();
+        mol.getRingInfo()->initialize(RingInfo::MEMBERSHIP);
       }
 
       int nats = mol.getNumAtoms();
+      const CSRGraph &g=mol.getCSRGraph();
 
       INT_VECT atomColors(nats,0);
 
       for(unsigned int i=0;i<nats;++i){
         if(atomColors[i]) continue;
-        if(mol.getAtomWithIdx(i)->getDegree()<2){
+        if(g.getDegree(i)<2){
           atomColors[i]=2;
           continue;
         }
-        std::vector<const Atom *> traversalOrder;
-        _DFS(mol,mol.getAtomWithIdx(i),atomColors,traversalOrder,res);
+        INT_VECT traversalOrder;
+        _DFS(g,i,atomColors,traversalOrder,res);
       }
   
       FindRings::storeRingsInfo(mol,res);
     }
 
+    void findRingsIfNeeded(const ROMol &mol,RingInfo::PerceptionType type){
+      switch(type){
+      case RingInfo::UNINITIALIZED:
+        break;
+      case RingInfo::MEMBERSHIP:
+        if(!mol.getRingInfo()->isInitialized()) fastFindRings(mol);
+        break;
+      case RingInfo::SSSR:
+        if(mol.getRingInfo()->getPerceptionType()!=RingInfo::SSSR) findSSSR(mol);
+        break;
+      default:
+        PRECONDITION(0,"bad perception type");
+      }
+    }
     
   }// end of MolOps namespace  
 
@@ -61,10 +61,10 @@ namespace RDKit{
       if(typeIdx==nTypes) --typeIdx;
       code |= typeIdx<<(numBranchBits+numPiBits);
       if(includeChirality){
-        if(atom->hasProp("_CIPCode")){
+        if(atom->hasProp(common_properties::_CIPCode)){
           boost::uint32_t offset=numBranchBits+numPiBits+numTypeBits;
           std::string cipCode;
-          atom->getProp("_CIPCode",cipCode);
+          atom->getProp(common_properties::_CIPCode,cipCode);
           if(cipCode=="R"){
             code |= 1<<offset;
           } else if (cipCode=="S"){
@@ -618,7 +618,7 @@ namespace RDKit{
     PRECONDITION(!atomCounts || atomCounts->size()>=mol.getNumAtoms(),"bad atomCounts size");
     PRECONDITION(!setOnlyBits || setOnlyBits->getNumBits()==fpSize,"bad setOnlyBits size");
 
-    if(!mol.getRingInfo()->isInitialized()){
+    if(mol.getRingInfo()->getPerceptionType()!=RingInfo::SSSR){
       MolOps::findSSSR(mol);
     }
     
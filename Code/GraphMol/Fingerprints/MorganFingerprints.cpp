@@ -236,6 +236,7 @@ $([N;H0&+0]([C;!$(C(=O))])([C;!$(C(=O))])[C;!$(C(=O))])]", // Basic
         }
       }
       // now do our subsequent rounds:
+      const CSRGraph &g=mol.getCSRGraph();
       for(unsigned int layer=0;layer<radius;++layer){
         std::vector<uint32_t> roundInvariants(nAtoms);
         std::vector< boost::dynamic_bitset<> > roundAtomNeighborhoods=atomNeighborhoods;
@@ -244,24 +245,20 @@ $([N;H0&+0]([C;!$(C(=O))])([C;!$(C(=O))])[C;!$(C(=O))])]", // Basic
         BOOST_FOREACH(unsigned int atomIdx,atomOrder){
           if(!deadAtoms[atomIdx]){
             std::vector< std::pair<int32_t,uint32_t> > nbrs;
-            ROMol::OEDGE_ITER beg,end;
-            boost::tie(beg,end) = mol.getAtomBonds(mol.getAtomWithIdx(atomIdx));
-            while(beg!=end){
-              const BOND_SPTR bond=mol[*beg];
-              roundAtomNeighborhoods[atomIdx][bond->getIdx()]=1;
+            for(unsigned int slot=g.getSlotBegin(atomIdx);slot!=g.getSlotEnd(atomIdx);++slot){
+              unsigned int bIdx=g.getSlotBondIdx(slot);
+              roundAtomNeighborhoods[atomIdx][bIdx]=1;
 
-              unsigned int oIdx=bond->getOtherAtomIdx(atomIdx);
+              unsigned int oIdx=g.getSlotTarget(slot);
               roundAtomNeighborhoods[atomIdx] |= atomNeighborhoods[oIdx];
 
               if(useBondTypes){
-                nbrs.push_back(std::make_pair(static_cast<int32_t>(bond->getBondType()),
+                nbrs.push_back(std::make_pair(static_cast<int32_t>(g.getBond(bIdx)->getBondType()),
                                               (*invariants)[oIdx]));
               } else {
                 nbrs.push_back(std::make_pair(static_cast<int32_t>(1),
                                               (*invariants)[oIdx]));
               }
-
-              ++beg;
             }
 
             // sort the neighbor list:
@@ -293,8 +290,8 @@ $([N;H0&+0]([C;!$(C(=O))])([C;!$(C(=O))])[C;!$(C(=O))])]", // Basic
               // add an extra value to the invariant to reflect chirality:
               Atom const *tAt=mol.getAtomWithIdx(atomIdx);
               std::string cip="";
-              if(tAt->hasProp("_CIPCode")){
-                tAt->getProp("_CIPCode",cip);
+              if(tAt->hasProp(common_properties::_CIPCode)){
+                tAt->getProp(common_properties::_CIPCode,cip);
               }
               if(cip=="R"){
                 gboost::hash_combine(invar, 3);
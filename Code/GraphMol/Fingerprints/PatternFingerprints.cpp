@@ -26,6 +26,9 @@
 #include <RDGeneral/types.h>
 #include <algorithm>
 #include <boost/dynamic_bitset.hpp>
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread/mutex.hpp>
+#endif
 
 //#define VERBOSE_FINGERPRINTING 1
 //#define REPORT_FP_STATS 1
@@ -135,24 +138,29 @@ namespace RDKit{
     PRECONDITION(!setOnlyBits || setOnlyBits->getNumBits()==fpSize,"bad setOnlyBits size");
 
     static std::vector<ROMOL_SPTR> patts;
-    // FIX: need a mutex here to be threadsafe
-    if(patts.size()==0){
-      unsigned int idx=0;
-      while(1){
-        std::string pq=pqs[idx];
-        if(pq=="") break;
-        idx++;
-        RWMol *tm;
-        try {
-          tm = SmartsToMol(pq);
-        }catch (...) {
-          tm=NULL;
+    {
+#ifdef RDK_THREADSAFE_SSS
+      static boost::mutex pattMutex;
+      boost::mutex::scoped_lock pattLock(pattMutex);
+#endif
+      if(patts.size()==0){
+        unsigned int idx=0;
+        while(1){
+          std::string pq=pqs[idx];
+          if(pq=="") break;
+          idx++;
+          RWMol *tm;
+          try {
+            tm = SmartsToMol(pq);
+          }catch (...) {
+            tm=NULL;
+          }
+          if(!tm) continue;
+          patts.push_back(ROMOL_SPTR(static_cast<ROMol *>(tm)));
         }
-        if(!tm) continue;
-        patts.push_back(ROMOL_SPTR(static_cast<ROMol *>(tm)));
       }
     }
-    if(!mol.getRingInfo()->isInitialized()){
+    if(mol.getRingInfo()->getPerceptionType()!=RingInfo::SSSR){
       MolOps::findSSSR(mol);
     }
 
@@ -168,7 +176,11 @@ namespace RDKit{
     boost::tie(firstB,lastB) = mol.getEdges();
     while(firstB!=lastB){
       const Bond *bond = mol[*firstB].get();
-      if( Fingerprints::detail::isComplexQuery(bond) ){
+      // unspecified SMARTS bonds (single or aromatic) also need to be
+      // skipped: the query bond's type is single, but it may well match
+      // an aromatic bond in the molecule.
+      if( Fingerprints::detail::isComplexQuery(bond) ||
+          (bond->hasQuery() && bond->getQuery()->getDescription()!="BondOrder") ){
         isQueryBond.set(bond->getIdx());
       }
       ++firstB;
@@ -0,0 +1,91 @@
+// $Id$
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include <GraphMol/RDKitBase.h>
+#include <DataStructs/ExplicitBitVect.h>
+#include <RDGeneral/Invariant.h>
+#include "Fingerprints.h"
+#include "ScreenedSubstructMatch.h"
+#include <boost/dynamic_bitset.hpp>
+#include <iterator>
+
+namespace RDKit{
+  namespace {
+    typedef std::vector<unsigned long long> FP_BLOCKS;
+    const PropKey patternFPPropKey=getPropKey("_patternFPBlocks");
+
+    // The fingerprint is stored as a computed property holding the
+    // fingerprint size followed by the raw bit blocks. That's a type the
+    // property dictionary already knows about, and once it's cached
+    // testing a block array doesn't require any allocation.
+    const FP_BLOCKS &getPatternFPBlocks(const ROMol &mol,unsigned int fpSize,
+                                        FP_BLOCKS &scratch){
+      const FP_BLOCKS *cached=mol.getPropPtr<FP_BLOCKS>(patternFPPropKey);
+      if(cached && !cached->empty() && (*cached)[0]==fpSize) return *cached;
+
+      ExplicitBitVect *fp=PatternFingerprintMol(mol,fpSize);
+      std::vector<boost::dynamic_bitset<>::block_type> blocks;
+      boost::to_block_range(*fp->dp_bits,std::back_inserter(blocks));
+      delete fp;
+
+      scratch.clear();
+      scratch.reserve(blocks.size()+1);
+      scratch.push_back(fpSize);
+      scratch.insert(scratch.end(),blocks.begin(),blocks.end());
+      mol.setProp(patternFPPropKey,scratch,true);
+      return scratch;
+    }
+  }
+
+  bool PassesPatternScreen(const ROMol &mol,const ROMol &query,unsigned int fpSize){
+    PRECONDITION(fpSize!=0,"fpSize==0");
+    FP_BLOCKS mScratch,qScratch;
+    const FP_BLOCKS &mBlocks=getPatternFPBlocks(mol,fpSize,mScratch);
+    const FP_BLOCKS &qBlocks=getPatternFPBlocks(query,fpSize,qScratch);
+    CHECK_INVARIANT(mBlocks.size()==qBlocks.size(),"fingerprint size mismatch");
+    // every bit set in the query must also be set in the molecule:
+    for(unsigned int i=1;i<qBlocks.size();++i){
+      if(qBlocks[i] & ~mBlocks[i]) return false;
+    }
+    return true;
+  }
+
+  bool ScreenedSubstructMatch(const ROMol &mol,const ROMol &query,
+                              MatchVectType &matchVect,
+                              bool recursionPossible,bool useChirality,
+                              ScreenedMatchStats *stats,unsigned int fpSize){
+    if(stats) ++stats->nTested;
+    if(!PassesPatternScreen(mol,query,fpSize)){
+      if(stats) ++stats->nScreenedOut;
+      matchVect.clear();
+      return false;
+    }
+    bool res=SubstructMatch(mol,query,matchVect,recursionPossible,useChirality);
+    if(stats && res) ++stats->nMatched;
+    return res;
+  }
+
+  unsigned int ScreenedSubstructMatch(const ROMol &mol,const ROMol &query,
+                                      std::vector< MatchVectType > &matchVect,
+                                      bool uniquify,bool recursionPossible,
+                                      bool useChirality,
+                                      ScreenedMatchStats *stats,unsigned int fpSize){
+    if(stats) ++stats->nTested;
+    if(!PassesPatternScreen(mol,query,fpSize)){
+      if(stats) ++stats->nScreenedOut;
+      matchVect.clear();
+      return 0;
+    }
+    unsigned int res=SubstructMatch(mol,query,matchVect,uniquify,
+                                    recursionPossible,useChirality);
+    if(stats && res) ++stats->nMatched;
+    return res;
+  }
+}
@@ -0,0 +1,85 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_SCREENEDSUBSTRUCTMATCH_H_
+#define _RD_SCREENEDSUBSTRUCTMATCH_H_
+
+#include <vector>
+#include <GraphMol/Substruct/SubstructMatch.h>
+
+namespace RDKit{
+  class ROMol;
+
+  //! counts collected by the screened substructure matching functions
+  struct ScreenedMatchStats {
+    ScreenedMatchStats() : nTested(0), nScreenedOut(0), nMatched(0) {};
+    unsigned int nTested;      //!< number of molecules tested
+    unsigned int nScreenedOut; //!< number rejected by the fingerprint screen
+    unsigned int nMatched;     //!< number which actually matched the query
+    void reset() { nTested=nScreenedOut=nMatched=0; };
+    //! the fraction of the molecules tested that were rejected by the screen
+    double screenoutFraction() const {
+      return nTested ? static_cast<double>(nScreenedOut)/nTested : 0.0;
+    };
+  };
+
+  //! checks whether or not a molecule passes the pattern fingerprint screen for a query
+  /*!
+      \param mol       The ROMol to be searched
+      \param query     The query ROMol
+      \param fpSize    the size of the pattern fingerprints
+
+      \return false if the query cannot be a substructure of the molecule.
+
+      <b>Notes:</b>
+        - the pattern fingerprints (see PatternFingerprintMol()) are
+          cached on both molecules as computed properties, so they are
+          generated at most once per molecule. Use
+          \c ROMol::clearComputedProps() after modifying a molecule.
+        - because of the caching this is not safe to call on the same
+          molecule from multiple threads unless the fingerprint is already
+          there. Calling it once, up front, on each molecule takes care of
+          that.
+  */
+  bool PassesPatternScreen(const ROMol &mol,const ROMol &query,
+                           unsigned int fpSize=2048);
+
+  //! Find a substructure match, using the pattern fingerprint to screen first
+  /*!
+      Takes the same arguments as SubstructMatch(), plus:
+
+      \param stats     if provided, the screening statistics are added to this
+      \param fpSize    the size of the pattern fingerprints
+
+      Molecules which fail PassesPatternScreen() are rejected without
+      running the full match.
+  */
+  bool ScreenedSubstructMatch(const ROMol &mol,const ROMol &query,
+                              MatchVectType &matchVect,
+                              bool recursionPossible=true,
+                              bool useChirality=false,
+                              ScreenedMatchStats *stats=0,
+                              unsigned int fpSize=2048);
+
+  //! Find all substructure matches, using the pattern fingerprint to screen first
+  /*!
+      Takes the same arguments as SubstructMatch(), plus:
+
+      \param stats     if provided, the screening statistics are added to this
+      \param fpSize    the size of the pattern fingerprints
+  */
+  unsigned int ScreenedSubstructMatch(const ROMol &mol,const ROMol &query,
+                                      std::vector< MatchVectType > &matchVect,
+                                      bool uniquify=true,bool recursionPossible=true,
+                                      bool useChirality=false,
+                                      ScreenedMatchStats *stats=0,
+                                      unsigned int fpSize=2048);
+}
+
+#endif
@@ -18,6 +18,7 @@
 #include <GraphMol/Fingerprints/MorganFingerprints.h>
 #include <GraphMol/Fingerprints/MACCS.h>
 #include <GraphMol/Fingerprints/AtomPairs.h>
+#include <GraphMol/Fingerprints/ScreenedSubstructMatch.h>
 #include <DataStructs/ExplicitBitVect.h>
 #include <DataStructs/BitOps.h>
 #include <RDGeneral/RDLog.h>
@@ -2462,6 +2463,90 @@ void testGitHubIssue25(){
 }
 
 
+void testScreenedSubstructMatch(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Test screened substructure matching." << std::endl;
+
+  std::string fName = getenv("RDBASE");
+  fName += "/Data/NCI/first_200.props.sdf";
+  SDMolSupplier suppl(fName);
+  std::vector<ROMol *> mols;
+  while(!suppl.atEnd()){
+    ROMol *mol=suppl.next();
+    if(mol) mols.push_back(mol);
+  }
+  TEST_ASSERT(mols.size()>100);
+
+  // the first few queries are from SMILES, the rest from SMARTS:
+  std::vector<std::string> smas;
+  smas.push_back("c1ccccc1C(=O)O");
+  smas.push_back("C1CCCCC1N");
+  smas.push_back("c1ccncc1");
+  unsigned int nSmiles=smas.size();
+  smas.push_back("c1ccccc1C(=O)O");
+  smas.push_back("[#6]([#6])[!#6]");
+  smas.push_back("[$([O,S]-[!$(*=O)])]");
+  smas.push_back("[Cl,Br]c");
+  for(unsigned int qi=0;qi<smas.size();++qi){
+    ROMol *query;
+    if(qi<nSmiles){
+      query=SmilesToMol(smas[qi]);
+    } else {
+      query=SmartsToMol(smas[qi]);
+    }
+    TEST_ASSERT(query);
+    ScreenedMatchStats stats;
+    unsigned int nHits=0;
+    for(unsigned int i=0;i<mols.size();++i){
+      MatchVectType mv1,mv2;
+      bool m1=SubstructMatch(*mols[i],*query,mv1);
+      bool m2=ScreenedSubstructMatch(*mols[i],*query,mv2,true,false,&stats);
+      TEST_ASSERT(m1==m2);
+      TEST_ASSERT(mv1==mv2);
+      if(m1){
+        ++nHits;
+        TEST_ASSERT(PassesPatternScreen(*mols[i],*query));
+      }
+
+      std::vector<MatchVectType> mvs1,mvs2;
+      TEST_ASSERT(SubstructMatch(*mols[i],*query,mvs1)==
+                  ScreenedSubstructMatch(*mols[i],*query,mvs2));
+      TEST_ASSERT(mvs1==mvs2);
+    }
+    TEST_ASSERT(stats.nTested==mols.size());
+    TEST_ASSERT(stats.nMatched==nHits);
+    TEST_ASSERT(stats.nScreenedOut<=mols.size()-nHits);
+    if(qi<nSmiles){
+      // the screen should be doing real work for these:
+      TEST_ASSERT(stats.nScreenedOut>(mols.size()-nHits)/2);
+    }
+    BOOST_LOG(rdInfoLog)<<"  "<<smas[qi]<<" hits: "<<nHits<<" screened out: "
+                        <<stats.nScreenedOut<<std::endl;
+    delete query;
+  }
+
+  {
+    // the fingerprints are cached, make sure we don't get confused
+    // about their sizes:
+    ROMol *m=SmilesToMol("c1ccccc1C(=O)O");
+    ROMol *q1=SmilesToMol("c1ccccc1C(=O)O");
+    ROMol *q2=SmilesToMol("ClC");
+    TEST_ASSERT(PassesPatternScreen(*m,*q1));
+    TEST_ASSERT(PassesPatternScreen(*m,*q1,1024));
+    TEST_ASSERT(!PassesPatternScreen(*m,*q2));
+    TEST_ASSERT(!PassesPatternScreen(*m,*q2,1024));
+    TEST_ASSERT(m->hasProp("_patternFPBlocks"));
+    m->clearComputedProps();
+    TEST_ASSERT(!m->hasProp("_patternFPBlocks"));
+    delete m;
+    delete q1;
+    delete q2;
+  }
+
+  for(unsigned int i=0;i<mols.size();++i) delete mols[i];
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+
 int main(int argc,char *argv[]){
   RDLog::InitLogs();
   test1();
@@ -2502,5 +2587,6 @@ int main(int argc,char *argv[]){
   testChiralPairs();
   testChiralTorsions();
   testGitHubIssue25();
+  testScreenedSubstructMatch();
   return 0;
 }
@@ -10,6 +10,8 @@
 //
 #include <iostream>
 #include <cmath>
+#include <map>
+#include <algorithm>
 
 #include <RDGeneral/Invariant.h>
 #include <GraphMol/RDKitBase.h>
@@ -116,6 +118,85 @@ namespace RDKit {
       //
       //
       // ------------------------------------------------------------------------
+      namespace {
+        void addAngleContrib(const ROMol &mol,const AtomicParamVect &params,
+                             ForceFields::ForceField *field,
+                             unsigned int i,unsigned int j,int k){
+          if(!params[k]) return;
+          const Atom *atomK = mol.getAtomWithIdx(k);
+          // skip special cases:
+          if( atomK->getHybridization()==Atom::SP3D && atomK->getDegree()==5 ) return;
+          const Bond *b1 =mol.getBondBetweenAtoms(i,k);
+          const Bond *b2 =mol.getBondBetweenAtoms(j,k);
+          // FIX: recognize amide bonds here.
+          AngleBendContrib *contrib;
+          int order=0;
+          switch(atomK->getHybridization()){
+          case Atom::SP:
+            order=2;
+            break;
+          case Atom::SP3D2:
+            order=4;
+            break;
+          default:
+            order=0;
+            break;
+          } 
+                  
+          contrib = new AngleBendContrib(field,i,k,j,
+                                         b1->getBondTypeAsDouble(),
+                                         b2->getBondTypeAsDouble(),
+                                         params[i],params[k],params[j],order);
+          field->contribs().push_back(ForceFields::ContribPtr(contrib));
+        }
+
+        // the non-default entries of the neighbor matrix, keyed by (i,j)
+        // with i<j. Only bond pairs that share an atom are visited, in
+        // the same order buildNeighborMatrix() uses, so the entries
+        // (including the ones overwritten in small rings) are identical.
+        typedef std::map<std::pair<unsigned int,unsigned int>,int> NeighborMap;
+        void setNeighbor(NeighborMap &nbrs,unsigned int a,unsigned int b,int val){
+          if(a>b) std::swap(a,b);
+          nbrs[std::make_pair(a,b)]=val;
+        }
+        void buildNeighborMap(const ROMol &mol,NeighborMap &nbrs){
+          std::vector<const Bond *> bonds(mol.getNumBonds());
+          for(ROMol::ConstBondIterator bIt=mol.beginBonds();bIt!=mol.endBonds();++bIt){
+            bonds[(*bIt)->getIdx()]=*bIt;
+          }
+          std::vector<unsigned int> later;
+          for(unsigned int i=0;i<bonds.size();i++){
+            const Bond *bondi=bonds[i];
+            setNeighbor(nbrs,bondi->getBeginAtomIdx(),bondi->getEndAtomIdx(),-1);
+
+            later.clear();
+            const Atom *ends[2]={bondi->getBeginAtom(),bondi->getEndAtom()};
+            for(unsigned int e=0;e<2;++e){
+              ROMol::OEDGE_ITER beg,end;
+              boost::tie(beg,end) = mol.getAtomBonds(ends[e]);
+              while(beg!=end){
+                unsigned int bIdx=mol[*beg]->getIdx();
+                if(bIdx>i) later.push_back(bIdx);
+                ++beg;
+              }
+            }
+            std::sort(later.begin(),later.end());
+            for(unsigned int jj=0;jj<later.size();jj++){
+              const Bond *bondj=bonds[later[jj]];
+              unsigned int central;
+              if(bondi->getBeginAtomIdx()==bondj->getBeginAtomIdx() ||
+                 bondi->getBeginAtomIdx()==bondj->getEndAtomIdx()){
+                central=bondi->getBeginAtomIdx();
+              } else {
+                central=bondi->getEndAtomIdx();
+              }
+              setNeighbor(nbrs,bondi->getOtherAtomIdx(central),
+                          bondj->getOtherAtomIdx(central),central);
+            }
+          }
+        }
+      }
+
       void addAngles(const ROMol &mol,const AtomicParamVect &params,
                      ForceFields::ForceField *field,boost::shared_array<int> neighborMatrix){
         PRECONDITION(mol.getNumAtoms()==params.size(),"bad parameters");
@@ -127,39 +208,32 @@ namespace RDKit {
           for(unsigned int j=i+1;j<nAtoms;j++){
             if(!params[j]) continue;
             if(neighborMatrix[i*nAtoms+j]>-1){
-              int k = neighborMatrix[i*nAtoms+j];
-              if(!params[k]) continue;
-              const Atom *atomK = mol.getAtomWithIdx(k);
-              // skip special cases:
-              if( !(atomK->getHybridization()==Atom::SP3D && atomK->getDegree()==5) ){
-                const Bond *b1 =mol.getBondBetweenAtoms(i,k);
-                const Bond *b2 =mol.getBondBetweenAtoms(j,k);
-                // FIX: recognize amide bonds here.
-                AngleBendContrib *contrib;
-                int order=0;
-                switch(atomK->getHybridization()){
-                case Atom::SP:
-                  order=2;
-                  break;
-                case Atom::SP3D2:
-                  order=4;
-                  break;
-                default:
-                  order=0;
-                  break;
-                } 
-                  
-                contrib = new AngleBendContrib(field,i,k,j,
-                                               b1->getBondTypeAsDouble(),
-                                               b2->getBondTypeAsDouble(),
-                                               params[i],params[k],params[j],order);
-                field->contribs().push_back(ForceFields::ContribPtr(contrib));
-              }
+              addAngleContrib(mol,params,field,i,j,neighborMatrix[i*nAtoms+j]);
             }
           }
         }
       }
 
+      // ------------------------------------------------------------------------
+      //
+      // adds the same terms as the version above, but works from the bonds
+      // instead of an nAtoms x nAtoms neighbor matrix
+      //
+      // ------------------------------------------------------------------------
+      void addAngles(const ROMol &mol,const AtomicParamVect &params,
+                     ForceFields::ForceField *field){
+        PRECONDITION(mol.getNumAtoms()==params.size(),"bad parameters");
+        PRECONDITION(field,"bad forcefield");
+
+        NeighborMap nbrs;
+        buildNeighborMap(mol,nbrs);
+        for(NeighborMap::const_iterator nIt=nbrs.begin();nIt!=nbrs.end();++nIt){
+          unsigned int i=nIt->first.first,j=nIt->first.second;
+          if(nIt->second<0 || !params[i] || !params[j]) continue;
+          addAngleContrib(mol,params,field,i,j,nIt->second);
+        }
+      }
+
       // ------------------------------------------------------------------------
       //
       //
@@ -384,6 +458,40 @@ namespace RDKit {
         }
       }
 
+      // ------------------------------------------------------------------------
+      //
+      //
+      //
+      // ------------------------------------------------------------------------
+      void addNonbondedList(const ROMol &mol,const AtomicParamVect &params,
+                            ForceFields::ForceField *field,double cutoff,
+                            bool ignoreInterfragInteractions){
+        PRECONDITION(mol.getNumAtoms()==params.size(),"bad parameters");
+        PRECONDITION(field,"bad forcefield");
+
+        vdWListContrib *contrib=new vdWListContrib(field,params,cutoff);
+        if(ignoreInterfragInteractions){
+          INT_VECT fragMapping;
+          std::vector<ROMOL_SPTR> molFrags=MolOps::getMolFrags(mol,true,&fragMapping);
+          contrib->setFragments(fragMapping);
+        }
+        // as in addNonbonded(), atoms separated by one or two bonds
+        // don't interact:
+        for(ROMol::ConstAtomIterator atomIt=mol.beginAtoms();
+            atomIt!=mol.endAtoms();++atomIt){
+          unsigned int idx=(*atomIt)->getIdx();
+          ROMol::ADJ_ITER nbrIdx1,nbrIdx2,endNbrs;
+          boost::tie(nbrIdx1,endNbrs) = mol.getAtomNeighbors(*atomIt);
+          for(;nbrIdx1!=endNbrs;++nbrIdx1){
+            contrib->addExclusion(idx,*nbrIdx1);
+            for(nbrIdx2=nbrIdx1+1;nbrIdx2!=endNbrs;++nbrIdx2){
+              contrib->addExclusion(*nbrIdx1,*nbrIdx2);
+            }
+          }
+        }
+        field->contribs().push_back(ForceFields::ContribPtr(contrib));
+      }
+
       // ------------------------------------------------------------------------
       //
       //
@@ -515,7 +623,8 @@ namespace RDKit {
     ForceFields::ForceField *constructForceField(ROMol &mol,
                                                  const AtomicParamVect &params,
                                                  double vdwThresh, int confId,
-                                                 bool ignoreInterfragInteractions){
+                                                 bool ignoreInterfragInteractions,
+                                                 double nonbondedCutoff){
       PRECONDITION(mol.getNumAtoms()==params.size(),"bad parameters");
         
       ForceFields::ForceField *res=new ForceFields::ForceField();
@@ -527,10 +636,15 @@ namespace RDKit {
       }
       
       Tools::addBonds(mol,params,res);
-      boost::shared_array<int> neighborMat = Tools::buildNeighborMatrix(mol);
-      Tools::addAngles(mol,params,res,neighborMat);
+      Tools::addAngles(mol,params,res);
       Tools::addAngleSpecialCases(mol,confId,params,res);
-      Tools::addNonbonded(mol,confId,params,res,neighborMat,vdwThresh,ignoreInterfragInteractions);
+      if(nonbondedCutoff>0.0){
+        Tools::addNonbondedList(mol,params,res,nonbondedCutoff,ignoreInterfragInteractions);
+      } else {
+        // only the distance-threshold path needs the full matrix:
+        boost::shared_array<int> neighborMat = Tools::buildNeighborMatrix(mol);
+        Tools::addNonbonded(mol,confId,params,res,neighborMat,vdwThresh,ignoreInterfragInteractions);
+      }
       Tools::addTorsions(mol,params,res);
       //Tools::addInversions(mol,params,res);
 
@@ -543,11 +657,13 @@ namespace RDKit {
     //
     // ------------------------------------------------------------------------
     ForceFields::ForceField *constructForceField(ROMol &mol,double vdwThresh, int confId,
-                                                 bool ignoreInterfragInteractions){
+                                                 bool ignoreInterfragInteractions,
+                                                 double nonbondedCutoff){
       bool foundAll;
       AtomicParamVect params;
       boost::tie(params,foundAll)=getAtomTypes(mol);
-      return constructForceField(mol,params,vdwThresh, confId,ignoreInterfragInteractions);
+      return constructForceField(mol,params,vdwThresh, confId,ignoreInterfragInteractions,
+                                 nonbondedCutoff);
     }
 
   }
@@ -38,13 +38,18 @@ namespace RDKit {
                         default confId will be used.
       \param ignoreInterfragInteractions if true, nonbonded terms will not be added between
                                          fragments
+      \param nonbondedCutoff if this is positive, the van der Waals terms are evaluated
+                             using a neighbor list that is updated as the atoms move.
+                             Contacts longer than this distance (in Angstroms) are
+                             ignored. \c vdwThresh is not used in this case.
 
       \return the new force field. The client is responsible for free'ing this.
     */
     ForceFields::ForceField *constructForceField(ROMol &mol,
 						 double vdwThresh=100.0,
 						 int confId=-1,
-                                                 bool ignoreInterfragInteractions=true);
+                                                 bool ignoreInterfragInteractions=true,
+                                                 double nonbondedCutoff=-1.0);
 
     //! Builds and returns a UFF force field for a molecule
     /*!
@@ -60,6 +65,10 @@ namespace RDKit {
                         default confId will be used.
       \param ignoreInterfragInteractions if true, nonbonded terms will not be added between
                                          fragments
+      \param nonbondedCutoff if this is positive, the van der Waals terms are evaluated
+                             using a neighbor list that is updated as the atoms move.
+                             Contacts longer than this distance (in Angstroms) are
+                             ignored. \c vdwThresh is not used in this case.
     
       \return the new force field. The client is responsible for free'ing this.
     */
@@ -67,7 +76,8 @@ namespace RDKit {
 						 const AtomicParamVect &params,
 						 double vdwThresh=100.0,
 						 int confId=-1,
-                                                 bool ignoreInterfragInteractions=true);
+                                                 bool ignoreInterfragInteractions=true,
+                                                 double nonbondedCutoff=-1.0);
 
     namespace Tools {
       // these functions are primarily exposed so they can be tested.
@@ -76,9 +86,14 @@ namespace RDKit {
       boost::shared_array<int> buildNeighborMatrix(const ROMol &mol);
       void addAngles(const ROMol &mol,const AtomicParamVect &params,
 		     ForceFields::ForceField *field,boost::shared_array<int> neighborMatrix);
+      void addAngles(const ROMol &mol,const AtomicParamVect &params,
+		     ForceFields::ForceField *field);
       void addNonbonded(const ROMol &mol,int confId, const AtomicParamVect &params,
 			ForceFields::ForceField *field,boost::shared_array<int> neighborMatrix,
 			double vdwThresh=100.0,bool ignoreInterfragInteractions=true);
+      void addNonbondedList(const ROMol &mol,const AtomicParamVect &params,
+                            ForceFields::ForceField *field,double cutoff,
+                            bool ignoreInterfragInteractions=true);
       void addTorsions(const ROMol &mol,const AtomicParamVect &params,
 		       ForceFields::ForceField *field,
                        std::string torsionBondSmarts="[!$(*#*)&!D1]~[!$(*#*)&!D1]");
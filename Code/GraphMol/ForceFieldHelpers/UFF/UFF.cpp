@@ -0,0 +1,154 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include <RDGeneral/Invariant.h>
+#include <GraphMol/ROMol.h>
+#include <GraphMol/Conformer.h>
+#include <ForceField/ForceField.h>
+#include <boost/scoped_ptr.hpp>
+#include <algorithm>
+
+#include "Builder.h"
+#include "UFF.h"
+
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/exception_ptr.hpp>
+#include <RDBoost/Exceptions.h>
+#endif
+
+namespace RDKit {
+  namespace UFF {
+    namespace {
+      // optimizes conformers threadIdx, threadIdx+numThreads, ... with ff
+      void optimizeConfs(ROMol *mol,ForceFields::ForceField *ff,
+                         const std::vector<Conformer *> *confs,
+                         std::vector<std::pair<int,double> > *res,
+                         int maxIters,unsigned int threadIdx,unsigned int numThreads){
+        for(unsigned int ci=threadIdx;ci<confs->size();ci+=numThreads){
+          Conformer *conf=(*confs)[ci];
+          ff->positions().clear();
+          for(unsigned int i=0;i<mol->getNumAtoms();++i){
+            ff->positions().push_back(&conf->getAtomPos(i));
+          }
+          ff->initialize();
+          int needsMore=ff->minimize(maxIters);
+          (*res)[ci]=std::make_pair(needsMore,ff->calcEnergy());
+        }
+      }
+
+      // the conformers are optimized directly with the caller's force
+      // field, its positions are put back afterwards (also on errors)
+      void optimizeConfsSerially(ROMol *mol,ForceFields::ForceField *ff,
+                                 const std::vector<Conformer *> *confs,
+                                 std::vector<std::pair<int,double> > *res,
+                                 int maxIters){
+        RDGeom::PointPtrVect origPositions=ff->positions();
+        try {
+          optimizeConfs(mol,ff,confs,res,maxIters,0,1);
+        } catch (...) {
+          ff->positions()=origPositions;
+          throw;
+        }
+        ff->positions()=origPositions;
+        ff->initialize();
+      }
+#ifdef RDK_THREADSAFE_SSS
+      // runs optimizeConfs() on a worker thread. An exception can't be
+      // allowed to escape the thread, so it's stored in err to be
+      // rethrown once the threads have been joined. boost::current_exception()
+      // would turn our exceptions into plain std::runtime_errors, so those
+      // are copied explicitly.
+      void optimizeConfsThread(ROMol *mol,ForceFields::ForceField *ff,
+                               const std::vector<Conformer *> *confs,
+                               std::vector<std::pair<int,double> > *res,
+                               int maxIters,unsigned int threadIdx,unsigned int numThreads,
+                               boost::exception_ptr *err){
+        try {
+          optimizeConfs(mol,ff,confs,res,maxIters,threadIdx,numThreads);
+        } catch (const ValueErrorException &e) {
+          *err=boost::copy_exception(e);
+        } catch (const IndexErrorException &e) {
+          *err=boost::copy_exception(e);
+        } catch (const Invar::Invariant &e) {
+          *err=boost::copy_exception(e);
+        } catch (...) {
+          *err=boost::current_exception();
+        }
+      }
+#endif
+    }
+
+    void OptimizeMoleculeConfs(ROMol &mol,ForceFields::ForceField &ff,
+                               std::vector<std::pair<int,double> > &res,
+                               unsigned int numThreads,int maxIters){
+      PRECONDITION(ff.positions().size()==mol.getNumAtoms(),"force field doesn't match molecule");
+      std::vector<Conformer *> confs;
+      confs.reserve(mol.getNumConformers());
+      for(ROMol::ConformerIterator ci=mol.beginConformers();ci!=mol.endConformers();++ci){
+        confs.push_back(ci->get());
+      }
+      res.clear();
+      res.resize(confs.size(),std::make_pair(0,0.0));
+      if(confs.empty()) return;
+
+#ifdef RDK_THREADSAFE_SSS
+      if(!numThreads){
+        numThreads=boost::thread::hardware_concurrency();
+      }
+      numThreads=std::min(std::max(numThreads,1U),static_cast<unsigned int>(confs.size()));
+      if(numThreads>1){
+        // each thread needs its own copy of the force field, if that isn't
+        // possible because some contributions don't support copy() we
+        // fall back to a single thread:
+        std::vector<boost::shared_ptr<ForceFields::ForceField> > ffs;
+        for(unsigned int ti=0;ti<numThreads;++ti){
+          ForceFields::ForceField *localFF=0;
+          try {
+            localFF=new ForceFields::ForceField(ff);
+          } catch (const ValueErrorException &) {
+            ffs.clear();
+            break;
+          }
+          ffs.push_back(boost::shared_ptr<ForceFields::ForceField>(localFF));
+        }
+        if(!ffs.empty()){
+          std::vector<boost::exception_ptr> errs(numThreads);
+          boost::thread_group tg;
+          for(unsigned int ti=0;ti<numThreads;++ti){
+            tg.add_thread(new boost::thread(optimizeConfsThread,&mol,ffs[ti].get(),&confs,&res,
+                                            maxIters,ti,numThreads,&errs[ti]));
+          }
+          tg.join_all();
+          for(unsigned int ti=0;ti<numThreads;++ti){
+            if(errs[ti]) boost::rethrow_exception(errs[ti]);
+          }
+          return;
+        }
+      }
+#endif
+      optimizeConfsSerially(&mol,&ff,&confs,&res,maxIters);
+    }
+
+    void UFFOptimizeMoleculeConfs(ROMol &mol,
+                                  std::vector<std::pair<int,double> > &res,
+                                  unsigned int numThreads,int maxIters,
+                                  double vdwThresh,bool ignoreInterfragInteractions,
+                                  double nonbondedCutoff){
+      res.clear();
+      if(!mol.getNumConformers()) return;
+      int confId=(*mol.beginConformers())->getId();
+      boost::scoped_ptr<ForceFields::ForceField> ff(constructForceField(mol,vdwThresh,confId,
+                                                                        ignoreInterfragInteractions,
+                                                                        nonbondedCutoff));
+      OptimizeMoleculeConfs(mol,*ff,res,numThreads,maxIters);
+    }
+  }
+}
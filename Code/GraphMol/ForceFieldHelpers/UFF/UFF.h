@@ -0,0 +1,73 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_UFFOPTIMIZE_H_
+#define _RD_UFFOPTIMIZE_H_
+
+#include <vector>
+#include <utility>
+
+namespace ForceFields {
+  class ForceField;
+}
+
+namespace RDKit {
+  class ROMol;
+  namespace UFF {
+    //! Optimizes all of a molecule's conformers with a single force field setup
+    /*!
+      \param mol        the molecule to use
+      \param ff         the force field, this should have been set up for
+                        one of \c mol's conformers. When a single thread is
+                        used the conformers are optimized with \c ff itself,
+                        its positions are restored afterwards.
+      \param res        used to return a (needsMore,energy) pair for each
+                        conformer, in the order of the molecule's conformers.
+                        needsMore is nonzero if the minimization did not converge.
+      \param numThreads the number of threads to use, 0 uses one per processor.
+                        This is ignored if the RDKit was built without
+                        thread support.
+      \param maxIters   the maximum number of iterations for each conformer
+
+      Each thread works with its own copy of \c ff, so the atom typing and
+      term setup are only done once regardless of the number of conformers.
+      If \c ff contains contributions that can't be copied, a single
+      thread is used.
+    */
+    void OptimizeMoleculeConfs(ROMol &mol,ForceFields::ForceField &ff,
+                               std::vector<std::pair<int,double> > &res,
+                               unsigned int numThreads=1,int maxIters=200);
+
+    //! Optimizes all of a molecule's conformers using UFF
+    /*!
+      \param mol        the molecule to use
+      \param res        used to return a (needsMore,energy) pair for each
+                        conformer, in the order of the molecule's conformers.
+      \param numThreads the number of threads to use, 0 uses one per processor.
+      \param maxIters   the maximum number of iterations for each conformer
+      \param vdwThresh  used to exclude long-range van der Waals interactions,
+                        see constructForceField()
+      \param ignoreInterfragInteractions if true, nonbonded terms will not be added between
+                                         fragments
+      \param nonbondedCutoff if positive, the van der Waals terms are evaluated
+                             using a neighbor list, see constructForceField()
+
+      The force field is set up once, using the first conformer's
+      geometry to decide which van der Waals terms are included.
+    */
+    void UFFOptimizeMoleculeConfs(ROMol &mol,
+                                  std::vector<std::pair<int,double> > &res,
+                                  unsigned int numThreads=1,int maxIters=200,
+                                  double vdwThresh=100.0,
+                                  bool ignoreInterfragInteractions=true,
+                                  double nonbondedCutoff=-1.0);
+  }
+}
+
+#endif
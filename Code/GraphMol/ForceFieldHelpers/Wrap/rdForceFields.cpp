@@ -17,28 +17,46 @@
 #include <ForceField/Wrap/PyForceField.h>
 #include <GraphMol/ForceFieldHelpers/UFF/AtomTyper.h>
 #include <GraphMol/ForceFieldHelpers/UFF/Builder.h>
+#include <GraphMol/ForceFieldHelpers/UFF/UFF.h>
 
 namespace python = boost::python;
 
 namespace RDKit {
   int UFFOptimizeMolecule(ROMol &mol, int maxIters=200,
 			  double vdwThresh=10.0, int confId=-1,
-                          bool ignoreInterfragInteractions=true ){
+                          bool ignoreInterfragInteractions=true,
+                          double nonbondedCutoff=-1.0 ){
     ForceFields::ForceField *ff=UFF::constructForceField(mol,vdwThresh, confId,
-                                                         ignoreInterfragInteractions);
+                                                         ignoreInterfragInteractions,
+                                                         nonbondedCutoff);
     ff->initialize();
     int res=ff->minimize(maxIters);
     delete ff;
     return res;
   }
 
+  python::object UFFConfsHelper(ROMol &mol, unsigned int numThreads, int maxIters,
+                                double vdwThresh, bool ignoreInterfragInteractions,
+                                double nonbondedCutoff){
+    std::vector<std::pair<int,double> > res;
+    UFF::UFFOptimizeMoleculeConfs(mol,res,numThreads,maxIters,vdwThresh,
+                                  ignoreInterfragInteractions,nonbondedCutoff);
+    python::list pyres;
+    for(unsigned int i=0;i<res.size();++i){
+      pyres.append(python::make_tuple(res[i].first,res[i].second));
+    }
+    return python::tuple(pyres);
+  }
+
   ForceFields::PyForceField *UFFGetMoleculeForceField(ROMol &mol,
                                                       double vdwThresh=10.0,
                                                       int confId=-1,
-                                                      bool ignoreInterfragInteractions=true ){
+                                                      bool ignoreInterfragInteractions=true,
+                                                      double nonbondedCutoff=-1.0 ){
 
     ForceFields::ForceField *ff=UFF::constructForceField(mol,vdwThresh, confId,
-                                                         ignoreInterfragInteractions);
+                                                         ignoreInterfragInteractions,
+                                                         nonbondedCutoff);
     ForceFields::PyForceField *res=new ForceFields::PyForceField(ff);
     res->initialize();
     return res;
@@ -67,13 +85,41 @@ BOOST_PYTHON_MODULE(rdForceFieldHelpers) {
     - confId : indicates which conformer to optimize\n\
     - ignoreInterfragInteractions : if true, nonbonded terms between \n\
                   fragments will not be added to the forcefield.\n\
+    - nonbondedCutoff : if this is positive, the van der Waals terms are\n\
+                  evaluated using a neighbor list with this cutoff (in\n\
+                  Angstroms) and vdwThresh is ignored. This is much faster\n\
+                  for large molecules.\n\
 \n\
  RETURNS: 0 if the optimization converged, 1 if more iterations are required.\n\
 \n";
   python::def("UFFOptimizeMolecule", RDKit::UFFOptimizeMolecule,
 	      (python::arg("self"),python::arg("maxIters")=200,
 	       python::arg("vdwThresh")=10.0,python::arg("confId")=-1,
-               python::arg("ignoreInterfragInteractions")=true),
+               python::arg("ignoreInterfragInteractions")=true,
+               python::arg("nonbondedCutoff")=-1.0),
+	      docString.c_str());
+
+ docString = "uses UFF to optimize all of a molecule's conformers\n\n\
+ \n\
+ ARGUMENTS:\n\n\
+    - mol : the molecule of interrest\n\
+    - numThreads : the number of threads to use, 0 uses one per processor\n\
+                  (defaults to 1)\n\
+    - maxIters : the maximum number of iterations (defaults to 200)\n\
+    - vdwThresh : used to exclude long-range van der Waals interactions\n\
+                  (defaults to 10.0)\n\
+    - ignoreInterfragInteractions : if true, nonbonded terms between \n\
+                  fragments will not be added to the forcefield.\n\
+    - nonbondedCutoff : if this is positive, the van der Waals terms are\n\
+                  evaluated using a neighbor list with this cutoff.\n\
+\n\
+ RETURNS: a tuple with a (not_converged, energy) pair for each conformer.\n\
+\n";
+  python::def("UFFOptimizeMoleculeConfs", RDKit::UFFConfsHelper,
+	      (python::arg("self"),python::arg("numThreads")=1,python::arg("maxIters")=200,
+	       python::arg("vdwThresh")=10.0,
+               python::arg("ignoreInterfragInteractions")=true,
+               python::arg("nonbondedCutoff")=-1.0),
 	      docString.c_str());
 
  docString = "returns a UFF force field for a molecule\n\n\
@@ -85,10 +131,15 @@ BOOST_PYTHON_MODULE(rdForceFieldHelpers) {
     - confId : indicates which conformer to optimize\n\
     - ignoreInterfragInteractions : if true, nonbonded terms between \n\
                   fragments will not be added to the forcefield.\n\
+    - nonbondedCutoff : if this is positive, the van der Waals terms are\n\
+                  evaluated using a neighbor list with this cutoff (in\n\
+                  Angstroms) and vdwThresh is ignored. This is much faster\n\
+                  for large molecules.\n\
 \n";
   python::def("UFFGetMoleculeForceField", RDKit::UFFGetMoleculeForceField,
 	      (python::arg("mol"),python::arg("vdwThresh")=10.0,python::arg("confId")=-1,
-               python::arg("ignoreInterfragInteractions")=true),
+               python::arg("ignoreInterfragInteractions")=true,
+               python::arg("nonbondedCutoff")=-1.0),
 	      python::return_value_policy<python::manage_new_object>(),
 	      docString.c_str());
 
@@ -0,0 +1,101 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+// Compares the BFGS and L-BFGS minimizers on UFF force fields.
+//
+#include <iostream>
+#include <cstdlib>
+#include <RDGeneral/Invariant.h>
+#include <RDGeneral/RDLog.h>
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/FileParsers/MolSupplier.h>
+#include <GraphMol/ForceFieldHelpers/UFF/Builder.h>
+#include <ForceField/ForceField.h>
+#include <ForceField/Contrib.h>
+#include <Numerics/Optimizer/LBFGSOpt.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+using namespace RDKit;
+
+namespace {
+  // a contribution that does nothing but count the number of gradient
+  // evaluations, the minimizers do one of these per iteration:
+  class CountingContrib : public ForceFields::ForceFieldContrib {
+  public:
+    CountingContrib(ForceFields::ForceField *owner,unsigned int *counter) :
+      dp_counter(counter) { dp_forceField=owner; };
+    double getEnergy(double *pos) const { return 0.0; };
+    void getGrad(double *pos,double *grad) const { ++(*dp_counter); };
+    CountingContrib *copy() const { return new CountingContrib(*this); };
+  private:
+    unsigned int *dp_counter;
+  };
+}
+
+void benchMinimizers(const std::string &fName,unsigned int maxIts=1000){
+  std::cout << " ----------------- BFGS vs L-BFGS: " << fName << std::endl;
+  SDMolSupplier suppl(fName,false,false);
+  const char *names[2]={"BFGS","LBFGS"};
+  unsigned int totIters[2]={0,0},nConverged[2]={0,0};
+  double totTime[2]={0.0,0.0},totEnergy[2]={0.0,0.0};
+  unsigned int nMols=0;
+  while(!suppl.atEnd()){
+    ROMol *mol=suppl.next();
+    if(!mol) continue;
+    MolOps::sanitizeMol(*(RWMol *)mol);
+    unsigned int dim=3*mol->getNumAtoms();
+    for(unsigned int which=0;which<2;++which){
+      ROMol molCopy(*mol);
+      ForceFields::ForceField *field=UFF::constructForceField(molCopy);
+      TEST_ASSERT(field);
+      unsigned int nGrads=0;
+      field->contribs().push_back(ForceFields::ContribPtr(new CountingContrib(field,&nGrads)));
+      field->initialize();
+      field->setMinimizer(which ? ForceFields::ForceField::LBFGS : ForceFields::ForceField::BFGS);
+      boost::posix_time::ptime start=boost::posix_time::microsec_clock::universal_time();
+      int needsMore=field->minimize(maxIts);
+      boost::posix_time::ptime finish=boost::posix_time::microsec_clock::universal_time();
+      totTime[which] += (finish-start).total_microseconds()/1e6;
+      // the first gradient evaluation is before the first iteration:
+      totIters[which] += nGrads-1;
+      if(!needsMore) ++nConverged[which];
+      totEnergy[which] += field->calcEnergy();
+      delete field;
+    }
+    std::cout << "  " << nMols << " atoms: " << mol->getNumAtoms()
+              << " hessian: " << dim*dim*sizeof(double)/1024 << "KB"
+              << " history: " << (2*LBFGSOpt::HISTORYSIZE+2)*dim*sizeof(double)/1024 << "KB"
+              << std::endl;
+    delete mol;
+    ++nMols;
+  }
+  for(unsigned int which=0;which<2;++which){
+    std::cout << "  " << names[which] << ": mols: " << nMols
+              << " converged: " << nConverged[which]
+              << " iterations: " << totIters[which]
+              << " time: " << totTime[which] << "s"
+              << " total energy: " << totEnergy[which]
+              << std::endl;
+  }
+  std::cout << "Done\n" << std::endl;
+}
+
+int main(int argc,char *argv[])
+{
+  RDLog::InitLogs();
+  std::string fName;
+  if(argc>1){
+    fName=argv[1];
+  } else {
+    fName=getenv("RDBASE");
+    fName += "/Code/GraphMol/ForceFieldHelpers/test_data/bulk.sdf";
+  }
+  benchMinimizers(fName);
+  return 0;
+}
@@ -10,6 +10,7 @@
 //
 
 #include <iostream>
+#include <algorithm>
 #include <RDGeneral/Invariant.h>
 #include <RDGeneral/RDLog.h>
 #include <RDGeneral/utils.h>
@@ -22,7 +23,9 @@
 
 #include <GraphMol/ForceFieldHelpers/UFF/AtomTyper.h>
 #include <GraphMol/ForceFieldHelpers/UFF/Builder.h>
+#include <GraphMol/ForceFieldHelpers/UFF/UFF.h>
 #include <ForceField/ForceField.h>
+#include <ForceField/Contrib.h>
 #include <GraphMol/DistGeomHelpers/Embedder.h>
 
 using namespace RDKit;
@@ -847,9 +850,287 @@ void testSFIssue3009337(){
   BOOST_LOG(rdErrorLog) << "  done" << std::endl;
 }
 
+void testUFFBatchedEvaluation(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Test that batched UFF evaluation matches the per-term results." << std::endl;
+
+  std::string pathName=getenv("RDBASE");
+  pathName += "/Code/GraphMol/ForceFieldHelpers/test_data";
+  SDMolSupplier suppl(pathName+"/bulk.sdf");
+
+  unsigned int count=0;
+  while(!suppl.atEnd() && count<20){
+    ROMol *mol=suppl.next();
+    if(!mol) continue;
+    ++count;
+    ForceFields::ForceField *field=UFF::constructForceField(*mol);
+    TEST_ASSERT(field);
+    field->initialize();
+    for(unsigned int iter=0;iter<2;++iter){
+      unsigned int nPts=field->numPoints();
+      double *pos=new double[3*nPts];
+      double *grad1=new double[3*nPts];
+      double *grad2=new double[3*nPts];
+      for(unsigned int i=0;i<nPts;++i){
+        for(unsigned int j=0;j<3;++j){
+          pos[3*i+j]=(*field->positions()[i])[j];
+        }
+      }
+      std::fill(grad1,grad1+3*nPts,0.0);
+      std::fill(grad2,grad2+3*nPts,0.0);
+
+      // the const forms don't use the batches:
+      double e1=field->calcEnergy();
+      double e2=field->calcEnergy(pos);
+      TEST_ASSERT(e1==e2);
+      field->calcGrad(grad1);
+      field->calcGrad(pos,grad2);
+      for(unsigned int i=0;i<3*nPts;++i){
+        TEST_ASSERT(grad1[i]==grad2[i]);
+      }
+      delete [] pos;
+      delete [] grad1;
+      delete [] grad2;
+
+      // and again from somewhere else on the surface:
+      field->minimize(10);
+    }
+    delete field;
+    delete mol;
+  }
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+
+void testUFFNonbondedList(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Test UFF force fields with neighbor-list nonbonded terms." << std::endl;
+
+  std::string pathName=getenv("RDBASE");
+  pathName += "/Code/GraphMol/ForceFieldHelpers/test_data";
+  SDMolSupplier suppl(pathName+"/bulk.sdf");
+
+  unsigned int count=0;
+  while(!suppl.atEnd() && count<20){
+    ROMol *mol=suppl.next();
+    if(!mol) continue;
+    ++count;
+    // with a long enough cutoff the energies are the same as with
+    // individual terms:
+    ForceFields::ForceField *field=UFF::constructForceField(*mol);
+    ForceFields::ForceField *listField=UFF::constructForceField(*mol,100.0,-1,true,100.0);
+    TEST_ASSERT(field);
+    TEST_ASSERT(listField);
+    field->initialize();
+    listField->initialize();
+    TEST_ASSERT(listField->contribs().size()<field->contribs().size());
+    TEST_ASSERT(feq(field->calcEnergy(),listField->calcEnergy(),1e-6));
+    delete listField;
+
+    // and the minimizer is happy with a shorter cutoff:
+    ROMol mol2(*mol);
+    listField=UFF::constructForceField(mol2,100.0,-1,true,8.0);
+    listField->initialize();
+    double e1=listField->calcEnergy();
+    listField->minimize(200);
+    TEST_ASSERT(listField->calcEnergy()<=e1);
+    delete listField;
+
+    delete field;
+    delete mol;
+  }
+
+  // the angle terms built without the neighbor matrix are the same,
+  // also for the small rings where the matrix entries are overwritten:
+  std::string smis[]={"C1CC1C","C12C3C4C1C5C2C3C45","C1CCC1C(=O)N","CC#CC=C"};
+  for(unsigned int i=0;i<4;i++){
+    RWMol *mol=SmilesToMol(smis[i]);
+    TEST_ASSERT(mol);
+    MolOps::addHs(*mol);
+    DGeomHelpers::EmbedMolecule(*mol,0,42);
+    UFF::AtomicParamVect types;
+    bool foundAll;
+    boost::tie(types,foundAll)=UFF::getAtomTypes(*mol);
+    TEST_ASSERT(foundAll);
+    ForceFields::ForceField *matField=new ForceFields::ForceField();
+    ForceFields::ForceField *listField=new ForceFields::ForceField();
+    UFF::Tools::addAngles(*mol,types,matField,UFF::Tools::buildNeighborMatrix(*mol));
+    UFF::Tools::addAngles(*mol,types,listField);
+    TEST_ASSERT(matField->contribs().size()>0);
+    TEST_ASSERT(listField->contribs().size()==matField->contribs().size());
+    for(unsigned int j=0;j<mol->getNumAtoms();j++){
+      matField->positions().push_back(&mol->getConformer().getAtomPos(j));
+      listField->positions().push_back(&mol->getConformer().getAtomPos(j));
+    }
+    matField->initialize();
+    listField->initialize();
+    TEST_ASSERT(feq(matField->calcEnergy(),listField->calcEnergy(),1e-8));
+    delete matField;
+    delete listField;
+    delete mol;
+  }
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+
+// a contribution that can't be evaluated
+class FailingContrib : public ForceFields::ForceFieldContrib {
+public:
+  double getEnergy(double *pos) const {
+    throw ValueErrorException("cannot evaluate energy");
+  }
+  void getGrad(double *pos,double *grad) const {
+    throw ValueErrorException("cannot evaluate gradient");
+  }
+  ForceFields::ForceFieldContrib *copy() const { return new FailingContrib(); }
+};
+
+// a contribution that doesn't add anything and doesn't implement copy()
+class NoCopyContrib : public ForceFields::ForceFieldContrib {
+public:
+  double getEnergy(double *pos) const { return 0.0; }
+  void getGrad(double *pos,double *grad) const {}
+};
+
+void testUFFOptimizeConfs(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Test optimizing multiple conformers with one force field." << std::endl;
+
+  ROMol *mol=SmilesToMol("CCOC(=O)c1ccc(NC(=O)CCN)cc1");
+  TEST_ASSERT(mol);
+  ROMol *mh=MolOps::addHs(*mol);
+  delete mol;
+  INT_VECT cids=DGeomHelpers::EmbedMultipleConfs(*mh,10,30,0xf00d);
+  TEST_ASSERT(cids.size()==10);
+  ROMol m1(*mh),m2(*mh),m4(*mh);
+
+  // the reference: a new force field for each conformer
+  std::vector<std::pair<int,double> > ref;
+  for(ROMol::ConformerIterator ci=mh->beginConformers();ci!=mh->endConformers();++ci){
+    ForceFields::ForceField *field=UFF::constructForceField(*mh,100.0,(*ci)->getId());
+    field->initialize();
+    int needsMore=field->minimize(200);
+    ref.push_back(std::make_pair(needsMore,field->calcEnergy()));
+    delete field;
+  }
+
+  std::vector<std::pair<int,double> > res;
+  UFF::UFFOptimizeMoleculeConfs(m1,res,1,200);
+  TEST_ASSERT(res.size()==ref.size());
+  for(unsigned int i=0;i<res.size();++i){
+    TEST_ASSERT(res[i].first==ref[i].first);
+    TEST_ASSERT(feq(res[i].second,ref[i].second));
+  }
+  // the coordinates were updated:
+  for(unsigned int i=0;i<mh->getNumAtoms();++i){
+    RDGeom::Point3D d=mh->getConformer(cids[3]).getAtomPos(i)-m1.getConformer(cids[3]).getAtomPos(i);
+    TEST_ASSERT(feq(d.length(),0.0));
+  }
+
+  // the number of threads doesn't change anything:
+  std::vector<std::pair<int,double> > res2;
+  UFF::UFFOptimizeMoleculeConfs(m2,res2,4,200);
+  TEST_ASSERT(res2.size()==res.size());
+  for(unsigned int i=0;i<res.size();++i){
+    TEST_ASSERT(res2[i].first==res[i].first);
+    TEST_ASSERT(res2[i].second==res[i].second);
+  }
+
+  // no conformers:
+  ROMol m3(*mh);
+  m3.clearConformers();
+  UFF::UFFOptimizeMoleculeConfs(m3,res,1,200);
+  TEST_ASSERT(res.empty());
+
+  // force fields that can't be copied are used on a single thread:
+  {
+    ForceFields::ForceField *field=UFF::constructForceField(m4,100.0,cids[0]);
+    field->contribs().push_back(ForceFields::ContribPtr(new NoCopyContrib()));
+    bool ok=false;
+    try {
+      ForceFields::ForceField fieldCopy(*field);
+    } catch (const ValueErrorException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    RDGeom::PointPtrVect origPositions=field->positions();
+    std::vector<std::pair<int,double> > res3;
+    UFF::OptimizeMoleculeConfs(m4,*field,res3,4,200);
+    TEST_ASSERT(res3.size()==res2.size());
+    for(unsigned int i=0;i<res2.size();++i){
+      TEST_ASSERT(res3[i].first==res2[i].first);
+      TEST_ASSERT(res3[i].second==res2[i].second);
+    }
+    // the force field's own positions are back:
+    TEST_ASSERT(field->positions()==origPositions);
+    delete field;
+  }
+
+  // errors are passed on to the caller, also from the worker threads:
+  ForceFields::ForceField *field=UFF::constructForceField(*mh,100.0,cids[0]);
+  field->contribs().push_back(ForceFields::ContribPtr(new FailingContrib()));
+  for(unsigned int nt=1;nt<5;nt+=3){
+    ROMol m5(*mh);
+    bool ok=false;
+    try {
+      UFF::OptimizeMoleculeConfs(m5,*field,res,nt,200);
+    } catch (const ValueErrorException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+  }
+  delete field;
+
+  delete mh;
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+
 //-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
 //
 //-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
+void testUFFLBFGS(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Test minimizing with L-BFGS." << std::endl;
+
+  std::string pathName=getenv("RDBASE");
+  pathName += "/Code/GraphMol/ForceFieldHelpers/test_data";
+  SDMolSupplier suppl(pathName+"/bulk.sdf",false,false);
+  unsigned int count=0;
+  while(!suppl.atEnd() && count<10){
+    ROMol *mol=suppl.next();
+    TEST_ASSERT(mol);
+    MolOps::sanitizeMol(*(RWMol *)mol);
+    ROMol mol2(*mol);
+
+    ForceFields::ForceField *field=UFF::constructForceField(*mol);
+    TEST_ASSERT(field);
+    field->initialize();
+    TEST_ASSERT(field->getMinimizer()==ForceFields::ForceField::BFGS);
+    int needsMore=field->minimize(1000);
+    TEST_ASSERT(!needsMore);
+    double e1=field->calcEnergy();
+    delete field;
+
+    field=UFF::constructForceField(mol2);
+    field->initialize();
+    field->setMinimizer(ForceFields::ForceField::LBFGS);
+    TEST_ASSERT(field->getMinimizer()==ForceFields::ForceField::LBFGS);
+    // copies use the same minimizer:
+    ForceFields::ForceField field2(*field);
+    TEST_ASSERT(field2.getMinimizer()==ForceFields::ForceField::LBFGS);
+    needsMore=field->minimize(1000);
+    TEST_ASSERT(!needsMore);
+    double e2=field->calcEnergy();
+    delete field;
+
+    // the two don't have to end up in the same minimum, but they should
+    // be close:
+    TEST_ASSERT(fabs(e1-e2)<0.05*fabs(e1)+1.0);
+    delete mol;
+    ++count;
+  }
+  TEST_ASSERT(count==10);
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+
 int main(){
   RDLog::InitLogs();
 #if 1
@@ -866,5 +1147,9 @@ int main(){
 #endif
   testMissingParams();
   testSFIssue3009337();
+  testUFFBatchedEvaluation();
+  testUFFNonbondedList();
+  testUFFOptimizeConfs();
+  testUFFLBFGS();
 
 }
@@ -499,7 +499,7 @@ namespace RDKit {
 
       // first find the all the simple rings in the molecule
       VECT_INT_VECT arings;
-      if(mol.getRingInfo()->isInitialized()){
+      if(mol.getRingInfo()->getPerceptionType()==RingInfo::SSSR){
         arings = mol.getRingInfo()->atomRings();
       } else {
         MolOps::findSSSR(mol, arings);
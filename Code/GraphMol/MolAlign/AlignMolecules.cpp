@@ -14,8 +14,14 @@
 #include <GraphMol/Substruct/SubstructMatch.h>
 #include <GraphMol/Conformer.h>
 #include <GraphMol/ROMol.h>
+#include <GraphMol/RWMol.h>
 #include <Numerics/Alignment/AlignPoints.h>
 #include <GraphMol/MolTransforms/MolTransforms.h>
+#include <set>
+#include <algorithm>
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread.hpp>
+#endif
 
 namespace RDKit {
   namespace MolAlign {
@@ -136,5 +142,173 @@ namespace RDKit {
         }
       }
     }   
+
+    namespace {
+      // the data used to compute the RMSD matrix, the coordinates of each
+      // conformation are centered and stored contiguously:
+      struct RMSMatrixData {
+        unsigned int nConfs;
+        unsigned int nPts;
+        std::vector<double> coords;   // 3*nPts per conformation
+        std::vector<double> lenSqs;   // one per conformation
+        std::vector< std::vector<unsigned int> > maps; // empty: identity
+        bool reflect;
+      };
+
+      double calcPairRMS(const RMSMatrixData &data,unsigned int i,unsigned int j){
+        const double *ri=&data.coords[3*data.nPts*i];
+        const double *rj=&data.coords[3*data.nPts*j];
+        double ssr;
+        if(data.maps.empty()){
+          ssr=RDNumeric::Alignments::AlignCenteredPointsSSR(data.nPts,ri,rj,
+                                                            data.lenSqs[i],data.lenSqs[j],
+                                                            0,data.reflect);
+        } else {
+          ssr=-1.0;
+          for(unsigned int mi=0;mi<data.maps.size();++mi){
+            double tssr=RDNumeric::Alignments::AlignCenteredPointsSSR(data.nPts,ri,rj,
+                                                                      data.lenSqs[i],data.lenSqs[j],
+                                                                      &data.maps[mi].front(),
+                                                                      data.reflect);
+            if(ssr<0.0 || tssr<ssr) ssr=tssr;
+          }
+        }
+        return sqrt(ssr/data.nPts);
+      }
+
+      void calcRMSRows(const RMSMatrixData *data,std::vector<double> *res,
+                       unsigned int start,unsigned int step){
+        for(unsigned int i=start;i<data->nConfs;i+=step){
+          unsigned int offset=i*(i-1)/2;
+          for(unsigned int j=0;j<i;++j){
+            (*res)[offset+j]=calcPairRMS(*data,i,j);
+          }
+        }
+      }
+    }
+
+    void getConformerRMSMatrix(const ROMol &mol,std::vector<double> &res,
+                               const std::vector<unsigned int> *atomIds,
+                               const std::vector<unsigned int> *confIds,
+                               bool symmetry,bool reflect,
+                               unsigned int numThreads,
+                               unsigned int maxMatches) {
+      std::vector<const Conformer *> confs;
+      if(confIds){
+        for(std::vector<unsigned int>::const_iterator cid=confIds->begin();
+            cid!=confIds->end();++cid){
+          confs.push_back(&mol.getConformer(*cid));
+        }
+      } else {
+        for(ROMol::ConstConformerIterator cnfi=mol.beginConformers();
+            cnfi!=mol.endConformers();++cnfi){
+          confs.push_back(cnfi->get());
+        }
+      }
+
+      std::vector<unsigned int> atoms;
+      if(atomIds){
+        atoms=*atomIds;
+      } else {
+        for(unsigned int ai=0;ai<mol.getNumAtoms();++ai){
+          atoms.push_back(ai);
+        }
+      }
+
+      RMSMatrixData data;
+      data.nConfs=confs.size();
+      data.nPts=atoms.size();
+      data.reflect=reflect;
+      res.clear();
+      if(data.nConfs<2) return;
+      res.resize(data.nConfs*(data.nConfs-1)/2,0.0);
+      if(!data.nPts) return;
+
+      data.coords.resize(3*data.nPts*data.nConfs);
+      data.lenSqs.resize(data.nConfs);
+      for(unsigned int ci=0;ci<data.nConfs;++ci){
+        RDGeom::Point3D ctr;
+        for(unsigned int ai=0;ai<data.nPts;++ai){
+          ctr += confs[ci]->getAtomPos(atoms[ai]);
+        }
+        ctr /= data.nPts;
+        double *coords=&data.coords[3*data.nPts*ci];
+        double lenSq=0.0;
+        for(unsigned int ai=0;ai<data.nPts;++ai){
+          RDGeom::Point3D pt=confs[ci]->getAtomPos(atoms[ai])-ctr;
+          coords[3*ai]=pt.x;
+          coords[3*ai+1]=pt.y;
+          coords[3*ai+2]=pt.z;
+          lenSq += pt.lengthSq();
+        }
+        data.lenSqs[ci]=lenSq;
+      }
+
+      if(symmetry){
+        // find the mappings of our atoms onto the molecule and convert
+        // them to indices into atoms. The query only contains our atoms,
+        // so equivalent atoms we aren't using (e.g. Hs that were left
+        // out) don't multiply the number of mappings, and the search
+        // stops once maxMatches mappings have been found. Mappings that
+        // take one of our atoms to an atom we aren't using are skipped,
+        // as are duplicates:
+        std::vector<int> atomIdx(mol.getNumAtoms(),-1);
+        for(unsigned int ai=0;ai<data.nPts;++ai){
+          atomIdx[atoms[ai]]=ai;
+        }
+        RWMol query;
+        for(unsigned int ai=0;ai<data.nPts;++ai){
+          query.addAtom(mol.getAtomWithIdx(atoms[ai])->copy(),false,true);
+        }
+        for(unsigned int bi=0;bi<mol.getNumBonds();++bi){
+          const Bond *bond=mol.getBondWithIdx(bi);
+          int begIdx=atomIdx[bond->getBeginAtomIdx()];
+          int endIdx=atomIdx[bond->getEndAtomIdx()];
+          if(begIdx<0 || endIdx<0) continue;
+          query.addBond(begIdx,endIdx,bond->getBondType());
+        }
+        std::vector<MatchVectType> matches;
+        SubstructMatch(mol,query,matches,false,true,false,maxMatches);
+        std::set< std::vector<unsigned int> > seen;
+        for(std::vector<MatchVectType>::const_iterator mi=matches.begin();
+            mi!=matches.end();++mi){
+          std::vector<unsigned int> map(data.nPts);
+          bool ok=true;
+          for(MatchVectType::const_iterator pi=mi->begin();pi!=mi->end();++pi){
+            // pi->first is the query atom, which is atoms[pi->first], and
+            // pi->second the probe atom:
+            if(atomIdx[pi->second]<0){
+              ok=false;
+              break;
+            }
+            map[pi->first]=atomIdx[pi->second];
+          }
+          if(ok && seen.insert(map).second){
+            data.maps.push_back(map);
+          }
+        }
+      }
+
+#ifdef RDK_THREADSAFE_SSS
+      if(!numThreads){
+        numThreads=boost::thread::hardware_concurrency();
+      }
+      numThreads=std::min(std::max(numThreads,1U),data.nConfs);
+#else
+      numThreads=1;
+#endif
+      if(numThreads==1){
+        calcRMSRows(&data,&res,0,1);
+      }
+#ifdef RDK_THREADSAFE_SSS
+      else {
+        boost::thread_group tg;
+        for(unsigned int ti=0;ti<numThreads;++ti){
+          tg.add_thread(new boost::thread(calcRMSRows,&data,&res,ti,numThreads));
+        }
+        tg.join_all();
+      }
+#endif
+    }
   }
 }
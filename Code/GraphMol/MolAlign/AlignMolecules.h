@@ -113,6 +113,44 @@ namespace RDKit {
                             const std::vector<unsigned int> *confIds=0,
                             const RDNumeric::DoubleVector *weights=0, 
                             bool reflect=false, unsigned int maxIters=50);
+
+    //! Compute the RMSD between all pairs of conformations of a molecule
+    /*!
+      Each pair of conformations is optimally aligned (the conformations
+      themselves are not changed).
+
+      \param mol       The molecule of interest
+      \param res       used to return the RMSDs. This is the lower triangle of the
+                       symmetric matrix, the RMSD between conformations \c i and
+                       \c j (j<i) is in res[i*(i-1)/2+j]. This is the format
+                       used by the Butina clustering code.
+      \param atomIds   vector of atoms to be used to compute the RMSDs.
+                       All atoms will be used is not specified
+      \param confIds   vector of conformations to use - defaults to all. The
+                       conformations are numbered in this order in \c res.
+      \param symmetry  if true, the RMSD of each pair is the minimum over the
+                       mappings of the atoms in \c atomIds onto the molecule
+                       (these are found by substructure matching with a query
+                       built from just those atoms). Mappings that take any of
+                       the atoms in \c atomIds to atoms that are not in it are
+                       not used. Molecules with many equivalent atoms
+                       (e.g. hydrogens) can have a very large number of
+                       mappings, leaving those atoms out of \c atomIds
+                       (e.g. using only the heavy atoms) avoids this.
+      \param reflect   toggles reflecting (about the origin) the alignment
+      \param numThreads the number of threads to use. If this is zero, the
+                       number of hardware threads is used. The results do
+                       not depend on the number of threads.
+      \param maxMatches the maximum number of mappings found when \c symmetry
+                       is set, the search for mappings stops once this many
+                       have been found
+    */
+    void getConformerRMSMatrix(const ROMol &mol,std::vector<double> &res,
+                               const std::vector<unsigned int> *atomIds=0,
+                               const std::vector<unsigned int> *confIds=0,
+                               bool symmetry=false,bool reflect=false,
+                               unsigned int numThreads=1,
+                               unsigned int maxMatches=1000);
   }
 }
 #endif
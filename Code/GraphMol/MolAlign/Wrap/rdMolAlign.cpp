@@ -88,6 +88,32 @@ namespace RDKit {
     }
   }
     
+  PyObject *getConfRMSMatrix(const ROMol &mol, python::object atomIds=python::list(),
+                             python::object confIds=python::list(),
+                             bool symmetry=false, bool reflect=false,
+                             unsigned int numThreads=1, unsigned int maxMatches=1000) {
+    std::vector<unsigned int> *aIds = _translateIds(atomIds);
+    std::vector<unsigned int> *cIds = _translateIds(confIds);
+    std::vector<double> rms;
+    MolAlign::getConformerRMSMatrix(mol, rms, aIds, cIds, symmetry, reflect,
+                                    numThreads, maxMatches);
+    if (aIds) {
+      delete aIds;
+    }
+    if (cIds) {
+      delete cIds;
+    }
+    npy_intp dims[1];
+    dims[0] = rms.size();
+    PyArrayObject *res = (PyArrayObject *)PyArray_SimpleNew(1,dims,NPY_DOUBLE);
+    if (!rms.empty()) {
+      memcpy(static_cast<void *>(res->data),
+             static_cast<const void *>(&rms.front()),
+             rms.size()*sizeof(double));
+    }
+    return PyArray_Return(res);
+  }
+
   PyObject* getMolAlignTransform(const ROMol &prbMol, const ROMol &refMol,
                                       int prbCid=-1, int refCid=-1, 
                                       python::object atomMap=python::list(),
@@ -255,6 +281,33 @@ BOOST_PYTHON_MODULE(rdMolAlign) {
                python::arg("weights")=python::list(),
                python::arg("reflect")=false, python::arg("maxIters")=50),
               docString.c_str());
+
+  docString = "Compute the RMSD between all pairs of conformations of a molecule\n\
+     \n\
+      Each pair of conformations is optimally aligned, the conformations\n\
+      themselves are not changed.\n\
+     \n\
+     ARGUMENTS\n\
+      - mol        molecule of interest\n\
+      - atomIds    List of atom ids to use for the RMSD - defaults to all atoms\n\
+      - confIds    Ids of conformations to use - defaults to all conformers \n\
+      - symmetry   if true, use the minimum RMSD over the mappings of the\n\
+                   molecule onto itself\n\
+      - reflect    if true reflect the conformations\n\
+      - numThreads the number of threads to use, zero uses all hardware threads\n\
+      - maxMatches the maximum number of mappings to use when symmetry is set\n\
+       \n\
+      RETURNS\n\
+      the lower triangle of the RMSD matrix, the RMSD between conformations\n\
+      i and j (j<i) is at position i*(i-1)/2+j. This can be passed to\n\
+      rdkit.ML.Cluster.Butina.ClusterData with isDistData=True\n\
+    \n";
+  python::def("GetConformerRMSMatrix", RDKit::getConfRMSMatrix,
+              (python::arg("mol"), python::arg("atomIds")=python::list(),
+               python::arg("confIds")=python::list(),
+               python::arg("symmetry")=false, python::arg("reflect")=false,
+               python::arg("numThreads")=1, python::arg("maxMatches")=1000),
+              docString.c_str());
 }
     
   
@@ -106,7 +106,24 @@ class TestCase(unittest.TestCase):
             
             self.failUnless(lstFeq(mpos, pos, .5))
 
-          
+
+    def test5ConformerRMSMatrix(self):
+      mol = Chem.MolFromSmiles('CC(C)(C)c1ccc(OCC(=O)NC)cc1')
+      cids = rdDistGeom.EmbedMultipleConfs(mol,10,30,0xf00d)
+      rms = rdMolAlign.GetConformerRMSMatrix(mol)
+      self.failUnlessEqual(len(rms),45)
+      idx = 0
+      for i in range(1,len(cids)):
+        for j in range(i):
+          ref,trans = rdMolAlign.GetAlignmentTransform(mol,mol,cids[i],cids[j],
+                                                       [(x,x) for x in range(mol.GetNumAtoms())])
+          self.failUnless(feq(rms[idx],ref,1e-4))
+          idx += 1
+      rms2 = rdMolAlign.GetConformerRMSMatrix(mol,symmetry=True,numThreads=2)
+      self.failUnlessEqual(len(rms2),45)
+      for i in range(len(rms)):
+        self.failIf(rms2[i]>rms[i]+1e-6)
+
 if __name__ == '__main__':
     print "Testing MolAlign Wrappers"
     unittest.main()
@@ -18,6 +18,8 @@
 #include <GraphMol/ForceFieldHelpers/UFF/Builder.h>
 #include <GraphMol/MolPickler.h>
 #include <GraphMol/DistGeomHelpers/Embedder.h>
+#include <GraphMol/SmilesParse/SmilesParse.h>
+#include <GraphMol/MolOps.h>
 
 using namespace RDKit;
 
@@ -125,6 +127,104 @@ void testIssue241() {
   CHECK_INVARIANT(RDKit::feq(rmsd, 0.0), "");
 }
     
+void testConformerRMSMatrix() {
+  ROMol *m=SmilesToMol("CC(C)(C)c1ccc(OCC(=O)NC)cc1");
+  TEST_ASSERT(m);
+  INT_VECT cids=DGeomHelpers::EmbedMultipleConfs(*m,10,30,0xf00d);
+  TEST_ASSERT(cids.size()==10);
+
+  std::vector<double> rms;
+  MolAlign::getConformerRMSMatrix(*m,rms);
+  TEST_ASSERT(rms.size()==45);
+  RDGeom::Transform3D trans;
+  MatchVectType identity;
+  for(unsigned int ai=0;ai<m->getNumAtoms();++ai){
+    identity.push_back(std::make_pair(ai,ai));
+  }
+  for(unsigned int i=1;i<cids.size();++i){
+    for(unsigned int j=0;j<i;++j){
+      double ref=MolAlign::getAlignmentTransform(*m,*m,trans,cids[i],cids[j],&identity);
+      TEST_ASSERT(RDKit::feq(rms[i*(i-1)/2+j],ref,1e-4));
+    }
+  }
+  
+  // the number of threads doesn't change anything:
+  std::vector<double> rms2;
+  MolAlign::getConformerRMSMatrix(*m,rms2,0,0,false,false,4);
+  TEST_ASSERT(rms2.size()==rms.size());
+  for(unsigned int i=0;i<rms.size();++i){
+    TEST_ASSERT(rms2[i]==rms[i]);
+  }
+
+  // a subset of the conformers and atoms, with symmetry:
+  std::vector<unsigned int> atomIds,confIds;
+  // the t-butyl phenyl, this is closed under the symmetry operations:
+  for(unsigned int ai=0;ai<8;++ai) atomIds.push_back(ai);
+  atomIds.push_back(14);
+  atomIds.push_back(15);
+  confIds.push_back(cids[2]);
+  confIds.push_back(cids[5]);
+  confIds.push_back(cids[7]);
+  MolAlign::getConformerRMSMatrix(*m,rms,&atomIds,&confIds,true,false,2);
+  TEST_ASSERT(rms.size()==3);
+  std::vector<MatchVectType> matches;
+  SubstructMatch(*m,*m,matches,false);
+  // the methyl groups of the t-butyl can be swapped and the ring flipped:
+  TEST_ASSERT(matches.size()==12);
+  for(unsigned int i=1;i<confIds.size();++i){
+    for(unsigned int j=0;j<i;++j){
+      double best=-1.0;
+      for(unsigned int mi=0;mi<matches.size();++mi){
+        MatchVectType atomMap;
+        for(unsigned int ai=0;ai<atomIds.size();++ai){
+          atomMap.push_back(std::make_pair(matches[mi][atomIds[ai]].second,
+                                           matches[mi][atomIds[ai]].first));
+        }
+        double tmp=MolAlign::getAlignmentTransform(*m,*m,trans,confIds[i],confIds[j],&atomMap);
+        if(best<0 || tmp<best) best=tmp;
+      }
+      TEST_ASSERT(RDKit::feq(rms[i*(i-1)/2+j],best,1e-4));
+    }
+  }
+
+  // with Hs, only the heavy atoms are used to find the mappings, so the
+  // results are the same as without the Hs:
+  {
+    ROMol *mh=MolOps::addHs(*m);
+    cids=DGeomHelpers::EmbedMultipleConfs(*mh,5,30,0xf00d);
+    TEST_ASSERT(cids.size()==5);
+    ROMol *mnoh=MolOps::removeHs(*mh);
+    TEST_ASSERT(mnoh->getNumConformers()==5);
+    atomIds.clear();
+    for(unsigned int ai=0;ai<mh->getNumAtoms();++ai){
+      if(mh->getAtomWithIdx(ai)->getAtomicNum()>1) atomIds.push_back(ai);
+    }
+    TEST_ASSERT(atomIds.size()==mnoh->getNumAtoms());
+    std::vector<double> rmsNoH;
+    MolAlign::getConformerRMSMatrix(*mnoh,rmsNoH,0,0,true);
+    MolAlign::getConformerRMSMatrix(*mh,rms,&atomIds,0,true);
+    TEST_ASSERT(rms.size()==10);
+    TEST_ASSERT(rmsNoH.size()==rms.size());
+    for(unsigned int i=0;i<rms.size();++i){
+      TEST_ASSERT(RDKit::feq(rms[i],rmsNoH[i],1e-4));
+    }
+    // using fewer mappings can't make the RMSDs smaller:
+    MolAlign::getConformerRMSMatrix(*mh,rms2,&atomIds,0,true,false,1,1);
+    TEST_ASSERT(rms2.size()==rms.size());
+    for(unsigned int i=0;i<rms.size();++i){
+      TEST_ASSERT(rms2[i]>=rms[i]-1e-4);
+    }
+    delete mnoh;
+    delete mh;
+  }
+
+  // no conformers:
+  m->clearConformers();
+  MolAlign::getConformerRMSMatrix(*m,rms);
+  TEST_ASSERT(rms.empty());
+  delete m;
+}
+
 int main() {
   std::cout << "***********************************************************\n";
   std::cout << "Testing MolAlign\n";
@@ -144,6 +244,10 @@ int main() {
   std::cout << "\t---------------------------------\n";
   std::cout << "\t testIssue241 \n\n";
   testIssue241();
+
+  std::cout << "\t---------------------------------\n";
+  std::cout << "\t testConformerRMSMatrix \n\n";
+  testConformerRMSMatrix();
   std::cout << "***********************************************************\n";
   return(0);
 
@@ -147,7 +147,7 @@ namespace RDKit {
                                      double dblBondOffset=0.3,
                                      double dblBondLengthFrac=0.8,
                                      double angstromsPerChar=0.20){
-      if(!mol.getRingInfo()->isInitialized()){
+      if(mol.getRingInfo()->getPerceptionType()!=RingInfo::SSSR){
         MolOps::findSSSR(mol);
       }
       std::vector<ElementType> res;
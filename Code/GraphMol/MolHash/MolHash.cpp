@@ -0,0 +1,160 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include "MolHash.h"
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/SmilesParse/SmilesWrite.h>
+#include <RDGeneral/Invariant.h>
+#include <boost/lexical_cast.hpp>
+#include <cstdio>
+
+namespace RDKit {
+  namespace MolHash {
+    namespace {
+      // the cached text of each layer and the structure version of
+      // the molecule it was calculated for:
+      const PropKey layerKeys[3]={getPropKey("_MolHashCanonicalSmiles"),
+                                  getPropKey("_MolHashIsomericSmiles"),
+                                  getPropKey("_MolHashTautomerSmiles")};
+      const PropKey versionKeys[3]={getPropKey("_MolHashCanonicalSmilesVersion"),
+                                    getPropKey("_MolHashIsomericSmilesVersion"),
+                                    getPropKey("_MolHashTautomerSmilesVersion")};
+
+      // the 64 bit finalizer from MurmurHash3, this makes every bit of
+      // the result depend on every bit of the input
+      inline boost::uint64_t fmix64(boost::uint64_t h){
+        h ^= h>>33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h>>33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h>>33;
+        return h;
+      }
+
+      bool isHeteroatom(const Atom *atom){
+        return atom->getAtomicNum()!=6 && atom->getAtomicNum()!=1;
+      }
+
+      std::string calcTautomerSmiles(const ROMol &mol){
+        RWMol tmol(mol,true);
+        unsigned int nAtoms=tmol.getNumAtoms();
+        std::vector<unsigned int> nHs(nAtoms);
+        for(unsigned int i=0;i<nAtoms;++i){
+          nHs[i]=mol.getAtomWithIdx(i)->getTotalNumHs();
+        }
+
+        // find the bonds that can take part in a tautomeric shift and
+        // make them single:
+        std::vector<bool> inSystem(nAtoms,false);
+        for(ROMol::BondIterator bondIt=tmol.beginBonds();
+            bondIt!=tmol.endBonds();++bondIt){
+          Bond *bond=*bondIt;
+          if(bond->getIsAromatic() || bond->getIsConjugated() ||
+             (bond->getBondType()==Bond::DOUBLE &&
+              (isHeteroatom(bond->getBeginAtom()) || isHeteroatom(bond->getEndAtom())))){
+            bond->setBondType(Bond::SINGLE);
+            bond->setIsAromatic(false);
+            bond->setIsConjugated(false);
+            bond->setStereo(Bond::STEREONONE);
+            inSystem[bond->getBeginAtomIdx()]=true;
+            inSystem[bond->getEndAtomIdx()]=true;
+          }
+        }
+
+        // the hydrogens on heteroatoms in those bonds are mobile, the
+        // others stay where they are:
+        unsigned int nMobileHs=0;
+        for(unsigned int i=0;i<nAtoms;++i){
+          Atom *atom=tmol.getAtomWithIdx(i);
+          unsigned int nH=nHs[i];
+          if(inSystem[i]){
+            atom->setIsAromatic(false);
+            if(isHeteroatom(atom)){
+              nMobileHs+=nH;
+              nH=0;
+            }
+          }
+          atom->setNumExplicitHs(nH);
+          atom->setNoImplicit(true);
+          atom->setChiralTag(Atom::CHI_UNSPECIFIED);
+        }
+        tmol.updatePropertyCache(false);
+
+        std::string res=MolToSmiles(tmol,false);
+        res += "_"+boost::lexical_cast<std::string>(nMobileHs);
+        return res;
+      }
+
+      std::string calcLayer(const ROMol &mol,HashLayer layer){
+        switch(layer){
+        case CanonicalSmiles:
+          return MolToSmiles(mol,false);
+        case IsomericSmiles:
+          return MolToSmiles(mol,true);
+        case TautomerSmiles:
+          return calcTautomerSmiles(mol);
+        default:
+          PRECONDITION(0,"bad hash layer");
+        }
+        return "";
+      }
+    } // end of anonymous namespace
+
+    std::string HashValue128::toString() const {
+      char buf[33];
+      sprintf(buf,"%08x%08x%08x%08x",
+              static_cast<unsigned int>(hi>>32),static_cast<unsigned int>(hi&0xffffffff),
+              static_cast<unsigned int>(lo>>32),static_cast<unsigned int>(lo&0xffffffff));
+      return std::string(buf);
+    }
+
+    std::string getLayer(const ROMol &mol,HashLayer layer){
+      PRECONDITION(layer>=CanonicalSmiles && layer<=TautomerSmiles,"bad hash layer");
+      std::string res;
+      unsigned int version;
+      if(mol.getPropIfPresent(versionKeys[layer],version) &&
+         version==mol.getStructureVersion() &&
+         mol.getPropIfPresent(layerKeys[layer],res)){
+        return res;
+      }
+      res=calcLayer(mol,layer);
+      mol.setProp(layerKeys[layer],res,true);
+      mol.setProp(versionKeys[layer],mol.getStructureVersion(),true);
+      return res;
+    }
+
+    boost::uint64_t hashString64(const std::string &text){
+      // FNV-1a
+      boost::uint64_t h=0xcbf29ce484222325ULL;
+      for(std::string::const_iterator ci=text.begin();ci!=text.end();++ci){
+        h ^= static_cast<unsigned char>(*ci);
+        h *= 0x100000001b3ULL;
+      }
+      return fmix64(h);
+    }
+
+    HashValue128 hashString128(const std::string &text){
+      // the low word is an independent multiply-xorshift hash of the text:
+      boost::uint64_t h=0x9e3779b97f4a7c15ULL^text.size();
+      for(std::string::const_iterator ci=text.begin();ci!=text.end();++ci){
+        h = (h^static_cast<unsigned char>(*ci))*0x87c37b91114253d5ULL;
+        h ^= h>>31;
+      }
+      return HashValue128(hashString64(text),fmix64(h));
+    }
+
+    boost::uint64_t getHash64(const ROMol &mol,HashLayer layer){
+      return hashString64(getLayer(mol,layer));
+    }
+
+    HashValue128 getHash128(const ROMol &mol,HashLayer layer){
+      return hashString128(getLayer(mol,layer));
+    }
+  }
+}
@@ -0,0 +1,199 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_MOLHASH_H_
+#define _RD_MOLHASH_H_
+
+#include <GraphMol/ROMol.h>
+#include <boost/cstdint.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
+#include <string>
+
+namespace RDKit {
+  namespace MolHash {
+    //! the version of the hashing scheme
+    /*!
+      This is changed whenever a change to the canonicalization or to the
+      hash functions changes the values returned here. Hashes that are
+      stored (e.g. in a database) should be stored along with this number.
+    */
+    const unsigned int hashVersion=1;
+
+    //! the layers that can be hashed
+    typedef enum {
+      CanonicalSmiles=0,   //!< canonical SMILES without stereochemistry or isotopes
+      IsomericSmiles,      //!< canonical isomeric SMILES
+      TautomerSmiles       //!< tautomer-insensitive layer, see getTautomerSmiles()
+    } HashLayer;
+
+    //! a 128 bit hash value
+    struct HashValue128 {
+      boost::uint64_t hi,lo;
+      HashValue128() : hi(0), lo(0) {};
+      HashValue128(boost::uint64_t h,boost::uint64_t l) : hi(h), lo(l) {};
+      bool operator==(const HashValue128 &other) const {
+        return hi==other.hi && lo==other.lo;
+      };
+      bool operator!=(const HashValue128 &other) const {
+        return !(*this==other);
+      };
+      bool operator<(const HashValue128 &other) const {
+        return hi<other.hi || (hi==other.hi && lo<other.lo);
+      };
+      //! returns the value as 32 hexadecimal digits
+      std::string toString() const;
+    };
+    //! allows HashValue128 to be used in the boost unordered containers
+    inline std::size_t hash_value(const HashValue128 &val) {
+      return static_cast<std::size_t>(val.lo);
+    }
+
+    //! returns the text of a layer for a molecule
+    /*!
+      The result is cached on the molecule as a computed property and is
+      recalculated if the molecule's structure version (see
+      ROMol::getStructureVersion()) has changed since it was cached,
+      this includes changes made to its Atoms and Bonds in place.
+
+      \param mol    the molecule of interest, it should be sanitized
+      \param layer  the layer to return
+
+      <b>Notes:</b>
+        - the cache is not protected by a lock, molecules should not be
+          shared between threads while their layers are being calculated.
+    */
+    std::string getLayer(const ROMol &mol,HashLayer layer);
+
+    //! returns the canonical SMILES for a molecule, this is cached
+    inline std::string getCanonicalSmiles(const ROMol &mol,bool isomeric=true){
+      return getLayer(mol,isomeric ? IsomericSmiles : CanonicalSmiles);
+    }
+
+    //! returns the tautomer-insensitive layer for a molecule, this is cached
+    /*!
+      This is the canonical SMILES of the molecule after all conjugated
+      and aromatic bonds, and all double bonds to heteroatoms, have been
+      made single and the hydrogens on heteroatoms in those bonds have been
+      removed. The number of removed hydrogens is appended to the SMILES.
+      Tautomers that differ in the position of hydrogens on heteroatoms
+      (e.g. 2-hydroxypyridine and 2-pyridone) have the same layer.
+
+      <b>Notes:</b>
+        - tautomers that move a hydrogen to or from a carbon (e.g.
+          keto-enol tautomers) do not have the same layer.
+        - stereochemistry is not included.
+    */
+    inline std::string getTautomerSmiles(const ROMol &mol){
+      return getLayer(mol,TautomerSmiles);
+    }
+
+    //! returns a 64 bit hash of a layer
+    /*!
+      The hash is calculated from the text of the layer and does not
+      depend on the platform.
+    */
+    boost::uint64_t getHash64(const ROMol &mol,HashLayer layer=IsomericSmiles);
+    //! returns a 128 bit hash of a layer
+    HashValue128 getHash128(const ROMol &mol,HashLayer layer=IsomericSmiles);
+
+    //! returns a 64 bit hash of a string
+    boost::uint64_t hashString64(const std::string &text);
+    //! returns a 128 bit hash of a string
+    HashValue128 hashString128(const std::string &text);
+
+    //! a set of molecules, identified by the 128 bit hashes of a layer
+    /*!
+      Only the hashes are stored, so the set is useful for removing
+      duplicates from large collections of molecules:
+      \code
+        MolHash::MolSet seen;
+        ... loop over molecules ...
+          if(seen.insert(*mol)){
+            ... this is the first time we've seen the molecule ...
+          }
+      \endcode
+    */
+    class MolSet {
+    public:
+      typedef boost::unordered_set<HashValue128> SetType;
+      typedef SetType::const_iterator const_iterator;
+
+      explicit MolSet(HashLayer layer=IsomericSmiles) : d_layer(layer) {};
+
+      //! returns the layer used to identify molecules
+      HashLayer getLayer() const { return d_layer; };
+      //! returns the key for a molecule
+      HashValue128 getKey(const ROMol &mol) const { return getHash128(mol,d_layer); };
+
+      //! adds a molecule, returns whether or not it was not already present
+      bool insert(const ROMol &mol) { return d_keys.insert(getKey(mol)).second; };
+      //! returns whether or not a molecule is present
+      bool contains(const ROMol &mol) const { return d_keys.count(getKey(mol))!=0; };
+      //! removes a molecule, returns whether or not it was present
+      bool erase(const ROMol &mol) { return d_keys.erase(getKey(mol))!=0; };
+
+      unsigned int size() const { return d_keys.size(); };
+      bool empty() const { return d_keys.empty(); };
+      void clear() { d_keys.clear(); };
+      void reserve(unsigned int sz) { d_keys.rehash(sz); };
+
+      const_iterator begin() const { return d_keys.begin(); };
+      const_iterator end() const { return d_keys.end(); };
+    private:
+      HashLayer d_layer;
+      SetType d_keys;
+    };
+
+    //! a map from molecules, identified by the 128 bit hashes of a layer,
+    //! to values
+    template <typename T>
+    class MolMap {
+    public:
+      typedef boost::unordered_map<HashValue128,T> MapType;
+      typedef typename MapType::iterator iterator;
+      typedef typename MapType::const_iterator const_iterator;
+
+      explicit MolMap(HashLayer layer=IsomericSmiles) : d_layer(layer) {};
+
+      //! returns the layer used to identify molecules
+      HashLayer getLayer() const { return d_layer; };
+      //! returns the key for a molecule
+      HashValue128 getKey(const ROMol &mol) const { return getHash128(mol,d_layer); };
+
+      //! returns the value for a molecule, adding a default value if needed
+      T &operator[](const ROMol &mol) { return d_map[getKey(mol)]; };
+      //! adds a value for a molecule if the molecule is not already present
+      std::pair<iterator,bool> insert(const ROMol &mol,const T &val) {
+        return d_map.insert(std::make_pair(getKey(mol),val));
+      };
+      iterator find(const ROMol &mol) { return d_map.find(getKey(mol)); };
+      const_iterator find(const ROMol &mol) const { return d_map.find(getKey(mol)); };
+      //! returns whether or not a molecule is present
+      bool contains(const ROMol &mol) const { return d_map.count(getKey(mol))!=0; };
+      //! removes a molecule, returns whether or not it was present
+      bool erase(const ROMol &mol) { return d_map.erase(getKey(mol))!=0; };
+
+      unsigned int size() const { return d_map.size(); };
+      bool empty() const { return d_map.empty(); };
+      void clear() { d_map.clear(); };
+      void reserve(unsigned int sz) { d_map.rehash(sz); };
+
+      iterator begin() { return d_map.begin(); };
+      iterator end() { return d_map.end(); };
+      const_iterator begin() const { return d_map.begin(); };
+      const_iterator end() const { return d_map.end(); };
+    private:
+      HashLayer d_layer;
+      MapType d_map;
+    };
+  }
+}
+
+#endif
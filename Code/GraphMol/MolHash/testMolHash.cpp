@@ -0,0 +1,269 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include "MolHash.h"
+#include <RDGeneral/Invariant.h>
+#include <RDGeneral/RDLog.h>
+#include <RDGeneral/StreamOps.h>
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/SmilesParse/SmilesParse.h>
+#include <GraphMol/SmilesParse/SmilesWrite.h>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+
+using namespace RDKit;
+
+void testStructureVersion(){
+  BOOST_LOG(rdInfoLog) << "-----------------------\n Testing structure versions" << std::endl;
+  RWMol *m=static_cast<RWMol *>(SmilesToMol("CCO"));
+  TEST_ASSERT(m);
+  unsigned int v0=m->getStructureVersion();
+
+  ROMol cp(*m);
+  TEST_ASSERT(cp.getStructureVersion()==v0);
+
+  m->addAtom(new Atom(6),true,true);
+  unsigned int v1=m->getStructureVersion();
+  TEST_ASSERT(v1!=v0);
+  m->addBond(2,3,Bond::SINGLE);
+  unsigned int v2=m->getStructureVersion();
+  TEST_ASSERT(v2!=v1);
+  m->removeBond(2,3);
+  TEST_ASSERT(m->getStructureVersion()!=v2);
+  v2=m->getStructureVersion();
+  m->removeAtom(3);
+  TEST_ASSERT(m->getStructureVersion()!=v2);
+  v2=m->getStructureVersion();
+  m->updateStructureVersion();
+  TEST_ASSERT(m->getStructureVersion()!=v2);
+  TEST_ASSERT(cp.getStructureVersion()==v0);
+
+  // modifying atoms and bonds changes the version:
+  v2=m->getStructureVersion();
+  m->getAtomWithIdx(0)->setFormalCharge(1);
+  TEST_ASSERT(m->getStructureVersion()!=v2);
+  v2=m->getStructureVersion();
+  m->getAtomWithIdx(0)->setIsotope(13);
+  TEST_ASSERT(m->getStructureVersion()!=v2);
+  v2=m->getStructureVersion();
+  m->getBondWithIdx(0)->setBondType(Bond::DOUBLE);
+  TEST_ASSERT(m->getStructureVersion()!=v2);
+  TEST_ASSERT(cp.getStructureVersion()==v0);
+
+  // but modifying copies that aren't part of the molecule doesn't:
+  v2=m->getStructureVersion();
+  Bond *bnd=m->getBondWithIdx(0)->copy();
+  bnd->setBondType(Bond::SINGLE);
+  delete bnd;
+  TEST_ASSERT(m->getStructureVersion()==v2);
+  Bond assigned;
+  assigned=*m->getBondWithIdx(0);
+  assigned.setBondType(Bond::TRIPLE);
+  TEST_ASSERT(m->getStructureVersion()==v2);
+  TEST_ASSERT(m->getBondWithIdx(0)->getBondType()==Bond::DOUBLE);
+  delete m;
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
+
+void testLayers(){
+  BOOST_LOG(rdInfoLog) << "-----------------------\n Testing hash layers" << std::endl;
+  {
+    ROMol *m=SmilesToMol("F[C@H](Cl)Br");
+    TEST_ASSERT(m);
+    TEST_ASSERT(MolHash::getCanonicalSmiles(*m)==MolToSmiles(*m,true));
+    TEST_ASSERT(MolHash::getCanonicalSmiles(*m,false)==MolToSmiles(*m,false));
+    TEST_ASSERT(MolHash::getHash64(*m)!=MolHash::getHash64(*m,MolHash::CanonicalSmiles));
+    TEST_ASSERT(MolHash::getHash128(*m)!=MolHash::getHash128(*m,MolHash::CanonicalSmiles));
+    TEST_ASSERT(MolHash::getHash128(*m).toString().size()==32);
+    TEST_ASSERT(MolHash::getHash128(*m).hi==MolHash::getHash64(*m));
+
+    ROMol *m2=SmilesToMol("Br[C@@H](Cl)F");
+    TEST_ASSERT(m2);
+    TEST_ASSERT(MolHash::getHash128(*m)==MolHash::getHash128(*m2));
+    delete m2;
+    m2=SmilesToMol("Br[C@H](Cl)F");
+    TEST_ASSERT(m2);
+    TEST_ASSERT(MolHash::getHash128(*m)!=MolHash::getHash128(*m2));
+    TEST_ASSERT(MolHash::getHash128(*m,MolHash::CanonicalSmiles)==
+                MolHash::getHash128(*m2,MolHash::CanonicalSmiles));
+    delete m2;
+    delete m;
+  }
+  {
+    // the values don't depend on the platform. If these change,
+    // MolHash::hashVersion needs to be changed too:
+    TEST_ASSERT(MolHash::hashString64("")==0xefd01f60ba992926ULL);
+    TEST_ASSERT(MolHash::hashString64("CCO")==0x95702e6d443f3d2cULL);
+    TEST_ASSERT(MolHash::hashString128("")==
+                MolHash::HashValue128(0xefd01f60ba992926ULL,0x9ca066f1a4ab2eeaULL));
+    TEST_ASSERT(MolHash::hashString128("CCO").toString()=="95702e6d443f3d2cf31330859e79e5cf");
+    TEST_ASSERT(MolHash::hashString128("CCO")!=MolHash::hashString128("OCC"));
+
+    RWMol *m=SmilesToMol("OCC");
+    TEST_ASSERT(m);
+    TEST_ASSERT(MolHash::getHash64(*m)==0x95702e6d443f3d2cULL);
+    delete m;
+    m=SmilesToMol("c1ccccc1O");
+    TEST_ASSERT(m);
+    TEST_ASSERT(MolHash::getCanonicalSmiles(*m)=="Oc1ccccc1");
+    TEST_ASSERT(MolHash::getHash64(*m)==0x2ef5df7284904d39ULL);
+    TEST_ASSERT(MolHash::getHash128(*m).toString()=="2ef5df7284904d3912770b1030ac43fa");
+    delete m;
+  }
+  {
+    // the cached value is updated when the molecule changes:
+    RWMol *m=static_cast<RWMol *>(SmilesToMol("CCO"));
+    TEST_ASSERT(m);
+    TEST_ASSERT(MolHash::getCanonicalSmiles(*m)=="CCO");
+    TEST_ASSERT(m->hasProp("_MolHashIsomericSmiles"));
+    boost::uint64_t h1=MolHash::getHash64(*m);
+
+    ROMol cp(*m);
+    TEST_ASSERT(MolHash::getCanonicalSmiles(cp)=="CCO");
+
+    m->addAtom(new Atom(6),true,true);
+    m->addBond(2,3,Bond::SINGLE);
+    m->updatePropertyCache();
+    TEST_ASSERT(MolHash::getCanonicalSmiles(*m)=="CCOC");
+    TEST_ASSERT(MolHash::getHash64(*m)!=h1);
+    TEST_ASSERT(MolHash::getCanonicalSmiles(cp)=="CCO");
+    TEST_ASSERT(MolHash::getHash64(cp)==h1);
+
+    // as is the value for in-place changes:
+    m->getAtomWithIdx(2)->setAtomicNum(7);
+    m->updatePropertyCache();
+    TEST_ASSERT(MolHash::getCanonicalSmiles(*m)=="CCNC");
+    m->getBondBetweenAtoms(2,3)->setBondType(Bond::DOUBLE);
+    m->updatePropertyCache();
+    TEST_ASSERT(MolHash::getCanonicalSmiles(*m)=="C=NCC");
+
+    // and for changes to a copy, which starts with the original's cache:
+    RWMol cp2(cp);
+    cp2.getAtomWithIdx(2)->setAtomicNum(7);
+    cp2.updatePropertyCache();
+    TEST_ASSERT(MolHash::getCanonicalSmiles(cp2)=="CCN");
+    TEST_ASSERT(MolHash::getHash64(cp2)!=h1);
+    TEST_ASSERT(MolHash::getCanonicalSmiles(cp)=="CCO");
+
+    // clearing the computed properties clears the cache:
+    m->clearComputedProps();
+    TEST_ASSERT(!m->hasProp("_MolHashIsomericSmiles"));
+    delete m;
+  }
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
+
+void testTautomerLayer(){
+  BOOST_LOG(rdInfoLog) << "-----------------------\n Testing the tautomer layer" << std::endl;
+  std::string pairs[][2]={
+    {"Oc1ccccn1","O=c1cccc[nH]1"},
+    {"CC(O)=N","CC(N)=O"},
+    {"Oc1ncccc1C(=O)O","O=C(O)c1ccc[nH]c1=O"},
+    {"N=c1[nH]cccc1","Nc1ncccc1"},
+    {"",""}
+  };
+  for(unsigned int i=0;pairs[i][0]!="";++i){
+    ROMol *m1=SmilesToMol(pairs[i][0]);
+    TEST_ASSERT(m1);
+    ROMol *m2=SmilesToMol(pairs[i][1]);
+    TEST_ASSERT(m2);
+    TEST_ASSERT(MolHash::getHash128(*m1)!=MolHash::getHash128(*m2));
+    TEST_ASSERT(MolHash::getTautomerSmiles(*m1)==MolHash::getTautomerSmiles(*m2));
+    TEST_ASSERT(MolHash::getHash128(*m1,MolHash::TautomerSmiles)==
+                MolHash::getHash128(*m2,MolHash::TautomerSmiles));
+    delete m1;
+    delete m2;
+  }
+
+  std::string different[][2]={
+    {"Oc1ccccn1","Oc1ccncc1"},
+    {"Oc1ccccn1","OC1=NCCC=C1"},
+    {"CC(=O)O","CC(=O)[O-]"},
+    {"",""}
+  };
+  for(unsigned int i=0;different[i][0]!="";++i){
+    ROMol *m1=SmilesToMol(different[i][0]);
+    TEST_ASSERT(m1);
+    ROMol *m2=SmilesToMol(different[i][1]);
+    TEST_ASSERT(m2);
+    TEST_ASSERT(MolHash::getTautomerSmiles(*m1)!=MolHash::getTautomerSmiles(*m2));
+    delete m1;
+    delete m2;
+  }
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
+
+void testMolSetMolMap(){
+  BOOST_LOG(rdInfoLog) << "-----------------------\n Testing MolSet and MolMap" << std::endl;
+  std::string fName=getenv("RDBASE");
+  fName += "/Data/NCI/first_5K.smi";
+  std::ifstream inf(fName.c_str());
+  TEST_ASSERT(inf.good());
+
+  MolHash::MolSet molSet;
+  MolHash::MolMap<unsigned int> molMap(MolHash::CanonicalSmiles);
+  std::set<std::string> smiSet,nonIsoSmiSet;
+  unsigned int nMols=0;
+  while(inf.good() && nMols<500){
+    std::string line=getLine(inf);
+    if(line.empty()) continue;
+    ROMol *m=0;
+    try {
+      m=SmilesToMol(line.substr(0,line.find_first_of(" \t")));
+    } catch (MolSanitizeException &) {
+      m=0;
+    }
+    if(!m) continue;
+    ++nMols;
+    std::string smi=MolToSmiles(*m,true);
+    TEST_ASSERT(molSet.insert(*m)==smiSet.insert(smi).second);
+    TEST_ASSERT(molSet.contains(*m));
+    nonIsoSmiSet.insert(MolToSmiles(*m,false));
+    molMap[*m]+=1;
+
+    // the same molecule with a different atom order is a duplicate:
+    ROMol *m2=SmilesToMol(MolToSmiles(*m,true,false,m->getNumAtoms()-1,false));
+    TEST_ASSERT(m2);
+    TEST_ASSERT(!molSet.insert(*m2));
+    TEST_ASSERT(molMap.contains(*m2));
+    delete m2;
+    delete m;
+  }
+  TEST_ASSERT(nMols==500);
+  TEST_ASSERT(molSet.size()==smiSet.size());
+  TEST_ASSERT(molMap.size()==nonIsoSmiSet.size());
+  unsigned int total=0;
+  for(MolHash::MolMap<unsigned int>::const_iterator it=molMap.begin();
+      it!=molMap.end();++it){
+    total += it->second;
+  }
+  TEST_ASSERT(total==nMols);
+
+  ROMol *m=SmilesToMol("CCO");
+  TEST_ASSERT(m);
+  TEST_ASSERT(!molSet.contains(*m));
+  TEST_ASSERT(molSet.insert(*m));
+  TEST_ASSERT(molSet.erase(*m));
+  TEST_ASSERT(!molSet.erase(*m));
+  TEST_ASSERT(molMap.insert(*m,12).second);
+  TEST_ASSERT(!molMap.insert(*m,13).second);
+  TEST_ASSERT(molMap.find(*m)->second==12);
+  delete m;
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
+
+int main(){
+  RDLog::InitLogs();
+  testStructureVersion();
+  testLayers();
+  testTautomerLayer();
+  testMolSetMolMap();
+  return 0;
+}
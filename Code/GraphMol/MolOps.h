@@ -14,6 +14,7 @@
 #include <list>
 #include <boost/smart_ptr.hpp>
 #include <boost/dynamic_bitset.hpp>
+#include <GraphMol/RingInfo.h>
 
 extern const int ci_LOCAL_INF;
 namespace RDKit{
@@ -389,6 +390,24 @@ namespace RDKit{
     */  
     void fastFindRings(const ROMol &mol);
 
+    //! does ring perception if the molecule doesn't already have the
+    //! requested kind of ring information
+    /*!
+      \param mol   the molecule of interest
+      \param type  the kind of ring information needed: RingInfo::MEMBERSHIP
+                   uses fastFindRings(), RingInfo::SSSR uses findSSSR().
+
+      This is used by the ring queries (e.g. the SMARTS primitives R, r and x)
+      so that they can be matched against molecules that have not been
+      sanitized.
+
+      <b>Notes:</b>
+        - the molecule's RingInfo is modified without any locking, ring
+          perception should be done before a molecule is shared between
+          threads.
+    */
+    void findRingsIfNeeded(const ROMol &mol,RingInfo::PerceptionType type);
+
 
     //! symmetrize the molecule's Smallest Set of Smallest Rings
     /*!
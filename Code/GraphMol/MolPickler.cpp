@@ -17,14 +17,16 @@
 #include <RDGeneral/types.h>
 #include <Query/QueryObjects.h>
 #include <map>
+#include <cstring>
+#include <algorithm>
 #include <boost/cstdint.hpp>
 using boost::int32_t;
 using boost::uint32_t;
 namespace RDKit{
 
-  const int32_t MolPickler::versionMajor=7;
-  const int32_t MolPickler::versionMinor=1;
-  const int32_t MolPickler::versionPatch=1;
+  const int32_t MolPickler::versionMajor=8;
+  const int32_t MolPickler::versionMinor=0;
+  const int32_t MolPickler::versionPatch=0;
   const int32_t MolPickler::endianId=0xDEADBEEF;
 
   void streamWrite(std::ostream &ss,const std::string &what){
@@ -462,27 +464,132 @@ namespace RDKit{
   } // end of anonymous namespace
 
 
-  void MolPickler::pickleMol(const ROMol *mol,std::ostream &ss){
+  namespace {
+    // molecules with queries are written in the tagged (version 7) format:
+    const int32_t taggedVersionMajor=7;
+    const int32_t taggedVersionMinor=1;
+    const int32_t taggedVersionPatch=1;
+
+    template <typename T>
+    inline void bufWrite(std::string &buf,const T &val){
+      T tval=EndianSwapBytes<HOST_ENDIAN_ORDER,LITTLE_ENDIAN_ORDER>(val);
+      buf.append(reinterpret_cast<const char *>(&tval),sizeof(T));
+    }
+    inline void bufWrite(std::string &buf,const std::string &val){
+      bufWrite(buf,static_cast<uint32_t>(val.size()));
+      buf.append(val);
+    }
+
+    inline void checkAvail(const char *pos,const char *end,size_t nBytes){
+      if(static_cast<size_t>(end-pos)<nBytes){
+        throw MolPicklerException("Bad pickle format: unexpected end of pickle");
+      }
+    }
+
+    // returns an atom index read from a pickle after making sure it's valid
+    template <typename T>
+    unsigned int checkAtomIdx(T idx,unsigned int numAtoms){
+      if(static_cast<unsigned int>(idx)>=numAtoms){
+        throw MolPicklerException("Bad pickle format: bad atom index");
+      }
+      return idx;
+    }
+
+    // no bounds checking, this is used for data in records that
+    // have already been checked:
+    template <typename T>
+    inline T getVal(const char *pos){
+      T tval;
+      memcpy(&tval,pos,sizeof(T));
+      return EndianSwapBytes<LITTLE_ENDIAN_ORDER,HOST_ENDIAN_ORDER>(tval);
+    }
+    template <typename T>
+    inline void bufRead(const char *&pos,const char *end,T &val){
+      checkAvail(pos,end,sizeof(T));
+      val=getVal<T>(pos);
+      pos+=sizeof(T);
+    }
+    inline void bufRead(const char *&pos,const char *end,std::string &val){
+      uint32_t len;
+      bufRead(pos,end,len);
+      checkAvail(pos,end,len);
+      val.assign(pos,len);
+      pos+=len;
+    }
+
+    bool hasQueryFeatures(const ROMol *mol){
+      for(ROMol::ConstAtomIterator atIt=mol->beginAtoms();atIt!=mol->endAtoms();++atIt){
+        if((*atIt)->hasQuery()) return true;
+      }
+      for(ROMol::ConstBondIterator bondIt=mol->beginBonds();bondIt!=mol->endBonds();++bondIt){
+        if((*bondIt)->hasQuery()) return true;
+      }
+      return false;
+    }
+
+    void checkVersion(int32_t majorVersion,int32_t minorVersion){
+      if(majorVersion>MolPickler::versionMajor||
+         (majorVersion==MolPickler::versionMajor&&minorVersion>MolPickler::versionMinor)){
+        BOOST_LOG(rdWarningLog)<<"Depickling from a version number ("<<majorVersion<<"." << minorVersion<<")" << "that is higher than our version ("<<MolPickler::versionMajor<<"."<<MolPickler::versionMinor<<").\nThis probably won't work."<<std::endl;
+      }
+    }
+  } // end of anonymous namespace
+
+  void MolPickler::pickleMol(const ROMol *mol,std::ostream &ss,unsigned int propertyFlags){
     PRECONDITION(mol,"empty molecule");
+#ifndef OLD_PICKLE
+    if(!hasQueryFeatures(mol)){
+      std::string res;
+      MolPickler::pickleMol(mol,res,propertyFlags);
+      ss.write(res.c_str(),res.size());
+      return;
+    }
+    // the version 8 format doesn't support queries:
     streamWrite(ss,endianId);
     streamWrite(ss,static_cast<int>(VERSION));
-    streamWrite(ss,versionMajor);
-    streamWrite(ss,versionMinor);
-    streamWrite(ss,versionPatch);
-#ifndef OLD_PICKLE
+    streamWrite(ss,taggedVersionMajor);
+    streamWrite(ss,taggedVersionMinor);
+    streamWrite(ss,taggedVersionPatch);
     if(mol->getNumAtoms()>255){
       _pickle<int32_t>(mol,ss);
     } else {
       _pickle<unsigned char>(mol,ss);
     }
 #else
+    streamWrite(ss,endianId);
+    streamWrite(ss,static_cast<int>(VERSION));
+    streamWrite(ss,versionMajor);
+    streamWrite(ss,versionMinor);
+    streamWrite(ss,versionPatch);
     _pickleV1(mol,ss);
 #endif    
   }
-  void MolPickler::pickleMol(const ROMol *mol,std::string &res){
+  void MolPickler::pickleMol(const ROMol *mol,std::string &res,unsigned int propertyFlags){
     PRECONDITION(mol,"empty molecule");
+#ifndef OLD_PICKLE
+    if(!hasQueryFeatures(mol)){
+      res.clear();
+      bufWrite(res,endianId);
+      bufWrite(res,static_cast<int32_t>(VERSION));
+      bufWrite(res,versionMajor);
+      bufWrite(res,versionMinor);
+      bufWrite(res,versionPatch);
+      // the length of the body is filled in once it's known:
+      size_t lengthPos=res.size();
+      bufWrite(res,static_cast<uint32_t>(0));
+      if(mol->getNumAtoms()>255){
+        _pickleV8<uint32_t>(mol,res,propertyFlags);
+      } else {
+        _pickleV8<unsigned char>(mol,res,propertyFlags);
+      }
+      uint32_t bodyLength=static_cast<uint32_t>(res.size()-lengthPos-sizeof(uint32_t));
+      bodyLength=EndianSwapBytes<HOST_ENDIAN_ORDER,LITTLE_ENDIAN_ORDER>(bodyLength);
+      memcpy(&res[lengthPos],&bodyLength,sizeof(uint32_t));
+      return;
+    }
+#endif    
     std::stringstream ss(std::ios_base::binary|std::ios_base::out|std::ios_base::in);
-    MolPickler::pickleMol(mol,ss);
+    MolPickler::pickleMol(mol,ss,propertyFlags);
     res = ss.str();
   }
 
@@ -509,12 +616,23 @@ namespace RDKit{
     streamRead(ss,majorVersion);
     streamRead(ss,minorVersion);
     streamRead(ss,patchVersion);
-    if(majorVersion>versionMajor||(majorVersion==versionMajor&&minorVersion>versionMinor)){
-      BOOST_LOG(rdWarningLog)<<"Depickling from a version number ("<<majorVersion<<"." << minorVersion<<")" << "that is higher than our version ("<<versionMajor<<"."<<versionMinor<<").\nThis probably won't work."<<std::endl;
-    }
+    checkVersion(majorVersion,minorVersion);
     majorVersion=1000*majorVersion+minorVersion*10+patchVersion;
     if(majorVersion==1){
       _depickleV1(ss,mol);
+    } else if(majorVersion>=8000){
+      // the body is read into a buffer and parsed from there:
+      uint32_t bodyLength;
+      streamRead(ss,bodyLength);
+      std::vector<char> body(bodyLength);
+      if(bodyLength){
+        ss.read(&body[0],bodyLength);
+        if(static_cast<uint32_t>(ss.gcount())!=bodyLength){
+          throw MolPicklerException("Bad pickle format: unexpected end of pickle");
+        }
+      }
+      const char *pos=bodyLength ? &body[0] : 0;
+      _depickleV8(pos,pos+bodyLength,mol,majorVersion);
     } else {
       int32_t numAtoms;
       streamRead(ss,numAtoms,majorVersion);
@@ -533,9 +651,44 @@ namespace RDKit{
   }
   void MolPickler::molFromPickle(const std::string &pickle,ROMol *mol){
     PRECONDITION(mol,"empty molecule");
-    std::stringstream ss(std::ios_base::binary|std::ios_base::out|std::ios_base::in);
-    ss.write(pickle.c_str(),pickle.length());
-    MolPickler::molFromPickle(ss,mol);
+    MolPickler::molFromPickle(pickle.c_str(),pickle.length(),mol);
+  }
+  void MolPickler::molFromPickle(const char *pickle,unsigned int len,ROMol *mol){
+    PRECONDITION(mol,"empty molecule");
+    PRECONDITION(pickle||!len,"empty pickle");
+    const char *pos=pickle;
+    const char *end=pickle+len;
+    int32_t tmpInt;
+    bufRead(pos,end,tmpInt);
+    if(tmpInt!=endianId){
+      throw MolPicklerException("Bad pickle format: bad endian ID or invalid file format");
+    }
+    bufRead(pos,end,tmpInt);
+    if(static_cast<Tags>(tmpInt)!=VERSION){
+      throw MolPicklerException("Bad pickle format: no version tag");
+    }
+    int32_t majorVersion,minorVersion,patchVersion;
+    bufRead(pos,end,majorVersion);
+    bufRead(pos,end,minorVersion);
+    bufRead(pos,end,patchVersion);
+    if(majorVersion<8){
+      // older pickles are read from a stream:
+      std::stringstream ss(std::ios_base::binary|std::ios_base::out|std::ios_base::in);
+      ss.write(pickle,len);
+      MolPickler::molFromPickle(ss,mol);
+      return;
+    }
+    checkVersion(majorVersion,minorVersion);
+    majorVersion=1000*majorVersion+minorVersion*10+patchVersion;
+
+    uint32_t bodyLength;
+    bufRead(pos,end,bodyLength);
+    checkAvail(pos,end,bodyLength);
+    mol->clearAllAtomBookmarks();
+    mol->clearAllBondBookmarks();
+    // anything after the parts of the body we know about was added by
+    // a later version and is ignored:
+    _depickleV8(pos,pos+bodyLength,mol,majorVersion);
   }
 
 
@@ -590,7 +743,7 @@ namespace RDKit{
     //
     // -------------------
     const RingInfo *ringInfo=mol->getRingInfo();
-    if(ringInfo && ringInfo->isInitialized()){
+    if(ringInfo && ringInfo->getPerceptionType()==RingInfo::SSSR){
       streamWrite(ss,BEGINSSSR);
       _pickleSSSR<T>(ss,ringInfo,atomIdxMap);
     }
@@ -852,20 +1005,19 @@ namespace RDKit{
     T tmpT = static_cast<T>(conf->getNumAtoms());
     streamWrite(ss,tmpT);
     const RDGeom::POINT3D_VECT &pts = conf->getPositions();
-    for (RDGeom::POINT3D_VECT_CI pti = pts.begin(); pti != pts.end(); pti++) {
-      float tmpFloat;
-      tmpFloat = static_cast<float>(pti->x);
-      streamWrite(ss,tmpFloat);
-      tmpFloat = static_cast<float>(pti->y);
-      streamWrite(ss,tmpFloat);
-      tmpFloat = static_cast<float>(pti->z);
-      streamWrite(ss,tmpFloat);
-    } 
+    if (pts.empty()) return;
+    // write the coordinates as a single block:
+    std::vector<float> coords(3*pts.size());
+    for (unsigned int i = 0; i < pts.size(); ++i) {
+      coords[3*i] = static_cast<float>(pts[i].x);
+      coords[3*i+1] = static_cast<float>(pts[i].y);
+      coords[3*i+2] = static_cast<float>(pts[i].z);
+    }
+    streamWriteArray(ss,&coords[0],coords.size());
   }
     
   template <typename T> 
   Conformer *MolPickler::_conformerFromPickle(std::istream &ss,int version) {
-    float tmpFloat;
     bool is3D=true;
     if(version>4000){
       char tmpChr;
@@ -881,13 +1033,14 @@ namespace RDKit{
     Conformer *conf = new Conformer(numAtoms);
     conf->setId(cid);
     conf->set3D(is3D);
+    if (!numAtoms) return conf;
+    std::vector<float> coords(3*numAtoms);
+    streamReadArray(ss,&coords[0],coords.size());
+    RDGeom::POINT3D_VECT &pts = conf->getPositions();
     for (unsigned int i = 0; i < numAtoms; i++) {
-      streamRead(ss, tmpFloat,version);
-      conf->getAtomPos(i).x = static_cast<double>(tmpFloat);
-      streamRead(ss, tmpFloat,version);
-      conf->getAtomPos(i).y = static_cast<double>(tmpFloat);
-      streamRead(ss, tmpFloat,version);
-      conf->getAtomPos(i).z = static_cast<double>(tmpFloat);
+      pts[i].x = static_cast<double>(coords[3*i]);
+      pts[i].y = static_cast<double>(coords[3*i+1]);
+      pts[i].z = static_cast<double>(coords[3*i+2]);
     }
     return conf;
   }
@@ -1333,6 +1486,566 @@ namespace RDKit{
   }
 
 
+  //--------------------------------------
+  //
+  //            Version 8 Pickler:
+  //
+  //  The atoms, bonds, rings and conformers are written as packed
+  //  arrays of fixed-size records. The body is preceded by its length
+  //  so that it can be read from a single buffer.
+  //
+  //--------------------------------------
+  namespace {
+    // the sizes of the fixed-size records:
+    const unsigned int atomRecordSize=9;
+    const unsigned int bondRecordExtraSize=4; // in addition to the two atom indices
+
+    // flags for the optional parts of the pickle:
+    const uint32_t hasRingsFlag=0x1;
+    const uint32_t hasMolPropsFlag=0x2;
+    const uint32_t hasAtomPropsFlag=0x4;
+    const uint32_t hasBondPropsFlag=0x8;
+
+    // types of the property values we can pickle:
+    typedef enum {
+      PROP_INT=1,
+      PROP_UNSIGNED,
+      PROP_BOOL,
+      PROP_DOUBLE,
+      PROP_STRING
+    } PropType;
+
+    // writes the values in a Dict that we know how to pickle,
+    // computed properties are skipped.
+    // returns the number of values written
+    unsigned int pickleProps(std::string &res,const Dict &dict){
+      const Dict::DataType &data=dict.getData();
+      const STR_VECT *computed=0;
+      for(Dict::DataType::const_iterator it=data.begin();it!=data.end();++it){
+        if(it->first==common_properties::__computedProps.id){
+          computed=boost::any_cast<STR_VECT>(&it->second);
+          break;
+        }
+      }
+      std::string tmp;
+      unsigned int nWritten=0;
+      for(Dict::DataType::const_iterator it=data.begin();it!=data.end();++it){
+        if(it->first==common_properties::__computedProps.id) continue;
+        PropKey key={it->first};
+        const std::string &name=key.getName();
+        if(computed && std::find(computed->begin(),computed->end(),name)!=computed->end()){
+          continue;
+        }
+        const boost::any &val=it->second;
+        if(val.type()==typeid(int)){
+          bufWrite(tmp,name);
+          bufWrite(tmp,static_cast<unsigned char>(PROP_INT));
+          bufWrite(tmp,static_cast<int32_t>(boost::any_cast<int>(val)));
+        } else if(val.type()==typeid(unsigned int)){
+          bufWrite(tmp,name);
+          bufWrite(tmp,static_cast<unsigned char>(PROP_UNSIGNED));
+          bufWrite(tmp,static_cast<uint32_t>(boost::any_cast<unsigned int>(val)));
+        } else if(val.type()==typeid(bool)){
+          bufWrite(tmp,name);
+          bufWrite(tmp,static_cast<unsigned char>(PROP_BOOL));
+          bufWrite(tmp,static_cast<unsigned char>(boost::any_cast<bool>(val)));
+        } else if(val.type()==typeid(double)){
+          bufWrite(tmp,name);
+          bufWrite(tmp,static_cast<unsigned char>(PROP_DOUBLE));
+          bufWrite(tmp,boost::any_cast<double>(val));
+        } else if(val.type()==typeid(std::string)){
+          bufWrite(tmp,name);
+          bufWrite(tmp,static_cast<unsigned char>(PROP_STRING));
+          bufWrite(tmp,boost::any_cast<std::string>(val));
+        } else {
+          // we don't know how to pickle this type
+          continue;
+        }
+        ++nWritten;
+      }
+      if(nWritten){
+        bufWrite(res,static_cast<uint32_t>(nWritten));
+        res.append(tmp);
+      }
+      return nWritten;
+    }
+
+    // returns the key for a property name read from a pickle. This is
+    // only called once the value has been read, so truncated or corrupt
+    // pickles don't add names to the global key table.
+    PropKey propKeyFor(const std::string &name){
+      PropKey res;
+      if(!findPropKey(name.c_str(),res)) res=getPropKey(name);
+      return res;
+    }
+
+    void unpickleProps(const char *&pos,const char *end,Dict &dict){
+      uint32_t nProps;
+      bufRead(pos,end,nProps);
+      std::string name;
+      for(unsigned int i=0;i<nProps;++i){
+        bufRead(pos,end,name);
+        unsigned char type;
+        bufRead(pos,end,type);
+        switch(type){
+        case PROP_INT:
+          {
+            int32_t tmp;
+            bufRead(pos,end,tmp);
+            int v=tmp;
+            dict.setVal(propKeyFor(name),v);
+          }
+          break;
+        case PROP_UNSIGNED:
+          {
+            uint32_t tmp;
+            bufRead(pos,end,tmp);
+            unsigned int v=tmp;
+            dict.setVal(propKeyFor(name),v);
+          }
+          break;
+        case PROP_BOOL:
+          {
+            unsigned char tmp;
+            bufRead(pos,end,tmp);
+            bool v=tmp;
+            dict.setVal(propKeyFor(name),v);
+          }
+          break;
+        case PROP_DOUBLE:
+          {
+            double v;
+            bufRead(pos,end,v);
+            dict.setVal(propKeyFor(name),v);
+          }
+          break;
+        case PROP_STRING:
+          {
+            std::string v;
+            bufRead(pos,end,v);
+            dict.setVal(propKeyFor(name),v);
+          }
+          break;
+        default:
+          throw MolPicklerException("Bad pickle format: unknown property type");
+        }
+      }
+    }
+  } // end of anonymous namespace
+
+  template <typename T>
+  void MolPickler::_pickleV8(const ROMol *mol,std::string &res,unsigned int propertyFlags){
+    PRECONDITION(mol,"empty molecule");
+    unsigned int nAtoms=mol->getNumAtoms();
+    unsigned int nBonds=mol->getNumBonds();
+    unsigned int nConfs=mol->getNumConformers();
+    const RingInfo *ringInfo=mol->getRingInfo();
+
+    uint32_t flags=0;
+    if(ringInfo && ringInfo->getPerceptionType()==RingInfo::SSSR) flags |= hasRingsFlag;
+    if(propertyFlags & MolProps) flags |= hasMolPropsFlag;
+    if(propertyFlags & AtomProps) flags |= hasAtomPropsFlag;
+    if(propertyFlags & BondProps) flags |= hasBondPropsFlag;
+
+    res.reserve(res.size()+16+nAtoms*(atomRecordSize+12*nConfs)+
+                nBonds*(2*sizeof(T)+bondRecordExtraSize)+nConfs*5);
+    bufWrite(res,static_cast<uint32_t>(nAtoms));
+    bufWrite(res,static_cast<uint32_t>(nBonds));
+    bufWrite(res,static_cast<uint32_t>(nConfs));
+    bufWrite(res,flags);
+
+    // -------------------
+    //
+    // Write Atoms
+    //
+    // -------------------
+    std::vector<unsigned int> isotopes,mapNums,dummyLabels;
+    char rec[atomRecordSize];
+    for(unsigned int i=0;i<nAtoms;++i){
+      const Atom *atom=mol->getAtomWithIdx(i);
+      char atomFlags=0;
+      if(atom->getIsAromatic()) atomFlags |= 0x1;
+      if(atom->getNoImplicit()) atomFlags |= 0x1<<1;
+      rec[0]=static_cast<char>(atom->getAtomicNum());
+      rec[1]=atomFlags;
+      rec[2]=static_cast<char>(atom->getFormalCharge());
+      rec[3]=static_cast<char>(atom->getChiralTag());
+      rec[4]=static_cast<char>(atom->getHybridization());
+      rec[5]=static_cast<char>(atom->getNumExplicitHs());
+      // these are -1 if they haven't been calculated:
+      rec[6]=static_cast<char>(atom->d_explicitValence);
+      rec[7]=static_cast<char>(atom->d_implicitValence);
+      rec[8]=static_cast<char>(atom->getNumRadicalElectrons());
+      res.append(rec,atomRecordSize);
+
+      if(atom->getIsotope()) isotopes.push_back(i);
+      if(atom->hasProp(common_properties::molAtomMapNumber)) mapNums.push_back(i);
+      if(atom->hasProp(common_properties::dummyLabel)) dummyLabels.push_back(i);
+    }
+    // the rarely used atom fields are stored as lists:
+    bufWrite(res,static_cast<uint32_t>(isotopes.size()));
+    for(unsigned int i=0;i<isotopes.size();++i){
+      bufWrite(res,static_cast<T>(isotopes[i]));
+      bufWrite(res,static_cast<uint32_t>(mol->getAtomWithIdx(isotopes[i])->getIsotope()));
+    }
+    std::vector<std::pair<unsigned int,int> > goodMapNums;
+    for(unsigned int i=0;i<mapNums.size();++i){
+      int mapNum;
+      if(getAtomMapNumber(mol->getAtomWithIdx(mapNums[i]),mapNum)){
+        goodMapNums.push_back(std::make_pair(mapNums[i],mapNum));
+      }
+    }
+    bufWrite(res,static_cast<uint32_t>(goodMapNums.size()));
+    for(unsigned int i=0;i<goodMapNums.size();++i){
+      bufWrite(res,static_cast<T>(goodMapNums[i].first));
+      bufWrite(res,static_cast<int32_t>(goodMapNums[i].second));
+    }
+    bufWrite(res,static_cast<uint32_t>(dummyLabels.size()));
+    for(unsigned int i=0;i<dummyLabels.size();++i){
+      std::string label;
+      mol->getAtomWithIdx(dummyLabels[i])->getProp(common_properties::dummyLabel,label);
+      bufWrite(res,static_cast<T>(dummyLabels[i]));
+      bufWrite(res,label);
+    }
+
+    // -------------------
+    //
+    // Write Bonds
+    //
+    // -------------------
+    std::vector<unsigned int> stereoBonds;
+    for(unsigned int i=0;i<nBonds;++i){
+      const Bond *bond=mol->getBondWithIdx(i);
+      bufWrite(res,static_cast<T>(bond->getBeginAtomIdx()));
+      bufWrite(res,static_cast<T>(bond->getEndAtomIdx()));
+      char bondFlags=0;
+      if(bond->getIsAromatic()) bondFlags |= 0x1;
+      if(bond->getIsConjugated()) bondFlags |= 0x1<<1;
+      rec[0]=static_cast<char>(bond->getBondType());
+      rec[1]=static_cast<char>(bond->getBondDir());
+      rec[2]=static_cast<char>(bond->getStereo());
+      rec[3]=bondFlags;
+      res.append(rec,bondRecordExtraSize);
+      if(bond->getStereoAtoms().size()) stereoBonds.push_back(i);
+    }
+    bufWrite(res,static_cast<uint32_t>(stereoBonds.size()));
+    for(unsigned int i=0;i<stereoBonds.size();++i){
+      const INT_VECT &stereoAts=mol->getBondWithIdx(stereoBonds[i])->getStereoAtoms();
+      bufWrite(res,static_cast<uint32_t>(stereoBonds[i]));
+      bufWrite(res,static_cast<unsigned char>(stereoAts.size()));
+      for(INT_VECT_CI idxIt=stereoAts.begin();idxIt!=stereoAts.end();++idxIt){
+        bufWrite(res,static_cast<T>(*idxIt));
+      }
+    }
+
+    // -------------------
+    //
+    // Write Rings (if present)
+    //
+    // -------------------
+    if(flags & hasRingsFlag){
+      const VECT_INT_VECT &atomRings=ringInfo->atomRings();
+      bufWrite(res,static_cast<uint32_t>(atomRings.size()));
+      for(unsigned int i=0;i<atomRings.size();++i){
+        bufWrite(res,static_cast<T>(atomRings[i].size()));
+      }
+      for(unsigned int i=0;i<atomRings.size();++i){
+        for(unsigned int j=0;j<atomRings[i].size();++j){
+          bufWrite(res,static_cast<T>(atomRings[i][j]));
+        }
+      }
+    }
+
+    // -------------------
+    //
+    // Write Conformers
+    //
+    // -------------------
+    for(ROMol::ConstConformerIterator ci=mol->beginConformers();
+        ci!=mol->endConformers();++ci){
+      const Conformer *conf=ci->get();
+      bufWrite(res,static_cast<uint32_t>(conf->getId()));
+      bufWrite(res,static_cast<unsigned char>(conf->is3D()));
+      const RDGeom::POINT3D_VECT &pts=conf->getPositions();
+      for(unsigned int i=0;i<nAtoms;++i){
+        bufWrite(res,static_cast<float>(pts[i].x));
+        bufWrite(res,static_cast<float>(pts[i].y));
+        bufWrite(res,static_cast<float>(pts[i].z));
+      }
+    }
+
+    // -------------------
+    //
+    // Write Properties (if requested)
+    //
+    // -------------------
+    if(flags & hasMolPropsFlag){
+      if(!pickleProps(res,*mol->dp_props)){
+        bufWrite(res,static_cast<uint32_t>(0));
+      }
+    }
+    if(flags & hasAtomPropsFlag){
+      std::string tmp;
+      uint32_t nWritten=0;
+      for(unsigned int i=0;i<nAtoms;++i){
+        std::string atomProps;
+        if(pickleProps(atomProps,*mol->getAtomWithIdx(i)->dp_props)){
+          bufWrite(tmp,static_cast<T>(i));
+          tmp.append(atomProps);
+          ++nWritten;
+        }
+      }
+      bufWrite(res,nWritten);
+      res.append(tmp);
+    }
+    if(flags & hasBondPropsFlag){
+      std::string tmp;
+      uint32_t nWritten=0;
+      for(unsigned int i=0;i<nBonds;++i){
+        std::string bondProps;
+        if(pickleProps(bondProps,*mol->getBondWithIdx(i)->dp_props)){
+          bufWrite(tmp,static_cast<uint32_t>(i));
+          tmp.append(bondProps);
+          ++nWritten;
+        }
+      }
+      bufWrite(res,nWritten);
+      res.append(tmp);
+    }
+  }
+
+  void MolPickler::_depickleV8(const char *&pos,const char *end,ROMol *mol,int version){
+    PRECONDITION(mol,"empty molecule");
+    uint32_t numAtoms;
+    bufRead(pos,end,numAtoms);
+    if(numAtoms>255){
+      _depickleV8<uint32_t>(pos,end,mol,version,numAtoms);
+    } else {
+      _depickleV8<unsigned char>(pos,end,mol,version,numAtoms);
+    }
+  }
+
+  template <typename T>
+  void MolPickler::_depickleV8(const char *&pos,const char *end,ROMol *mol,int version,
+                               unsigned int numAtoms){
+    PRECONDITION(mol,"empty molecule");
+    uint32_t numBonds,numConfs,flags;
+    bufRead(pos,end,numBonds);
+    bufRead(pos,end,numConfs);
+    bufRead(pos,end,flags);
+
+    // atoms and bonds are added directly to the graph of an empty molecule:
+    unsigned int atomOffset=mol->getNumAtoms();
+    bool directMap= atomOffset==0 && mol->getNumConformers()==0;
+
+    // -------------------
+    //
+    // Read Atoms
+    //
+    // -------------------
+    checkAvail(pos,end,static_cast<size_t>(numAtoms)*atomRecordSize);
+    for(unsigned int i=0;i<numAtoms;++i){
+      const char *rec=pos+i*atomRecordSize;
+      Atom *atom=new Atom(static_cast<unsigned char>(rec[0]));
+      atom->setIsAromatic(rec[1] & 0x1);
+      atom->setNoImplicit(rec[1] & (0x1<<1));
+      atom->setFormalCharge(static_cast<signed char>(rec[2]));
+      atom->setChiralTag(static_cast<Atom::ChiralType>(rec[3]));
+      atom->setHybridization(static_cast<Atom::HybridizationType>(rec[4]));
+      atom->setNumExplicitHs(static_cast<unsigned char>(rec[5]));
+      atom->d_explicitValence=static_cast<signed char>(rec[6]);
+      atom->d_implicitValence=static_cast<signed char>(rec[7]);
+      atom->d_numRadicalElectrons=static_cast<unsigned char>(rec[8]);
+      if(directMap){
+        ROMol::vertex_descriptor which=boost::add_vertex(mol->d_graph);
+        mol->d_graph[which].reset(atom);
+        atom->setOwningMol(mol);
+        atom->setIdx(which);
+      } else {
+        mol->addAtom(atom,false,true);
+      }
+    }
+    pos+=static_cast<size_t>(numAtoms)*atomRecordSize;
+
+    uint32_t nEntries;
+    bufRead(pos,end,nEntries);
+    for(unsigned int i=0;i<nEntries;++i){
+      T idx;
+      uint32_t isotope;
+      bufRead(pos,end,idx);
+      bufRead(pos,end,isotope);
+      mol->getAtomWithIdx(atomOffset+checkAtomIdx(idx,numAtoms))->setIsotope(isotope);
+    }
+    bufRead(pos,end,nEntries);
+    for(unsigned int i=0;i<nEntries;++i){
+      T idx;
+      int32_t mapNum;
+      bufRead(pos,end,idx);
+      bufRead(pos,end,mapNum);
+      mol->getAtomWithIdx(atomOffset+checkAtomIdx(idx,numAtoms))->setProp(common_properties::molAtomMapNumber,
+                                                                           static_cast<int>(mapNum));
+    }
+    bufRead(pos,end,nEntries);
+    for(unsigned int i=0;i<nEntries;++i){
+      T idx;
+      std::string label;
+      bufRead(pos,end,idx);
+      bufRead(pos,end,label);
+      mol->getAtomWithIdx(atomOffset+checkAtomIdx(idx,numAtoms))->setProp(common_properties::dummyLabel,label);
+    }
+
+    // -------------------
+    //
+    // Read Bonds
+    //
+    // -------------------
+    const unsigned int bondRecordSize=2*sizeof(T)+bondRecordExtraSize;
+    checkAvail(pos,end,static_cast<size_t>(numBonds)*bondRecordSize);
+    std::vector<Bond *> bonds(numBonds);
+    for(unsigned int i=0;i<numBonds;++i){
+      const char *rec=pos+i*bondRecordSize;
+      unsigned int begIdx=atomOffset+getVal<T>(rec);
+      unsigned int endIdx=atomOffset+getVal<T>(rec+sizeof(T));
+      rec += 2*sizeof(T);
+      if(begIdx>=mol->getNumAtoms() || endIdx>=mol->getNumAtoms() || begIdx==endIdx){
+        throw MolPicklerException("Bad pickle format: bad atom index in bond");
+      }
+      Bond *bond=new Bond(static_cast<Bond::BondType>(rec[0]));
+      bond->setBondDir(static_cast<Bond::BondDir>(rec[1]));
+      bond->setStereo(static_cast<Bond::BondStereo>(rec[2]));
+      bond->setIsAromatic(rec[3] & 0x1);
+      bond->setIsConjugated(rec[3] & (0x1<<1));
+      bond->setBeginAtomIdx(begIdx);
+      bond->setEndAtomIdx(endIdx);
+      if(directMap){
+        bool ok;
+        ROMol::edge_descriptor which;
+        boost::tie(which,ok) = boost::add_edge(begIdx,endIdx,mol->d_graph);
+        CHECK_INVARIANT(ok,"bond could not be added");
+        mol->d_graph[which].reset(bond);
+        bond->setOwningMol(mol);
+        bond->setIdx(i);
+      } else {
+        mol->addBond(bond,true);
+      }
+      bonds[i]=bond;
+    }
+    pos+=static_cast<size_t>(numBonds)*bondRecordSize;
+    if(directMap){
+      // we skipped addAtom() and addBond(), so do their bookkeeping here:
+      mol->clearCSRGraph();
+      mol->updateStructureVersion();
+    }
+
+    bufRead(pos,end,nEntries);
+    for(unsigned int i=0;i<nEntries;++i){
+      uint32_t idx;
+      unsigned char nStereoAtoms;
+      bufRead(pos,end,idx);
+      bufRead(pos,end,nStereoAtoms);
+      if(idx>=numBonds){
+        throw MolPicklerException("Bad pickle format: bad bond index");
+      }
+      INT_VECT &stereoAts=bonds[idx]->getStereoAtoms();
+      for(unsigned int j=0;j<nStereoAtoms;++j){
+        T atomIdx;
+        bufRead(pos,end,atomIdx);
+        stereoAts.push_back(atomOffset+checkAtomIdx(atomIdx,numAtoms));
+      }
+    }
+
+    // -------------------
+    //
+    // Read Rings (if present)
+    //
+    // -------------------
+    if(flags & hasRingsFlag){
+      RingInfo *ringInfo=mol->getRingInfo();
+      if(!ringInfo->isInitialized()) ringInfo->initialize();
+      uint32_t numRings;
+      bufRead(pos,end,numRings);
+      if(numRings>0){
+        ringInfo->preallocate(mol->getNumAtoms(),mol->getNumBonds());
+      }
+      checkAvail(pos,end,static_cast<size_t>(numRings)*sizeof(T));
+      const char *ringAtoms=pos+numRings*sizeof(T);
+      for(unsigned int i=0;i<numRings;++i){
+        unsigned int ringSize=getVal<T>(pos+i*sizeof(T));
+        if(!ringSize){
+          throw MolPicklerException("Bad pickle format: empty ring");
+        }
+        checkAvail(ringAtoms,end,static_cast<size_t>(ringSize)*sizeof(T));
+        INT_VECT atoms(ringSize),ringBonds(ringSize);
+        for(unsigned int j=0;j<ringSize;++j){
+          atoms[j]=atomOffset+checkAtomIdx(getVal<T>(ringAtoms),numAtoms);
+          ringAtoms+=sizeof(T);
+        }
+        for(unsigned int j=0;j<ringSize;++j){
+          const Bond *bond=mol->getBondBetweenAtoms(atoms[j],atoms[(j+1)%ringSize]);
+          if(!bond){
+            throw MolPicklerException("Bad pickle format: ring bond not found");
+          }
+          ringBonds[j]=bond->getIdx();
+        }
+        ringInfo->addRing(atoms,ringBonds);
+      }
+      pos=ringAtoms;
+    }
+
+    // -------------------
+    //
+    // Read Conformers
+    //
+    // -------------------
+    for(unsigned int i=0;i<numConfs;++i){
+      uint32_t confId;
+      unsigned char is3D;
+      bufRead(pos,end,confId);
+      bufRead(pos,end,is3D);
+      checkAvail(pos,end,static_cast<size_t>(numAtoms)*3*sizeof(float));
+      Conformer *conf=new Conformer(numAtoms);
+      conf->setId(confId);
+      conf->set3D(is3D);
+      RDGeom::POINT3D_VECT &pts=conf->getPositions();
+      for(unsigned int j=0;j<numAtoms;++j){
+        pts[j].x=getVal<float>(pos);
+        pts[j].y=getVal<float>(pos+sizeof(float));
+        pts[j].z=getVal<float>(pos+2*sizeof(float));
+        pos+=3*sizeof(float);
+      }
+      mol->addConformer(conf);
+    }
+
+    // -------------------
+    //
+    // Read Properties (if present)
+    //
+    // -------------------
+    if(flags & hasMolPropsFlag){
+      unpickleProps(pos,end,*mol->dp_props);
+    }
+    if(flags & hasAtomPropsFlag){
+      bufRead(pos,end,nEntries);
+      for(unsigned int i=0;i<nEntries;++i){
+        T idx;
+        bufRead(pos,end,idx);
+        unpickleProps(pos,end,*mol->getAtomWithIdx(atomOffset+checkAtomIdx(idx,numAtoms))->dp_props);
+      }
+    }
+    if(flags & hasBondPropsFlag){
+      bufRead(pos,end,nEntries);
+      for(unsigned int i=0;i<nEntries;++i){
+        uint32_t idx;
+        bufRead(pos,end,idx);
+        if(idx>=numBonds){
+          throw MolPicklerException("Bad pickle format: bad bond index");
+        }
+        unpickleProps(pos,end,*bonds[idx]->dp_props);
+      }
+    }
+  }
+
+
   //--------------------------------------
   //
   //            Version 1 Pickler:
@@ -99,17 +99,64 @@ namespace RDKit{
       ATOM_DUMMYLABEL,
     } Tags;
 
+    //! flags used to select the properties that are pickled
+    typedef enum {
+      NoProps=0,
+      MolProps=0x1,
+      AtomProps=0x2,
+      BondProps=0x4,
+      AllProps=0x7
+    } PropertyPickleOptions;
+
     //! pickles a molecule and sends the results to stream \c ss
-    static void pickleMol(const ROMol *mol,std::ostream &ss);
-    static void pickleMol(const ROMol &mol,std::ostream &ss) {MolPickler::pickleMol(&mol,ss);};
-    //! pickles a molecule and adds the results to string \c res
-    static void pickleMol(const ROMol *mol,std::string &res);
-    static void pickleMol(const ROMol &mol,std::string &res) {MolPickler::pickleMol(&mol,res);};
+    /*!
+      \param mol            the molecule to pickle
+      \param ss             the stream to write to
+      \param propertyFlags  a combination of PropertyPickleOptions
+                            selecting the properties to include
+
+      <b>Notes:</b>
+        - only properties with int, unsigned int, bool, double or
+          std::string values are pickled. Computed properties are
+          never pickled.
+        - molecules with query atoms or bonds are written in the
+          version 7 format, which does not include properties.
+    */
+    static void pickleMol(const ROMol *mol,std::ostream &ss,
+                          unsigned int propertyFlags=NoProps);
+    static void pickleMol(const ROMol &mol,std::ostream &ss,
+                          unsigned int propertyFlags=NoProps) {
+      MolPickler::pickleMol(&mol,ss,propertyFlags);
+    };
+    //! pickles a molecule and puts the results in string \c res
+    /*!
+      see the stream version for a description of the arguments
+    */
+    static void pickleMol(const ROMol *mol,std::string &res,
+                          unsigned int propertyFlags=NoProps);
+    static void pickleMol(const ROMol &mol,std::string &res,
+                          unsigned int propertyFlags=NoProps) {
+      MolPickler::pickleMol(&mol,res,propertyFlags);
+    };
 
     //! constructs a molecule from a pickle stored in a string
     static void molFromPickle(const std::string &pickle,ROMol *mol);
     static void molFromPickle(const std::string &pickle,ROMol &mol) {MolPickler::molFromPickle(pickle,&mol);};
 
+    //! constructs a molecule from a pickle stored in a buffer
+    /*!
+      \param pickle  the start of the pickle
+      \param len     the number of bytes in the pickle
+      \param mol     the molecule to add the atoms and bonds to
+
+      Version 8 and later pickles are read directly from the buffer,
+      without copying it into a stream.
+    */
+    static void molFromPickle(const char *pickle,unsigned int len,ROMol *mol);
+    static void molFromPickle(const char *pickle,unsigned int len,ROMol &mol) {
+      MolPickler::molFromPickle(pickle,len,&mol);
+    };
+
     //! constructs a molecule from a pickle stored in a stream
     static void molFromPickle(std::istream &ss,ROMol *mol);
     static void molFromPickle(std::istream &ss,ROMol &mol) { MolPickler::molFromPickle(ss,&mol); };
@@ -140,6 +187,16 @@ namespace RDKit{
     template <typename T>
     static void _depickle(std::istream &ss,ROMol *mol, int version,int numAtoms);
 
+    //! do the actual work of pickling a molecule in the version 8 format
+    template <typename T>
+    static void _pickleV8(const ROMol *mol,std::string &res,unsigned int propertyFlags);
+
+    //! do the actual work of de-pickling a version 8 molecule
+    static void _depickleV8(const char *&pos,const char *end,ROMol *mol,int version);
+    template <typename T>
+    static void _depickleV8(const char *&pos,const char *end,ROMol *mol,int version,
+                            unsigned int numAtoms);
+
 
     //! extract atomic data from a pickle and add the resulting Atom to the molecule
     template <typename T>
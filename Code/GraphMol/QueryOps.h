@@ -93,36 +93,43 @@ namespace RDKit{
 
   static int queryBondOrder(Bond const * bond) { return static_cast<int>(bond->getBondType()); };
   static int queryBondDir(Bond const * bond) { return static_cast<int>(bond->getBondDir()); };
-  static int queryIsBondInNRings(Bond const * at) {
-    return at->getOwningMol().getRingInfo()->numBondRings(at->getIdx());
-  };
-
   // -------------------------------------------------
   // ring queries 
 
+  //! returns the RingInfo of a molecule, doing ring perception first if
+  //! the molecule doesn't have the requested kind of ring information
+  inline const RingInfo *getQueryRingInfo(const ROMol &mol,RingInfo::PerceptionType type){
+    if(mol.getRingInfo()->getPerceptionType()<type) MolOps::findRingsIfNeeded(mol,type);
+    return mol.getRingInfo();
+  }
+
+  static int queryIsBondInNRings(Bond const * at) {
+    return getQueryRingInfo(at->getOwningMol(),RingInfo::SSSR)->numBondRings(at->getIdx());
+  };
   static int queryIsAtomInNRings(Atom const * at) {
-    return at->getOwningMol().getRingInfo()->numAtomRings(at->getIdx());
+    return getQueryRingInfo(at->getOwningMol(),RingInfo::SSSR)->numAtomRings(at->getIdx());
   };
   static int queryIsAtomInRing(Atom const * at) {
-    return at->getOwningMol().getRingInfo()->numAtomRings(at->getIdx())!=0;
+    return getQueryRingInfo(at->getOwningMol(),RingInfo::MEMBERSHIP)->numAtomRings(at->getIdx())!=0;
   };
   static int queryIsBondInRing(Bond const * bond) {
-    return bond->getOwningMol().getRingInfo()->numBondRings(bond->getIdx())!=0;
+    return getQueryRingInfo(bond->getOwningMol(),RingInfo::MEMBERSHIP)->numBondRings(bond->getIdx())!=0;
   };
   static int queryAtomMinRingSize(Atom const *at){
-    return at->getOwningMol().getRingInfo()->minAtomRingSize(at->getIdx());
+    return getQueryRingInfo(at->getOwningMol(),RingInfo::SSSR)->minAtomRingSize(at->getIdx());
   };
   static int queryBondMinRingSize(Bond const *bond){
-    return bond->getOwningMol().getRingInfo()->minBondRingSize(bond->getIdx());
+    return getQueryRingInfo(bond->getOwningMol(),RingInfo::SSSR)->minBondRingSize(bond->getIdx());
   };
 
   static int queryAtomRingBondCount(Atom const *at) {
     // EFF: cache this result
     int res=0;
+    const RingInfo *ringInfo=getQueryRingInfo(at->getOwningMol(),RingInfo::MEMBERSHIP);
     ROMol::OBOND_ITER_PAIR atomBonds=at->getOwningMol().getAtomBonds(at);
     while(atomBonds.first != atomBonds.second){
       unsigned int bondIdx=at->getOwningMol().getTopology()[*atomBonds.first]->getIdx();
-      if(at->getOwningMol().getRingInfo()->numBondRings(bondIdx)) {
+      if(ringInfo->numBondRings(bondIdx)) {
         res++;
       }
       ++atomBonds.first;  
@@ -132,7 +139,7 @@ namespace RDKit{
 
   template <int tgt>
   int queryAtomIsInRingOfSize(Atom const *at) {
-    if(at->getOwningMol().getRingInfo()->isAtomInRingOfSize(at->getIdx(),tgt)){
+    if(getQueryRingInfo(at->getOwningMol(),RingInfo::SSSR)->isAtomInRingOfSize(at->getIdx(),tgt)){
       return tgt;
     } else {
       return 0;
@@ -140,7 +147,7 @@ namespace RDKit{
   };
   template <int tgt>
   int queryBondIsInRingOfSize(Bond const *bond) {
-    if(bond->getOwningMol().getRingInfo()->isBondInRingOfSize(bond->getIdx(),tgt)){
+    if(getQueryRingInfo(bond->getOwningMol(),RingInfo::SSSR)->isBondInRingOfSize(bond->getIdx(),tgt)){
       return tgt;
     } else {
       return 0;
@@ -207,7 +214,7 @@ namespace RDKit{
   ATOM_NULL_QUERY *makeAtomNullQuery();
 
   static int queryAtomRingMembership(Atom const *at) {
-    return static_cast<int>(at->getOwningMol().getRingInfo()->numAtomRings(at->getIdx()));
+    return static_cast<int>(getQueryRingInfo(at->getOwningMol(),RingInfo::SSSR)->numAtomRings(at->getIdx()));
   }
   // I'm pretty sure that this typedef shouldn't be necessary,
   // but VC++ generates a warning about const Atom const * in
@@ -230,7 +237,14 @@ namespace RDKit{
     };
 
     virtual bool Match(const ConstAtomPtr what) const {
-      int v = this->TypeConvert(what,Queries::Int2Type<true>());
+      int v;
+      if(this->d_val<0 || (this->d_val==0 && !this->d_tol)){
+        // only ring membership is needed for R and R0, that's cheaper
+        // to find than the number of rings:
+        v = queryIsAtomInRing(what);
+      } else {
+        v = this->TypeConvert(what,Queries::Int2Type<true>());
+      }
       bool res;
       if(this->d_val<0){
         res = v!=0;
@@ -300,7 +314,7 @@ namespace RDKit{
     copy() const {
       RecursiveStructureQuery *res =
 	new RecursiveStructureQuery();
-      res->dp_queryMol.reset(new ROMol(*dp_queryMol,true));
+      res->dp_queryMol.reset(new ROMol(*dp_queryMol));
 
       std::set<int>::const_iterator i;
       for(i=d_set.begin();i!=d_set.end();i++){
@@ -22,6 +22,7 @@
 #include "QueryBond.h"
 #include "MolPickler.h"
 #include "Conformer.h"
+#include "CSRGraph.h"
 
 namespace RDKit{
   class QueryAtom;
@@ -43,6 +44,7 @@ namespace RDKit{
       delete dp_ringInfo;
       dp_ringInfo=0;
     }
+    clearCSRGraph();
   };
 
   ROMol::ROMol(const std::string &pickle) {
@@ -103,20 +105,23 @@ namespace RDKit{
     if(!dp_props){
       dp_props = new Dict();
       STR_VECT computed;
-      dp_props->setVal("__computedProps", computed);
+      dp_props->setVal(common_properties::__computedProps, computed);
     }
+    d_structureVersion=other.d_structureVersion;
     //std::cerr<<"---------    done init from other: "<<this<<" "<<&other<<std::endl;
   }
 
   void ROMol::initMol() {
     dp_props = new Dict();
     dp_ringInfo = new RingInfo();
+    dp_csrGraph = 0;
+    d_structureVersion = 0;
     // ok every molecule contains a property entry called "__computedProps" which provides
     //  list of property keys that correspond to value that have been computed
     // this can used to blow out all computed properties while leaving the rest along
     // initialize this list to an empty vector of strings
     STR_VECT computed;
-    dp_props->setVal("__computedProps", computed);
+    dp_props->setVal(common_properties::__computedProps, computed);
   }
   
   unsigned int ROMol::getAtomDegree(const Atom *at) const {
@@ -325,6 +330,30 @@ namespace RDKit{
     return boost::out_edges(at->getIdx(),d_graph);
   }
 
+  const CSRGraph &ROMol::getCSRGraph() const {
+    // once the view has been published it is only replaced by topology
+    // changes, so the common case doesn't need the lock:
+    if(dp_csrGraph) return *dp_csrGraph;
+#ifdef RDK_THREADSAFE_SSS
+    boost::mutex::scoped_lock lock(d_csrGraphMutex);
+#endif
+    if(!dp_csrGraph){
+      // build it completely before making it visible to other threads
+      CSRGraph *graph = new CSRGraph(*this);
+      dp_csrGraph = graph;
+    }
+    return *dp_csrGraph;
+  }
+  void ROMol::clearCSRGraph() const {
+#ifdef RDK_THREADSAFE_SSS
+    boost::mutex::scoped_lock lock(d_csrGraphMutex);
+#endif
+    if(dp_csrGraph){
+      delete dp_csrGraph;
+      dp_csrGraph=0;
+    }
+  }
+
   ROMol::ATOM_ITER_PAIR ROMol::getVertices() { return boost::vertices(d_graph);}
   ROMol::BOND_ITER_PAIR ROMol::getEdges() {return boost::edges(d_graph);}
   ROMol::ATOM_ITER_PAIR ROMol::getVertices() const { return boost::vertices(d_graph);}
@@ -338,6 +367,8 @@ namespace RDKit{
     else atom_p = atom_pin;
 
     atom_p->setOwningMol(this);
+    clearCSRGraph();
+    ++d_structureVersion;
     MolGraph::vertex_descriptor which=boost::add_vertex(d_graph);
     d_graph[which].reset(atom_p);
     atom_p->setIdx(which);
@@ -368,6 +399,8 @@ namespace RDKit{
     else bond_p = bond_pin;
 
     bond_p->setOwningMol(this);
+    clearCSRGraph();
+    ++d_structureVersion;
     bool ok;
     MolGraph::edge_descriptor which;
     boost::tie(which,ok) = boost::add_edge(bond_p->getBeginAtomIdx(),bond_p->getEndAtomIdx(),d_graph);
@@ -478,12 +511,15 @@ namespace RDKit{
     if(includeRings) this->dp_ringInfo->reset();
 
     STR_VECT compLst;
-    getProp("__computedProps", compLst);
+    STR_VECT *compLstPtr=dp_props->getValPtr<STR_VECT>(common_properties::__computedProps);
+    if(compLstPtr){
+      // empty the list before clearing the values, clearing them
+      // rearranges the Dict's storage:
+      compLst.swap(*compLstPtr);
+    }
     BOOST_FOREACH(std::string &sv,compLst){
       dp_props->clearVal(sv);
     }
-    compLst.clear();
-    dp_props->setVal("__computedProps", compLst);
     for(ConstAtomIterator atomIt=this->beginAtoms();
         atomIt!=this->endAtoms();
         ++atomIt){
@@ -30,6 +30,10 @@
 
 #include "Conformer.h"
 
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread/mutex.hpp>
+#endif
+
 namespace RDKit{
   class Atom;
   class Bond;
@@ -47,6 +51,7 @@ namespace RDKit{
   class QueryAtom;
   class QueryBond;
   class RingInfo;
+  class CSRGraph;
 
   template <class T1,class T2>
   class AtomIterator_;
@@ -96,6 +101,9 @@ namespace RDKit{
 
       - information about rings (SSSR and the like) is stored in the
         molecule's RingInfo pointer.
+
+      - a compact, read-only view of the topology (a CSRGraph) is built
+        on demand and cached; it is discarded when the topology changes.
     
    */
   
@@ -178,7 +186,7 @@ namespace RDKit{
            copy any of the properties or bookmarks and conformers from \c other.  This can
            make the copy substantially faster (thus the name).
     */
-    ROMol(const ROMol &other,bool quickCopy=false) {dp_props=0;dp_ringInfo=0;initFromOther(other,quickCopy);};
+    ROMol(const ROMol &other,bool quickCopy=false) {dp_props=0;dp_ringInfo=0;dp_csrGraph=0;d_structureVersion=0;initFromOther(other,quickCopy);};
     //! construct a molecule from a pickle string
     ROMol(const std::string &binStr);
 
@@ -306,6 +314,56 @@ namespace RDKit{
     //! <b>Note:</b> the client should not delete this.
     RingInfo *getRingInfo() const { return dp_ringInfo; };
 
+    //! returns a compact, read-only view of our topology
+    /*!
+      The view is built the first time it is requested and is cached
+      until the topology of the molecule is changed.
+      It is much cheaper to walk than the BGL graph (no smart pointers
+      are involved) and should be preferred in performance-critical
+      code.
+
+      <b>Usage</b>
+      \code
+        ... mol is a const ROMol & ...
+        const CSRGraph &g=mol.getCSRGraph();
+        CSRGraph::IDX_ITER nbr,endNbrs;
+        boost::tie(nbr,endNbrs) = g.getAtomNeighbors(atomIdx);
+        while(nbr!=endNbrs){
+          ... *nbr is the index of a neighboring atom ...
+          ++nbr;
+        }
+      \endcode
+
+      <b>Note:</b> the reference is invalidated by any change to the
+      molecule's topology.
+    */
+    const CSRGraph &getCSRGraph() const;
+    //! discards our cached CSRGraph
+    /*!
+      This is done automatically when the topology is changed.
+    */
+    void clearCSRGraph() const;
+
+    //! returns the structure version of the molecule
+    /*!
+      The structure version is changed every time Atoms or Bonds are
+      added, removed or replaced, and when their atomic numbers,
+      charges, isotopes, H counts, bond types, aromaticity or stereo
+      are set. It can be used to check whether or not values computed
+      from the molecule (e.g. the cached hashes in MolHash.h) are still
+      valid. Copies of a molecule start with the structure version of
+      the original.
+    */
+    unsigned int getStructureVersion() const { return d_structureVersion; };
+    //! changes the structure version of the molecule
+    /*!
+      This is done automatically when the molecule or its Atoms or
+      Bonds are modified, it only needs to be called directly when
+      something else that values computed from the molecule depend on
+      is changed.
+    */
+    void updateStructureVersion() { ++d_structureVersion; };
+
     //! provides access to all neighbors around an Atom
     /*!
       \param at the atom whose neighbors we are looking for
@@ -488,8 +546,8 @@ namespace RDKit{
                          bool includeComputed=true) const {
       const STR_VECT &tmp=dp_props->keys();
       STR_VECT res,computed;
-      if(!includeComputed && hasProp("__computedProps")){
-        getProp("__computedProps",computed);
+      if(!includeComputed && hasProp(common_properties::__computedProps)){
+        getProp(common_properties::__computedProps,computed);
         computed.push_back("__computedProps");
       }
       
@@ -515,19 +573,27 @@ namespace RDKit{
            \c computed.
      */
     template <typename T>
-    void setProp(const char *key, T val, bool computed=false) const {
-      std::string what(key);
-      setProp(what,val, computed);
+    void setProp(const char *key, T val, bool computed=false) const{
+      setProp(getPropKey(key),val,computed);
     }
     //! \overload
     template <typename T>
     void setProp(const std::string key, T val, bool computed=false) const {
+      setProp(getPropKey(key),val,computed);
+    }
+    //! \overload
+    template <typename T>
+    void setProp(PropKey key, T val, bool computed=false) const {
       if (computed) {
-        STR_VECT compLst;
-        getProp("__computedProps", compLst);
-        if (std::find(compLst.begin(), compLst.end(), key) == compLst.end()) {
-          compLst.push_back(key);
-          dp_props->setVal("__computedProps", compLst);
+        STR_VECT *compLst=dp_props->getValPtr<STR_VECT>(common_properties::__computedProps);
+        if (!compLst) {
+          STR_VECT tmp;
+          dp_props->setVal(common_properties::__computedProps, tmp);
+          compLst=dp_props->getValPtr<STR_VECT>(common_properties::__computedProps);
+        }
+        const std::string &name=key.getName();
+        if (std::find(compLst->begin(), compLst->end(), name) == compLst->end()) {
+          compLst->push_back(name);
         }
       }
       dp_props->setVal(key, val);
@@ -547,28 +613,61 @@ namespace RDKit{
            If this fails, a \c boost::bad_lexical_cast exception will be thrown.
 
     */
-    template <typename T> 
-    void getProp(const char *key, T &res) const {
-      dp_props->getVal(key, res);
+    template <typename T>
+    void getProp(const char *key,T &res) const {
+      dp_props->getVal(key,res);
+    }
+    //! \overload
+    template <typename T>
+    void getProp(const std::string key,T &res) const {
+      dp_props->getVal(key,res);
     }
     //! \overload
     template <typename T>
-    void getProp(const std::string key, T &res) const {
-      //getProp(key.c_str(), res);
-      dp_props->getVal(key, res);
+    void getProp(PropKey key,T &res) const {
+      dp_props->getVal(key,res);
+    }
+
+    //! retrieves a property value if we have it
+    /*!
+       This is faster than calling hasProp() and then getProp().
+
+       \return whether or not we have a \c property with name \c key
+    */
+    template <typename T>
+    bool getPropIfPresent(PropKey key,T &res) const {
+      if (!dp_props) return false;
+      return dp_props->getValIfPresent(key,res);
+    }
+
+    //! returns a pointer to a property value, without copying it
+    /*!
+       No type conversions are done.
+
+       \return null if we don't have a \c property with name \c key
+               or if its value is not of type \c T
+    */
+    template <typename T>
+    const T *getPropPtr(PropKey key) const {
+      if (!dp_props) return 0;
+      return dp_props->getValPtr<T>(key);
     }
 
     //! returns whether or not we have a \c property with name \c key
     bool hasProp(const char *key) const {
       if (!dp_props) return false;
       return dp_props->hasVal(key);
-    }
+    };
     //! \overload
     bool hasProp(const std::string key) const {
       if (!dp_props) return false;
       return dp_props->hasVal(key);
-      //return hasProp(key.c_str());
-    }
+    };
+    //! \overload
+    bool hasProp(PropKey key) const {
+      if (!dp_props) return false;
+      return dp_props->hasVal(key);
+    };
 
     //! clears the value of a \c property
     /*!
@@ -584,14 +683,18 @@ namespace RDKit{
     };
     //! \overload
     void clearProp(const std::string key) const {
-      STR_VECT compLst;
-      getProp("__computedProps", compLst);
-      STR_VECT_I svi = std::find(compLst.begin(), compLst.end(), key);
-      if (svi != compLst.end()) {
-        compLst.erase(svi);
-        dp_props->setVal("__computedProps", compLst);
+      if (!dp_props->hasVal(key)) throw KeyErrorException(key);
+      clearProp(getPropKey(key));
+    };
+    //! \overload
+    void clearProp(PropKey key) const {
+      STR_VECT *compLst=dp_props->getValPtr<STR_VECT>(common_properties::__computedProps);
+      if (compLst) {
+        STR_VECT_I svi = std::find(compLst->begin(), compLst->end(), key.getName());
+        if (svi != compLst->end()) {
+          compLst->erase(svi);
+        }
       }
-    
       dp_props->clearVal(key);
     };
 
@@ -627,6 +730,11 @@ namespace RDKit{
     Dict *dp_props;
     RingInfo *dp_ringInfo;
     CONF_SPTR_LIST d_confs;
+    mutable CSRGraph *dp_csrGraph;
+    unsigned int d_structureVersion;
+#ifdef RDK_THREADSAFE_SSS
+    mutable boost::mutex d_csrGraphMutex;
+#endif
     ROMol &operator=(const ROMol &); // disable assignment
 
 #ifdef WIN32
@@ -60,6 +60,8 @@ namespace RDKit{
   unsigned int RWMol::addAtom(bool updateLabel){
     Atom *atom_p = new Atom();
     atom_p->setOwningMol(this);
+    clearCSRGraph();
+    ++d_structureVersion;
     MolGraph::vertex_descriptor which = boost::add_vertex(d_graph);
     d_graph[which].reset(atom_p);
     atom_p->setIdx(which);
@@ -81,6 +83,8 @@ namespace RDKit{
     Atom *atom_p = atom_pin->copy();
     atom_p->setOwningMol(this);
     atom_p->setIdx(idx);
+    clearCSRGraph();
+    ++d_structureVersion;
     MolGraph::vertex_descriptor vd = boost::vertex(idx,d_graph);
     d_graph[vd].reset(atom_p);
     // FIX: do something about bookmarks
@@ -177,6 +181,8 @@ namespace RDKit{
     clearComputedProps(true);
 
     oatom->setOwningMol(NULL);
+    clearCSRGraph();
+    ++d_structureVersion;
     
     // remove all connections to the atom:
     MolGraph::vertex_descriptor vd = boost::vertex(idx,d_graph);
@@ -208,6 +214,8 @@ namespace RDKit{
       getAtomWithIdx(atomIdx1)->setIsAromatic(1);
       getAtomWithIdx(atomIdx2)->setIsAromatic(1);
     }
+    clearCSRGraph();
+    ++d_structureVersion;
     bool ok;
     MolGraph::edge_descriptor which;
     boost::tie(which,ok) = boost::add_edge(atomIdx1,atomIdx2,d_graph);
@@ -291,6 +299,8 @@ namespace RDKit{
     }
 
     bnd->setOwningMol(NULL);
+    clearCSRGraph();
+    ++d_structureVersion;
     
     MolGraph::vertex_descriptor vd1 = boost::vertex(aid1,d_graph);
     MolGraph::vertex_descriptor vd2 = boost::vertex(aid2,d_graph);
@@ -212,7 +212,8 @@ namespace RDKit{
       d_confs.clear();
       if(dp_props) dp_props->reset();
       if(dp_ringInfo) dp_ringInfo->reset();
-      
+      clearCSRGraph();
+      ++d_structureVersion;
     };
 
 
@@ -15,44 +15,35 @@
 #include <boost/cstdint.hpp>
 #include <boost/foreach.hpp>
 #include <boost/dynamic_bitset.hpp>
+#include <boost/tuple/tuple.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
 #include <RDGeneral/hash/hash.hpp>
 
-#include <boost/lambda/lambda.hpp>
 #include <list>
 #include <algorithm>
-using namespace boost::lambda;
+#include <cmath>
 
 //#define VERBOSE_CANON 1
 //#define VERYVERBOSE_CANON 1
 
 namespace RankAtoms{
   using namespace RDKit;
-  // --------------------------------------------------
-  //
-  // grabs the corresponding primes for the rank vector ranks
-  //
-  // --------------------------------------------------
-  void getPrimes(const INT_VECT &ranks,INT_VECT &res){
-    PRECONDITION(res.size()==0,"");
-    res.reserve(ranks.size());
-    for(INT_VECT_CI ivCIt=ranks.begin();ivCIt!=ranks.end();++ivCIt){
-      res.push_back(firstThousandPrimes[(*ivCIt)%NUM_PRIMES_AVAIL]);
-    }
-  }
-
   // --------------------------------------------------
   //
   // blows out any indices in indicesInPlay which correspond to unique ranks
   //
   // --------------------------------------------------
   void updateInPlayIndices(const INT_VECT &ranks,INT_LIST &indicesInPlay){
+    // sort a copy of the ranks so that the number of times each
+    // one appears can be found with a binary search:
+    INT_VECT sortedRanks(ranks);
+    std::sort(sortedRanks.begin(),sortedRanks.end());
     INT_LIST::iterator ivIt=indicesInPlay.begin();    
     while(ivIt!=indicesInPlay.end()){
-      // find the first instance of this rank:
-      INT_VECT::const_iterator pos=std::find(ranks.begin(),ranks.end(),ranks[*ivIt]);
-      ++pos;
-      // now check to see if there is at least one more:
-      if( std::find(pos,ranks.end(),ranks[*ivIt])==ranks.end()){
+      std::pair<INT_VECT_I,INT_VECT_I> range=std::equal_range(sortedRanks.begin(),
+                                                              sortedRanks.end(),
+                                                              ranks[*ivIt]);
+      if(range.second-range.first<2){
         INT_LIST::iterator tmpIt = ivIt;
         ++ivIt;
         indicesInPlay.erase(tmpIt);
@@ -62,48 +53,6 @@ namespace RankAtoms{
     }
   }
   
-  // --------------------------------------------------
-  //
-  // for each index in indicesInPlay, generate the products of the adjacent
-  // elements
-  //
-  //  The products are weighted by the order of the bond connecting the atoms.
-  //
-  // --------------------------------------------------
-  void calcAdjacentProducts(unsigned int nAtoms,
-                            const INT_VECT &valVect,
-                            double const *adjMat,
-                            const INT_LIST &indicesInPlay,
-                            DOUBLE_VECT &res,
-                            bool useSelf=true,
-                            double tol=1e-6){
-    PRECONDITION(valVect.size() >= nAtoms,"");
-    PRECONDITION(res.size() == 0,"");
-    PRECONDITION(adjMat,"");
-    for(INT_LIST::const_iterator idxIt=indicesInPlay.begin();
-        idxIt != indicesInPlay.end();
-        ++idxIt){
-      double accum;
-      if(useSelf)
-        accum=valVect[*idxIt];
-      else
-        accum=1.0;
-      const unsigned int iTab = (*idxIt)*nAtoms;
-      for(unsigned int j=0;j<nAtoms;++j){
-        double elem=adjMat[iTab+j];
-        if(elem>tol){
-          if(elem<2.-tol){
-            accum *= valVect[j];
-          } else {
-            accum *= pow(static_cast<double>(valVect[j]),
-                         static_cast<int>(elem));
-          }
-        }
-      }
-      res.push_back(accum);
-    }
-  }
-
   template <typename T>
   void debugVect(const std::vector<T> arg){
     typename std::vector<T>::const_iterator viIt;
@@ -112,217 +61,300 @@ namespace RankAtoms{
     }
     BOOST_LOG(rdDebugLog)<< std::endl;
   }
-  
-  // --------------------------------------------------
-  //
-  //  This is one round of the process from Step III in the Daylight
-  //  paper
-  //
-  // --------------------------------------------------
-  unsigned int iterateRanks(unsigned int nAtoms,INT_VECT &primeVect,
-                            DOUBLE_VECT &atomicVect,
-                            INT_LIST &indicesInPlay,
-                            double *adjMat,
-                            INT_VECT &ranks,
-                            VECT_INT_VECT *rankHistory,unsigned int stagnantTol){
-    PRECONDITION(!rankHistory||rankHistory->size()>=nAtoms,"bad rankHistory size");
-    bool done = false;
-    unsigned int numClasses = countClasses(ranks);
-    unsigned int lastNumClasses = 0;
-    unsigned int nCycles = 0;
-    unsigned int nStagnant=0;
 
+  namespace {
+    class rankValueLess {
+    public:
+      rankValueLess(const INT_VECT &ranks,const DOUBLE_VECT &vals) :
+        d_ranks(ranks), d_vals(vals) {};
+      bool operator() (int i,int j) const {
+        if(d_ranks[i]!=d_ranks[j]) return d_ranks[i]<d_ranks[j];
+        return d_vals[i]<d_vals[j];
+      }
+    private:
+      const INT_VECT &d_ranks;
+      const DOUBLE_VECT &d_vals;
+    };
+
+    // --------------------------------------------------
     //
-    // loop until either we finish or no improvement is seen
+    // removes the indices of atoms in classes of size one from inPlay
     //
-#ifdef VERBOSE_CANON
-    for(unsigned int i=0;i<nAtoms;i++) {
-      BOOST_LOG(rdDebugLog)<< "\t\t>:" << i << " " << ranks[i] << std::endl;
+    // --------------------------------------------------
+    void updateInPlay(const INT_VECT &ranks,unsigned int numClasses,
+                      INT_VECT &inPlay,INT_VECT &classSizes){
+      classSizes.assign(numClasses,0);
+      BOOST_FOREACH(int rank,ranks){
+        ++classSizes[rank];
+      }
+      INT_VECT_I newEnd=inPlay.begin();
+      BOOST_FOREACH(int idx,inPlay){
+        if(classSizes[ranks[idx]]>1) *newEnd++ = idx;
+      }
+      inPlay.erase(newEnd,inPlay.end());
     }
-    BOOST_LOG(rdDebugLog)<< "\t\t-*-*-*-*-" << std::endl;
-#endif
-    while(!done && nCycles < nAtoms){
-      // determine which atomic indices are in play (which have duplicate ranks)
-      if(rankHistory){
-        for(INT_LIST_CI idx=indicesInPlay.begin();idx!=indicesInPlay.end();++idx){
-          (*rankHistory)[*idx].push_back(ranks[*idx]);
+
+    // --------------------------------------------------
+    //
+    // splits the classes of the atoms in inPlay using their values
+    // in vals. inPlay must contain every atom in a class with more than
+    // one member.
+    //
+    // The ranks remain dense: the classes a class is split into get
+    // consecutive ranks (ordered by value) and the ranks of the classes
+    // above it are shifted up to make room.
+    //
+    // returns the new number of classes
+    //
+    // --------------------------------------------------
+    unsigned int splitClasses(INT_VECT &ranks,unsigned int numClasses,
+                              const DOUBLE_VECT &vals,const INT_VECT &inPlay,
+                              INT_VECT &order,INT_VECT &shifts,INT_VECT &newRanks){
+      order.assign(inPlay.begin(),inPlay.end());
+      std::sort(order.begin(),order.end(),rankValueLess(ranks,vals));
+
+      // newRanks[i] is the position of order[i] in the split class,
+      // shifts[r+1] the number of new classes made from class r:
+      newRanks.resize(order.size());
+      shifts.assign(numClasses+1,0);
+      for(unsigned int i=0;i<order.size();++i){
+        if(i && ranks[order[i]]==ranks[order[i-1]]){
+          newRanks[i]=newRanks[i-1];
+          if(vals[order[i]]!=vals[order[i-1]]){
+            ++newRanks[i];
+            ++shifts[ranks[order[i]]+1];
+          }
+        } else {
+          newRanks[i]=0;
         }
       }
-      updateInPlayIndices(ranks,indicesInPlay);
-      if(indicesInPlay.empty()) break;
-        
-#ifdef VERYVERBOSE_CANON
-      BOOST_LOG(rdDebugLog)<< "IN PLAY:" << std::endl;
-      BOOST_LOG(rdDebugLog)<< "\t\t->";
-      for(INT_LIST::const_iterator tmpI=indicesInPlay.begin();tmpI != indicesInPlay.end();tmpI++){
-        BOOST_LOG(rdDebugLog)<< " " << *tmpI;
+      for(unsigned int i=1;i<=numClasses;++i) shifts[i]+=shifts[i-1];
+      if(!shifts[numClasses]) return numClasses;
+
+      for(unsigned int i=0;i<order.size();++i){
+        newRanks[i] += ranks[order[i]]+shifts[ranks[order[i]]];
       }
-      BOOST_LOG(rdDebugLog)<< std::endl;
-      BOOST_LOG(rdDebugLog)<< "\t\t---------" << std::endl;
-#endif
-      //-------------------------
-      // Step (2):
-      //    Get the products of adjacent primes
-      //-------------------------
-      primeVect.resize(0);
-      getPrimes(ranks,primeVect);
-      atomicVect.resize(0);
-      calcAdjacentProducts(nAtoms,primeVect,adjMat,indicesInPlay,atomicVect,false);
+      BOOST_FOREACH(int &rank,ranks){
+        rank += shifts[rank];
+      }
+      for(unsigned int i=0;i<order.size();++i){
+        ranks[order[i]]=newRanks[i];
+      }
+      return numClasses+shifts[numClasses];
+    }
+
+    // --------------------------------------------------
+    //
+    //  This is one round of the process from Step III in the Daylight
+    //  paper: the classes are refined using the products of the primes
+    //  corresponding to the ranks of each atom's neighbors until either
+    //  all classes are unique or the refinement stagnates.
+    //
+    //  Equal products leave atoms in the same class, so ranking on the
+    //  products within the current classes is equivalent to ranking
+    //  on the history of the products of each atom.
+    //
+    // --------------------------------------------------
+    unsigned int iterateRanks(unsigned int nAtoms,
+                              const UINT_VECT &nbrStarts,
+                              const UINT_VECT &nbrs,
+                              const DOUBLE_VECT &nbrWeights,
+                              INT_VECT &ranks,unsigned int numClasses,
+                              INT_VECT &inPlay,
+                              VECT_INT_VECT *rankHistory,unsigned int stagnantTol,
+                              double tol=1e-6){
+      bool done = false;
+      unsigned int lastNumClasses = 0;
+      unsigned int nCycles = 0;
+      unsigned int nStagnant=0;
+
+      DOUBLE_VECT products(nAtoms,0.0);
+      INT_VECT classSizes,order,shifts,newRanks;
+      //
+      // loop until either we finish or no improvement is seen
+      //
+      while(!done && nCycles < nAtoms){
+        // determine which atomic indices are in play (which have duplicate ranks)
+        if(rankHistory){
+          BOOST_FOREACH(int idx,inPlay){
+            (*rankHistory)[idx].push_back(ranks[idx]);
+          }
+        }
+        updateInPlay(ranks,numClasses,inPlay,classSizes);
+        if(inPlay.empty()) break;
+
+        //-------------------------
+        // Step (2):
+        //    Get the products of adjacent primes, weighted by
+        //    the order of the bonds to the neighbors
+        //-------------------------
+        BOOST_FOREACH(int idx,inPlay){
+          double accum=1.0;
+          for(unsigned int j=nbrStarts[idx];j<nbrStarts[idx+1];++j){
+            int prime=firstThousandPrimes[ranks[nbrs[j]]%NUM_PRIMES_AVAIL];
+            if(nbrWeights[j]<2.-tol){
+              accum *= prime;
+            } else {
+              accum *= pow(static_cast<double>(prime),
+                           static_cast<int>(nbrWeights[j]));
+            }
+          }
+          products[idx]=accum;
+        }
 #ifdef VERYVERBOSE_CANON
-      BOOST_LOG(rdDebugLog)<< "primes: ";
-      debugVect(primeVect);
-      BOOST_LOG(rdDebugLog)<< "products: ";
-      debugVect(atomicVect);
+        BOOST_LOG(rdDebugLog)<< "products: ";
+        debugVect(products);
 #endif
 
-
-      //-------------------------
-      // Steps (3) and (4)
-      //   sort the products and count classes
-      //-------------------------
-      sortAndRankVect(nAtoms,atomicVect,indicesInPlay,ranks);
-      lastNumClasses = numClasses;
-      numClasses = countClasses(ranks);
-      if(numClasses == lastNumClasses) nStagnant++;
+        //-------------------------
+        // Steps (3) and (4)
+        //   sort the products and count classes
+        //-------------------------
+        lastNumClasses = numClasses;
+        numClasses = splitClasses(ranks,numClasses,products,inPlay,order,shifts,newRanks);
+        if(numClasses == lastNumClasses) nStagnant++;
 #ifdef VERYVERBOSE_CANON
-      int tmpOff=0;
-      for(unsigned int i=0;i<nAtoms;i++){
-        //for(INT_LIST::const_iterator tmpI=indicesInPlay.begin();tmpI != indicesInPlay.end();tmpI++){
-        BOOST_LOG(rdDebugLog)<< "\t\ti:" << i << "\t" << ranks[i] << "\t" << primeVect[i];
-        if(std::find(indicesInPlay.begin(),indicesInPlay.end(),i)!=indicesInPlay.end()){
-          BOOST_LOG(rdDebugLog)<< "\t" << atomicVect[tmpOff];
-          tmpOff++;
+        for(unsigned int i=0;i<nAtoms;i++){
+          BOOST_LOG(rdDebugLog)<< "\t\ti:" << i << "\t" << ranks[i] << std::endl;
         }
-        BOOST_LOG(rdDebugLog)<< std::endl;    }
-      BOOST_LOG(rdDebugLog)<< "\t\t---------" << std::endl;
+        BOOST_LOG(rdDebugLog)<< "\t\t---------" << std::endl;
 #endif
         
-      // terminal condition, we'll allow a single round of stagnancy
-      if(numClasses == nAtoms || nStagnant > stagnantTol) done = 1;
-      nCycles++;
-    }
+        // terminal condition, we'll allow a single round of stagnancy
+        if(numClasses == nAtoms || nStagnant > stagnantTol) done = 1;
+        nCycles++;
+      }
 #ifdef VERBOSE_CANON
-    BOOST_LOG(rdDebugLog)<< ">>>>>> done inner iteration. static: "<< nStagnant << " ";
-    BOOST_LOG(rdDebugLog)<< nCycles << " " << nAtoms << " " << numClasses << std::endl;
-#ifdef VERYVERBOSE_CANON
-    for(unsigned int i=0;i<nAtoms;i++) {
-      BOOST_LOG(rdDebugLog)<< "\t" << i << " " << ranks[i] << std::endl;
-    }
-#endif    
-    if(nCycles == nAtoms){
-      BOOST_LOG(rdWarningLog) << "WARNING: ranking bottomed out" << std::endl;
-    }
+      BOOST_LOG(rdDebugLog)<< ">>>>>> done inner iteration. static: "<< nStagnant << " ";
+      BOOST_LOG(rdDebugLog)<< nCycles << " " << nAtoms << " " << numClasses << std::endl;
+      if(nCycles == nAtoms){
+        BOOST_LOG(rdWarningLog) << "WARNING: ranking bottomed out" << std::endl;
+      }
 #endif
-    return numClasses;
-  }
-  unsigned int iterateRanks2(unsigned int nAtoms,INT_VECT &primeVect,
-                            DOUBLE_VECT &atomicVect,
-                            INT_LIST &indicesInPlay,
-                            double *adjMat,
-                             INT_VECT &ranks,VECT_DOUBLE_VECT &nRanks,
-                            VECT_INT_VECT *rankHistory,unsigned int stagnantTol){
-    PRECONDITION(!rankHistory||rankHistory->size()>=nAtoms,"bad rankHistory size");
-    bool done = false;
-    unsigned int numClasses = countClasses(ranks);
-    unsigned int lastNumClasses = 0;
-    unsigned int nCycles = 0;
-    unsigned int nStagnant=0;
+      return numClasses;
+    }
 
+    // --------------------------------------------------
     //
-    // loop until either we finish or no improvement is seen
+    // sets up the neighbor lists used by refineRanks from
+    // a list of (atom, neighbor, weight) connections
     //
-#ifdef VERBOSE_CANON
-    for(unsigned int i=0;i<nAtoms;i++) {
-      BOOST_LOG(rdDebugLog)<< "\t\t>:" << i << " " << ranks[i] << std::endl;
-    }
-    BOOST_LOG(rdDebugLog)<< "\t\t-*-*-*-*-" << std::endl;
-#endif
-    while(!done && nCycles < nAtoms){
-      // determine which atomic indices are in play (which have duplicate ranks)
-      if(rankHistory){
-        BOOST_FOREACH(int idx,indicesInPlay){
-          (*rankHistory)[idx].push_back(ranks[idx]);
-        }
-      }
-      updateInPlayIndices(ranks,indicesInPlay);
-      if(indicesInPlay.empty()) break;
-        
-#ifdef VERYVERBOSE_CANON
-      BOOST_LOG(rdDebugLog)<< "IN PLAY:" << std::endl;
-      BOOST_LOG(rdDebugLog)<< "\t\t->";
-      for(INT_LIST::const_iterator tmpI=indicesInPlay.begin();tmpI != indicesInPlay.end();tmpI++){
-        BOOST_LOG(rdDebugLog)<< " " << *tmpI;
+    // --------------------------------------------------
+    typedef boost::tuple<unsigned int,unsigned int,double> CONNECTION;
+    void buildNeighborLists(unsigned int nAtoms,std::vector<CONNECTION> &connections,
+                            UINT_VECT &nbrStarts,UINT_VECT &nbrs,DOUBLE_VECT &nbrWeights,
+                            double tol=1e-6){
+      std::sort(connections.begin(),connections.end());
+      nbrStarts.assign(nAtoms+1,0);
+      nbrs.clear();
+      nbrWeights.clear();
+      nbrs.reserve(connections.size());
+      nbrWeights.reserve(connections.size());
+      BOOST_FOREACH(const CONNECTION &conn,connections){
+        // connections with a zero weight are ignored:
+        if(conn.get<2>()<=tol) continue;
+        ++nbrStarts[conn.get<0>()+1];
+        nbrs.push_back(conn.get<1>());
+        nbrWeights.push_back(conn.get<2>());
       }
-      BOOST_LOG(rdDebugLog)<< std::endl;
-      BOOST_LOG(rdDebugLog)<< "\t\t---------" << std::endl;
-#endif
-      //-------------------------
-      // Step (2):
-      //    Get the products of adjacent primes
-      //-------------------------
-      primeVect.resize(0);
-      getPrimes(ranks,primeVect);
-      atomicVect.resize(0);
-      calcAdjacentProducts(nAtoms,primeVect,adjMat,indicesInPlay,atomicVect,false);
-#ifdef VERYVERBOSE_CANON
-      BOOST_LOG(rdDebugLog)<< "primes: ";
-      debugVect(primeVect);
-      BOOST_LOG(rdDebugLog)<< "products: ";
-      debugVect(atomicVect);
-#endif
+      for(unsigned int i=1;i<=nAtoms;++i) nbrStarts[i]+=nbrStarts[i-1];
+    }
+  }
 
-      unsigned int p=0;
-      BOOST_FOREACH(int idx,indicesInPlay){
-        nRanks[idx].push_back(atomicVect[p++]);
+  // --------------------------------------------------
+  //
+  // Ranks atoms by iterative refinement of the partition defined by
+  // their invariants, breaking ties between equivalent atoms if
+  // requested.
+  //
+  // --------------------------------------------------
+  void refineRanks(unsigned int nAtoms,const DOUBLE_VECT &invariants,
+                   const UINT_VECT &nbrStarts,const UINT_VECT &nbrs,
+                   const DOUBLE_VECT &nbrWeights,
+                   bool breakTies,INT_VECT &ranks,
+                   VECT_INT_VECT *rankHistory){
+    PRECONDITION(invariants.size()>=nAtoms,"bad invariants size");
+    PRECONDITION(nbrStarts.size()==nAtoms+1,"bad nbrStarts size");
+    PRECONDITION(nbrs.size()==nbrStarts[nAtoms],"bad nbrs size");
+    PRECONDITION(nbrWeights.size()==nbrs.size(),"bad nbrWeights size");
+    PRECONDITION(!rankHistory||rankHistory->size()>=nAtoms,"bad rankHistory size");
+    if(!nAtoms) return;
+
+    // ----------------------
+    // iteration 1: Steps (3) and (4)
+    // ----------------------
+    ranks.resize(nAtoms);
+    rankVect(invariants,ranks);
+    if(rankHistory){
+      for(unsigned int i=0;i<nAtoms;i++){
+        (*rankHistory)[i].push_back(ranks[i]);
       }
-#ifdef VERYVERBOSE_CANON
-      for(int idx=0;idx<nAtoms;++idx){
-        std::cerr<<"  nranks["<<idx<<"]: ";
-        std::copy(nRanks[idx].begin(),nRanks[idx].end(),std::ostream_iterator<double>(std::cerr," "));
-        std::cerr<<"\n";
+    }
+    // the ranks are dense, so this is the number of classes:
+    unsigned int numClasses=*std::max_element(ranks.begin(),ranks.end())+1;
+    if(numClasses==nAtoms) return;
+
+    // inPlay is used to track the atoms with non-unique ranks
+    //  (we'll be modifying these in each step)
+    INT_VECT inPlay(nAtoms);
+    for(unsigned int i=0;i<nAtoms;i++) inPlay[i]=i;
+
+    // if we aren't breaking ties here, allow the rank iteration to
+    // go the full number of atoms:
+    unsigned int stagnantTol = breakTies ? 1 : nAtoms;
+
+    while(1){
+      //
+      // do one round of iterations
+      //
+      numClasses = iterateRanks(nAtoms,nbrStarts,nbrs,nbrWeights,ranks,numClasses,
+                                inPlay,rankHistory,stagnantTol);
+#ifdef VERBOSE_CANON
+      BOOST_LOG(rdDebugLog)<< "************************ done outer iteration" << std::endl;
+      BOOST_LOG(rdDebugLog)<< "RANKS:" << std::endl;
+      debugVect(ranks);
+#endif    
+      if( !breakTies || inPlay.empty() || numClasses==nAtoms ) break;
+
+      //
+      // This is the tiebreaker stage of things:
+      // find lowest duplicate rank with lowest invariant:
+      //
+      int lowestIdx=inPlay.front();
+      double lowestInvariant = invariants[lowestIdx];
+      int lowestRank=ranks[lowestIdx];
+      BOOST_FOREACH(int idx,inPlay){
+        if(ranks[idx]<=lowestRank){
+          if(ranks[idx]<lowestRank ||
+             invariants[idx] <= lowestInvariant){
+            lowestRank = ranks[idx];
+            lowestIdx = idx;
+            lowestInvariant = invariants[idx];
+          }
+        }
       }
-#endif
 
-      
-      //-------------------------
-      // Steps (3) and (4)
-      //   sort the products and count classes
-      //-------------------------
-      rankVect(nRanks,ranks);
-      //sortAndRankVect2(nRanks,indicesInPlay,ranks);
-      lastNumClasses = numClasses;
-      numClasses = countClasses(ranks);
-      if(numClasses == lastNumClasses) nStagnant++;
-#ifdef VERYVERBOSE_CANON
-      int tmpOff=0;
-      for(unsigned int i=0;i<nAtoms;i++){
-        //for(INT_LIST::const_iterator tmpI=indicesInPlay.begin();tmpI != indicesInPlay.end();tmpI++){
-        BOOST_LOG(rdDebugLog)<< "\t\ti:" << i << "\t" << ranks[i] << "\t" << primeVect[i];
-        if(std::find(indicesInPlay.begin(),indicesInPlay.end(),i)!=indicesInPlay.end()){
-          BOOST_LOG(rdDebugLog)<< "\t" << atomicVect[tmpOff];
-          tmpOff++;
+      //
+      // split that atom off from the rest of its class and proceed
+      //
+      bool inClass=false;
+      for(unsigned int i=0;i<nAtoms && !inClass;++i){
+        inClass = (ranks[i]==lowestRank && static_cast<int>(i)!=lowestIdx);
+      }
+      if(inClass){
+        for(unsigned int i=0;i<nAtoms;++i){
+          if(ranks[i]>lowestRank ||
+             (ranks[i]==lowestRank && static_cast<int>(i)!=lowestIdx)){
+            ++ranks[i];
+          }
         }
-        BOOST_LOG(rdDebugLog)<< std::endl;    }
-      BOOST_LOG(rdDebugLog)<< "\t\t---------" << std::endl;
-#endif
-        
-      // terminal condition, we'll allow a single round of stagnancy
-      if(numClasses == nAtoms || nStagnant > stagnantTol) done = 1;
-      nCycles++;
-    }
+        ++numClasses;
+      }
 #ifdef VERBOSE_CANON
-    BOOST_LOG(rdDebugLog)<< ">>>>>> done inner iteration. static: "<< nStagnant << " ";
-    BOOST_LOG(rdDebugLog)<< nCycles << " " << nAtoms << " " << numClasses << std::endl;
-#ifdef VERYVERBOSE_CANON
-    for(unsigned int i=0;i<nAtoms;i++) {
-      BOOST_LOG(rdDebugLog)<< "\t" << i << " " << ranks[i] << std::endl;
-    }
+      BOOST_LOG(rdDebugLog)<< "RE-RANKED ON:" << lowestIdx << std::endl;
+      debugVect(ranks);
 #endif    
-    if(nCycles == nAtoms){
-      BOOST_LOG(rdWarningLog) << "WARNING: ranking bottomed out" << std::endl;
     }
-#endif
-    return numClasses;
   }
 
   // --------------------------------------------------
@@ -385,9 +417,9 @@ namespace RankAtoms{
       invariant = (invariant << 1) | chgSign;
       if(includeChirality ){
         int isR=0;
-        if( atom->hasProp("_CIPCode")){
+        if( atom->hasProp(common_properties::_CIPCode)){
           std::string cipCode;
-          atom->getProp("_CIPCode",cipCode);
+          atom->getProp(common_properties::_CIPCode,cipCode);
           if(cipCode=="R"){
             isR=1;
           } else {
@@ -431,7 +463,7 @@ namespace RankAtoms{
         Atom const *atom = *atIt;
         if((atom->getChiralTag()==Atom::CHI_TETRAHEDRAL_CW ||
             atom->getChiralTag()==Atom::CHI_TETRAHEDRAL_CCW) &&
-           atom->hasProp("_ringStereoAtoms")){
+           atom->hasProp(common_properties::_ringStereoAtoms)){
           //atom->hasProp("_CIPRank") &&
           //!atom->hasProp("_CIPCode")){
           ROMol::ADJ_ITER beg,end;
@@ -511,9 +543,9 @@ namespace RankAtoms{
 
       if(includeChirality ){
         int isR=0;
-        if( atom->hasProp("_CIPCode")){
+        if( atom->hasProp(common_properties::_CIPCode)){
           std::string cipCode;
-          atom->getProp("_CIPCode",cipCode);
+          atom->getProp(common_properties::_CIPCode,cipCode);
           if(cipCode=="R"){
             isR=1;
           } else {
@@ -567,20 +599,15 @@ namespace RDKit{
                    bool includeChirality,
                    bool includeIsotopes,
                    VECT_INT_VECT *rankHistory){
-
-      unsigned int i;
       unsigned int nAtoms = mol.getNumAtoms();
       PRECONDITION(ranks.size()>=nAtoms,"");
       PRECONDITION(!rankHistory||rankHistory->size()>=nAtoms,"bad rankHistory size");
-      unsigned int stagnantTol=1;
 
-      if(!mol.getRingInfo()->isInitialized()){
+      if(mol.getRingInfo()->getPerceptionType()!=RingInfo::SSSR){
         MolOps::findSSSR(mol);
       }
     
       if(nAtoms > 1){
-        double *adjMat = MolOps::getAdjacencyMatrix(mol, true);
-
         // ----------------------
         // generate atomic invariants, Step (1)
         // ----------------------
@@ -590,131 +617,31 @@ namespace RDKit{
       
 #ifdef VERBOSE_CANON
         BOOST_LOG(rdDebugLog)<< "invariants:" << std::endl;
-        for(i=0;i<nAtoms;i++){
+        for(unsigned int i=0;i<nAtoms;i++){
           BOOST_LOG(rdDebugLog)<< i << " " << (long)invariants[i]<< std::endl;
         }
-
 #endif
 
-        DOUBLE_VECT atomicVect;
-        atomicVect.resize(nAtoms);
-
-        // ----------------------
-        // iteration 1: Steps (3) and (4)
-        // ----------------------
-
-        // Unlike the original paper, we're going to keep track of the
-        // ranks at each iteration and use those vectors to rank
-        // atoms. This seems to lead to more stable evolution of the
-        // ranks by avoiding ranks oscillating back and forth across
-        // iterations. 
-        VECT_DOUBLE_VECT nRanks(nAtoms);
-        for(i=0;i<nAtoms;i++) nRanks[i].push_back(invariants[i]);
-
-        // start by ranking the atoms using the invariants
-        ranks.resize(nAtoms);
-        RankAtoms::rankVect(nRanks,ranks);
-
-        if(rankHistory){
-          for(i=0;i<nAtoms;i++){
-            (*rankHistory)[i].push_back(ranks[i]);
-          }
+        // the neighbors are weighted by the valence contributions
+        // of the bonds to them:
+        std::vector<RankAtoms::CONNECTION> connections;
+        connections.reserve(2*mol.getNumBonds());
+        for(ROMol::ConstBondIterator bondIt=mol.beginBonds();
+            bondIt!=mol.endBonds();++bondIt){
+          const Bond *bond=*bondIt;
+          unsigned int begIdx=bond->getBeginAtomIdx();
+          unsigned int endIdx=bond->getEndAtomIdx();
+          connections.push_back(RankAtoms::CONNECTION(begIdx,endIdx,
+                                                      bond->getValenceContrib(bond->getBeginAtom())));
+          connections.push_back(RankAtoms::CONNECTION(endIdx,begIdx,
+                                                      bond->getValenceContrib(bond->getEndAtom())));
         }
+        UINT_VECT nbrStarts,nbrs;
+        DOUBLE_VECT nbrWeights;
+        RankAtoms::buildNeighborLists(nAtoms,connections,nbrStarts,nbrs,nbrWeights);
 
-        // how many classes are present?
-        unsigned int numClasses = RankAtoms::countClasses(ranks);
-
-        if(numClasses != nAtoms){
-          INT_VECT primeVect;
-          primeVect.reserve(nAtoms);
-
-          DOUBLE_VECT atomicVect;
-          atomicVect.reserve(nAtoms);
-      
-          // indicesInPlay is used to track the atoms with non-unique ranks
-          //  (we'll be modifying these in each step)
-          INT_LIST indicesInPlay;
-          for(i=0;i<nAtoms;i++) indicesInPlay.push_back(i);
-
-          // if we aren't breaking ties here, allow the rank iteration to
-          // go the full number of atoms:
-          if(!breakTies) stagnantTol=nAtoms;
-
-          bool done=indicesInPlay.empty();
-          while(!done){
-            //
-            // do one round of iterations
-            //
-            numClasses = RankAtoms::iterateRanks2(nAtoms,primeVect,atomicVect,
-                                                  indicesInPlay,adjMat,ranks,nRanks,
-                                                  rankHistory,stagnantTol);
-
-#ifdef VERBOSE_CANON
-            BOOST_LOG(rdDebugLog)<< "************************ done outer iteration" << std::endl;
-#endif  
-#ifdef VERBOSE_CANON
-            unsigned int tmpI;
-            BOOST_LOG(rdDebugLog)<< "RANKS:" << std::endl;
-            for(tmpI=0;tmpI<ranks.size();tmpI++){
-              BOOST_LOG(rdDebugLog)<< "\t\t" << tmpI << " " << ranks[tmpI] << std::endl;
-            }
-            BOOST_LOG(rdDebugLog)<< std::endl;
-#endif    
-            //
-            // This is the tiebreaker stage of things
-            //
-            if( breakTies && !indicesInPlay.empty() && numClasses<nAtoms){
-              INT_VECT newRanks = ranks;
-
-              // Add one to all ranks and multiply by two
-              BOOST_FOREACH(int &nr,newRanks) {
-                nr=(nr+1)*2;
-              }
-#ifdef VERBOSE_CANON
-              BOOST_LOG(rdDebugLog)<< "postmult:" << std::endl;
-              for(tmpI=0;tmpI<newRanks.size();tmpI++){
-                BOOST_LOG(rdDebugLog)<< "\t\t" << newRanks[tmpI] << std::endl;
-              }
-              BOOST_LOG(rdDebugLog)<< std::endl;
-#endif    
-
-              //
-              // find lowest duplicate rank with lowest invariant:
-              //
-              int lowestIdx=indicesInPlay.front();
-              double lowestInvariant = invariants[lowestIdx];
-              int lowestRank=newRanks[lowestIdx];
-              BOOST_FOREACH(int ilidx,indicesInPlay){
-                if(newRanks[ilidx]<=lowestRank){
-                  if(newRanks[ilidx]<lowestRank ||
-                     invariants[ilidx] <= lowestInvariant){
-                    lowestRank = newRanks[ilidx];
-                    lowestIdx = ilidx;
-                    lowestInvariant = invariants[ilidx];
-                  }
-                }
-              }
-
-              //
-              // subtract one from the lowest index, rerank and proceed
-              //
-              newRanks[lowestIdx] -= 1;
-              RankAtoms::rankVect(newRanks,ranks);
-              BOOST_FOREACH(int ilidx,indicesInPlay){
-                nRanks[ilidx].push_back(ranks[ilidx]);
-              }
-#ifdef VERBOSE_CANON
-              BOOST_LOG(rdDebugLog)<< "RE-RANKED ON:" << lowestIdx << std::endl;
-              for(tmpI=0;tmpI<newRanks.size();tmpI++){
-                BOOST_LOG(rdDebugLog)<< "\t\t" << newRanks[tmpI] << " " << ranks[tmpI] << std::endl;
-              }
-              BOOST_LOG(rdDebugLog)<< std::endl;
-#endif    
-            } else {
-              done = true;
-            }
-          }
-        }
+        RankAtoms::refineRanks(nAtoms,invariants,nbrStarts,nbrs,nbrWeights,
+                               breakTies,ranks,rankHistory);
       }
     } // end of function rankAtoms
 
@@ -732,7 +659,6 @@ namespace RDKit{
       PRECONDITION(!rankHistory||rankHistory->size()>=nAtoms,"bad rankHistory size");
       PRECONDITION(mol.getRingInfo()->isInitialized(),"no ring information present");
       PRECONDITION(!rankHistory,"rankHistory not currently supported.");
-      unsigned int stagnantTol=1;
 
       if(nActiveAtoms > 1){
 
@@ -746,9 +672,11 @@ namespace RDKit{
                                                atomSymbols);
         INVAR_VECT tinvariants;
         tinvariants.resize(nActiveAtoms);
+        INT_VECT activeIndices(nAtoms,-1);
         unsigned int activeIdx=0;
         for(unsigned int aidx=0;aidx<nAtoms;++aidx){
           if(atomsToUse[aidx]){
+            activeIndices[aidx]=activeIdx;
             tinvariants[activeIdx++]=invariants[aidx];
           }
         }
@@ -758,188 +686,46 @@ namespace RDKit{
         for(unsigned int i=0;i<nActiveAtoms;i++){
           BOOST_LOG(rdDebugLog)<< i << " " << (long)tinvariants[i]<< std::endl;
         }
-
 #endif
-        // ----------------------
-        // iteration 1: Steps (3) and (4)
-        // ----------------------
 
-        // start by ranking the atoms using the invariants
-        VECT_DOUBLE_VECT nRanks(nActiveAtoms);
-        for(int i=0;i<nActiveAtoms;i++) nRanks[i].push_back(tinvariants[i]);
-        INT_VECT tranks(nActiveAtoms,0);
-        RankAtoms::rankVect(nRanks,tranks);
-#if 0
-        if(rankHistory){
-          for(unsigned int i=0;i<nAtoms;i++){
-            (*rankHistory)[i].push_back(ranks[i]);
+        // the neighbors are weighted either by the valence contributions
+        // of the bonds to them or by the ranks of the bond symbols:
+        INT_VECT branks;
+        if(bondSymbols){
+          std::vector<boost::uint32_t> tbranks(bondsToUse.size(),0);
+          for(unsigned int bidx=0;bidx<bondsToUse.size();++bidx){
+            if(!bondsToUse[bidx]) continue;
+            const std::string &symb=(*bondSymbols)[bidx];
+            tbranks[bidx]=gboost::hash_range(symb.begin(),symb.end());
           }
+          branks.resize(bondsToUse.size());
+          RankAtoms::rankVect(tbranks,branks);
         }
-#endif
-        // how many classes are present?
-        unsigned int numClasses = RankAtoms::countClasses(tranks);
-        if(numClasses != nActiveAtoms){
-          double *tadjMat = new double[nActiveAtoms*nActiveAtoms];
-          memset(static_cast<void *>(tadjMat),0,nActiveAtoms*nActiveAtoms*sizeof(double));
-          if(!bondSymbols){
-            double *adjMat = MolOps::getAdjacencyMatrix(mol,true,0,true,0,&bondsToUse);
-            activeIdx=0;
-            for(unsigned int aidx=0;aidx<nAtoms;++aidx){
-              if(atomsToUse[aidx]){
-                unsigned int activeIdx2=activeIdx+1;
-                for(unsigned int aidx2=aidx+1;aidx2<nAtoms;++aidx2){
-                  if(atomsToUse[aidx2]){
-                    tadjMat[activeIdx*nActiveAtoms+activeIdx2]=adjMat[aidx*nAtoms+aidx2];
-                    tadjMat[activeIdx2*nActiveAtoms+activeIdx]=adjMat[aidx2*nAtoms+aidx];
-                    ++activeIdx2;
-                  }
-                }
-                ++activeIdx;
-              }
-            }
+        std::vector<RankAtoms::CONNECTION> connections;
+        for(unsigned int bidx=0;bidx<bondsToUse.size();++bidx){
+          if(!bondsToUse[bidx]) continue;
+          const Bond *bond=mol.getBondWithIdx(bidx);
+          int tidx1=activeIndices[bond->getBeginAtomIdx()];
+          int tidx2=activeIndices[bond->getEndAtomIdx()];
+          if(tidx1<0 || tidx2<0) continue;
+          if(bondSymbols){
+            connections.push_back(RankAtoms::CONNECTION(tidx1,tidx2,branks[bidx]));
+            connections.push_back(RankAtoms::CONNECTION(tidx2,tidx1,branks[bidx]));
           } else {
-            // rank the bond symbols we have:
-            std::vector<boost::uint32_t> tbranks(bondsToUse.size(),
-                                                 0);
-            for(unsigned int bidx=0;bidx<bondsToUse.size();++bidx){
-              if(!bondsToUse[bidx]) continue;
-              const Bond *bond=mol.getBondWithIdx(bidx);
-              const std::string &symb=(*bondSymbols)[bidx];
-              boost::uint32_t hsh=gboost::hash_range(symb.begin(),symb.end());
-              tbranks[bidx]=hsh;
-            }
-            INT_VECT branks(bondsToUse.size(),1000000);
-#ifdef VERBOSE_CANON
-            std::cerr<<"  tbranks:";
-            std::copy(tbranks.begin(),tbranks.end(),std::ostream_iterator<boost::uint32_t>(std::cerr," "));
-            std::cerr<<std::endl;
-#endif            
-            RankAtoms::rankVect(tbranks,branks);
-#ifdef VERBOSE_CANON
-            std::cerr<<"  branks:";
-            std::copy(branks.begin(),branks.end(),std::ostream_iterator<int>(std::cerr," "));
-            std::cerr<<std::endl;
-#endif            
-            for(unsigned int bidx=0;bidx<bondsToUse.size();++bidx){
-              if(!bondsToUse[bidx]) continue;
-              const Bond *bond=mol.getBondWithIdx(bidx);
-              unsigned int aidx1=bond->getBeginAtomIdx();
-              unsigned int aidx2=bond->getEndAtomIdx();
-              unsigned int tidx1=0;
-              for(unsigned int iidx=0;iidx<aidx1;++iidx){
-                if(atomsToUse[iidx]) ++tidx1;
-              }
-              unsigned int tidx2=0;
-              for(unsigned int iidx=0;iidx<aidx2;++iidx){
-                if(atomsToUse[iidx]) ++tidx2;
-              }
-              const std::string &symb=(*bondSymbols)[bidx];
-              boost::uint32_t hsh=gboost::hash_range(symb.begin(),symb.end());
-              //std::cerr<<" ::: "<<bidx<<"->"<<branks[bidx]<<std::endl;
-              tadjMat[tidx1*nActiveAtoms+tidx2]=branks[bidx];
-              tadjMat[tidx2*nActiveAtoms+tidx1]=branks[bidx];
-            }
+            connections.push_back(RankAtoms::CONNECTION(tidx1,tidx2,
+                                                        bond->getValenceContrib(bond->getBeginAtom())));
+            connections.push_back(RankAtoms::CONNECTION(tidx2,tidx1,
+                                                        bond->getValenceContrib(bond->getEndAtom())));
           }
-          INT_VECT primeVect;
-          primeVect.reserve(nActiveAtoms);
-
-          DOUBLE_VECT atomicVect;
-          atomicVect.reserve(nActiveAtoms);
-
-#ifdef VERBOSE_CANON
-          for(unsigned int aidx1=0;aidx1<nActiveAtoms;++aidx1){
-            std::cerr<<aidx1<<" : ";
-            for(unsigned int aidx2=aidx1+1;aidx2<nActiveAtoms;++aidx2){
-              std::cerr<< tadjMat[aidx1*nActiveAtoms+aidx2]<<" ";
-            }
-            std::cerr<<std::endl;
-          }
-#endif
-      
-          // indicesInPlay is used to track the atoms with non-unique ranks
-          //  (we'll be modifying these in each step)
-          INT_LIST indicesInPlay;
-          for(unsigned int i=0;i<nActiveAtoms;i++) indicesInPlay.push_back(i);
-
-          // if we aren't breaking ties here, allow the rank iteration to
-          // go the full number of atoms:
-          if(!breakTies) stagnantTol=nActiveAtoms;
-
-          bool done=indicesInPlay.empty();
-          while(!done){
-            //
-            // do one round of iterations
-            //
-            numClasses = RankAtoms::iterateRanks2(nActiveAtoms,primeVect,atomicVect,
-                                                  indicesInPlay,tadjMat,tranks,nRanks,
-                                                  rankHistory,stagnantTol);
+        }
+        UINT_VECT nbrStarts,nbrs;
+        DOUBLE_VECT nbrWeights;
+        RankAtoms::buildNeighborLists(nActiveAtoms,connections,nbrStarts,nbrs,nbrWeights);
 
-#ifdef VERBOSE_CANON
-            BOOST_LOG(rdDebugLog)<< "************************ done outer iteration" << std::endl;
-#endif  
-#ifdef VERBOSE_CANON
-            BOOST_LOG(rdDebugLog)<< "RANKS:" << std::endl;
-            for(unsigned int tmpI=0;tmpI<tranks.size();tmpI++){
-              BOOST_LOG(rdDebugLog)<< "\t\t" << tmpI << " " << tranks[tmpI] << std::endl;
-            }
-            BOOST_LOG(rdDebugLog)<< std::endl;
-#endif    
-            //
-            // This is the tiebreaker stage of things
-            //
-            if( breakTies && !indicesInPlay.empty() && numClasses<nActiveAtoms){
-              INT_VECT newRanks = tranks;
-
-              // Add one to all ranks and multiply by two
-              std::for_each(newRanks.begin(),newRanks.end(),_1=(_1+1)*2);
-#ifdef VERBOSE_CANON
-              BOOST_LOG(rdDebugLog)<< "postmult:" << std::endl;
-              for(unsigned tmpI=0;tmpI<newRanks.size();tmpI++){
-                BOOST_LOG(rdDebugLog)<< "\t\t" << newRanks[tmpI] << std::endl;
-              }
-              BOOST_LOG(rdDebugLog)<< std::endl;
-#endif    
+        INT_VECT tranks(nActiveAtoms,0);
+        RankAtoms::refineRanks(nActiveAtoms,tinvariants,nbrStarts,nbrs,nbrWeights,
+                               breakTies,tranks);
 
-              //
-              // find lowest duplicate rank with lowest invariant:
-              //
-              int lowestIdx=indicesInPlay.front();
-              double lowestInvariant = tinvariants[lowestIdx];
-              int lowestRank=newRanks[lowestIdx];
-              for(INT_LIST_I ilIt=indicesInPlay.begin();
-                  ilIt!=indicesInPlay.end();
-                  ++ilIt){
-                if(newRanks[*ilIt]<=lowestRank){
-                  if(newRanks[*ilIt]<lowestRank ||
-                     tinvariants[*ilIt] <= lowestInvariant){
-                    lowestRank = newRanks[*ilIt];
-                    lowestIdx = *ilIt;
-                    lowestInvariant = tinvariants[*ilIt];
-                  }
-                }
-              }
-
-              //
-              // subtract one from the lowest index, rerank and proceed
-              //
-              newRanks[lowestIdx] -= 1;
-              RankAtoms::rankVect(newRanks,tranks);
-              BOOST_FOREACH(int ilidx,indicesInPlay){
-                nRanks[ilidx].push_back(ranks[ilidx]);
-              }
-#ifdef VERBOSE_CANON
-              BOOST_LOG(rdDebugLog)<< "RE-RANKED ON:" << lowestIdx << std::endl;
-              for(unsigned int tmpI=0;tmpI<newRanks.size();tmpI++){
-                BOOST_LOG(rdDebugLog)<< "\t\t" << newRanks[tmpI] << " " << tranks[tmpI] << std::endl;
-              }
-              BOOST_LOG(rdDebugLog)<< std::endl;
-#endif    
-            } else {
-              done = true;
-            }
-          }
-          delete [] tadjMat;
-        }
         unsigned int tidx=0;
         for(unsigned int aidx=0;aidx<nAtoms;++aidx){
           ranks[aidx]=0;
@@ -28,6 +28,33 @@ namespace RankAtoms {
   //! utility function for ranking atoms
   void updateInPlayIndices(const INT_VECT &ranks,INT_LIST &indicesInPlay);
 
+  //! ranks atoms by iterative refinement of the partition given by their invariants
+  /*!
+    The classes of equivalent atoms are split using the ranks of the
+    atoms' neighbors until no further progress is made. If \c breakTies
+    is set, the lowest ranked atom of the lowest class with more than one
+    member is then split off and the refinement continues until all
+    ranks are unique.
+
+    \param nAtoms       the number of atoms
+    \param invariants   the atom invariants, these determine the initial ranks
+    \param nbrStarts    the neighbors of atom \c i are in positions \c nbrStarts[i] to
+                        \c nbrStarts[i+1]-1 of \c nbrs, sorted by index.
+                        Must have \c nAtoms+1 entries.
+    \param nbrs         the neighbor indices
+    \param nbrWeights   the weights (bond orders) of the connections to the neighbors
+    \param breakTies    toggles breaking ties between equivalent atoms
+    \param ranks        used to return the ranks, these are dense (0 to \c nClasses-1)
+    \param rankHistory  (optional) used to return the ranks of the atoms in play
+                        at each iteration
+  */
+  void refineRanks(unsigned int nAtoms,const std::vector<double> &invariants,
+                   const std::vector<unsigned int> &nbrStarts,
+                   const std::vector<unsigned int> &nbrs,
+                   const std::vector<double> &nbrWeights,
+                   bool breakTies,INT_VECT &ranks,
+                   std::vector<INT_VECT> *rankHistory=0);
+
   //! returns the count of unique items in an std::vector
   template <typename T>
   unsigned int countClasses(const std::vector<T> &vect){
@@ -110,58 +137,53 @@ namespace RankAtoms {
     //
     // --------------
     INT_VECT newRanks(vals.size());
+    if(vals.empty()) return;
     rankVect(vals,newRanks);
 
     // --------------
     //  
-    // At the end of this operation, ranks will contain the ranks
-    // of atoms that are no longer active (-1 for active atoms).
+    // The ranks of atoms that are no longer active are left alone,
+    // collect them (the active atoms get -1):
     //
     // --------------
     BOOST_FOREACH(int idx,indicesInPlay){
       ranks[idx] = -1;
     }
-
-    INT_VECT idxVect;
-    idxVect.assign(indicesInPlay.begin(),indicesInPlay.end());
+    INT_VECT takenRanks;
+    takenRanks.reserve(ranks.size());
+    BOOST_FOREACH(int rank,ranks){
+      if(rank>=0) takenRanks.push_back(rank);
+    }
+    std::sort(takenRanks.begin(),takenRanks.end());
 
     // -------------
     //
-    //  Loop over all the new ranks.  We'll know that we're done
-    //  when currNewRank > maxNewRank
+    //  Loop over the new ranks in order. Each one is moved up
+    //  (along with all higher new ranks) past any values that
+    //  are already taken.
     //
     // -------------
-
-    int currNewRank= *(std::min_element(newRanks.begin(),newRanks.end()));
     int maxNewRank = *(std::max_element(newRanks.begin(),newRanks.end()));
-    while(currNewRank<=maxNewRank){
-      //
-      // If this rank is already present in ranks, increment
-      //  this rank and all new ranks that are higher:
-      //
-      while(std::find(ranks.begin(),ranks.end(),currNewRank)!=ranks.end()){
-        BOOST_FOREACH(int &rank,newRanks){
-          if(rank>=currNewRank)
-            ++rank;
-        }
-        // increment both the current rank *and* the maximum new rank
-        ++currNewRank;
-        ++maxNewRank;
+    INT_VECT finalRanks(maxNewRank+1);
+    INT_VECT::const_iterator takenIt=takenRanks.begin();
+    int offset=0;
+    for(int currNewRank=0;currNewRank<=maxNewRank;++currNewRank){
+      int rank=currNewRank+offset;
+      while(takenIt!=takenRanks.end() && *takenIt<rank) ++takenIt;
+      while(takenIt!=takenRanks.end() && *takenIt==rank){
+        ++rank;
+        ++offset;
+        while(takenIt!=takenRanks.end() && *takenIt<rank) ++takenIt;
       }
+      finalRanks[currNewRank]=rank;
+    }
 
-      //
-      //  now grab all entries with this new rank and copy them into
-      //  the ranks list
-      //
-      INT_VECT::iterator ivIt=std::find(newRanks.begin(),newRanks.end(),currNewRank);
-      while(ivIt!=newRanks.end()){
-        int offset=ivIt-newRanks.begin();
-        int idx = idxVect[offset];
-        ranks[idx] = currNewRank;
-        ++ivIt;
-        ivIt=std::find(ivIt,newRanks.end(),currNewRank);
-      }
-      ++currNewRank;
+    //
+    //  now copy the new ranks into the ranks list
+    //
+    unsigned int offsetInPlay=0;
+    BOOST_FOREACH(int idx,indicesInPlay){
+      ranks[idx] = finalRanks[newRanks[offsetInPlay++]];
     }
   }
   template <typename T>
@@ -13,10 +13,29 @@
 #include <algorithm>
 
 namespace RDKit{
+  namespace {
+    const unsigned int maxMaskedSize=31;
+
+    void addToMembers(unsigned int idx,unsigned int sz,
+                      RingInfo::DataType &members,
+                      std::vector<boost::uint32_t> &sizes,
+                      std::vector<unsigned int> &minSizes){
+      if(idx>=members.size()){
+        members.resize(idx+1);
+        sizes.resize(idx+1,0);
+        minSizes.resize(idx+1,0);
+      }
+      members[idx].push_back(sz);
+      if(sz<=maxMaskedSize) sizes[idx] |= (1u<<sz);
+      if(!minSizes[idx] || sz<minSizes[idx]) minSizes[idx]=sz;
+    }
+  }
+
   bool RingInfo::isAtomInRingOfSize(unsigned int idx,unsigned int size) const {
     PRECONDITION(df_init,"RingInfo not initialized");
     PRECONDITION(idx>=0,"bad index");
     if( idx < d_atomMembers.size() ){
+      if(size<=maxMaskedSize) return d_atomRingSizes[idx] & (1u<<size);
       return std::find(d_atomMembers[idx].begin(),d_atomMembers[idx].end(),
                        static_cast<int>(size))!=d_atomMembers[idx].end();
     } else {
@@ -26,8 +45,8 @@ namespace RDKit{
   unsigned int RingInfo::minAtomRingSize(unsigned int idx) const {
     PRECONDITION(df_init,"RingInfo not initialized");
     PRECONDITION(idx>=0,"bad index");
-    if( idx < d_atomMembers.size() && d_atomMembers[idx].size() ){
-      return *std::min_element(d_atomMembers[idx].begin(),d_atomMembers[idx].end());
+    if( idx < d_atomMinRingSize.size() ){
+      return d_atomMinRingSize[idx];
     } else {
       return 0;
     }
@@ -45,6 +64,7 @@ namespace RDKit{
     PRECONDITION(df_init,"RingInfo not initialized");
     PRECONDITION(idx>=0,"bad index");
     if( idx < d_bondMembers.size() ){
+      if(size<=maxMaskedSize) return d_bondRingSizes[idx] & (1u<<size);
       return std::find(d_bondMembers[idx].begin(),
                        d_bondMembers[idx].end(),
                        static_cast<int>(size))!=d_bondMembers[idx].end();
@@ -56,8 +76,8 @@ namespace RDKit{
   unsigned int RingInfo::minBondRingSize(unsigned int idx) const {
     PRECONDITION(df_init,"RingInfo not initialized");
     PRECONDITION(idx>=0,"bad index");
-    if( idx < d_bondMembers.size() && d_bondMembers[idx].size() ){
-      return *std::min_element(d_bondMembers[idx].begin(),d_bondMembers[idx].end());
+    if( idx < d_bondMinRingSize.size() ){
+      return d_bondMinRingSize[idx];
     } else {
       return 0;
     }
@@ -82,16 +102,14 @@ namespace RDKit{
   unsigned int RingInfo::addRing(const INT_VECT &atomIndices,const INT_VECT &bondIndices){
     PRECONDITION(df_init,"RingInfo not initialized");
     PRECONDITION(atomIndices.size()==bondIndices.size(),"length mismatch");
-    int sz = atomIndices.size();
+    unsigned int sz = atomIndices.size();
     for(INT_VECT::const_iterator i=atomIndices.begin();
 	i<atomIndices.end(); i++){
-      if( *i>=static_cast<int>(d_atomMembers.size()) ) d_atomMembers.resize((*i)+1);
-      d_atomMembers[*i].push_back(sz);
+      addToMembers(*i,sz,d_atomMembers,d_atomRingSizes,d_atomMinRingSize);
     }
     for(INT_VECT::const_iterator i=bondIndices.begin();
 	i<bondIndices.end(); i++){
-      if( *i>=static_cast<int>(d_bondMembers.size()) ) d_bondMembers.resize((*i)+1);
-      d_bondMembers[*i].push_back(sz);
+      addToMembers(*i,sz,d_bondMembers,d_bondRingSizes,d_bondMinRingSize);
     }
     d_atomRings.push_back(atomIndices);
     d_bondRings.push_back(bondIndices);
@@ -99,20 +117,31 @@ namespace RDKit{
     return d_atomRings.size();
   }
 
-  void RingInfo::initialize() {
+  void RingInfo::initialize(PerceptionType type) {
     PRECONDITION(!df_init,"already initialized");
+    PRECONDITION(type!=UNINITIALIZED,"bad perception type");
     df_init=true;
+    d_perceptionType=type;
   };
   void RingInfo::reset(){
     if(!df_init) return;
     df_init=false;
+    d_perceptionType=UNINITIALIZED;
     d_atomMembers.clear();
     d_bondMembers.clear();
     d_atomRings.clear();
     d_bondRings.clear();
+    d_atomRingSizes.clear();
+    d_bondRingSizes.clear();
+    d_atomMinRingSize.clear();
+    d_bondMinRingSize.clear();
   }
   void RingInfo::preallocate(unsigned int numAtoms,unsigned int numBonds){
     d_atomMembers.resize(numAtoms);
+    d_atomRingSizes.resize(numAtoms,0);
+    d_atomMinRingSize.resize(numAtoms,0);
     d_bondMembers.resize(numBonds);
+    d_bondRingSizes.resize(numBonds,0);
+    d_bondMinRingSize.resize(numBonds,0);
   }
 }
@@ -12,11 +12,19 @@
 
 #include <map>
 #include <vector>
+#include <boost/cstdint.hpp>
 
 namespace RDKit {
   //! A class to store information about a molecule's rings
   /*!
-
+    In addition to the rings themselves, a bit mask of the sizes of the
+    rings each atom and bond is in and the size of its smallest ring are
+    stored, so the per-atom and per-bond queries take constant time.
+
+    The type of ring perception that was used to fill the object is
+    recorded (see getPerceptionType()), this allows ring perception to be
+    done on demand with only as much work as the caller needs
+    (see MolOps::findRingsIfNeeded()).
    */
   class RingInfo {
     friend class MolPickler;
@@ -26,17 +34,38 @@ namespace RDKit {
     typedef std::vector<int> INT_VECT;
     typedef std::vector< INT_VECT > VECT_INT_VECT;
 
-    RingInfo() : df_init(false) {};
+    //! the kinds of ring information we can hold
+    /*!
+      The values are ordered by the amount of information available.
+    */
+    typedef enum {
+      UNINITIALIZED=0, //!< no ring perception has been done
+      MEMBERSHIP,      //!< only whether or not atoms and bonds are in rings is
+                       //!<  reliable (MolOps::fastFindRings())
+      SSSR             //!< the smallest set of smallest rings (MolOps::findSSSR())
+    } PerceptionType;
+
+    RingInfo() : df_init(false), d_perceptionType(UNINITIALIZED) {};
     RingInfo(const RingInfo &other) : df_init(other.df_init),
+                                      d_perceptionType(other.d_perceptionType),
 				      d_atomMembers(other.d_atomMembers),
 				      d_bondMembers(other.d_bondMembers),
 				      d_atomRings(other.d_atomRings),
-				      d_bondRings(other.d_bondRings) {};
+				      d_bondRings(other.d_bondRings),
+                                      d_atomRingSizes(other.d_atomRingSizes),
+                                      d_bondRingSizes(other.d_bondRingSizes),
+                                      d_atomMinRingSize(other.d_atomMinRingSize),
+                                      d_bondMinRingSize(other.d_bondMinRingSize) {};
     
     //! checks to see if we've been properly initialized
     bool isInitialized() const { return df_init; };
     //! does initialization
-    void initialize();
+    /*!
+      \param type  the kind of ring information that is going to be added
+    */
+    void initialize(PerceptionType type=SSSR);
+    //! returns the kind of ring information we hold
+    PerceptionType getPerceptionType() const { return d_perceptionType; };
 
     //! blows out all current data and de-initializes
     void reset();
@@ -130,8 +159,13 @@ namespace RDKit {
     void preallocate(unsigned int numAtoms,unsigned int numBonds);
 
     bool df_init;
+    PerceptionType d_perceptionType;
     DataType d_atomMembers,d_bondMembers;
     VECT_INT_VECT d_atomRings,d_bondRings;
+    // bit n is set if the atom (bond) is in a ring of size n, rings
+    // with more than 31 members are only in the member lists:
+    std::vector<boost::uint32_t> d_atomRingSizes,d_bondRingSizes;
+    std::vector<unsigned int> d_atomMinRingSize,d_bondMinRingSize;
   };
 }
 
@@ -0,0 +1,351 @@
+//
+//   Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include "GaussianShape.h"
+#include <Geometry/Transform3D.h>
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/MolTransforms/MolTransforms.h>
+#include <Numerics/Alignment/AlignPoints.h>
+#include <Numerics/Optimizer/BFGSOpt.h>
+#include <RDGeneral/Invariant.h>
+#include <math.h>
+#include <algorithm>
+
+namespace RDKit {
+  namespace MolShapes {
+    namespace {
+      // the Gaussian amplitude and the exponent factor that gives each
+      // Gaussian the volume of its atom's vdW sphere:
+      const double GAUSSIAN_P=2.0*sqrt(2.0);
+      const double GAUSSIAN_KAPPA=2.41798;
+
+      double pairOverlap(double a1,double a2,double d2,double &expTerm){
+        double sum=a1+a2;
+        expTerm=a1*a2/sum;
+        double res=GAUSSIAN_P*GAUSSIAN_P*pow(M_PI/sum,1.5)*exp(-expTerm*d2);
+        return res;
+      }
+
+      double selfOverlap(const RDGeom::POINT3D_VECT &centers,const std::vector<double> &alphas){
+        double res=0.0,expTerm;
+        for(unsigned int i=0;i<centers.size();++i){
+          res += pairOverlap(alphas[i],alphas[i],0.0,expTerm);
+          for(unsigned int j=0;j<i;++j){
+            double d2=(centers[i]-centers[j]).lengthSq();
+            res += 2.0*pairOverlap(alphas[i],alphas[j],d2,expTerm);
+          }
+        }
+        return res;
+      }
+
+      // the rotation matrix of the (not necessarily normalized) quaternion q,
+      // and its derivatives with respect to the components of q:
+      void quaternionRotation(const double *q,double rot[3][3],double dRot[4][3][3]){
+        double w=q[0],x=q[1],y=q[2],z=q[3];
+        double n=w*w+x*x+y*y+z*z;
+        double m[3][3]={{w*w+x*x-y*y-z*z,2*(x*y-w*z),2*(x*z+w*y)},
+                        {2*(x*y+w*z),w*w-x*x+y*y-z*z,2*(y*z-w*x)},
+                        {2*(x*z-w*y),2*(y*z+w*x),w*w-x*x-y*y+z*z}};
+        double dm[4][3][3]={{{w,-z,y},{z,w,-x},{-y,x,w}},
+                            {{x,y,z},{y,-x,-w},{z,w,-x}},
+                            {{-y,x,w},{x,y,z},{-w,z,-y}},
+                            {{-z,-w,x},{w,-z,y},{x,y,z}}};
+        for(unsigned int a=0;a<3;++a){
+          for(unsigned int b=0;b<3;++b){
+            rot[a][b]=m[a][b]/n;
+            for(unsigned int k=0;k<4;++k){
+              dRot[k][a][b]=2.0*dm[k][a][b]/n - 2.0*q[k]*m[a][b]/(n*n);
+            }
+          }
+        }
+      }
+
+      double overlapVolume(const RDGeom::POINT3D_VECT &centers1,const std::vector<double> &alphas1,
+                           const RDGeom::POINT3D_VECT &centers2,const std::vector<double> &alphas2,
+                           RDGeom::POINT3D_VECT *grad){
+        if(grad){
+          grad->resize(centers2.size());
+          std::fill(grad->begin(),grad->end(),RDGeom::Point3D(0,0,0));
+        }
+        double res=0.0,expTerm;
+        for(unsigned int j=0;j<centers2.size();++j){
+          const RDGeom::Point3D &pj=centers2[j];
+          for(unsigned int i=0;i<centers1.size();++i){
+            RDGeom::Point3D delta=pj-centers1[i];
+            double vij=pairOverlap(alphas1[i],alphas2[j],delta.lengthSq(),expTerm);
+            res += vij;
+            if(grad){
+              delta *= -2.0*expTerm*vij;
+              (*grad)[j] += delta;
+            }
+          }
+        }
+        return res;
+      }
+
+      // The function minimized to align a probe shape to a reference. The
+      // parameters are a quaternion for the rotation about the probe's
+      // centroid followed by a translation. The overlap is normalized by the
+      // average self overlap and a penalty keeps the quaternion near unit
+      // length, this doesn't change the rotation.
+      class OverlapFunctor {
+      public:
+        OverlapFunctor(const GaussianShape &ref,const GaussianShape &probe) :
+          dp_ref(&ref), dp_probe(&probe), d_centroid(probe.getCentroid()) {
+          d_scale=2.0/(ref.getSelfOverlap()+probe.getSelfOverlap());
+        };
+
+        double operator()(double *v) const {
+          RDGeom::POINT3D_VECT moved;
+          double dRot[4][3][3];
+          placeProbe(v,moved,dRot);
+          return -d_scale*overlapVolume(dp_ref->getCenters(),dp_ref->getAlphas(),
+                                        moved,dp_probe->getAlphas(),0) + penalty(v);
+        }
+
+        double calcGrad(double *v,double *grad) const {
+          RDGeom::POINT3D_VECT moved,pointGrads;
+          double dRot[4][3][3];
+          placeProbe(v,moved,dRot);
+          overlapVolume(dp_ref->getCenters(),dp_ref->getAlphas(),
+                        moved,dp_probe->getAlphas(),&pointGrads);
+
+          // chain rule from the gradients on the points to the parameters:
+          const RDGeom::POINT3D_VECT &centers=dp_probe->getCenters();
+          double g[3][3]={{0,0,0},{0,0,0},{0,0,0}};
+          RDGeom::Point3D tGrad(0,0,0);
+          for(unsigned int i=0;i<centers.size();++i){
+            const RDGeom::Point3D &pg=pointGrads[i];
+            RDGeom::Point3D p=centers[i]-d_centroid;
+            tGrad += pg;
+            for(unsigned int a=0;a<3;++a){
+              g[a][0] += pg[a]*p.x;
+              g[a][1] += pg[a]*p.y;
+              g[a][2] += pg[a]*p.z;
+            }
+          }
+          double n=v[0]*v[0]+v[1]*v[1]+v[2]*v[2]+v[3]*v[3]-1.0;
+          for(unsigned int k=0;k<4;++k){
+            double accum=0.0;
+            for(unsigned int a=0;a<3;++a){
+              for(unsigned int b=0;b<3;++b){
+                accum += dRot[k][a][b]*g[a][b];
+              }
+            }
+            grad[k] = -d_scale*accum + 4.0*n*v[k];
+          }
+          grad[4] = -d_scale*tGrad.x;
+          grad[5] = -d_scale*tGrad.y;
+          grad[6] = -d_scale*tGrad.z;
+          return 1.0;
+        }
+
+        // the transform corresponding to a set of parameters:
+        void getTransform(const double *v,RDGeom::Transform3D &trans) const {
+          double rot[3][3],dRot[4][3][3];
+          quaternionRotation(v,rot,dRot);
+          trans.setToIdentity();
+          double *data=trans.getData();
+          for(unsigned int a=0;a<3;++a){
+            for(unsigned int b=0;b<3;++b){
+              data[a*4+b]=rot[a][b];
+            }
+            data[a*4+3]=d_centroid[a]+v[4+a]-
+              (rot[a][0]*d_centroid.x+rot[a][1]*d_centroid.y+rot[a][2]*d_centroid.z);
+          }
+        }
+
+      private:
+        const GaussianShape *dp_ref,*dp_probe;
+        RDGeom::Point3D d_centroid;
+        double d_scale;
+
+        void placeProbe(const double *v,RDGeom::POINT3D_VECT &moved,double dRot[4][3][3]) const {
+          double rot[3][3];
+          quaternionRotation(v,rot,dRot);
+          const RDGeom::POINT3D_VECT &centers=dp_probe->getCenters();
+          moved.resize(centers.size());
+          for(unsigned int i=0;i<centers.size();++i){
+            RDGeom::Point3D p=centers[i]-d_centroid;
+            moved[i].x=rot[0][0]*p.x+rot[0][1]*p.y+rot[0][2]*p.z+d_centroid.x+v[4];
+            moved[i].y=rot[1][0]*p.x+rot[1][1]*p.y+rot[1][2]*p.z+d_centroid.y+v[5];
+            moved[i].z=rot[2][0]*p.x+rot[2][1]*p.y+rot[2][2]*p.z+d_centroid.z+v[6];
+          }
+        }
+        double penalty(const double *v) const {
+          double n=v[0]*v[0]+v[1]*v[1]+v[2]*v[2]+v[3]*v[3]-1.0;
+          return n*n;
+        }
+      };
+
+      // BFGSOpt wants separate functors for the function and gradient:
+      class OverlapGradFunctor {
+      public:
+        OverlapGradFunctor(const OverlapFunctor &func) : dp_func(&func) {};
+        double operator()(double *v,double *grad) const {
+          return dp_func->calcGrad(v,grad);
+        }
+      private:
+        const OverlapFunctor *dp_func;
+      };
+      double axesDeterminant(const RDGeom::Transform3D &trans){
+        RDGeom::Point3D ax0(trans.getVal(0,0),trans.getVal(0,1),trans.getVal(0,2));
+        RDGeom::Point3D ax1(trans.getVal(1,0),trans.getVal(1,1),trans.getVal(1,2));
+        RDGeom::Point3D ax2(trans.getVal(2,0),trans.getVal(2,1),trans.getVal(2,2));
+        return ax0.crossProduct(ax1).dotProduct(ax2);
+      }
+    } // end of anonymous namespace
+
+    GaussianShape::GaussianShape(const Conformer &conf, bool ignoreHs,
+                                 const RDGeom::Transform3D *trans) {
+      const ROMol &mol = conf.getOwningMol();
+      for (ROMol::ConstAtomIterator ai = mol.beginAtoms(); ai != mol.endAtoms(); ++ai) {
+        unsigned int anum = (*ai)->getAtomicNum();
+        if ((anum == 1) && (ignoreHs)) {
+          continue;
+        }
+        RDGeom::Point3D loc = conf.getAtomPos((*ai)->getIdx());
+        if (trans) {
+          trans->TransformPoint(loc);
+        }
+        double rad = PeriodicTable::getTable()->getRvdw(anum);
+        d_centers.push_back(loc);
+        d_alphas.push_back(GAUSSIAN_KAPPA/(rad*rad));
+      }
+      d_selfOverlap = selfOverlap(d_centers, d_alphas);
+    }
+
+    RDGeom::Point3D GaussianShape::getCentroid() const {
+      RDGeom::Point3D res(0,0,0);
+      if (!d_centers.size()) return res;
+      for (RDGeom::POINT3D_VECT_CI pi = d_centers.begin(); pi != d_centers.end(); ++pi) {
+        res += *pi;
+      }
+      res /= d_centers.size();
+      return res;
+    }
+
+    void GaussianShape::transform(const RDGeom::Transform3D &trans) {
+      for (RDGeom::POINT3D_VECT_I pi = d_centers.begin(); pi != d_centers.end(); ++pi) {
+        trans.TransformPoint(*pi);
+      }
+    }
+
+    double gaussianOverlapVolume(const GaussianShape &shape1, const GaussianShape &shape2,
+                                 RDGeom::POINT3D_VECT *grad) {
+      return overlapVolume(shape1.getCenters(), shape1.getAlphas(),
+                           shape2.getCenters(), shape2.getAlphas(), grad);
+    }
+
+    double gaussianTanimotoDistance(const GaussianShape &shape1, const GaussianShape &shape2) {
+      double overlap = gaussianOverlapVolume(shape1, shape2);
+      double denom = shape1.getSelfOverlap() + shape2.getSelfOverlap() - overlap;
+      if (denom <= 0.0) return 0.0;
+      return 1.0 - overlap/denom;
+    }
+
+    double gaussianTanimotoDistance(const ROMol &mol1, const ROMol &mol2,
+                                    int confId1, int confId2, bool ignoreHs) {
+      GaussianShape shape1(mol1.getConformer(confId1), ignoreHs);
+      GaussianShape shape2(mol2.getConformer(confId2), ignoreHs);
+      return gaussianTanimotoDistance(shape1, shape2);
+    }
+
+    double optimizeGaussianOverlap(const GaussianShape &refShape, const GaussianShape &probeShape,
+                                   RDGeom::Transform3D &trans, unsigned int maxIts) {
+      GaussianShape start(probeShape);
+      start.transform(trans);
+      if (!start.getNumGaussians() || !refShape.getNumGaussians()) {
+        return gaussianTanimotoDistance(refShape, start);
+      }
+
+      OverlapFunctor func(refShape, start);
+      OverlapGradFunctor gradFunc(func);
+      double params[7] = {1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+      unsigned int numIters = 0;
+      double funcVal;
+      BFGSOpt::minimize(7, params, 1e-4, numIters, funcVal, func, gradFunc,
+                        BFGSOpt::TOLX, maxIts);
+
+      RDGeom::Transform3D step;
+      func.getTransform(params, step);
+      trans.assign(step*trans);
+
+      GaussianShape res(probeShape);
+      res.transform(trans);
+      return gaussianTanimotoDistance(refShape, res);
+    }
+
+    double alignGaussianShapes(const ROMol &refMol, ROMol &probeMol,
+                               int refConfId, int probeConfId, bool ignoreHs,
+                               unsigned int maxIts, RDGeom::Transform3D *trans) {
+      const Conformer &refConf = refMol.getConformer(refConfId);
+      Conformer &probeConf = probeMol.getConformer(probeConfId);
+      GaussianShape refShape(refConf, ignoreHs);
+      GaussianShape probeShape(probeConf, ignoreHs);
+
+      // the starting points are the current position of the probe and the
+      // alignments of its principal axes onto those of the reference,
+      // the axes are represented by points so that AlignPoints can
+      // generate the transforms:
+      std::vector<RDGeom::Transform3D> seeds(1);
+      if (refShape.getNumGaussians() > 1 && probeShape.getNumGaussians() > 1) {
+        RDGeom::Point3D refCentroid = refShape.getCentroid();
+        RDGeom::Point3D probeCentroid = probeShape.getCentroid();
+        RDGeom::Transform3D *refCanon =
+          MolTransforms::computeCanonicalTransform(refConf, &refCentroid, false, ignoreHs);
+        RDGeom::Transform3D *probeCanon =
+          MolTransforms::computeCanonicalTransform(probeConf, &probeCentroid, false, ignoreHs);
+        // the signs of the principal axes are arbitrary, make sure the two
+        // sets of axes have the same handedness so that only proper
+        // rotations are needed to overlay them:
+        double signs[4][3] = {{1, 1, 1}, {1, -1, -1}, {-1, 1, -1}, {-1, -1, 1}};
+        if (axesDeterminant(*refCanon)*axesDeterminant(*probeCanon) < 0) {
+          for (unsigned int s = 0; s < 4; ++s) {
+            signs[s][2] *= -1;
+          }
+        }
+        RDGeom::POINT3D_VECT refAxes(4, refCentroid), probeAxes(4, probeCentroid);
+        for (unsigned int s = 0; s < 4; ++s) {
+          RDGeom::Point3DConstPtrVect refPts, probePts;
+          for (unsigned int a = 0; a < 3; ++a) {
+            for (unsigned int b = 0; b < 3; ++b) {
+              refAxes[a+1][b] = refCentroid[b] + signs[s][a]*refCanon->getVal(a, b);
+              probeAxes[a+1][b] = probeCentroid[b] + probeCanon->getVal(a, b);
+            }
+          }
+          for (unsigned int a = 0; a < 4; ++a) {
+            refPts.push_back(&refAxes[a]);
+            probePts.push_back(&probeAxes[a]);
+          }
+          RDGeom::Transform3D seed;
+          RDNumeric::Alignments::AlignPoints(refPts, probePts, seed);
+          seeds.push_back(seed);
+        }
+        delete refCanon;
+        delete probeCanon;
+      }
+
+      double bestDist = 2.0;
+      RDGeom::Transform3D bestTrans;
+      for (unsigned int i = 0; i < seeds.size(); ++i) {
+        double dist = optimizeGaussianOverlap(refShape, probeShape, seeds[i], maxIts);
+        if (dist < bestDist) {
+          bestDist = dist;
+          bestTrans.assign(seeds[i]);
+        }
+      }
+      MolTransforms::transformConformer(probeConf, bestTrans);
+      if (trans) {
+        trans->assign(bestTrans);
+      }
+      return bestDist;
+    }
+  }
+}
@@ -0,0 +1,127 @@
+//
+//   Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_GAUSSIAN_SHAPE_H_
+#define _RD_GAUSSIAN_SHAPE_H_
+#include <Geometry/point.h>
+#include <vector>
+
+namespace RDGeom {
+  class Transform3D;
+}
+
+namespace RDKit {
+  class ROMol;
+  class Conformer;
+
+  namespace MolShapes {
+    //! The shape of a conformer represented as a set of atom-centered Gaussians
+    /*!
+      Each atom contributes a Gaussian \c p*exp(-alpha*r^2) with
+      \c p=2*sqrt(2) and \c alpha chosen so that the volume of the Gaussian is
+      that of the atom's van der Waals sphere, see:
+        J.A. Grant, B.T. Pickup, J. Phys. Chem. 99:3503-3510 (1995)
+
+      Overlap volumes are computed directly from the atom positions using the
+      first-order (pairwise) approximation, so no grid is needed.
+    */
+    class GaussianShape {
+    public:
+      //! Constructor
+      /*!
+        \param conf      the conformer whose shape is to be represented
+        \param ignoreHs  if true, hydrogens do not contribute to the shape
+        \param trans     optional transformation applied to the atom positions
+      */
+      GaussianShape(const Conformer &conf, bool ignoreHs=true,
+                    const RDGeom::Transform3D *trans=0);
+
+      //! returns the number of Gaussians
+      unsigned int getNumGaussians() const { return d_centers.size(); };
+      //! returns the centers of the Gaussians
+      const RDGeom::POINT3D_VECT &getCenters() const { return d_centers; };
+      //! returns the exponents of the Gaussians
+      const std::vector<double> &getAlphas() const { return d_alphas; };
+      //! returns the overlap volume of the shape with itself
+      double getSelfOverlap() const { return d_selfOverlap; };
+      //! returns the centroid of the Gaussian centers
+      RDGeom::Point3D getCentroid() const;
+
+      //! applies a transformation to the shape
+      void transform(const RDGeom::Transform3D &trans);
+
+    private:
+      RDGeom::POINT3D_VECT d_centers;
+      std::vector<double> d_alphas;
+      double d_selfOverlap;
+    };
+
+    //! Compute the Gaussian overlap volume of two shapes
+    /*!
+      \param shape1   the first shape
+      \param shape2   the second shape
+      \param grad     if provided, this is used to return the gradient of the
+                      overlap volume with respect to the centers of \c shape2
+     */
+    double gaussianOverlapVolume(const GaussianShape &shape1, const GaussianShape &shape2,
+                                 RDGeom::POINT3D_VECT *grad=0);
+
+    //! Compute the Gaussian shape tanimoto distance between two shapes
+    //! based on their current alignment
+    double gaussianTanimotoDistance(const GaussianShape &shape1, const GaussianShape &shape2);
+
+    //! Compute the Gaussian shape tanimoto distance between two molecules
+    //! based on a predefined alignment
+    /*!
+      \param mol1     the first molecule of interest
+      \param mol2     the second molecule of interest
+      \param confId1  conformer in the first molecule (defaults to first conformer)
+      \param confId2  conformer in the second molecule (defaults to first conformer)
+      \param ignoreHs if true, hydrogens do not contribute to the shapes
+     */
+    double gaussianTanimotoDistance(const ROMol &mol1, const ROMol &mol2,
+                                    int confId1=-1, int confId2=-1, bool ignoreHs=true);
+
+    //! Optimize the overlap of two shapes over rigid transformations of the probe
+    /*!
+      \param refShape    the reference shape
+      \param probeShape  the shape to be moved
+      \param trans       the starting transformation of the probe, used to return
+                         the optimized transformation
+      \param maxIts      maximum number of iterations of the optimizer
+
+      \return the Gaussian shape tanimoto distance of the optimized alignment
+     */
+    double optimizeGaussianOverlap(const GaussianShape &refShape, const GaussianShape &probeShape,
+                                   RDGeom::Transform3D &trans, unsigned int maxIts=200);
+
+    //! Align a probe molecule to a reference molecule by maximizing their
+    //! Gaussian shape overlap
+    /*!
+      The optimization is started from the current position of the probe and
+      from the four alignments of the probe's principal axes onto those of the
+      reference, the best alignment found is applied to the probe conformer.
+
+      \param refMol      the reference molecule
+      \param probeMol    the molecule to be aligned
+      \param refConfId   conformer in the reference (defaults to first conformer)
+      \param probeConfId conformer in the probe (defaults to first conformer)
+      \param ignoreHs    if true, hydrogens do not contribute to the shapes
+      \param maxIts      maximum number of iterations of the optimizer for each start
+      \param trans       if provided, this is used to return the transformation
+                         applied to the probe
+
+      \return the Gaussian shape tanimoto distance of the aligned molecules
+     */
+    double alignGaussianShapes(const ROMol &refMol, ROMol &probeMol,
+                               int refConfId=-1, int probeConfId=-1, bool ignoreHs=true,
+                               unsigned int maxIts=200, RDGeom::Transform3D *trans=0);
+  }
+}
+#endif
@@ -15,6 +15,10 @@
 #include <Geometry/Transform3D.h>
 #include <GraphMol/MolTransforms/MolTransforms.h>
 #include <Geometry/GridUtils.h>
+#include <algorithm>
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread.hpp>
+#endif
 
 namespace RDKit {
   namespace MolShapes {
@@ -175,6 +179,133 @@ namespace RDKit {
       }
       return res;
     }
+
+    namespace {
+      // the shared data for comparing many probes to one reference:
+      struct ShapeBatch {
+        const RDGeom::UniformGrid3D *refGrid;
+        const std::vector<const Conformer *> *probeConfs;
+        const RDGeom::Transform3D *trans;
+        RDGeom::Point3D dims, offset;
+        double gridSpacing;
+        DiscreteValueVect::DiscreteValueType bitsPerPoint;
+        double vdwScale, stepSize;
+        int maxLayers;
+        bool ignoreHs;
+        bool protrude, allowReordering;
+        std::vector<double> *res;
+      };
+
+      void compareShapes(const ShapeBatch *batch, unsigned int start, unsigned int step) {
+        const RDGeom::UniformGrid3D &refGrid = *(batch->refGrid);
+        for (unsigned int i = start; i < batch->probeConfs->size(); i += step) {
+          RDGeom::UniformGrid3D grd(batch->dims.x, batch->dims.y, batch->dims.z,
+                                    batch->gridSpacing, batch->bitsPerPoint, &batch->offset);
+          EncodeShape(*(*batch->probeConfs)[i], grd, batch->trans, batch->vdwScale,
+                      batch->stepSize, batch->maxLayers, batch->ignoreHs);
+          double val;
+          if (!batch->protrude) {
+            val = RDGeom::tanimotoDistance(refGrid, grd);
+          } else if (batch->allowReordering &&
+                     ( grd.getOccupancyVect()->getTotalVal() <
+                       refGrid.getOccupancyVect()->getTotalVal() ) ) {
+            val = RDGeom::protrudeDistance(grd, refGrid);
+          } else {
+            val = RDGeom::protrudeDistance(refGrid, grd);
+          }
+          (*batch->res)[i] = val;
+        }
+      }
+
+      void compareShapesToReference(const Conformer &refConf,
+                                    const std::vector<const Conformer *> &probeConfs,
+                                    std::vector<double> &res, double gridSpacing,
+                                    DiscreteValueVect::DiscreteValueType bitsPerPoint,
+                                    double vdwScale, double stepSize, int maxLayers,
+                                    bool ignoreHs, bool protrude, bool allowReordering,
+                                    unsigned int numThreads) {
+        res.clear();
+        res.resize(probeConfs.size(), 0.0);
+        if (probeConfs.empty()) {
+          return;
+        }
+        RDGeom::Transform3D *trans = MolTransforms::computeCanonicalTransform(refConf);
+
+        // the grid has to hold the reference and all the probes:
+        RDGeom::Point3D uLeftBottom, uRightTop, leftBottom, rightTop;
+        computeConfBox(refConf, uLeftBottom, uRightTop, trans);
+        for (unsigned int i = 0; i < probeConfs.size(); ++i) {
+          PRECONDITION(probeConfs[i], "bad conformer");
+          computeConfBox(*probeConfs[i], leftBottom, rightTop, trans);
+          computeUnionBox(leftBottom, rightTop, uLeftBottom, uRightTop, uLeftBottom, uRightTop);
+        }
+        uRightTop -= uLeftBottom; // uRightTop now has grid dimensions
+
+        // the reference is only encoded once:
+        RDGeom::UniformGrid3D refGrid(uRightTop.x, uRightTop.y, uRightTop.z, gridSpacing,
+                                      bitsPerPoint, &uLeftBottom);
+        EncodeShape(refConf, refGrid, trans, vdwScale, stepSize, maxLayers, ignoreHs);
+
+        ShapeBatch batch;
+        batch.refGrid = &refGrid;
+        batch.probeConfs = &probeConfs;
+        batch.trans = trans;
+        batch.dims = uRightTop;
+        batch.offset = uLeftBottom;
+        batch.gridSpacing = gridSpacing;
+        batch.bitsPerPoint = bitsPerPoint;
+        batch.vdwScale = vdwScale;
+        batch.stepSize = stepSize;
+        batch.maxLayers = maxLayers;
+        batch.ignoreHs = ignoreHs;
+        batch.protrude = protrude;
+        batch.allowReordering = allowReordering;
+        batch.res = &res;
+
+#ifdef RDK_THREADSAFE_SSS
+        if (!numThreads) {
+          numThreads = boost::thread::hardware_concurrency();
+        }
+        numThreads = std::min(std::max(numThreads, 1U),
+                              static_cast<unsigned int>(probeConfs.size()));
+#else
+        numThreads = 1;
+#endif
+        if (numThreads == 1) {
+          compareShapes(&batch, 0, 1);
+        }
+#ifdef RDK_THREADSAFE_SSS
+        else {
+          boost::thread_group tg;
+          for (unsigned int ti = 0; ti < numThreads; ++ti) {
+            tg.add_thread(new boost::thread(compareShapes, &batch, ti, numThreads));
+          }
+          tg.join_all();
+        }
+#endif
+        delete trans;
+      }
+    }
+
+    void tanimotoDistances(const Conformer &refConf, const std::vector<const Conformer *> &probeConfs,
+                           std::vector<double> &res, double gridSpacing,
+                           DiscreteValueVect::DiscreteValueType bitsPerPoint,
+                           double vdwScale, double stepSize, int maxLayers,
+                           bool ignoreHs, unsigned int numThreads) {
+      compareShapesToReference(refConf, probeConfs, res, gridSpacing, bitsPerPoint,
+                               vdwScale, stepSize, maxLayers, ignoreHs, false, false,
+                               numThreads);
+    }
+
+    void protrudeDistances(const Conformer &refConf, const std::vector<const Conformer *> &probeConfs,
+                           std::vector<double> &res, double gridSpacing,
+                           DiscreteValueVect::DiscreteValueType bitsPerPoint,
+                           double vdwScale, double stepSize, int maxLayers,
+                           bool ignoreHs, bool allowReordering, unsigned int numThreads) {
+      compareShapesToReference(refConf, probeConfs, res, gridSpacing, bitsPerPoint,
+                               vdwScale, stepSize, maxLayers, ignoreHs, true, allowReordering,
+                               numThreads);
+    }
   }
 }
       
@@ -149,7 +149,49 @@ namespace RDKit {
                             DiscreteValueVect::DiscreteValueType bitsPerPoint=DiscreteValueVect::TWOBITVALUE,
                             double vdwScale=0.8, double stepSize=0.25, int maxLayers=-1, bool ignoreHs=true,
                             bool allowReordering=true);
-    
+
+    //! Compute the shape tanimoto distances between a reference conformer and a set of
+    //! probe conformers based on a predefined alignment
+    /*!
+      This is much faster than calling tanimotoDistance() for each probe: the reference
+      is only encoded once and the probes can be handled in parallel. All the shapes are
+      encoded on a single grid that is big enough for the reference and all the probes,
+      so the values can differ slightly from those calculated by tanimotoDistance().
+
+      \param refConf      The reference conformer
+      \param probeConfs   The probe conformers
+      \param res          used to return the distances, one per probe
+      \param gridSpacing  resolution of the grid used to encode the molecular shapes
+      \param bitsPerPoint number of bit used to encode the occupancy at each grid point
+      \param vdwScale     Scaling factor for the radius of the atoms to determine the base radius 
+                          used in the encoding - grid points inside this sphere carry the maximum occupany
+      \param stepSize     thickness of the each layer outside the base radius, the occupancy value is decreased 
+                          from layer to layer from the maximum value
+      \param maxLayers    the maximum number of layers - defaults to the number allowed the number of bits 
+                          use per grid point - e.g. two bits per grid point will allow 3 layers
+      \param ignoreHs     if true, ignore the hydrogen atoms in the shape encoding process
+      \param numThreads   the number of threads to use. If this is zero, the number of
+                          hardware threads is used. The results do not depend on the
+                          number of threads.
+     */
+    void tanimotoDistances(const Conformer &refConf, const std::vector<const Conformer *> &probeConfs,
+                           std::vector<double> &res, double gridSpacing=0.5,
+                           DiscreteValueVect::DiscreteValueType bitsPerPoint=DiscreteValueVect::TWOBITVALUE,
+                           double vdwScale=0.8, double stepSize=0.25, int maxLayers=-1,
+                           bool ignoreHs=true, unsigned int numThreads=1);
+    //! Compute the shape protrusion distances between a reference conformer and a set of
+    //! probe conformers based on a predefined alignment
+    /*!
+      The distance for each probe is the protrusion of the probe from the reference, or
+      if \c allowReordering is set, of the smaller shape from the larger one. The other
+      arguments and the caveats are the same as for tanimotoDistances().
+     */
+    void protrudeDistances(const Conformer &refConf, const std::vector<const Conformer *> &probeConfs,
+                           std::vector<double> &res, double gridSpacing=0.5,
+                           DiscreteValueVect::DiscreteValueType bitsPerPoint=DiscreteValueVect::TWOBITVALUE,
+                           double vdwScale=0.8, double stepSize=0.25, int maxLayers=-1,
+                           bool ignoreHs=true, bool allowReordering=true,
+                           unsigned int numThreads=1);
   }
 
 }
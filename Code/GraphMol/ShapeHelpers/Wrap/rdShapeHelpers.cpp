@@ -19,6 +19,7 @@
 
 #include <GraphMol/ShapeHelpers/ShapeEncoder.h>
 #include <GraphMol/ShapeHelpers/ShapeUtils.h>
+#include <GraphMol/ShapeHelpers/GaussianShape.h>
 #include <DataStructs/DiscreteValueVect.h>
 #include <Geometry/point.h>
 
@@ -122,6 +123,58 @@ namespace RDKit {
     return MolShapes::protrudeDistance(mol1, mol2, confId1, confId2, gridSpacing, bitsPerPoint,
                                        vdwScale, stepSize, maxLayers, ignoreHs, allowReordering);
   }
+
+  double alignGaussianMolShapes(const ROMol &refMol, ROMol &probeMol, int refConfId=-1,
+                                int probeConfId=-1, bool ignoreHs=true, unsigned int maxIts=200) {
+    return MolShapes::alignGaussianShapes(refMol, probeMol, refConfId, probeConfId,
+                                          ignoreHs, maxIts);
+  }
+
+  void _getProbeConfs(python::object probes, std::vector<const Conformer *> &confs) {
+    unsigned int nProbes = python::extract<unsigned int>(probes.attr("__len__")());
+    for (unsigned int i = 0; i < nProbes; ++i) {
+      const ROMol &probe = python::extract<const ROMol &>(probes[i]);
+      for (ROMol::ConstConformerIterator ci = probe.beginConformers();
+           ci != probe.endConformers(); ++ci) {
+        confs.push_back((*ci).get());
+      }
+    }
+  }
+  python::tuple tanimotoMolShapesBatch(const ROMol &refMol, python::object probes, int refConfId=-1,
+                                       double gridSpacing=0.5, 
+                                       DiscreteValueVect::DiscreteValueType bitsPerPoint=DiscreteValueVect::TWOBITVALUE, 
+                                       double vdwScale=0.8, double stepSize=0.25, int maxLayers=-1,
+                                       bool ignoreHs=true, unsigned int numThreads=1) {
+    std::vector<const Conformer *> confs;
+    _getProbeConfs(probes, confs);
+    std::vector<double> res;
+    MolShapes::tanimotoDistances(refMol.getConformer(refConfId), confs, res, gridSpacing,
+                                 bitsPerPoint, vdwScale, stepSize, maxLayers, ignoreHs,
+                                 numThreads);
+    python::list pyres;
+    for (unsigned int i = 0; i < res.size(); ++i) {
+      pyres.append(res[i]);
+    }
+    return python::tuple(pyres);
+  }
+  python::tuple protrudeMolShapesBatch(const ROMol &refMol, python::object probes, int refConfId=-1,
+                                       double gridSpacing=0.5, 
+                                       DiscreteValueVect::DiscreteValueType bitsPerPoint=DiscreteValueVect::TWOBITVALUE, 
+                                       double vdwScale=0.8, double stepSize=0.25, int maxLayers=-1,
+                                       bool ignoreHs=true, bool allowReordering=true,
+                                       unsigned int numThreads=1) {
+    std::vector<const Conformer *> confs;
+    _getProbeConfs(probes, confs);
+    std::vector<double> res;
+    MolShapes::protrudeDistances(refMol.getConformer(refConfId), confs, res, gridSpacing,
+                                 bitsPerPoint, vdwScale, stepSize, maxLayers, ignoreHs,
+                                 allowReordering, numThreads);
+    python::list pyres;
+    for (unsigned int i = 0; i < res.size(); ++i) {
+      pyres.append(res[i]);
+    }
+    return python::tuple(pyres);
+  }
 }
 
 BOOST_PYTHON_MODULE(rdShapeHelpers) {
@@ -210,6 +263,93 @@ BOOST_PYTHON_MODULE(rdShapeHelpers) {
                python::arg("allowReordering")=true),
               docString.c_str());
 
+  docString = "Compute the shape tanimoto distances between a reference molecule and each conformer\n\
+  of a set of probe molecules based on a predefined alignment\n\
+  \n\
+  The reference is encoded once onto a grid that fits all of the shapes, so the\n\
+  values can differ slightly from those returned by ShapeTanimotoDist.\n\
+  \n\
+  ARGUMENTS:\n\
+    - refMol : The reference molecule \n\
+    - probes : a sequence of probe molecules, all of their conformers are compared \n\
+    - refConfId : Conformer in the reference molecule (defaults to first conformer) \n\
+    - gridSpacing : resolution of the grid used to encode the molecular shapes \n\
+    - bitsPerPoint : number of bit used to encode the occupancy at each grid point \n\
+                          defaults to two bits per grid point \n\
+    - vdwScale : Scaling factor for the radius of the atoms to determine the base radius \n\
+                used in the encoding - grid points inside this sphere carry the maximum occupan \n\
+    - stepSize : thickness of the each layer outside the base radius, the occupancy value is decreased \n\
+                 from layer to layer from the maximum value \n\
+    - maxLayers : the maximum number of layers - defaults to the number allowed the number of bits \n\
+                  use per grid point - e.g. two bits per grid point will allow 3 layers \n\
+    - ignoreHs : when set, the contribution of Hs to the shape will be ignored\n\
+    - numThreads : the number of threads to use, 0 uses all available processors\n\
+  \n\
+  RETURNS:\n\
+    a tuple with one distance per probe conformer\n";
+  python::def("ShapeTanimotoDists", RDKit::tanimotoMolShapesBatch,
+              (python::arg("refMol"), python::arg("probes"), 
+               python::arg("refConfId")=-1,
+               python::arg("gridSpacing")=0.5, 
+               python::arg("bitsPerPoint")=RDKit::DiscreteValueVect::TWOBITVALUE,
+               python::arg("vdwScale")=0.8, python::arg("stepSize")=0.25,
+               python::arg("maxLayers")=-1, python::arg("ignoreHs")=true,
+               python::arg("numThreads")=1),
+              docString.c_str());
+
+  docString = "Compute the shape protrude distances between a reference molecule and each conformer\n\
+  of a set of probe molecules based on a predefined alignment\n\
+  \n\
+  The arguments are the same as for ShapeTanimotoDists, with the addition of:\n\
+    - allowReordering : when set, the order will be automatically updated so that the value calculated\n\
+                        is the protrusion of the smaller shape from the larger one.\n\
+  \n\
+  RETURNS:\n\
+    a tuple with one distance per probe conformer\n";
+  python::def("ShapeProtrudeDists", RDKit::protrudeMolShapesBatch,
+              (python::arg("refMol"), python::arg("probes"), 
+               python::arg("refConfId")=-1,
+               python::arg("gridSpacing")=0.5, 
+               python::arg("bitsPerPoint")=RDKit::DiscreteValueVect::TWOBITVALUE,
+               python::arg("vdwScale")=0.8, python::arg("stepSize")=0.25,
+               python::arg("maxLayers")=-1, python::arg("ignoreHs")=true,
+               python::arg("allowReordering")=true, python::arg("numThreads")=1),
+              docString.c_str());
+  docString = "Compute the Gaussian shape tanimoto distance between two molecule based on a\n\
+  predefined alignment. No grid is used, the shapes are represented by atom centered Gaussians.\n\
+  \n\
+  ARGUMENTS:\n\
+    - mol1 : The first molecule of interest \n\
+    - mol2 : The second molecule of interest \n\
+    - confId1 : Conformer in the first molecule (defaults to first conformer) \n\
+    - confId2 : Conformer in the second molecule (defaults to first conformer) \n\
+    - ignoreHs : when set, the contribution of Hs to the shape will be ignored\n";
+  python::def("GaussianShapeTanimotoDist",
+              (double (*)(const RDKit::ROMol &, const RDKit::ROMol &, int, int, bool))
+              RDKit::MolShapes::gaussianTanimotoDistance,
+              (python::arg("mol1"), python::arg("mol2"), 
+               python::arg("confId1")=-1, python::arg("confId2")=-1,
+               python::arg("ignoreHs")=true),
+              docString.c_str());
+
+  docString = "Align a probe molecule to a reference molecule by maximizing the overlap\n\
+  of their Gaussian shapes. The probe conformer is modified.\n\
+  \n\
+  ARGUMENTS:\n\
+    - refMol : The reference molecule \n\
+    - probeMol : The molecule to be aligned \n\
+    - refConfId : Conformer in the reference molecule (defaults to first conformer) \n\
+    - probeConfId : Conformer in the probe molecule (defaults to first conformer) \n\
+    - ignoreHs : when set, the contribution of Hs to the shape will be ignored\n\
+    - maxIts : maximum number of optimizer iterations for each starting orientation\n\
+  \n\
+  RETURNS:\n\
+    the Gaussian shape tanimoto distance after the alignment\n";
+  python::def("GaussianShapeAlign", RDKit::alignGaussianMolShapes,
+              (python::arg("refMol"), python::arg("probeMol"), 
+               python::arg("refConfId")=-1, python::arg("probeConfId")=-1,
+               python::arg("ignoreHs")=true, python::arg("maxIts")=200),
+              docString.c_str());
   
   docString = "Compute the size of the box that can fit the conformations, and offset \n\
    of the box from the origin\n";
@@ -12,6 +12,7 @@
 #include <Geometry/UniformGrid3D.h>
 #include "ShapeEncoder.h"
 #include "ShapeUtils.h"
+#include "GaussianShape.h"
 #include <GraphMol/RDKitBase.h>
 //#include <GraphMol/DistGeomHelpers/Embedder.h>
 #include <GraphMol/FileParsers/FileParsers.h>
@@ -92,6 +93,111 @@ void test3Methane() {
 }
 
 
+void test4Batch() {
+  std::string rdbase = getenv("RDBASE");
+  std::string fname1 = rdbase + "/Code/GraphMol/ShapeHelpers/test_data/1oir.mol";
+  ROMol *m = MolFileToMol(fname1);
+  std::string fname2 = rdbase + "/Code/GraphMol/ShapeHelpers/test_data/1oir_conf.mol";
+  ROMol *m2 = MolFileToMol(fname2);
+  MatchVectType atomMap;
+  atomMap.push_back(std::pair<int, int>(18, 27));
+  atomMap.push_back(std::pair<int, int>(13, 23));
+  atomMap.push_back(std::pair<int, int>(21, 14));
+  atomMap.push_back(std::pair<int, int>(24, 7));
+  atomMap.push_back(std::pair<int, int>(9, 19));
+  atomMap.push_back(std::pair<int, int>(16, 30));
+  MolAlign::alignMol(*m2, *m, 0, 0, &atomMap);
+  const Conformer &conf1 = m->getConformer();
+  const Conformer &conf2 = m2->getConformer();
+
+  // with a single probe the grid is the same as for the pairwise calculation:
+  std::vector<const Conformer *> probes;
+  probes.push_back(&conf2);
+  std::vector<double> res;
+  MolShapes::tanimotoDistances(conf1, probes, res);
+  CHECK_INVARIANT(res.size() == 1, "");
+  CHECK_INVARIANT(res[0] == MolShapes::tanimotoDistance(conf1, conf2), "");
+  MolShapes::protrudeDistances(conf1, probes, res);
+  CHECK_INVARIANT(res.size() == 1, "");
+  CHECK_INVARIANT(res[0] == MolShapes::protrudeDistance(conf1, conf2), "");
+
+  // more probes:
+  probes.push_back(&conf1);
+  probes.push_back(&conf2);
+  MolShapes::tanimotoDistances(conf1, probes, res);
+  CHECK_INVARIANT(res.size() == 3, "");
+  CHECK_INVARIANT(RDKit::feq(res[0], MolShapes::tanimotoDistance(conf1, conf2), 0.02), "");
+  CHECK_INVARIANT(res[1] == 0.0, "");
+  CHECK_INVARIANT(res[2] == res[0], "");
+
+  // the number of threads doesn't change anything:
+  std::vector<double> res2;
+  MolShapes::tanimotoDistances(conf1, probes, res2, 0.5, DiscreteValueVect::TWOBITVALUE,
+                               0.8, 0.25, -1, true, 2);
+  CHECK_INVARIANT(res2.size() == res.size(), "");
+  for (unsigned int i = 0; i < res.size(); ++i) {
+    CHECK_INVARIANT(res2[i] == res[i], "");
+  }
+
+  probes.clear();
+  MolShapes::tanimotoDistances(conf1, probes, res);
+  CHECK_INVARIANT(res.empty(), "");
+  delete m;
+  delete m2;
+}
+
+void test5GaussianShape() {
+  std::string rdbase = getenv("RDBASE");
+  std::string fname1 = rdbase + "/Code/GraphMol/ShapeHelpers/test_data/1oir.mol";
+  ROMol *m = MolFileToMol(fname1);
+  std::string fname2 = rdbase + "/Code/GraphMol/ShapeHelpers/test_data/1oir_conf.mol";
+  ROMol *m2 = MolFileToMol(fname2);
+
+  MolShapes::GaussianShape shape1(m->getConformer());
+  CHECK_INVARIANT(shape1.getNumGaussians() == m->getNumHeavyAtoms(), "");
+  CHECK_INVARIANT(RDKit::feq(MolShapes::gaussianOverlapVolume(shape1, shape1),
+                             shape1.getSelfOverlap()), "");
+  CHECK_INVARIANT(RDKit::feq(MolShapes::gaussianTanimotoDistance(*m, *m), 0.0), "");
+
+  // the gradient agrees with finite differences:
+  MolShapes::GaussianShape shape2(m2->getConformer());
+  RDGeom::POINT3D_VECT grad;
+  double v0 = MolShapes::gaussianOverlapVolume(shape1, shape2, &grad);
+  CHECK_INVARIANT(grad.size() == shape2.getNumGaussians(), "");
+  RDGeom::Point3D totGrad(0, 0, 0);
+  for (unsigned int i = 0; i < grad.size(); ++i) {
+    totGrad += grad[i];
+  }
+  RDGeom::Transform3D shift;
+  shift.SetTranslation(RDGeom::Point3D(1e-5, 0, 0));
+  MolShapes::GaussianShape shifted(shape2);
+  shifted.transform(shift);
+  double v1 = MolShapes::gaussianOverlapVolume(shape1, shifted);
+  CHECK_INVARIANT(RDKit::feq((v1 - v0)/1e-5, totGrad.x, 1e-3*fabs(totGrad.x) + 1e-4), "");
+
+  // move a copy of the molecule away and align it back:
+  ROMol m3(*m);
+  RDGeom::Transform3D rot, trans;
+  RDGeom::Point3D axis(0.3, 1.0, -0.4);
+  axis.normalize();
+  rot.SetRotation(1.2, axis);
+  trans.SetTranslation(RDGeom::Point3D(2.0, -1.0, 3.0));
+  trans.assign(trans*rot);
+  MolTransforms::transformConformer(m3.getConformer(), trans);
+  double startDist = MolShapes::gaussianTanimotoDistance(*m, m3);
+  CHECK_INVARIANT(startDist > 0.5, "");
+  double dist = MolShapes::alignGaussianShapes(*m, m3);
+  CHECK_INVARIANT(dist < 0.01, "");
+  CHECK_INVARIANT(RDKit::feq(dist, MolShapes::gaussianTanimotoDistance(*m, m3)), "");
+  CHECK_INVARIANT(MolAlign::alignMol(m3, *m) < 0.1, "");
+
+  // a different conformer can't fit as well:
+  dist = MolShapes::alignGaussianShapes(*m, *m2);
+  CHECK_INVARIANT(dist > 0.01 && dist < 0.5, "");
+  delete m;
+  delete m2;
+}
+
 int main() {
 
 #if 1
@@ -105,6 +211,14 @@ int main() {
   std::cout << "\t---------------------------------\n";
   std::cout << "\t test2Compare \n\n";
   test2Compare();
+
+  std::cout << "\t---------------------------------\n";
+  std::cout << "\t test4Batch \n\n";
+  test4Batch();
+
+  std::cout << "\t---------------------------------\n";
+  std::cout << "\t test5GaussianShape \n\n";
+  test5GaussianShape();
   std::cout << "***********************************************************\n";
 #endif
   //test3Methane();
@@ -0,0 +1,498 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+
+// ----------------------------------------------------------------------------------
+//  A single-pass parser for the common subset of SMILES.
+//
+//  The parser handles the organic subset, bracket atoms (isotope, element,
+//  @/@@, H count, charge and atom map), bonds (- = # : / \), branches,
+//  ring closures (including %nn) and dot-separated fragments. It builds
+//  exactly the molecule that the bison grammar builds: atom and bond
+//  ordering, ring-closure bond ordering, and the _SmilesStart and
+//  _RingClosures properties used by AdjustAtomChiralityFlags() all match.
+//
+//  Anything it doesn't handle is not reported as an error. Instead
+//  FastParseSmiles() returns null and the caller uses the full grammar,
+//  which also produces the usual error messages. This includes:
+//    - query bonds (~) and chirality classes (@TH1, etc.)
+//    - ring closures that cross a '.' or close on the opening atom
+//    - ring closures that duplicate an existing bond
+//    - anything that the grammar would reject
+//
+#include <GraphMol/RDKitBase.h>
+#include "SmilesParse.h"
+#include "SmilesParseOps.h"
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <boost/foreach.hpp>
+
+namespace SmilesParseOps {
+  using namespace RDKit;
+  namespace {
+    // the two-letter symbols the lexer recognizes inside square brackets:
+    const char *bracketSymbols[]={
+      "He","Li","Be","Ne","Na","Mg","Al","Si","Ar","Ca","Sc","Ti","Cr","Mn",
+      "Co","Fe","Ni","Cu","Zn","Ga","Ge","As","Se","Kr","Rb","Sr","Zr","Nb",
+      "Mo","Tc","Ru","Rh","Pd","Ag","Cd","In","Sn","Sb","Te","Xe","Cs","Ba",
+      "La","Ce","Pr","Nd","Pm","Sm","Eu","Gd","Tb","Dy","Ho","Er","Tm","Yb",
+      "Lu","Hf","Ta","Re","Os","Ir","Pt","Au","Hg","Tl","Pb","Bi","Po","At",
+      "Rn","Fr","Ra","Ac","Th","Pa","Np","Pu","Am","Cm","Bk","Cf","Es","Fm",
+      "Md","No","Lr","Rf","Cl","Br",0};
+
+    const unsigned int maxRingNumber=100;
+
+    struct RingBond {
+      int atomIdx;
+      unsigned int closureEntry; // position in FastSmilesParser::d_closureEntries
+      Bond::BondType bondType;
+      Bond::BondDir bondDir;
+      bool specified;
+    };
+    struct RingClosure {
+      unsigned int ringNumber;
+      RingBond first,second;
+    };
+    bool closureLess(const RingClosure &c1,const RingClosure &c2){
+      return c1.ringNumber<c2.ringNumber;
+    }
+    bool entryLess(const std::pair<int,int> &e1,const std::pair<int,int> &e2){
+      return e1.first<e2.first;
+    }
+
+    class FastSmilesParser {
+    public:
+      FastSmilesParser(const std::string &smi) :
+        dp_ptr(smi.c_str()), dp_end(smi.c_str()+smi.size()),
+        dp_mol(0), d_activeAtom(-1), d_haveChirality(false) {
+        for(unsigned int i=0;i<maxRingNumber;++i) d_openRings[i].atomIdx=-1;
+      };
+      ~FastSmilesParser() {
+        delete dp_mol;
+      };
+
+      // returns the molecule (which the caller then owns) or null
+      RWMol *parse(){
+        if(dp_ptr==dp_end) return 0;
+        dp_mol = new RWMol();
+        if(!parseFragment()) return 0;
+        // the rings in the first fragment are closed after everything
+        // else has been added:
+        std::vector<RingClosure> firstClosures;
+        firstClosures.swap(d_closures);
+        while(dp_ptr!=dp_end){
+          if(*dp_ptr!='.') return 0;
+          ++dp_ptr;
+          if(!parseFragment() || !closeRings(d_closures)) return 0;
+          d_closures.clear();
+        }
+        if(!closeRings(firstClosures)) return 0;
+
+        // set the ring-closure bond ids on the atoms, in SMILES order:
+        std::stable_sort(d_closureEntries.begin(),d_closureEntries.end(),entryLess);
+        unsigned int pos=0;
+        while(pos<d_closureEntries.size()){
+          int atomIdx=d_closureEntries[pos].first;
+          INT_VECT closures;
+          while(pos<d_closureEntries.size() && d_closureEntries[pos].first==atomIdx){
+            closures.push_back(d_closureEntries[pos].second);
+            ++pos;
+          }
+          dp_mol->getAtomWithIdx(atomIdx)->setProp(common_properties::_RingClosures,closures);
+        }
+        if(d_haveChirality){
+          AdjustAtomChiralityFlags(dp_mol);
+        }
+        RWMol *res=dp_mol;
+        dp_mol=0;
+        return res;
+      };
+
+    private:
+      const char *dp_ptr,*dp_end;
+      RWMol *dp_mol;
+      int d_activeAtom;
+      bool d_haveChirality;
+      std::vector<int> d_branchPoints;
+      RingBond d_openRings[maxRingNumber];
+      std::vector<RingClosure> d_closures;
+      std::vector<std::pair<int,int> > d_closureEntries;
+
+      bool parseFragment(){
+        Atom *atom=parseAtom();
+        if(!atom) return false;
+        atom->setProp(common_properties::_SmilesStart,1);
+        d_activeAtom = dp_mol->addAtom(atom,false,true);
+
+        while(dp_ptr!=dp_end && *dp_ptr!='.'){
+          bool branch=false;
+          if(*dp_ptr==')'){
+            if(d_branchPoints.empty()) return false;
+            d_activeAtom = d_branchPoints.back();
+            d_branchPoints.pop_back();
+            ++dp_ptr;
+            continue;
+          } else if(*dp_ptr=='('){
+            branch=true;
+            ++dp_ptr;
+            if(dp_ptr==dp_end) return false;
+          }
+
+          Bond::BondType bondType=Bond::UNSPECIFIED;
+          Bond::BondDir bondDir=Bond::NONE;
+          bool haveBond=true,isMinus=false;
+          switch(*dp_ptr){
+          case '-':
+            bondType=Bond::SINGLE;isMinus=true;break;
+          case '=':
+            bondType=Bond::DOUBLE;break;
+          case '#':
+            bondType=Bond::TRIPLE;break;
+          case ':':
+            bondType=Bond::AROMATIC;break;
+          case '/':
+            bondType=Bond::SINGLE;bondDir=Bond::ENDUPRIGHT;break;
+          case '\\':
+            bondType=Bond::SINGLE;bondDir=Bond::ENDDOWNRIGHT;break;
+          default:
+            haveBond=false;
+          }
+          if(haveBond){
+            ++dp_ptr;
+            if(dp_ptr==dp_end) return false;
+          }
+
+          if(!branch && (*dp_ptr=='%' || (*dp_ptr>='0' && *dp_ptr<='9'))){
+            if(!parseRingBond(bondType,bondDir,haveBond)) return false;
+            continue;
+          }
+
+          atom=parseAtom();
+          if(!atom) return false;
+          int atomIdx=dp_mol->addAtom(atom,false,true);
+          if(!haveBond){
+            dp_mol->addBond(d_activeAtom,atomIdx,
+                            GetUnspecifiedBondType(dp_mol,dp_mol->getAtomWithIdx(d_activeAtom),atom));
+          } else if(isMinus){
+            dp_mol->addBond(d_activeAtom,atomIdx,Bond::SINGLE);
+          } else {
+            // as in the grammar, bonds from bond tokens are added as-is.
+            // In particular an explicit aromatic bond does not mark its atoms
+            // as aromatic.
+            Bond *bond=new Bond(bondType);
+            bond->setBondDir(bondDir);
+            if(bondType==Bond::AROMATIC) bond->setIsAromatic(true);
+            bond->setBeginAtomIdx(d_activeAtom);
+            bond->setEndAtomIdx(atomIdx);
+            dp_mol->addBond(bond,true);
+          }
+          if(branch) d_branchPoints.push_back(d_activeAtom);
+          d_activeAtom=atomIdx;
+        }
+        if(!d_branchPoints.empty()) return false;
+        for(unsigned int i=0;i<maxRingNumber;++i){
+          if(d_openRings[i].atomIdx>=0) return false;
+        }
+        return true;
+      };
+
+      bool parseRingBond(Bond::BondType bondType,Bond::BondDir bondDir,bool specified){
+        unsigned int ringNumber;
+        if(*dp_ptr=='%'){
+          if(dp_end-dp_ptr<3 || dp_ptr[1]<'1' || dp_ptr[1]>'9' ||
+             dp_ptr[2]<'0' || dp_ptr[2]>'9') return false;
+          ringNumber = (dp_ptr[1]-'0')*10 + (dp_ptr[2]-'0');
+          dp_ptr+=3;
+        } else {
+          ringNumber = *dp_ptr-'0';
+          ++dp_ptr;
+        }
+        RingBond rb;
+        rb.atomIdx=d_activeAtom;
+        rb.closureEntry=d_closureEntries.size();
+        rb.bondType=bondType;
+        rb.bondDir=bondDir;
+        rb.specified=specified;
+        RingBond &open=d_openRings[ringNumber];
+        if(open.atomIdx<0){
+          open=rb;
+        } else {
+          if(open.atomIdx==d_activeAtom) return false;
+          RingClosure closure;
+          closure.ringNumber=ringNumber;
+          closure.first=open;
+          closure.second=rb;
+          d_closures.push_back(closure);
+          open.atomIdx=-1;
+        }
+        // the bond id is filled in when the ring is closed:
+        d_closureEntries.push_back(std::make_pair(d_activeAtom,-1));
+        return true;
+      };
+
+      // the grammar closes rings in order of ring number; bonds that reuse
+      // a ring number are closed in input order.
+      bool closeRings(std::vector<RingClosure> &closures){
+        std::stable_sort(closures.begin(),closures.end(),closureLess);
+        BOOST_FOREACH(const RingClosure &closure,closures){
+          int idx1=closure.first.atomIdx,idx2=closure.second.atomIdx;
+          if(dp_mol->getBondBetweenAtoms(idx1,idx2)) return false;
+          // the first specification of the bond wins:
+          Bond *bond;
+          if(closure.first.specified){
+            bond = new Bond(closure.first.bondType);
+            bond->setBondDir(closure.first.bondDir);
+            bond->setBeginAtomIdx(idx1);
+            bond->setEndAtomIdx(idx2);
+          } else {
+            bond = new Bond(closure.second.bondType);
+            bond->setBondDir(closure.second.bondDir);
+            bond->setBeginAtomIdx(idx2);
+            bond->setEndAtomIdx(idx1);
+            if(!closure.second.specified) bond->setProp(common_properties::_unspecifiedOrder,1);
+          }
+          if(bond->getBondType()==Bond::UNSPECIFIED){
+            bond->setBondType(GetUnspecifiedBondType(dp_mol,
+                                                     dp_mol->getAtomWithIdx(idx1),
+                                                     dp_mol->getAtomWithIdx(idx2)));
+          }
+          if(bond->getBondType()==Bond::AROMATIC) bond->setIsAromatic(true);
+          int bondIdx=dp_mol->addBond(bond,true)-1;
+          d_closureEntries[closure.first.closureEntry].second=bondIdx;
+          d_closureEntries[closure.second.closureEntry].second=bondIdx;
+        }
+        return true;
+      };
+
+      // numbers are either 0 or start with a non-zero digit
+      bool parseNumber(int &res){
+        if(dp_ptr==dp_end || *dp_ptr<'0' || *dp_ptr>'9') return false;
+        res = *dp_ptr-'0';
+        ++dp_ptr;
+        if(res){
+          while(dp_ptr!=dp_end && *dp_ptr>='0' && *dp_ptr<='9'){
+            res = res*10 + (*dp_ptr-'0');
+            ++dp_ptr;
+          }
+        }
+        return true;
+      };
+
+      Atom *parseAtom(){
+        if(dp_ptr==dp_end) return 0;
+        Atom *res=0;
+        switch(*dp_ptr){
+        case '[':
+          return parseBracketAtom();
+        case 'B':
+          if(dp_ptr+1!=dp_end && dp_ptr[1]=='r'){
+            res = new Atom(35);
+            ++dp_ptr;
+          } else {
+            res = new Atom(5);
+          }
+          break;
+        case 'C':
+          if(dp_ptr+1!=dp_end && dp_ptr[1]=='l'){
+            res = new Atom(17);
+            ++dp_ptr;
+          } else {
+            res = new Atom(6);
+          }
+          break;
+        case 'N':
+          res = new Atom(7);break;
+        case 'O':
+          res = new Atom(8);break;
+        case 'P':
+          res = new Atom(15);break;
+        case 'S':
+          res = new Atom(16);break;
+        case 'F':
+          res = new Atom(9);break;
+        case 'I':
+          res = new Atom(53);break;
+        case '*':
+          res = new Atom(0);
+          res->setProp(common_properties::dummyLabel,std::string("*"));
+          break;
+        default:
+          res = parseAromaticAtom(false);
+          if(!res) return 0;
+        }
+        ++dp_ptr;
+        return res;
+      };
+
+      // handles b, c, n, o, p, s and, inside brackets, si, se and te.
+      // Does not move past the symbol.
+      Atom *parseAromaticAtom(bool inBracket){
+        int atomicNum;
+        switch(*dp_ptr){
+        case 'b':
+          atomicNum=5;break;
+        case 'c':
+          atomicNum=6;break;
+        case 'n':
+          atomicNum=7;break;
+        case 'o':
+          atomicNum=8;break;
+        case 'p':
+          atomicNum=15;break;
+        case 's':
+          atomicNum=16;
+          if(inBracket && dp_ptr+1!=dp_end){
+            if(dp_ptr[1]=='i') atomicNum=14;
+            else if(dp_ptr[1]=='e') atomicNum=34;
+          }
+          break;
+        case 't':
+          if(!inBracket || dp_ptr+1==dp_end || dp_ptr[1]!='e') return 0;
+          atomicNum=52;
+          break;
+        default:
+          return 0;
+        }
+        Atom *res=new Atom(atomicNum);
+        res->setIsAromatic(true);
+        return res;
+      };
+
+      // returns the bracket atom's element, leaves dp_ptr after the symbol
+      Atom *parseBracketElement(){
+        if(dp_end-dp_ptr>=2 && dp_ptr[1]>='a' && dp_ptr[1]<='z'){
+          for(const char **sym=bracketSymbols;*sym;++sym){
+            if((*sym)[0]==dp_ptr[0] && (*sym)[1]==dp_ptr[1]){
+              Atom *res=new Atom(PeriodicTable::getTable()->getAtomicNumber(std::string(*sym)));
+              dp_ptr+=2;
+              return res;
+            }
+          }
+        }
+        Atom *res=0;
+        switch(*dp_ptr){
+        case 'K':
+        case 'V':
+        case 'Y':
+        case 'W':
+        case 'U':
+          res=new Atom(PeriodicTable::getTable()->getAtomicNumber(std::string(dp_ptr,1)));
+          break;
+        case 'B':
+          res=new Atom(5);break;
+        case 'C':
+          res=new Atom(6);break;
+        case 'N':
+          res=new Atom(7);break;
+        case 'O':
+          res=new Atom(8);break;
+        case 'P':
+          res=new Atom(15);break;
+        case 'S':
+          res=new Atom(16);break;
+        case 'F':
+          res=new Atom(9);break;
+        case 'I':
+          res=new Atom(53);break;
+        case '*':
+          res=new Atom(0);
+          res->setProp(common_properties::dummyLabel,std::string("*"));
+          break;
+        default:
+          res=parseAromaticAtom(true);
+          // si, se and te:
+          if(res && (res->getAtomicNum()==14 || res->getAtomicNum()==34 ||
+                     res->getAtomicNum()==52)){
+            ++dp_ptr;
+          }
+        }
+        if(res) ++dp_ptr;
+        return res;
+      };
+
+      Atom *parseBracketAtom(){
+        ++dp_ptr;
+        int isotope=-1;
+        if(dp_ptr!=dp_end && *dp_ptr>='0' && *dp_ptr<='9'){
+          parseNumber(isotope);
+        }
+        if(dp_ptr==dp_end) return 0;
+
+        Atom *res;
+        int numHs=-1;
+        bool isHydrogen=(*dp_ptr=='H' &&
+                         (dp_ptr+1==dp_end || !strchr("efgo",dp_ptr[1])));
+        if(isHydrogen){
+          ++dp_ptr;
+          res = new Atom(1);
+          if(dp_ptr!=dp_end && *dp_ptr=='H'){
+            ++dp_ptr;
+            numHs=1;
+            if(dp_ptr!=dp_end && *dp_ptr>='0' && *dp_ptr<='9') parseNumber(numHs);
+          }
+        } else {
+          res = parseBracketElement();
+          if(!res) return 0;
+          if(dp_ptr!=dp_end && *dp_ptr=='@'){
+            ++dp_ptr;
+            if(dp_ptr!=dp_end && *dp_ptr=='@'){
+              ++dp_ptr;
+              res->setChiralTag(Atom::CHI_TETRAHEDRAL_CW);
+            } else {
+              res->setChiralTag(Atom::CHI_TETRAHEDRAL_CCW);
+            }
+            d_haveChirality=true;
+          }
+          if(dp_ptr!=dp_end && *dp_ptr=='H'){
+            ++dp_ptr;
+            numHs=1;
+            if(dp_ptr!=dp_end && *dp_ptr>='0' && *dp_ptr<='9') parseNumber(numHs);
+          }
+        }
+        if(isotope>=0) res->setIsotope(isotope);
+        if(numHs>=0) res->setNumExplicitHs(numHs);
+
+        if(dp_ptr!=dp_end && (*dp_ptr=='+' || *dp_ptr=='-')){
+          char sign=*dp_ptr;
+          ++dp_ptr;
+          int charge=1;
+          if(dp_ptr!=dp_end && *dp_ptr==sign){
+            ++dp_ptr;
+            charge=2;
+          } else if(dp_ptr!=dp_end && *dp_ptr>='0' && *dp_ptr<='9'){
+            parseNumber(charge);
+          }
+          res->setFormalCharge(sign=='+' ? charge : -charge);
+        }
+        res->setNoImplicit(true);
+        if(dp_ptr!=dp_end && *dp_ptr==':'){
+          ++dp_ptr;
+          int mapNum;
+          if(!parseNumber(mapNum)){
+            delete res;
+            return 0;
+          }
+          res->setProp(common_properties::molAtomMapNumber,mapNum);
+        }
+        if(dp_ptr==dp_end || *dp_ptr!=']'){
+          delete res;
+          return 0;
+        }
+        ++dp_ptr;
+        return res;
+      };
+    };
+  } // end of local namespace
+
+  RWMol *FastParseSmiles(const std::string &smi){
+    FastSmilesParser parser(smi);
+    return parser.parse();
+  }
+} // end of namespace SmilesParseOps
@@ -76,6 +76,9 @@ namespace RDKit{
 
     std::string labelRecursivePatterns(std::string sma){
 #ifndef NO_AUTOMATIC_SMARTS_RELABELLING
+      // nothing to do if there are no recursive patterns:
+      if(sma.find('$')==std::string::npos) return sma;
+
       std::list<SmaState> state;
       std::list<unsigned int> startRecurse;
       std::map<std::string, std::string> patterns;
@@ -180,7 +183,11 @@ namespace RDKit{
       }
     }
 
-    RWMol *res = toMol(smi,smiles_parse,smi);
+    // most SMILES can be handled without the full grammar, the fast parser
+    // is skipped when debugging output was requested:
+    RWMol *res=0;
+    if(!debugParse) res = SmilesParseOps::FastParseSmiles(smi);
+    if(!res) res = toMol(smi,smiles_parse,smi);
     if(sanitize && res){
       // we're going to remove explicit Hs from the graph,
       // this triggers a sanitization, so we do not need to
@@ -72,15 +72,15 @@ namespace SmilesParseOps{
     //
     for(RWMol::AtomIterator atomIt=frag->beginAtoms();
         atomIt!=frag->endAtoms();atomIt++){
-      if((*atomIt)->hasProp("_RingClosures")){
+      if((*atomIt)->hasProp(common_properties::_RingClosures)){
         INT_VECT tmpVect;
-        (*atomIt)->getProp("_RingClosures",tmpVect);
+        (*atomIt)->getProp(common_properties::_RingClosures,tmpVect);
         BOOST_FOREACH(int &v, tmpVect){
           // if the ring closure is not already a bond, don't touch it:
           if(v>=0) v += nOrigBonds;
         }
         Atom *newAtom = mol->getAtomWithIdx(nOrigAtoms+(*atomIt)->getIdx());
-        newAtom->setProp("_RingClosures",tmpVect);
+        newAtom->setProp(common_properties::_RingClosures,tmpVect);
       }
     }
 
@@ -226,8 +226,8 @@ namespace SmilesParseOps{
         // need to insert into the list in a particular order
         //
         INT_VECT ringClosures;
-        if((*atomIt)->hasProp("_RingClosures"))
-          (*atomIt)->getProp("_RingClosures",ringClosures);
+        if((*atomIt)->hasProp(common_properties::_RingClosures))
+          (*atomIt)->getProp(common_properties::_RingClosures,ringClosures);
 #if 0
         std::cout << "CLOSURES: ";
         std::copy(ringClosures.begin(),ringClosures.end(),
@@ -292,7 +292,7 @@ namespace SmilesParseOps{
         //
         int nSwaps=(*atomIt)->getPerturbationOrder(bondOrdering);
         // FIX: explain this one:
-        if((*atomIt)->getDegree()==3 && (*atomIt)->hasProp("_SmilesStart")) ++nSwaps;
+        if((*atomIt)->getDegree()==3 && (*atomIt)->hasProp(common_properties::_SmilesStart)) ++nSwaps;
         if(nSwaps%2){
           (*atomIt)->invertChirality();
         }
@@ -382,7 +382,7 @@ namespace SmilesParseOps{
             //   bond, we'll just take the first one and ignore others
             //   NOTE: we used to do this the other way (take the last specification),
             //   but that turned out to be troublesome in odd cases like C1CC11CC1.
-            if(!bond1->hasProp("_unspecifiedOrder")){
+            if(!bond1->hasProp(common_properties::_unspecifiedOrder)){
               matchedBond = bond1;
               matchedBond->setEndAtomIdx(atom2->getIdx());
               delete bond2;
@@ -430,27 +430,27 @@ namespace SmilesParseOps{
             // we found a bond, so update the atom's _RingClosures
             // property:
             if(bondIdx>-1){
-              CHECK_INVARIANT(atom1->hasProp("_RingClosures") &&
-                  atom2->hasProp("_RingClosures"),
+              CHECK_INVARIANT(atom1->hasProp(common_properties::_RingClosures) &&
+                  atom2->hasProp(common_properties::_RingClosures),
                   "somehow atom doesn't have _RingClosures property.");
               INT_VECT closures;
-              atom1->getProp("_RingClosures",closures);
+              atom1->getProp(common_properties::_RingClosures,closures);
               INT_VECT::iterator closurePos= std::find(closures.begin(),
                   closures.end(),
                   -(bookmarkIt->first+1));
               CHECK_INVARIANT(closurePos!=closures.end(),
                   "could not find bookmark in atom _RingClosures");
               *closurePos = bondIdx-1;
-              atom1->setProp("_RingClosures",closures);
+              atom1->setProp(common_properties::_RingClosures,closures);
 
-              atom2->getProp("_RingClosures",closures);
+              atom2->getProp(common_properties::_RingClosures,closures);
               closurePos= std::find(closures.begin(),
                   closures.end(),
                   -(bookmarkIt->first+1));
               CHECK_INVARIANT(closurePos!=closures.end(),
                   "could not find bookmark in atom _RingClosures");
               *closurePos = bondIdx-1;
-              atom2->setProp("_RingClosures",closures);
+              atom2->setProp(common_properties::_RingClosures,closures);
             }
             bookmarkedAtomsToRemove.push_back(atom1);
             bookmarkedAtomsToRemove.push_back(atom2);
@@ -10,6 +10,7 @@
 #ifndef _RD_SMILESPARSEOPS_H
 #define _RD_SMILESPARSEOPS_H
 #include <GraphMol/Bond.h>
+#include <string>
 
 namespace RDKit{
   class RWMol;
@@ -27,6 +28,12 @@ namespace SmilesParseOps {
 					       const RDKit::Atom *atom2);
   void CloseMolRings(RDKit::RWMol *mol,bool toleratePartials);
   void AdjustAtomChiralityFlags(RDKit::RWMol *mol);
+  //! parses the common subset of SMILES in a single pass
+  /*!
+    Returns a molecule identical to the one the SMILES grammar produces,
+    or null if the input needs the full grammar.
+  */
+  RDKit::RWMol *FastParseSmiles(const std::string &smi);
 };
 
 #endif
@@ -0,0 +1,90 @@
+//
+//  Copyright (C) 2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+// Times a SMILES round trip (parse, write canonical isomeric SMILES,
+// parse that, write it again) and counts the heap allocations done.
+//
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <new>
+#include <RDGeneral/Invariant.h>
+#include <RDGeneral/RDLog.h>
+#include <RDGeneral/StreamOps.h>
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/SmilesParse/SmilesParse.h>
+#include <GraphMol/SmilesParse/SmilesWrite.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace {
+  unsigned long nAllocs=0;
+}
+void *operator new(size_t size) throw(std::bad_alloc) {
+  ++nAllocs;
+  void *res=malloc(size);
+  if(!res) throw std::bad_alloc();
+  return res;
+}
+void operator delete(void *ptr) throw() {
+  free(ptr);
+}
+
+using namespace RDKit;
+
+int main(int argc,char *argv[])
+{
+  RDLog::InitLogs();
+  boost::logging::disable_logs("rdApp.error");
+  std::string fName;
+  if(argc>1){
+    fName=argv[1];
+  } else {
+    fName=getenv("RDBASE");
+    fName += "/Data/NCI/first_5K.smi";
+  }
+  unsigned int nReps=argc>2 ? atoi(argv[2]) : 3;
+
+  std::vector<std::string> smis;
+  std::ifstream inf(fName.c_str());
+  while(inf.good()){
+    std::string line=getLine(inf);
+    if(line.empty()) continue;
+    smis.push_back(line.substr(0,line.find_first_of(" \t")));
+  }
+
+  unsigned long startAllocs=nAllocs;
+  boost::posix_time::ptime start=boost::posix_time::microsec_clock::universal_time();
+  unsigned int nMols=0,nMismatch=0;
+  for(unsigned int rep=0;rep<nReps;++rep){
+    for(unsigned int i=0;i<smis.size();++i){
+      ROMol *m=0;
+      try {
+        m=SmilesToMol(smis[i]);
+      } catch (MolSanitizeException &) {
+        m=0;
+      }
+      if(!m) continue;
+      std::string csmi1=MolToSmiles(*m,true);
+      delete m;
+      m=SmilesToMol(csmi1);
+      TEST_ASSERT(m);
+      std::string csmi2=MolToSmiles(*m,true);
+      delete m;
+      if(csmi1!=csmi2) ++nMismatch;
+      ++nMols;
+    }
+  }
+  boost::posix_time::ptime finish=boost::posix_time::microsec_clock::universal_time();
+  std::cout << "round trips: " << nMols
+            << " mismatches: " << nMismatch
+            << " time: " << (finish-start).total_microseconds()/1e6 << "s"
+            << " allocations: " << nAllocs-startAllocs
+            << std::endl;
+  return 0;
+}
@@ -12,6 +12,7 @@
 #include <GraphMol/RDKitBase.h>
 #include "SmilesParse.h"
 #include "SmilesWrite.h"
+#include "SmilesParseOps.h"
 #include <RDGeneral/RDLog.h>
 //#include <boost/log/functions.hpp>
 using namespace RDKit;
@@ -3315,6 +3316,159 @@ void testGithub45(){
   BOOST_LOG(rdInfoLog) << "done" << std::endl;
 }
 
+void testFastParser(){
+  BOOST_LOG(rdInfoLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdInfoLog) << "Testing the single-pass SMILES parser" << std::endl;
+  {
+    // common input is handled directly:
+    std::string smis[]={"c1ccccc1C(=O)O","C[C@@H](N)C(=O)O","[13CH3][N+](C)(C)C",
+                        "[NH4+].[Cl-]","F/C=C/Cl","C%10CCC%10","[Fe+3]","[2H][HH]",
+                        "[CH3:1][OH:2]","*C(=O)[*]","C1CC1.C1CC1","[se]1cccc1","EOS"};
+    for(unsigned int i=0;smis[i]!="EOS";++i){
+      RWMol *m=SmilesParseOps::FastParseSmiles(smis[i]);
+      TEST_ASSERT(m);
+      delete m;
+    }
+  }
+  {
+    // everything else is left to the grammar:
+    std::string smis[]={"","C~C","C[C@TH1](F)Br","C1.C1","C11","C1C1","CC)C","C(C",
+                        "C(C.C)C","[Fe+++]","[Cn]","K","C%1","EOS"};
+    for(unsigned int i=0;smis[i]!="EOS";++i){
+      RWMol *m=SmilesParseOps::FastParseSmiles(smis[i]);
+      TEST_ASSERT(!m);
+    }
+    RWMol *m=SmilesToMol("C1.C1",0,false);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumBonds()==1);
+    delete m;
+    m=SmilesToMol("C~C",0,false);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumBonds()==1);
+    delete m;
+    m=SmilesToMol("CC)C");
+    TEST_ASSERT(!m);
+    m=SmilesToMol("[Cn]");
+    TEST_ASSERT(!m);
+  }
+  {
+    // ring closures in later fragments are added first, as in the grammar:
+    RWMol *m=SmilesParseOps::FastParseSmiles("C1CC1.C2CC2");
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumBonds()==6);
+    TEST_ASSERT(m->getBondBetweenAtoms(3,5)->getIdx()==4);
+    TEST_ASSERT(m->getBondBetweenAtoms(0,2)->getIdx()==5);
+    INT_VECT closures;
+    m->getAtomWithIdx(2)->getProp("_RingClosures",closures);
+    TEST_ASSERT(closures.size()==1);
+    TEST_ASSERT(closures[0]==5);
+    TEST_ASSERT(m->getAtomWithIdx(3)->hasProp("_SmilesStart"));
+    delete m;
+
+    // the first bond specification wins:
+    m=SmilesParseOps::FastParseSmiles("C1CC=1");
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getBondBetweenAtoms(0,2)->getBondType()==Bond::DOUBLE);
+    TEST_ASSERT(m->getBondBetweenAtoms(0,2)->getBeginAtomIdx()==2);
+    delete m;
+    m=SmilesParseOps::FastParseSmiles("C=1CC-1");
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getBondBetweenAtoms(0,2)->getBondType()==Bond::DOUBLE);
+    TEST_ASSERT(m->getBondBetweenAtoms(0,2)->getBeginAtomIdx()==0);
+    delete m;
+  }
+  {
+    // chirality agrees with the grammar, which handles the second form:
+    RWMol *m1=SmilesToMol("F[C@](Cl)(Br)I");
+    RWMol *m2=SmilesToMol("F[C@]1(Br)I.Cl1");
+    TEST_ASSERT(m1);
+    TEST_ASSERT(m2);
+    TEST_ASSERT(MolToSmiles(*m1,true)==MolToSmiles(*m2,true));
+    delete m1;
+    delete m2;
+    m1=SmilesToMol("F[C@@]1(Cl)CCC1");
+    m2=SmilesToMol("F[C@@]12CCC1.Cl2");
+    TEST_ASSERT(m1);
+    TEST_ASSERT(m2);
+    TEST_ASSERT(MolToSmiles(*m1,true)==MolToSmiles(*m2,true));
+    delete m1;
+    delete m2;
+  }
+
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
+
+
+void testLargeSymmetricRanking(){
+  BOOST_LOG(rdInfoLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdInfoLog) << "Testing atom ranking of large symmetric molecules" << std::endl;
+  {
+    // C60: all atoms are equivalent
+    std::string smi="c12c3c4c5c1c1c6c7c2c2c8c3c3c9c4c4c%10c5c5c1c1c6c6c%11c7c2c2c7c8c3c3c8c9c4c4c9c%10c5c5c1c1c6c6c%11c2c2c7c3c3c8c4c4c9c5c1c1c6c2c3c41";
+    RWMol *m=SmilesToMol(smi);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumAtoms()==60);
+    INT_VECT ranks(m->getNumAtoms());
+    MolOps::rankAtoms(*m,ranks,false);
+    for(unsigned int i=0;i<m->getNumAtoms();++i){
+      TEST_ASSERT(ranks[i]==0);
+    }
+    MolOps::rankAtoms(*m,ranks,true);
+    INT_VECT sortedRanks(ranks);
+    std::sort(sortedRanks.begin(),sortedRanks.end());
+    for(unsigned int i=0;i<m->getNumAtoms();++i){
+      TEST_ASSERT(sortedRanks[i]==static_cast<int>(i));
+    }
+    std::string csmi=MolToSmiles(*m,true);
+    delete m;
+    m=SmilesToMol(csmi);
+    TEST_ASSERT(m);
+    TEST_ASSERT(MolToSmiles(*m,true)==csmi);
+    delete m;
+  }
+  {
+    // a peptide with 60 residues
+    std::string residues[]={"NCC(=O)","N[C@@H](C)C(=O)","N[C@@H](CO)C(=O)"};
+    std::string smi;
+    for(unsigned int i=0;i<60;++i) smi += residues[i%3];
+    smi += "O";
+    RWMol *m=SmilesToMol(smi);
+    TEST_ASSERT(m);
+    std::string csmi=MolToSmiles(*m,true);
+    delete m;
+    m=SmilesToMol(csmi);
+    TEST_ASSERT(m);
+    TEST_ASSERT(MolToSmiles(*m,true)==csmi);
+    delete m;
+  }
+  {
+    // ties within fragments are broken too:
+    std::string smi="CCO/C(O)=C1/C(=O)c2ccccc2C(=O)/C1=C\\c1ccc(CC)cc1";
+    RWMol *m=SmilesToMol(smi);
+    TEST_ASSERT(m);
+    boost::dynamic_bitset<> atomsToUse(m->getNumAtoms());
+    boost::dynamic_bitset<> bondsToUse(m->getNumBonds());
+    for(unsigned int i=0;i<m->getNumAtoms()-2;++i) atomsToUse.set(i);
+    for(unsigned int i=0;i<m->getNumBonds();++i){
+      const Bond *bond=m->getBondWithIdx(i);
+      if(atomsToUse[bond->getBeginAtomIdx()] && atomsToUse[bond->getEndAtomIdx()]){
+        bondsToUse.set(i);
+      }
+    }
+    INT_VECT ranks(m->getNumAtoms(),-1);
+    MolOps::rankAtomsInFragment(*m,ranks,atomsToUse,bondsToUse);
+    INT_VECT fragRanks;
+    for(unsigned int i=0;i<m->getNumAtoms();++i){
+      if(atomsToUse[i]) fragRanks.push_back(ranks[i]);
+    }
+    std::sort(fragRanks.begin(),fragRanks.end());
+    for(unsigned int i=0;i<fragRanks.size();++i){
+      TEST_ASSERT(fragRanks[i]==static_cast<int>(i));
+    }
+    delete m;
+  }
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
 
 int
 main(int argc, char *argv[])
@@ -3369,5 +3523,7 @@ main(int argc, char *argv[])
 #endif
   testGithub12();
   testGithub45();
+  testFastParser();
+  testLargeSymmetricRanking();
   //testBug1719046();
 }
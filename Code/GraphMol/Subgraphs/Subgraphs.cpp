@@ -34,35 +34,29 @@ namespace Subgraphs {
     // some bond IDs may be missing to index the list on.
     // so using an associative container.
 
+    const CSRGraph &g=mol.getCSRGraph();
     for (int i = 0; i < nAtoms; i++) {
-      const Atom *atom = mol.getAtomWithIdx(i);
       // if are at a hydrogen and we are not interested in bonds connecting to them
       // move on
-      if( useHs || atom->getAtomicNum()!=1 ){
-        ROMol::OEDGE_ITER bIt1,end;
-        boost::tie(bIt1,end) = mol.getAtomBonds(atom);
-        while(bIt1!=end){
-          const BOND_SPTR bond1 = mol[*bIt1];
+      if( useHs || g.getAtom(i)->getAtomicNum()!=1 ){
+        unsigned int end=g.getSlotEnd(i);
+        for(unsigned int slot1=g.getSlotBegin(i);slot1!=end;++slot1){
           // if this bond connect to a hydrogen and we are not interested
           // in it ignore 
-          if( useHs || bond1->getOtherAtom(atom)->getAtomicNum() != 1 ){
-            int bid1 = bond1->getIdx();
+          if( useHs || g.getAtom(g.getSlotTarget(slot1))->getAtomicNum() != 1 ){
+            int bid1 = g.getSlotBondIdx(slot1);
             if (nbrs.find(bid1) == nbrs.end()) {
               INT_VECT nlst;
               nbrs[bid1] = nlst;
             }
-            ROMol::OEDGE_ITER bIt2= mol.getAtomBonds(atom).first;
-            while(bIt2 != end){
-              const BOND_SPTR bond2 = mol[*bIt2];
-              int bid2 = bond2->getIdx();
+            for(unsigned int slot2=g.getSlotBegin(i);slot2!=end;++slot2){
+              int bid2 = g.getSlotBondIdx(slot2);
               if (bid1 != bid2 &&
-                  (useHs || bond2->getOtherAtom(atom)->getAtomicNum() != 1 ) ){
+                  (useHs || g.getAtom(g.getSlotTarget(slot2))->getAtomicNum() != 1 ) ){
                 nbrs[bid1].push_back(bid2); //FIX: pathListType should probably be container of pointers ??
               }
-              ++bIt2;
             }
           }
-          ++bIt1;
         }
       }
     }
@@ -296,6 +290,7 @@ namespace Subgraphs {
     // this should be the only dependence on mol object:
     INT_INT_VECT_MAP nbrs;
     Subgraphs::getNbrsList(mol, useHs,nbrs); 
+    const CSRGraph &g=mol.getCSRGraph();
   
     // Start path at each bond
     PATH_LIST res;
@@ -308,8 +303,9 @@ namespace Subgraphs {
 
       // if we're only returning paths rooted at a particular atom, check now
       // that this bond involves that atom:
-      if(rootedAtAtom>=0 && mol.getBondWithIdx(i)->getBeginAtomIdx()!=rootedAtAtom &&
-         mol.getBondWithIdx(i)->getEndAtomIdx()!=rootedAtAtom ){
+      if(rootedAtAtom>=0 &&
+         g.getBondBeginAtomIdx(i)!=static_cast<unsigned int>(rootedAtAtom) &&
+         g.getBondEndAtomIdx(i)!=static_cast<unsigned int>(rootedAtAtom) ){
         continue;
       }
 
@@ -345,6 +341,7 @@ namespace Subgraphs {
 
     INT_INT_VECT_MAP nbrs;
     Subgraphs::getNbrsList(mol, useHs,nbrs);
+    const CSRGraph &g=mol.getCSRGraph();
   
     // Start path at each bond
     INT_PATH_LIST_MAP res;
@@ -360,8 +357,9 @@ namespace Subgraphs {
 
       // if we're only returning paths rooted at a particular atom, check now
       // that this bond involves that atom:
-      if(rootedAtAtom>=0 && mol.getBondWithIdx(i)->getBeginAtomIdx()!=rootedAtAtom &&
-         mol.getBondWithIdx(i)->getEndAtomIdx()!=rootedAtAtom ){
+      if(rootedAtAtom>=0 &&
+         g.getBondBeginAtomIdx(i)!=static_cast<unsigned int>(rootedAtAtom) &&
+         g.getBondEndAtomIdx(i)!=static_cast<unsigned int>(rootedAtAtom) ){
         continue;
       }
 
@@ -490,6 +488,7 @@ namespace Subgraphs {
       res[1]=atomPaths[1];
     }
     if(useBonds || upperLen>1){
+      const CSRGraph &g=mol.getCSRGraph();
       for(unsigned int i=lowerLen;i<=upperLen;++i){
         if(i<=1){
           continue;
@@ -504,9 +503,9 @@ namespace Subgraphs {
           PATH_TYPE locV;
           locV.reserve(i);
           for(unsigned int j=0;j<i-1;j++){
-            const Bond *bond=mol.getBondBetweenAtoms(resi[j],resi[j+1]);
-            locV.push_back(bond->getIdx());
-            invar.set(bond->getIdx());
+            int bIdx=g.getBondIdxBetweenAtoms(resi[j],resi[j+1]);
+            locV.push_back(bIdx);
+            invar.set(bIdx);
           }
           if(std::find(invars.begin(),invars.end(),invar)==invars.end()){
             invars.push_back(invar);
@@ -532,15 +531,12 @@ namespace Subgraphs {
     if(rootedAtAtom>=mol.getNumAtoms()) throw ValueErrorException("bad atom index");
 
     PATH_TYPE res;
+    const CSRGraph &g=mol.getCSRGraph();
     std::list< std::pair<int,int> > nbrStack;
-    ROMol::OEDGE_ITER beg,end;
-    boost::tie(beg,end) = mol.getAtomBonds(mol.getAtomWithIdx(rootedAtAtom));
-    while(beg!=end){
-      BOND_SPTR bond=mol[*beg];
-      if(useHs || mol.getAtomWithIdx(bond->getOtherAtomIdx(rootedAtAtom))->getAtomicNum()!=1){
-        nbrStack.push_back(std::make_pair(rootedAtAtom,bond->getIdx()));
+    for(unsigned int slot=g.getSlotBegin(rootedAtAtom);slot!=g.getSlotEnd(rootedAtAtom);++slot){
+      if(useHs || g.getAtom(g.getSlotTarget(slot))->getAtomicNum()!=1){
+        nbrStack.push_back(std::make_pair(rootedAtAtom,g.getSlotBondIdx(slot)));
       }
-      ++beg;
     }
     boost::dynamic_bitset<> bondsIn(mol.getNumBonds());
     unsigned int i;
@@ -559,16 +555,14 @@ namespace Subgraphs {
           res.push_back(bondIdx);
 
           // add the next set of neighbors:
-          int oAtom=mol.getBondWithIdx(bondIdx)->getOtherAtomIdx(startAtom);
-          boost::tie(beg,end) = mol.getAtomBonds(mol.getAtomWithIdx(oAtom));
-          while(beg!=end){
-            BOND_SPTR bond=mol[*beg];
-            if(!bondsIn.test(bond->getIdx())){
-              if(useHs || mol.getAtomWithIdx(bond->getOtherAtomIdx(oAtom))->getAtomicNum()!=1){
-                nextLayer.push_back(std::make_pair(oAtom,bond->getIdx()));
+          int oAtom=g.getOtherAtomIdx(bondIdx,startAtom);
+          for(unsigned int slot=g.getSlotBegin(oAtom);slot!=g.getSlotEnd(oAtom);++slot){
+            unsigned int nbrBondIdx=g.getSlotBondIdx(slot);
+            if(!bondsIn.test(nbrBondIdx)){
+              if(useHs || g.getAtom(g.getSlotTarget(slot))->getAtomicNum()!=1){
+                nextLayer.push_back(std::make_pair(oAtom,nbrBondIdx));
               }
             }
-            ++beg;
           }
         }
       }
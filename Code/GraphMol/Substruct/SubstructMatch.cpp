@@ -16,8 +16,12 @@
 #include "SubstructUtils.h"
 #include <boost/smart_ptr.hpp>
 #include <map>
+#include <algorithm>
 #ifdef RDK_THREADSAFE_SSS
 #include <boost/thread/mutex.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
 #endif
 
 #include "ullmann.hpp"
@@ -133,38 +137,38 @@ namespace RDKit{
     class AtomLabelFunctor{
     public:
       AtomLabelFunctor(const ROMol &query,const ROMol &mol, bool useChirality) :
-        d_query(query), d_mol(mol), df_useChirality(useChirality) {};
+        d_query(query.getCSRGraph()), d_mol(mol.getCSRGraph()), df_useChirality(useChirality) {};
       bool operator()(unsigned int i,unsigned int j) const{
         bool res=false;
+        const Atom *qAt=d_query.getAtom(i);
+        const Atom *mAt=d_mol.getAtom(j);
         if(df_useChirality){
-          const Atom *qAt=d_query.getAtomWithIdx(i);
           if(qAt->getChiralTag()==Atom::CHI_TETRAHEDRAL_CW ||
              qAt->getChiralTag()==Atom::CHI_TETRAHEDRAL_CCW) {
-            const Atom *mAt=d_mol.getAtomWithIdx(j);
             if(mAt->getChiralTag()!=Atom::CHI_TETRAHEDRAL_CW &&
                mAt->getChiralTag()!=Atom::CHI_TETRAHEDRAL_CCW) return false;
           }
         }
-        res=atomCompat(d_query[i],d_mol[j]);
+        res=atomCompat(qAt,mAt);
         return res;
       }
     private:
-      const ROMol &d_query;
-      const ROMol &d_mol;
+      const CSRGraph &d_query;
+      const CSRGraph &d_mol;
       bool df_useChirality;
     };
     class BondLabelFunctor{
     public:
       BondLabelFunctor(const ROMol &query,const ROMol &mol,bool useChirality) :
-        d_query(query), d_mol(mol),df_useChirality(useChirality) {};
-      bool operator()(MolGraph::edge_descriptor i,MolGraph::edge_descriptor j) const{
-        bool res=bondCompat(d_query[i],d_mol[j]);
+        d_query(query.getCSRGraph()), d_mol(mol.getCSRGraph()),df_useChirality(useChirality) {};
+      bool operator()(CSRGraph::edge_descriptor i,CSRGraph::edge_descriptor j) const{
+        const Bond *qBnd=d_query.getBond(d_query.getSlotBondIdx(i));
+        const Bond *mBnd=d_mol.getBond(d_mol.getSlotBondIdx(j));
+        bool res=bondCompat(qBnd,mBnd);
         if(df_useChirality){
-          const BOND_SPTR qBnd=d_query[i];
           if(qBnd->getBondType()==Bond::DOUBLE &&
              (qBnd->getStereo()==Bond::STEREOZ ||
               qBnd->getStereo()==Bond::STEREOE)){
-            const BOND_SPTR mBnd=d_mol[j];
             if(mBnd->getBondType()==Bond::DOUBLE &&
                !(mBnd->getStereo()==Bond::STEREOZ ||
                  mBnd->getStereo()==Bond::STEREOE))
@@ -175,8 +179,8 @@ namespace RDKit{
         return res;
       }
     private:
-      const ROMol &d_query;
-      const ROMol &d_mol;
+      const CSRGraph &d_query;
+      const CSRGraph &d_mol;
       bool df_useChirality;
     };
   }    
@@ -214,7 +218,7 @@ namespace RDKit{
     bool res=boost::ullmann(query.getTopology(),mol.getTopology(),
                             atomLabeler,bondLabeler,match);
 #else
-    bool res=boost::vf2(query.getTopology(),mol.getTopology(),
+    bool res=boost::vf2(query.getCSRGraph(),mol.getCSRGraph(),
                         atomLabeler,bondLabeler,matchChecker,match);
 #endif
     if(res){
@@ -247,7 +251,7 @@ namespace RDKit{
   unsigned int SubstructMatch(const ROMol &mol,const ROMol &query,
 			      std::vector< MatchVectType > &matches,
 			      bool uniquify,bool recursionPossible,
-			      bool useChirality){
+			      bool useChirality,unsigned int maxMatches){
 
     if(recursionPossible){
       detail::SUBQUERY_MAP subqueryMap;
@@ -272,8 +276,8 @@ namespace RDKit{
     bool found=boost::ullmann_all(query.getTopology(),mol.getTopology(),
                                   atomLabeler,bondLabeler,pms);
 #else
-    bool found=boost::vf2_all(query.getTopology(),mol.getTopology(),
-                              atomLabeler,bondLabeler,matchChecker,pms);
+    bool found=boost::vf2_all(query.getCSRGraph(),mol.getCSRGraph(),
+                              atomLabeler,bondLabeler,matchChecker,pms,maxMatches);
 #endif
     unsigned int res=0;
     if(found){
@@ -308,6 +312,143 @@ namespace RDKit{
     return res;
   }
 
+  namespace detail {
+    // hands out blocks of molecule indices to the screening threads.
+    // Threads come back for more work as soon as they finish a block, so
+    // expensive molecules don't leave the other threads idle.
+    class ScreenBlockQueue {
+    public:
+      ScreenBlockQueue(unsigned int nItems,unsigned int blockSize) :
+        d_next(0), d_nItems(nItems), d_blockSize(blockSize) {};
+      bool getBlock(unsigned int &start,unsigned int &end){
+#ifdef RDK_THREADSAFE_SSS
+        boost::mutex::scoped_lock lock(d_mutex);
+#endif
+        if(d_next>=d_nItems) return false;
+        start=d_next;
+        end=std::min(d_nItems,d_next+d_blockSize);
+        d_next=end;
+        return true;
+      }
+    private:
+      unsigned int d_next,d_nItems,d_blockSize;
+#ifdef RDK_THREADSAFE_SSS
+      boost::mutex d_mutex;
+#endif
+    };
+
+    // small blocks keep the load balanced, but each block costs a trip
+    // through the queue's mutex
+    const unsigned int screenBlockSize=8;
+
+    void screenHitsWorker(const std::vector<ROMol *> &mols,const ROMol &query,
+                          ScreenBlockQueue &queue,std::vector<char> &hits,
+                          bool recursionPossible,bool useChirality){
+      unsigned int start,end;
+      while(queue.getBlock(start,end)){
+        for(unsigned int i=start;i<end;++i){
+          if(!mols[i]) continue;
+          MatchVectType matchVect;
+          hits[i]=SubstructMatch(*mols[i],query,matchVect,
+                                 recursionPossible,useChirality);
+        }
+      }
+    }
+
+    void screenMatchesWorker(const std::vector<ROMol *> &mols,const ROMol &query,
+                             ScreenBlockQueue &queue,
+                             std::vector< std::vector<MatchVectType> > &matches,
+                             bool uniquify,bool recursionPossible,bool useChirality){
+      unsigned int start,end;
+      while(queue.getBlock(start,end)){
+        for(unsigned int i=start;i<end;++i){
+          if(!mols[i]) continue;
+          SubstructMatch(*mols[i],query,matches[i],uniquify,
+                         recursionPossible,useChirality);
+        }
+      }
+    }
+
+    unsigned int getNumScreenThreads(unsigned int numThreads,unsigned int nMols){
+#ifdef RDK_THREADSAFE_SSS
+      if(!numThreads){
+        numThreads=boost::thread::hardware_concurrency();
+      }
+#else
+      numThreads=1;
+#endif
+      numThreads=std::min(numThreads,(nMols+screenBlockSize-1)/screenBlockSize);
+      return std::max(numThreads,1U);
+    }
+  } // end of namespace detail
+
+  unsigned int SubstructScreen(const std::vector<ROMol *> &mols,const ROMol &query,
+                               std::vector<unsigned int> &hits,
+                               bool recursionPossible,bool useChirality,
+                               unsigned int numThreads){
+    hits.clear();
+    std::vector<char> hitFlags(mols.size(),0);
+    detail::ScreenBlockQueue queue(mols.size(),detail::screenBlockSize);
+    numThreads=detail::getNumScreenThreads(numThreads,mols.size());
+    if(numThreads==1){
+      detail::screenHitsWorker(mols,query,queue,hitFlags,
+                               recursionPossible,useChirality);
+    }
+#ifdef RDK_THREADSAFE_SSS
+    else {
+      // each thread gets its own copy of the query, and with it its own
+      // recursive-match state:
+      std::vector< boost::shared_ptr<ROMol> > queries;
+      boost::thread_group tg;
+      for(unsigned int i=0;i<numThreads;++i){
+        queries.push_back(boost::shared_ptr<ROMol>(new ROMol(query)));
+        tg.add_thread(new boost::thread(detail::screenHitsWorker,
+                                        boost::cref(mols),boost::cref(*queries[i]),
+                                        boost::ref(queue),boost::ref(hitFlags),
+                                        recursionPossible,useChirality));
+      }
+      tg.join_all();
+    }
+#endif
+    for(unsigned int i=0;i<hitFlags.size();++i){
+      if(hitFlags[i]) hits.push_back(i);
+    }
+    return hits.size();
+  }
+
+  unsigned int SubstructScreen(const std::vector<ROMol *> &mols,const ROMol &query,
+                               std::vector< std::vector<MatchVectType> > &matches,
+                               bool uniquify,bool recursionPossible,
+                               bool useChirality,unsigned int numThreads){
+    matches.clear();
+    matches.resize(mols.size());
+    detail::ScreenBlockQueue queue(mols.size(),detail::screenBlockSize);
+    numThreads=detail::getNumScreenThreads(numThreads,mols.size());
+    if(numThreads==1){
+      detail::screenMatchesWorker(mols,query,queue,matches,uniquify,
+                                  recursionPossible,useChirality);
+    }
+#ifdef RDK_THREADSAFE_SSS
+    else {
+      std::vector< boost::shared_ptr<ROMol> > queries;
+      boost::thread_group tg;
+      for(unsigned int i=0;i<numThreads;++i){
+        queries.push_back(boost::shared_ptr<ROMol>(new ROMol(query)));
+        tg.add_thread(new boost::thread(detail::screenMatchesWorker,
+                                        boost::cref(mols),boost::cref(*queries[i]),
+                                        boost::ref(queue),boost::ref(matches),
+                                        uniquify,recursionPossible,useChirality));
+      }
+      tg.join_all();
+    }
+#endif
+    unsigned int res=0;
+    for(unsigned int i=0;i<matches.size();++i){
+      if(!matches[i].empty()) ++res;
+    }
+    return res;
+  }
+
   namespace detail {
     unsigned int RecursiveMatcher(const ROMol &mol,const ROMol &query,
 				  std::vector< int > &matches,bool useChirality,
@@ -331,7 +472,7 @@ namespace RDKit{
       bool found=boost::ullmann_all(query.getTopology(),mol.getTopology(),
 				    atomLabeler,bondLabeler,pms);
 #else
-      bool found=boost::vf2_all(query.getTopology(),mol.getTopology(),
+      bool found=boost::vf2_all(query.getCSRGraph(),mol.getCSRGraph(),
 				atomLabeler,bondLabeler,matchChecker,pms);
 #endif
       unsigned int res=0;
@@ -48,6 +48,10 @@ namespace RDKit{
       \param uniquify  Toggles uniquification (by atom index) of the results
       \param recursionPossible  flags whether or not recursive matches are allowed
       \param useChirality  use atomic CIP codes as part of the comparison
+      \param maxMatches  the maximum number of matches to find, zero for no
+                         limit. The search stops as soon as this many
+                         have been found, the limit is applied before
+                         uniquification.
 
       \return the number of matches found
     
@@ -55,7 +59,58 @@ namespace RDKit{
   unsigned int SubstructMatch(const ROMol &mol,const ROMol &query,
 			      std::vector< MatchVectType > &matchVect,
 			      bool uniquify=true,bool recursionPossible=true,
-			      bool useChirality=false);
+			      bool useChirality=false,unsigned int maxMatches=0);
+
+  //! Find which molecules in a collection match a query
+  /*!
+      \param mols      The molecules to be searched
+      \param query     The query ROMol
+      \param hits      Used to return the indices (in \c mols) of the
+                       molecules which match, in increasing order
+                       (pre-existing contents will be deleted)
+      \param recursionPossible  flags whether or not recursive matches are allowed
+      \param useChirality  use atomic CIP codes as part of the comparison
+      \param numThreads    the number of threads to use, 0 uses one per
+                           available core
+
+      \return the number of matching molecules
+
+      <b>Notes:</b>
+        - null entries in \c mols (e.g. from a supplier that failed to
+          parse a record) are skipped
+        - each thread works on its own copy of the query, so recursive
+          queries do not serialize the threads
+        - \c numThreads is ignored (a single thread is used) unless the
+          RDKit was built with RDK_THREADSAFE_SSS
+  */
+  unsigned int SubstructScreen(const std::vector<ROMol *> &mols,const ROMol &query,
+                               std::vector<unsigned int> &hits,
+                               bool recursionPossible=true,
+                               bool useChirality=false,
+                               unsigned int numThreads=1);
+
+  //! Find all substructure matches for a query in a collection of molecules
+  /*!
+      \param mols      The molecules to be searched
+      \param query     The query ROMol
+      \param matches   Used to return the matches: \c matches[i] holds the
+                       matches to \c mols[i]
+                       (pre-existing contents will be deleted)
+      \param uniquify  Toggles uniquification (by atom index) of the results
+      \param recursionPossible  flags whether or not recursive matches are allowed
+      \param useChirality  use atomic CIP codes as part of the comparison
+      \param numThreads    the number of threads to use, 0 uses one per
+                           available core
+
+      \return the number of molecules with at least one match
+
+      See the notes on the other form of SubstructScreen()
+  */
+  unsigned int SubstructScreen(const std::vector<ROMol *> &mols,const ROMol &query,
+                               std::vector< std::vector<MatchVectType> > &matches,
+                               bool uniquify=true,bool recursionPossible=true,
+                               bool useChirality=false,
+                               unsigned int numThreads=1);
 }
 
 #endif
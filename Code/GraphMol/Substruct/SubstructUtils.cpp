@@ -16,7 +16,7 @@
 
 namespace RDKit{
 
-  bool atomCompat(const ATOM_SPTR a1,const ATOM_SPTR a2){
+  bool atomCompat(const Atom *a1,const Atom *a2){
     PRECONDITION(a1,"bad atom");
     PRECONDITION(a2,"bad atom");
     //std::cerr << "\t\tatomCompat: "<< a1 << " " << a1->getIdx() << "-" << a2 << " " << a2->getIdx() << std::endl;
@@ -24,7 +24,7 @@ namespace RDKit{
     return res;
   }
 
-  bool chiralAtomCompat(const ATOM_SPTR a1,const ATOM_SPTR a2){
+  bool chiralAtomCompat(const Atom *a1,const Atom *a2){
     PRECONDITION(a1,"bad atom");
     PRECONDITION(a2,"bad atom");
     //std::cerr << "\t\tatomCompat: "<< a1 << " " << a1->getIdx() << "-" << a2 << " " << a2->getIdx() << std::endl;
@@ -45,7 +45,7 @@ namespace RDKit{
     return res;
   }
 
-  bool bondCompat(const BOND_SPTR b1,const BOND_SPTR b2){
+  bool bondCompat(const Bond *b1,const Bond *b2){
     PRECONDITION(b1,"bad bond");
     PRECONDITION(b2,"bad bond");
     bool res = b1->Match(b2);
@@ -53,6 +53,16 @@ namespace RDKit{
     return res;
   }
 
+  bool atomCompat(const ATOM_SPTR a1,const ATOM_SPTR a2){
+    return atomCompat(a1.get(),a2.get());
+  }
+  bool chiralAtomCompat(const ATOM_SPTR a1,const ATOM_SPTR a2){
+    return chiralAtomCompat(a1.get(),a2.get());
+  }
+  bool bondCompat(const BOND_SPTR b1,const BOND_SPTR b2){
+    return bondCompat(b1.get(),b2.get());
+  }
+
   void removeDuplicates(std::vector<MatchVectType> &v,unsigned int nAtoms){
     //
     //  This works by tracking the indices of the atoms in each match vector.  
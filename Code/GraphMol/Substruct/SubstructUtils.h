@@ -22,8 +22,11 @@ namespace RDKit{
   
   double toPrime(const MatchVectType &v);
   void removeDuplicates(std::vector<MatchVectType> &v,unsigned int nAtoms);
+  bool atomCompat(const Atom *a1,const Atom *a2);
   bool atomCompat(const ATOM_SPTR a1,const ATOM_SPTR a2);
+  bool chiralAtomCompat(const Atom *a1,const Atom *a2);
   bool chiralAtomCompat(const ATOM_SPTR a1,const ATOM_SPTR a2);
+  bool bondCompat(const Bond *b1,const Bond *b2);
   bool bondCompat(const BOND_SPTR b1,const BOND_SPTR b2);
 }
 
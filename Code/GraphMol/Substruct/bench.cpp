@@ -23,6 +23,10 @@
 #include "SubstructMatch.h"
 #include "SubstructUtils.h"
 #include <cstdlib>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread.hpp>
+#endif
 
 using namespace RDKit;
 
@@ -40,15 +44,74 @@ void test1(int stopAfter=1000){
   for(int i=0;i<stopAfter;i++){
     ROMol *mol=suppl[i];
     if(mol){
-      n = SubstructMatch(mol,q,matches,true);
+      n = SubstructMatch(*mol,*q,matches,true);
+      delete mol;
+    }
+  }
+  delete q;
+  std::cout << "Done\n" << std::endl;
+}
+
+void benchScreenScaling(unsigned int maxThreads=0){
+  std::cout << " ----------------- Screen scaling" << std::endl;
+  std::string fName=getenv("RDBASE");
+  fName += "/Data/NCI/first_5K.smi";
+  SmilesMolSupplier suppl(fName,"\t",0,1,false);
+  std::vector<ROMol *> mols;
+  while(!suppl.atEnd()){
+    ROMol *mol=0;
+    try{
+      mol=suppl.next();
+    } catch(...){
+      continue;
+    }
+    if(mol) mols.push_back(mol);
+  }
+  std::cout << " read " << mols.size() << " molecules" << std::endl;
+
+  if(!maxThreads){
+#ifdef RDK_THREADSAFE_SSS
+    maxThreads=boost::thread::hardware_concurrency();
+#endif
+    if(!maxThreads) maxThreads=1;
+  }
+
+  std::vector<std::string> smas;
+  smas.push_back("c1ccccc1");
+  smas.push_back("C1[C;X4][D3]1");
+  smas.push_back("[#6;$([#6]([#6])[!#6])]");
+  smas.push_back("[$([O,S]-[!$(*=O)])]");
+  for(unsigned int qi=0;qi<smas.size();++qi){
+    RWMol *q = SmartsToMol(smas[qi]);
+    TEST_ASSERT(q);
+    double t1=0.0;
+    for(unsigned int nThreads=1;nThreads<=maxThreads;++nThreads){
+      std::vector<unsigned int> hits;
+      boost::posix_time::ptime start=boost::posix_time::microsec_clock::universal_time();
+      // repeat so that the times are large enough to be meaningful:
+      for(unsigned int iter=0;iter<5;++iter){
+        SubstructScreen(mols,*q,hits,true,false,nThreads);
+      }
+      boost::posix_time::ptime finish=boost::posix_time::microsec_clock::universal_time();
+      double t=(finish-start).total_microseconds()/1e6;
+      if(nThreads==1) t1=t;
+      std::cout << "  " << smas[qi] << " threads: " << nThreads
+                << " hits: " << hits.size()
+                << " time: " << t << "s speedup: " << (t>0 ? t1/t : 0.0)
+                << std::endl;
     }
+    delete q;
   }
+  for(unsigned int i=0;i<mols.size();++i) delete mols[i];
   std::cout << "Done\n" << std::endl;
 }
 
 int main(int argc,char *argv[])
 {
   test1();  
+  unsigned int maxThreads=0;
+  if(argc>1) maxThreads=atoi(argv[1]);
+  benchScreenScaling(maxThreads);
   return 0;
 }
 
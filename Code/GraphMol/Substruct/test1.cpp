@@ -617,6 +617,26 @@ void testRecursiveSerialNumbers(){
   std::cout << "Done\n" << std::endl;
 }
 
+namespace {
+  // reads up to maxMols entries from the NCI test file; entries that fail
+  // to parse are returned as null pointers if keepNulls is set
+  void readNCIMols(std::vector<ROMol *> &mols,bool keepNulls,
+                   unsigned int maxMols=0){
+    std::string fName = getenv("RDBASE");
+    fName += "/Data/NCI/first_200.props.sdf";
+    SDMolSupplier suppl(fName);
+    while(!suppl.atEnd() && (!maxMols || mols.size()<maxMols)){
+      ROMol *mol=0;
+      try{
+        mol=suppl.next();
+      } catch(...){
+        continue;
+      }
+      if(mol || keepNulls) mols.push_back(mol);
+    }
+  }
+}
+
 #ifdef RDK_TEST_MULTITHREADED
 #include <boost/thread.hpp>  
 #include <boost/dynamic_bitset.hpp>
@@ -640,21 +660,9 @@ void testMultiThread(){
   BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
   BOOST_LOG(rdErrorLog) << "    Test multithreading" << std::endl;
 
-  std::string fName = getenv("RDBASE");
-  fName += "/Data/NCI/first_200.props.sdf";
-  SDMolSupplier suppl(fName);
   std::cerr<<"reading molecules"<<std::endl;
   std::vector<ROMol *> mols;
-  while(!suppl.atEnd()&&mols.size()<100){
-    ROMol *mol=0;
-    try{
-      mol=suppl.next();
-    } catch(...){
-      continue;
-    }
-    if(!mol) continue;
-    mols.push_back(mol);
-  }
+  readNCIMols(mols,false,100);
   boost::thread_group tg;
 
   ROMol *query=SmartsToMol("[#6;$([#6]([#6])[!#6])]");
@@ -1018,6 +1026,74 @@ void testGitHubIssue15(){
 
   BOOST_LOG(rdErrorLog) << "  done" << std::endl;
 }
+
+void testSubstructScreen(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Test SubstructScreen" << std::endl;
+
+  // keep the null entries, they should be skipped
+  std::vector<ROMol *> mols;
+  readNCIMols(mols,true);
+
+  std::vector<std::string> smas;
+  smas.push_back("[#6]([#6])[!#6]");
+  smas.push_back("[#6;$([#6]([#6])[!#6])]");
+  smas.push_back("[$([O,S]-[!$(*=O)])]");
+  for(unsigned int qi=0;qi<smas.size();++qi){
+    ROMol *query=SmartsToMol(smas[qi]);
+    TEST_ASSERT(query);
+
+    std::vector<unsigned int> refHits;
+    std::vector< std::vector<MatchVectType> > refMatches(mols.size());
+    for(unsigned int i=0;i<mols.size();++i){
+      if(!mols[i]) continue;
+      MatchVectType matchV;
+      if(SubstructMatch(*mols[i],*query,matchV)) refHits.push_back(i);
+      SubstructMatch(*mols[i],*query,refMatches[i]);
+    }
+    TEST_ASSERT(refHits.size());
+
+    for(unsigned int nThreads=1;nThreads<=4;++nThreads){
+      std::vector<unsigned int> hits;
+      unsigned int nHits=SubstructScreen(mols,*query,hits,true,false,nThreads);
+      TEST_ASSERT(nHits==refHits.size());
+      TEST_ASSERT(hits==refHits);
+
+      std::vector< std::vector<MatchVectType> > matches;
+      nHits=SubstructScreen(mols,*query,matches,true,true,false,nThreads);
+      TEST_ASSERT(nHits==refHits.size());
+      TEST_ASSERT(matches.size()==mols.size());
+      for(unsigned int i=0;i<mols.size();++i){
+        TEST_ASSERT(matches[i]==refMatches[i]);
+      }
+    }
+    delete query;
+  }
+  for(unsigned int i=0;i<mols.size();++i) delete mols[i];
+
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+
+void testMaxMatches(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Test limiting the number of matches" << std::endl;
+
+  ROMol *mol=SmilesToMol("c1ccccc1");
+  TEST_ASSERT(mol);
+  std::vector<MatchVectType> matches;
+  TEST_ASSERT(SubstructMatch(*mol,*mol,matches,false)==12);
+  std::vector<MatchVectType> someMatches;
+  TEST_ASSERT(SubstructMatch(*mol,*mol,someMatches,false,true,false,5)==5);
+  for(unsigned int i=0;i<someMatches.size();++i){
+    TEST_ASSERT(someMatches[i]==matches[i]);
+  }
+  // the limit is applied before uniquifying:
+  TEST_ASSERT(SubstructMatch(*mol,*mol,someMatches,true,true,false,5)==1);
+  delete mol;
+
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+
 int main(int argc,char *argv[])
 {
 #if 1
@@ -1037,6 +1113,8 @@ int main(int argc,char *argv[])
   testCisTransMatch();
 #endif
   testGitHubIssue15();
+  testSubstructScreen();
+  testMaxMatches();
   return 0;
 }
 
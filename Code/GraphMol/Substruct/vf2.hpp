@@ -10,6 +10,10 @@
  *    Author: P. Foggia
  *  http://amalfi.dis.unina.it/graph/db/vflib-2.0/doc/vflib.html
  *
+ * The graph functions (out_edges(), edge(), etc.) are called
+ * unqualified so that graph types other than the BGL ones
+ * (e.g. RDKit::CSRGraph) can be used through argument-dependent lookup.
+ *
  */
 #include <boost/graph/adjacency_list.hpp>
 #include <vector>
@@ -56,9 +60,9 @@ namespace boost{
 
     template <class Graph,class VertexDescr,class EdgeDescr> 
     VertexDescr getOtherIdx(const Graph &g,const EdgeDescr &edge,const VertexDescr &vertex) {
-      VertexDescr tmp=boost::source(edge,g);
+      VertexDescr tmp=source(edge,g);
       if(tmp==vertex){
-        tmp=boost::target(edge,g);
+        tmp=target(edge,g);
       }
       return tmp;
     }
@@ -78,14 +82,14 @@ namespace boost{
     template <class Graph>
     node_id* SortNodesByFrequency(const Graph *g) {
       std::vector<NodeInfo> vect;
-      vect.reserve(boost::num_vertices(*g));
+      vect.reserve(num_vertices(*g));
       typename Graph::vertex_iterator bNode,eNode;
-      boost::tie(bNode,eNode) = boost::vertices(*g);
+      boost::tie(bNode,eNode) = vertices(*g);
       while(bNode!=eNode){
         NodeInfo t;
         t.id=vect.size();
-        t.in=boost::out_degree(*bNode,*g);// <- assuming undirected graph
-        t.out=boost::out_degree(*bNode,*g); 
+        t.in=out_degree(*bNode,*g);// <- assuming undirected graph
+        t.out=out_degree(*bNode,*g); 
         vect.push_back(t);
         ++bNode;
       }
@@ -359,14 +363,14 @@ namespace boost{
 
         // Check the out edges of node1
         typename Graph::out_edge_iterator bNbrs,eNbrs;
-        boost::tie(bNbrs,eNbrs) = boost::out_edges(node1,*g1);
+        boost::tie(bNbrs,eNbrs) = out_edges(node1,*g1);
         while(bNbrs!=eNbrs){
           other1=getOtherIdx(*g1,*bNbrs,node1);
           if (core_1[other1] != NULL_NODE) {
             other2 = core_1[other1];
             typename Graph::edge_descriptor oEdge;
             bool found;
-            boost::tie(oEdge,found) = boost::edge(node2,other2,*g2);
+            boost::tie(oEdge,found) = edge(node2,other2,*g2);
             if(!found || !ec(*bNbrs,oEdge) ){
               //std::cerr<<"  short2"<<std::endl;
               return false;
@@ -380,7 +384,7 @@ namespace boost{
         }
 
         // Check the out edges of node2
-        boost::tie(bNbrs,eNbrs) = boost::out_edges(node2,*g2);
+        boost::tie(bNbrs,eNbrs) = out_edges(node2,*g2);
         while(bNbrs!=eNbrs){
           other2=getOtherIdx(*g2,*bNbrs,node2);
           if (core_2[other2] != NULL_NODE) {
@@ -432,7 +436,7 @@ namespace boost{
 
         typename Graph::out_edge_iterator bNbrs,eNbrs;
         // FIX: this is explicitly ignoring directionality
-        boost::tie(bNbrs,eNbrs) = boost::out_edges(node1,*g1);
+        boost::tie(bNbrs,eNbrs) = out_edges(node1,*g1);
         while(bNbrs!=eNbrs){
           unsigned int other = getOtherIdx(*g1,*bNbrs,node1);
           if (!in_1[other]) {
@@ -449,7 +453,7 @@ namespace boost{
         }
 
         // FIX: this is explicitly ignoring directionality
-        boost::tie(bNbrs,eNbrs) = boost::out_edges(node2,*g2);
+        boost::tie(bNbrs,eNbrs) = out_edges(node2,*g2);
         while(bNbrs!=eNbrs){
           unsigned int other = getOtherIdx(*g2,*bNbrs,node2);
           if (!in_2[other]) {
@@ -489,7 +493,7 @@ namespace boost{
           if (out_1[added_node1] == core_len)  out_1[added_node1] = 0;
 
           typename Graph::out_edge_iterator bNbrs,eNbrs;
-          boost::tie(bNbrs,eNbrs) = boost::out_edges(added_node1,*g1);
+          boost::tie(bNbrs,eNbrs) = out_edges(added_node1,*g1);
           while(bNbrs!=eNbrs){
             unsigned int other = getOtherIdx(*g1,*bNbrs,added_node1);
             if (out_1[other] == core_len) out_1[other] = 0;
@@ -501,7 +505,7 @@ namespace boost{
           if (in_2[node2] == core_len) in_2[node2] = 0;
           if (out_2[node2] == core_len) out_2[node2] = 0;
 
-          boost::tie(bNbrs,eNbrs) = boost::out_edges(node2,*g2);
+          boost::tie(bNbrs,eNbrs) = out_edges(node2,*g2);
           while(bNbrs!=eNbrs){
             unsigned int other = getOtherIdx(*g2,*bNbrs,node2);
             if (out_2[other] == core_len) out_2[other] = 0;
@@ -562,11 +566,13 @@ namespace boost{
      * Visits all the matchings between two graphs,  starting
      * from state s.
      * Returns true if the caller must stop the visit.
-     * Stops when there are no more matches
+     * Stops when there are no more matches or when max_results
+     * matches have been found (if max_results is nonzero)
      *
      ------------------------------------------------------------*/
     template <class SubState,class DoubleBackInsertionSequence>
-    bool match(node_id c1[], node_id c2[], SubState &s, DoubleBackInsertionSequence &res) {
+    bool match(node_id c1[], node_id c2[], SubState &s, DoubleBackInsertionSequence &res,
+               unsigned int max_results) {
       if (s.IsGoal()){
         s.GetCoreSet(c1, c2);
         if(s.MatchChecks(c1,c2)) {
@@ -575,6 +581,7 @@ namespace boost{
             newSeq.push_back(std::pair<int,int>(c1[i],c2[i]));
           }
           res.push_back(newSeq);
+          if(max_results && res.size()>=max_results) return true;
         }
         return false;
       }
@@ -587,7 +594,7 @@ namespace boost{
         if (s.IsFeasiblePair(n1, n2)){
           SubState *s1=s.Clone();
           s1->AddPair(n1, n2);
-          if (match(c1, c2, *s1,res)){
+          if (match(c1, c2, *s1,res,max_results)){
             s1->BackTrack(); 
             delete s1;
             return true;
@@ -641,7 +648,8 @@ namespace boost{
                VertexLabeling& vertex_labeling,
                EdgeLabeling& edge_labeling,
                MatchChecking& match_checking,
-               DoubleBackInsertionSequence& F) {
+               DoubleBackInsertionSequence& F,
+               unsigned int max_results=0) {
     detail::VF2SubState<const Graph,VertexLabeling,EdgeLabeling,MatchChecking> s0(&g1,&g2,vertex_labeling,
                                                                                   edge_labeling,match_checking,false);
     detail::node_id *ni1 = new detail::node_id[num_vertices(g1)];
@@ -650,7 +658,7 @@ namespace boost{
     F.clear();
     F.resize(0);
 
-    match(ni1,ni2,s0,F);
+    match(ni1,ni2,s0,F,max_results);
 
     delete [] ni1;
     delete [] ni2;
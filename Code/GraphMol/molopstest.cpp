@@ -4236,6 +4236,88 @@ void testGitHubIssue42()
 
 
 
+void testLazyRingPerception(){
+  BOOST_LOG(rdInfoLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdInfoLog) << "Testing ring perception on demand" << std::endl;
+  {
+    RWMol *m=SmilesToMol("C1CC2CCC1C2CC",0,0);
+    TEST_ASSERT(m);
+    TEST_ASSERT(!m->getRingInfo()->isInitialized());
+    TEST_ASSERT(m->getRingInfo()->getPerceptionType()==RingInfo::UNINITIALIZED);
+
+    // ring membership only needs fastFindRings():
+    RWMol *q=SmartsToMol("[R]");
+    TEST_ASSERT(q);
+    std::vector<MatchVectType> matches;
+    TEST_ASSERT(SubstructMatch(*m,*q,matches)==7);
+    TEST_ASSERT(m->getRingInfo()->getPerceptionType()==RingInfo::MEMBERSHIP);
+    delete q;
+
+    // ring sizes need the SSSR:
+    q=SmartsToMol("[r5]");
+    TEST_ASSERT(q);
+    TEST_ASSERT(SubstructMatch(*m,*q,matches)==7);
+    TEST_ASSERT(m->getRingInfo()->getPerceptionType()==RingInfo::SSSR);
+    TEST_ASSERT(m->getRingInfo()->numRings()==2);
+    delete q;
+    q=SmartsToMol("[R2]");
+    TEST_ASSERT(q);
+    TEST_ASSERT(SubstructMatch(*m,*q,matches)==3);
+    delete q;
+    q=SmartsToMol("[x3]");
+    TEST_ASSERT(q);
+    TEST_ASSERT(SubstructMatch(*m,*q,matches)==2);
+    delete q;
+
+    // an SSSR is not replaced:
+    MolOps::fastFindRings(*m);
+    TEST_ASSERT(m->getRingInfo()->getPerceptionType()==RingInfo::SSSR);
+    MolOps::findRingsIfNeeded(*m,RingInfo::MEMBERSHIP);
+    TEST_ASSERT(m->getRingInfo()->getPerceptionType()==RingInfo::SSSR);
+    delete m;
+  }
+  {
+    // findSSSR() replaces ring membership information:
+    RWMol *m=SmilesToMol("C12C3C4C1C5C2C3C45",0,0);
+    TEST_ASSERT(m);
+    MolOps::fastFindRings(*m);
+    TEST_ASSERT(m->getRingInfo()->getPerceptionType()==RingInfo::MEMBERSHIP);
+    TEST_ASSERT(m->getRingInfo()->numAtomRings(0));
+    MolOps::findRingsIfNeeded(*m,RingInfo::SSSR);
+    TEST_ASSERT(m->getRingInfo()->getPerceptionType()==RingInfo::SSSR);
+    TEST_ASSERT(m->getRingInfo()->numRings()==5);
+    for(unsigned int i=0;i<m->getNumAtoms();++i){
+      TEST_ASSERT(m->getRingInfo()->minAtomRingSize(i)==4);
+      TEST_ASSERT(m->getRingInfo()->isAtomInRingOfSize(i,4));
+      TEST_ASSERT(!m->getRingInfo()->isAtomInRingOfSize(i,5));
+    }
+    delete m;
+  }
+  {
+    // large rings:
+    std::string smi="C1CC2CC1";
+    for(unsigned int i=0;i<32;++i) smi+="C";
+    smi+="2";
+    RWMol *m=SmilesToMol(smi);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getRingInfo()->numRings()==2);
+    TEST_ASSERT(m->getRingInfo()->minAtomRingSize(0)==5);
+    TEST_ASSERT(m->getRingInfo()->minAtomRingSize(2)==5);
+    TEST_ASSERT(m->getRingInfo()->isAtomInRingOfSize(2,5));
+    TEST_ASSERT(m->getRingInfo()->isAtomInRingOfSize(2,35));
+    TEST_ASSERT(!m->getRingInfo()->isAtomInRingOfSize(0,35));
+    TEST_ASSERT(m->getRingInfo()->minAtomRingSize(6)==35);
+    TEST_ASSERT(m->getRingInfo()->isAtomInRingOfSize(6,35));
+    TEST_ASSERT(!m->getRingInfo()->isAtomInRingOfSize(6,31));
+    TEST_ASSERT(m->getRingInfo()->isBondInRingOfSize(m->getBondBetweenAtoms(6,7)->getIdx(),35));
+    TEST_ASSERT(m->getRingInfo()->minBondRingSize(m->getBondBetweenAtoms(6,7)->getIdx())==35);
+    TEST_ASSERT(m->getRingInfo()->minAtomRingSize(m->getNumAtoms()+1)==0);
+    TEST_ASSERT(!m->getRingInfo()->isAtomInRingOfSize(m->getNumAtoms()+1,5));
+    delete m;
+  }
+  BOOST_LOG(rdInfoLog) << "\tdone" << std::endl;
+}
+
 int main(){
   RDLog::InitLogs();
   //boost::logging::enable_logs("rdApp.debug");
@@ -4299,6 +4381,7 @@ int main(){
 #endif
   testGitHubIssue8();
   testGitHubIssue42();
+  testLazyRingPerception();
   return 0;
 }
 
@@ -11,6 +11,7 @@
 
 #include <GraphMol/RDKitBase.h>
 #include <GraphMol/RDKitQueries.h>
+#include <GraphMol/ConformerArena.h>
 #include <RDGeneral/types.h>
 #include <RDGeneral/RDLog.h>
 //#include <boost/log/functions.hpp>
@@ -954,6 +955,187 @@ void testIssue284()
 }
 
 
+void testCSRGraph()
+{
+  BOOST_LOG(rdInfoLog) << "-----------------------\n";
+  BOOST_LOG(rdInfoLog) << "Testing the CSRGraph topology view" << std::endl;
+  {
+    RWMol m;
+    m.addAtom(new Atom(6));
+    m.addAtom(new Atom(7));
+    m.addAtom(new Atom(8));
+    m.addAtom(new Atom(6));
+    m.addBond(0,1,Bond::SINGLE);
+    m.addBond(1,2,Bond::DOUBLE);
+    m.addBond(1,3,Bond::SINGLE);
+
+    const CSRGraph &g=m.getCSRGraph();
+    TEST_ASSERT(g.getNumAtoms()==4);
+    TEST_ASSERT(g.getNumBonds()==3);
+    TEST_ASSERT(g.getDegree(0)==1);
+    TEST_ASSERT(g.getDegree(1)==3);
+    TEST_ASSERT(g.getAtom(1)->getAtomicNum()==7);
+    // the view is only built once:
+    TEST_ASSERT(&m.getCSRGraph()==&g);
+    TEST_ASSERT(g.getAtom(2)==m.getAtomWithIdx(2));
+    TEST_ASSERT(g.getBond(1)==m.getBondWithIdx(1));
+    TEST_ASSERT(g.getBondIdxBetweenAtoms(1,2)==1);
+    TEST_ASSERT(g.getBondIdxBetweenAtoms(2,1)==1);
+    TEST_ASSERT(g.getBondIdxBetweenAtoms(0,2)==-1);
+    TEST_ASSERT(g.getOtherAtomIdx(2,3)==1);
+
+    // the neighbor ordering matches the BGL graph:
+    for(unsigned int i=0;i<m.getNumAtoms();++i){
+      ROMol::ADJ_ITER nbr,endNbrs;
+      boost::tie(nbr,endNbrs) = m.getAtomNeighbors(m.getAtomWithIdx(i));
+      ROMol::OEDGE_ITER bnd,endBnds;
+      boost::tie(bnd,endBnds) = m.getAtomBonds(m.getAtomWithIdx(i));
+      CSRGraph::IDX_ITER cnbr,cendNbrs;
+      boost::tie(cnbr,cendNbrs) = g.getAtomNeighbors(i);
+      CSRGraph::IDX_ITER cbnd=g.getAtomBonds(i).first;
+      while(nbr!=endNbrs){
+        TEST_ASSERT(cnbr!=cendNbrs);
+        TEST_ASSERT(*cnbr==*nbr);
+        TEST_ASSERT(*cbnd==m[*bnd]->getIdx());
+        ++nbr;++cnbr;
+        ++bnd;++cbnd;
+      }
+      TEST_ASSERT(cnbr==cendNbrs);
+    }
+
+    // changing the topology invalidates the view:
+    m.addBond(2,3,Bond::SINGLE);
+    const CSRGraph &g2=m.getCSRGraph();
+    TEST_ASSERT(g2.getNumBonds()==4);
+    TEST_ASSERT(g2.getDegree(3)==2);
+    TEST_ASSERT(g2.getBondIdxBetweenAtoms(3,2)==3);
+
+    m.removeBond(0,1);
+    TEST_ASSERT(m.getCSRGraph().getNumBonds()==3);
+    TEST_ASSERT(m.getCSRGraph().getDegree(0)==0);
+    TEST_ASSERT(m.getCSRGraph().getBondIdxBetweenAtoms(3,2)==2);
+
+    m.removeAtom(static_cast<unsigned int>(0));
+    TEST_ASSERT(m.getCSRGraph().getNumAtoms()==3);
+    TEST_ASSERT(m.getCSRGraph().getAtom(0)->getAtomicNum()==7);
+    // in-place changes to the atoms are seen through the view:
+    m.getAtomWithIdx(0)->setAtomicNum(9);
+    TEST_ASSERT(m.getCSRGraph().getAtom(0)->getAtomicNum()==9);
+
+    // copies get their own view:
+    ROMol m2(m);
+    TEST_ASSERT(m2.getCSRGraph().getNumAtoms()==3);
+    TEST_ASSERT(m2.getCSRGraph().getAtom(0)==m2.getAtomWithIdx(0));
+    TEST_ASSERT(m2.getCSRGraph().getAtom(0)!=m.getAtomWithIdx(0));
+  }
+  BOOST_LOG(rdInfoLog) << "Finished" << std::endl;
+}
+
+void testConformerArena()
+{
+  BOOST_LOG(rdInfoLog) << "-----------------------\n";
+  BOOST_LOG(rdInfoLog) << "Testing ConformerArena" << std::endl;
+  RWMol m;
+  m.addAtom(new Atom(6));
+  m.addAtom(new Atom(7));
+  m.addAtom(new Atom(8));
+  for(unsigned int i=0;i<3;++i){
+    Conformer *conf = new Conformer(m.getNumAtoms());
+    for(unsigned int j=0;j<m.getNumAtoms();++j){
+      conf->setAtomPos(j,RDGeom::Point3D(i+0.5,j+0.25,-1.0*i*j));
+    }
+    conf->set3D(i!=1);
+    m.addConformer(conf,true);
+  }
+  m.removeConformer(1);
+
+  {
+    DoubleConformerArena arena(m);
+    TEST_ASSERT(arena.getNumAtoms()==3);
+    TEST_ASSERT(arena.getNumConformers()==2);
+    TEST_ASSERT(arena.getConformerId(0)==0);
+    TEST_ASSERT(arena.getConformerId(1)==2);
+    TEST_ASSERT(arena.getConformerIndex(2)==1);
+    TEST_ASSERT(arena.getConformerIndex(1)==-1);
+    TEST_ASSERT(arena.is3D(1));
+    TEST_ASSERT(arena.getData().size()==18);
+    const double *coords=arena.getCoords(1);
+    TEST_ASSERT(feq(coords[3*2+2],m.getConformer(2).getAtomPos(2).z));
+    TEST_ASSERT(feq(arena.getAtomPos(1,1).y,1.25));
+    arena.setAtomPos(1,1,RDGeom::Point3D(1,2,3));
+    TEST_ASSERT(feq(arena.getAtomPos(1,1).y,2.0));
+
+    // the pickle round trips:
+    std::string pkl=arena.toString();
+    DoubleConformerArena arena2(pkl);
+    TEST_ASSERT(arena2.getNumAtoms()==3);
+    TEST_ASSERT(arena2.getNumConformers()==2);
+    TEST_ASSERT(arena2.getConformerId(1)==2);
+    TEST_ASSERT(arena2.getData()==arena.getData());
+
+    // as do conformers:
+    Conformer *conf=arena2.getConformer(1);
+    TEST_ASSERT(conf->getId()==2);
+    TEST_ASSERT(conf->is3D());
+    TEST_ASSERT(feq(conf->getAtomPos(1).z,3.0));
+    TEST_ASSERT(feq(conf->getAtomPos(2).x,m.getConformer(2).getAtomPos(2).x));
+    delete conf;
+
+    // pickles can be read with a different precision:
+    FloatConformerArena farena(pkl);
+    TEST_ASSERT(farena.getNumConformers()==2);
+    for(unsigned int i=0;i<farena.getData().size();++i){
+      TEST_ASSERT(feq(farena.getData()[i],arena.getData()[i]));
+    }
+
+    // counts that don't match the length of the pickle are caught
+    // before anything is allocated:
+    for(unsigned int offset=8;offset<16;offset+=4){
+      std::string bad=pkl;
+      for(unsigned int i=offset;i<offset+4;++i) bad[i]='\xff';
+      bool ok=false;
+      try {
+        DoubleConformerArena badArena(bad);
+      } catch (const ValueErrorException &) {
+        ok=true;
+      }
+      TEST_ASSERT(ok);
+    }
+    {
+      bool ok=false;
+      try {
+        DoubleConformerArena badArena(pkl.substr(0,10));
+      } catch (const ValueErrorException &) {
+        ok=true;
+      }
+      TEST_ASSERT(ok);
+    }
+  }
+  {
+    FloatConformerArena arena(m.getNumAtoms());
+    TEST_ASSERT(arena.getNumConformers()==0);
+    arena.addConformer(m.getConformer(2));
+    arena.addConformer(m.getConformer(0));
+    TEST_ASSERT(arena.getNumConformers()==2);
+    TEST_ASSERT(arena.getConformerIndex(0)==1);
+    TEST_ASSERT(arena.getData().size()==18);
+
+    RWMol m2(m);
+    m2.clearConformers();
+    arena.addConformersToMol(m2);
+    TEST_ASSERT(m2.getNumConformers()==2);
+    TEST_ASSERT(!m2.getConformer(0).is3D()==!m.getConformer(0).is3D());
+    for(unsigned int i=0;i<m.getNumAtoms();++i){
+      TEST_ASSERT(feq(m2.getConformer(2).getAtomPos(i).x,m.getConformer(2).getAtomPos(i).x));
+      TEST_ASSERT(feq(m2.getConformer(2).getAtomPos(i).z,m.getConformer(2).getAtomPos(i).z));
+    }
+
+    FloatConformerArena arena2(arena.toString());
+    TEST_ASSERT(arena2.getData()==arena.getData());
+  }
+  BOOST_LOG(rdInfoLog) << "Finished" << std::endl;
+}
+
 // -------------------------------------------------------------------
 int main()
 {
@@ -976,6 +1158,8 @@ int main()
   testIssue267();
   testIssue284();
   testClearMol();
+  testCSRGraph();
+  testConformerArena();
   
   return 0;
 }
@@ -917,6 +917,288 @@ void testIssue285(){
   BOOST_LOG(rdErrorLog) << "\tdone" << std::endl;
 }
 
+void testV8Pickles(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "Testing version 8 pickles." << std::endl;
+
+  {
+    RWMol *m1 = SmilesToMol("[13CH3:2][C@H](F)/C=C/c1cc[nH+]cc1.[CH2]Cl");
+    TEST_ASSERT(m1);
+    Conformer *conf=new Conformer(m1->getNumAtoms());
+    conf->setId(3);
+    for(unsigned int i=0;i<m1->getNumAtoms();++i){
+      conf->setAtomPos(i,RDGeom::Point3D(1.5*i,-0.25*i,2.0));
+    }
+    m1->addConformer(conf,false);
+    conf=new Conformer(m1->getNumAtoms());
+    conf->set3D(false);
+    unsigned int confId=m1->addConformer(conf,true);
+
+    std::string pickle;
+    MolPickler::pickleMol(*m1,pickle);
+    int32_t version;
+    memcpy(&version,pickle.c_str()+2*sizeof(int32_t),sizeof(int32_t));
+    TEST_ASSERT(version==8);
+
+    RWMol m2(pickle);
+    TEST_ASSERT(m2.getNumAtoms()==m1->getNumAtoms());
+    TEST_ASSERT(m2.getNumBonds()==m1->getNumBonds());
+    TEST_ASSERT(MolToSmiles(m2,true)==MolToSmiles(*m1,true));
+    TEST_ASSERT(m2.getAtomWithIdx(0)->getIsotope()==13);
+    TEST_ASSERT(feq(m2.getAtomWithIdx(0)->getMass(),m1->getAtomWithIdx(0)->getMass()));
+    TEST_ASSERT(m2.getAtomWithIdx(0)->hasProp("molAtomMapNumber"));
+    TEST_ASSERT(m2.getAtomWithIdx(1)->getChiralTag()==m1->getAtomWithIdx(1)->getChiralTag());
+    TEST_ASSERT(m2.getAtomWithIdx(8)->getFormalCharge()==1);
+    TEST_ASSERT(m2.getAtomWithIdx(8)->getNumExplicitHs()==1);
+    TEST_ASSERT(m2.getAtomWithIdx(11)->getNumRadicalElectrons()==1);
+    for(unsigned int i=0;i<m1->getNumAtoms();++i){
+      TEST_ASSERT(m2.getAtomWithIdx(i)->getIdx()==i);
+      TEST_ASSERT(&m2.getAtomWithIdx(i)->getOwningMol()==&m2);
+      TEST_ASSERT(m2.getAtomWithIdx(i)->getImplicitValence()==
+                  m1->getAtomWithIdx(i)->getImplicitValence());
+    }
+    for(unsigned int i=0;i<m1->getNumBonds();++i){
+      const Bond *b1=m1->getBondWithIdx(i);
+      const Bond *b2=m2.getBondWithIdx(i);
+      TEST_ASSERT(b2->getIdx()==i);
+      TEST_ASSERT(b2->getBeginAtomIdx()==b1->getBeginAtomIdx());
+      TEST_ASSERT(b2->getEndAtomIdx()==b1->getEndAtomIdx());
+      TEST_ASSERT(b2->getBondType()==b1->getBondType());
+      TEST_ASSERT(b2->getBondDir()==b1->getBondDir());
+      TEST_ASSERT(b2->getStereo()==b1->getStereo());
+      TEST_ASSERT(b2->getStereoAtoms()==b1->getStereoAtoms());
+      TEST_ASSERT(b2->getIsAromatic()==b1->getIsAromatic());
+      TEST_ASSERT(b2->getIsConjugated()==b1->getIsConjugated());
+    }
+    TEST_ASSERT(m2.getRingInfo()->getPerceptionType()==RingInfo::SSSR);
+    TEST_ASSERT(m2.getRingInfo()->numRings()==1);
+    TEST_ASSERT(m2.getRingInfo()->isBondInRingOfSize(6,6));
+    TEST_ASSERT(m2.getNumConformers()==2);
+    TEST_ASSERT(m2.getConformer(3).is3D());
+    TEST_ASSERT(!m2.getConformer(confId).is3D());
+    for(unsigned int i=0;i<m1->getNumAtoms();++i){
+      TEST_ASSERT(feq(m2.getConformer(3).getAtomPos(i).x,1.5*i));
+      TEST_ASSERT(feq(m2.getConformer(3).getAtomPos(i).y,-0.25*i));
+      TEST_ASSERT(feq(m2.getConformer(3).getAtomPos(i).z,2.0));
+    }
+
+    // the buffer and stream interfaces give the same results:
+    ROMol m3;
+    MolPickler::molFromPickle(pickle.c_str(),pickle.size(),m3);
+    TEST_ASSERT(MolToSmiles(m3,true)==MolToSmiles(*m1,true));
+    std::stringstream ss(std::ios_base::binary|std::ios_base::out|std::ios_base::in);
+    MolPickler::pickleMol(*m1,ss);
+    TEST_ASSERT(ss.str()==pickle);
+    ROMol m4;
+    MolPickler::molFromPickle(ss,m4);
+    TEST_ASSERT(MolToSmiles(m4,true)==MolToSmiles(*m1,true));
+    delete m1;
+  }
+
+  {
+    // pickles that follow each other in a stream:
+    ROMol *m1 = SmilesToMol("c1ccccc1O");
+    TEST_ASSERT(m1);
+    ROMol *m2 = SmilesToMol("CC(=O)[O-].[Na+]");
+    TEST_ASSERT(m2);
+    std::stringstream ss(std::ios_base::binary|std::ios_base::out|std::ios_base::in);
+    MolPickler::pickleMol(*m1,ss);
+    MolPickler::pickleMol(*m2,ss);
+    ROMol m3,m4;
+    MolPickler::molFromPickle(ss,m3);
+    MolPickler::molFromPickle(ss,m4);
+    TEST_ASSERT(MolToSmiles(m3,true)==MolToSmiles(*m1,true));
+    TEST_ASSERT(MolToSmiles(m4,true)==MolToSmiles(*m2,true));
+
+    // depickling into a molecule that already has atoms:
+    std::string pickle;
+    MolPickler::pickleMol(*m2,pickle);
+    MolPickler::molFromPickle(pickle,m3);
+    TEST_ASSERT(m3.getNumAtoms()==m1->getNumAtoms()+m2->getNumAtoms());
+    TEST_ASSERT(m3.getBondWithIdx(m1->getNumBonds())->getBeginAtomIdx()==m1->getNumAtoms());
+    delete m1;
+    delete m2;
+  }
+
+  {
+    // big molecules use 32 bit atom indices:
+    std::string smi="C1CC1";
+    for(unsigned int i=0;i<300;++i) smi+="C";
+    smi+="C1CCCCC1";
+    ROMol *m1 = SmilesToMol(smi);
+    TEST_ASSERT(m1);
+    TEST_ASSERT(m1->getNumAtoms()>255);
+    std::string pickle;
+    MolPickler::pickleMol(*m1,pickle);
+    ROMol m2(pickle);
+    TEST_ASSERT(MolToSmiles(m2,true)==MolToSmiles(*m1,true));
+    TEST_ASSERT(m2.getRingInfo()->numRings()==2);
+    TEST_ASSERT(m2.getRingInfo()->isAtomInRingOfSize(m1->getNumAtoms()-1,6));
+    TEST_ASSERT(!m2.getRingInfo()->numAtomRings(m1->getNumAtoms()-7));
+    delete m1;
+  }
+
+  {
+    // query molecules are still written in the version 7 format:
+    ROMol *m1 = SmartsToMol("[C,N]-,=[#6;R]");
+    TEST_ASSERT(m1);
+    std::string pickle;
+    MolPickler::pickleMol(*m1,pickle);
+    int32_t version;
+    memcpy(&version,pickle.c_str()+2*sizeof(int32_t),sizeof(int32_t));
+    TEST_ASSERT(version==7);
+    ROMol m2(pickle);
+    TEST_ASSERT(MolToSmarts(m2)==MolToSmarts(*m1));
+    delete m1;
+  }
+
+  {
+    // truncated pickles:
+    ROMol *m1 = SmilesToMol("C[C@H](F)/C=C/c1ccccc1");
+    TEST_ASSERT(m1);
+    m1->setProp("_Name","a name");
+    std::string pickle;
+    MolPickler::pickleMol(*m1,pickle,MolPickler::AllProps);
+    for(unsigned int len=0;len<pickle.size();++len){
+      ROMol m2;
+      bool ok=false;
+      try{
+        MolPickler::molFromPickle(pickle.c_str(),len,m2);
+      } catch (MolPicklerException &) {
+        ok=true;
+      }
+      TEST_ASSERT(ok);
+    }
+    delete m1;
+  }
+
+  {
+    // bad atom indices:
+    std::string smis[]={"C[13CH2]O","C[CH2:42]O","CCO","F/C=C/F","C1CC1",""};
+    // the entry with the index in each pickle and the offset of the
+    // index in it:
+    std::string patterns[]={std::string("\x01\x00\x00\x00\x01\x0d\x00\x00\x00",9),
+                            std::string("\x01\x00\x00\x00\x01\x2a\x00\x00\x00",9),
+                            std::string("\x01\x00\x00\x00\x01\x02\x00\x00\x00Xq",11),
+                            std::string("\x01\x00\x00\x00\x01\x00\x00\x00\x02\x00\x03",11),
+                            std::string("\x01\x00\x00\x00\x03\x00\x01\x02",8)};
+    unsigned int offsets[]={4,4,4,10,7};
+    for(unsigned int i=0;smis[i]!="";++i){
+      ROMol *m1 = SmilesToMol(smis[i]);
+      TEST_ASSERT(m1);
+      if(i==2) m1->getAtomWithIdx(1)->setProp("dummyLabel",std::string("Xq"));
+      std::string pickle;
+      MolPickler::pickleMol(*m1,pickle);
+      ROMol m2(pickle);
+      TEST_ASSERT(MolToSmiles(m2,true)==MolToSmiles(*m1,true));
+
+      size_t pos=pickle.find(patterns[i]);
+      TEST_ASSERT(pos!=std::string::npos);
+      pickle[pos+offsets[i]]='\x7f';
+      ROMol m3;
+      bool ok=false;
+      try{
+        MolPickler::molFromPickle(pickle,m3);
+      } catch (MolPicklerException &) {
+        ok=true;
+      }
+      TEST_ASSERT(ok);
+      delete m1;
+    }
+  }
+
+  BOOST_LOG(rdErrorLog) << "\tdone" << std::endl;
+}
+
+void testPickleProps(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "Testing pickling properties." << std::endl;
+
+  ROMol *m1 = SmilesToMol("CC(=O)O");
+  TEST_ASSERT(m1);
+  m1->setProp("_Name","acetic acid");
+  m1->setProp("intProp",-12);
+  m1->setProp("uintProp",12U);
+  m1->setProp("doubleProp",3.25);
+  m1->setProp("boolProp",true);
+  m1->setProp("computedProp",42,true);
+  std::vector<int> vect(2,1);
+  m1->setProp("vectProp",vect);
+  m1->getAtomWithIdx(2)->setProp("atomProp",std::string("carbonyl"));
+  m1->getBondWithIdx(1)->setProp("bondProp",2);
+
+  {
+    // by default no properties are pickled:
+    std::string pickle;
+    MolPickler::pickleMol(*m1,pickle);
+    ROMol m2(pickle);
+    TEST_ASSERT(!m2.hasProp("_Name"));
+    TEST_ASSERT(!m2.hasProp("intProp"));
+    TEST_ASSERT(!m2.getAtomWithIdx(2)->hasProp("atomProp"));
+    TEST_ASSERT(!m2.getBondWithIdx(1)->hasProp("bondProp"));
+  }
+  {
+    std::string pickle;
+    MolPickler::pickleMol(*m1,pickle,MolPickler::AllProps);
+    ROMol m2(pickle);
+    std::string sval;
+    m2.getProp("_Name",sval);
+    TEST_ASSERT(sval=="acetic acid");
+    int ival;
+    m2.getProp("intProp",ival);
+    TEST_ASSERT(ival==-12);
+    unsigned int uval;
+    m2.getProp("uintProp",uval);
+    TEST_ASSERT(uval==12);
+    double dval;
+    m2.getProp("doubleProp",dval);
+    TEST_ASSERT(dval==3.25);
+    bool bval;
+    m2.getProp("boolProp",bval);
+    TEST_ASSERT(bval);
+    TEST_ASSERT(!m2.hasProp("computedProp"));
+    TEST_ASSERT(!m2.hasProp("vectProp"));
+    m2.getAtomWithIdx(2)->getProp("atomProp",sval);
+    TEST_ASSERT(sval=="carbonyl");
+    TEST_ASSERT(!m2.getAtomWithIdx(1)->hasProp("atomProp"));
+    m2.getBondWithIdx(1)->getProp("bondProp",ival);
+    TEST_ASSERT(ival==2);
+  }
+  {
+    std::string pickle;
+    MolPickler::pickleMol(*m1,pickle,MolPickler::MolProps|MolPickler::BondProps);
+    ROMol m2(pickle);
+    TEST_ASSERT(m2.hasProp("_Name"));
+    TEST_ASSERT(!m2.getAtomWithIdx(2)->hasProp("atomProp"));
+    TEST_ASSERT(m2.getBondWithIdx(1)->hasProp("bondProp"));
+  }
+  {
+    // names from pickles that can't be read aren't added to the key table:
+    m1->setProp("pickleKeyA",1);
+    std::string pickle;
+    MolPickler::pickleMol(*m1,pickle,MolPickler::MolProps);
+    size_t pos=pickle.find("pickleKeyA");
+    TEST_ASSERT(pos!=std::string::npos);
+    pickle[pos+9]='Z';
+    ROMol m2;
+    bool ok=false;
+    try{
+      MolPickler::molFromPickle(pickle.c_str(),pos+10,m2);
+    } catch (MolPicklerException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    PropKey key;
+    TEST_ASSERT(!findPropKey("pickleKeyZ",key));
+    // but they are once the value is read:
+    ROMol m3(pickle);
+    TEST_ASSERT(m3.hasProp("pickleKeyZ"));
+    TEST_ASSERT(findPropKey("pickleKeyZ",key));
+  }
+  delete m1;
+  BOOST_LOG(rdErrorLog) << "\tdone" << std::endl;
+}
+
 
 int main(int argc, char *argv[]) {
   RDLog::InitLogs();
@@ -946,6 +1228,8 @@ int main(int argc, char *argv[]) {
   testIssue3496759();
   testIssue280();
   testIssue285();
+  testV8Pickles();
+  testPickleProps();
   
   return 0;
 
@@ -349,6 +349,71 @@ namespace RDNumeric {
       trans.SetTranslation(move);
       return ssr;
     }
+
+    double AlignCenteredPointsSSR(unsigned int npt,const double *refPts,
+                                  const double *probePts,
+                                  double refLenSq,double probeLenSq,
+                                  const unsigned int *probeIdx,
+                                  bool reflect) {
+      PRECONDITION(refPts,"bad reference points");
+      PRECONDITION(probePts,"bad probe points");
+      if(!npt) return 0.0;
+
+      // the covariance matrix:
+      double Sxx=0.0,Sxy=0.0,Sxz=0.0,Syx=0.0,Syy=0.0,Syz=0.0,Szx=0.0,Szy=0.0,Szz=0.0;
+      for(unsigned int i=0;i<npt;++i){
+        const double *r=refPts+3*i;
+        const double *p=probePts+3*(probeIdx ? probeIdx[i] : i);
+        Sxx += r[0]*p[0]; Sxy += r[0]*p[1]; Sxz += r[0]*p[2];
+        Syx += r[1]*p[0]; Syy += r[1]*p[1]; Syz += r[1]*p[2];
+        Szx += r[2]*p[0]; Szy += r[2]*p[1]; Szz += r[2]*p[2];
+      }
+      if(reflect){
+        Sxx=-Sxx; Sxy=-Sxy; Sxz=-Sxz;
+        Syx=-Syx; Syy=-Syy; Syz=-Syz;
+        Szx=-Szx; Szy=-Szy; Szz=-Szz;
+      }
+
+      // the coefficients of the characteristic polynomial of the 4x4 key
+      // matrix, x^4 + c2*x^2 + c1*x + c0:
+      double Sxx2=Sxx*Sxx,Syy2=Syy*Syy,Szz2=Szz*Szz;
+      double Sxy2=Sxy*Sxy,Syz2=Syz*Syz,Sxz2=Sxz*Sxz;
+      double Syx2=Syx*Syx,Szy2=Szy*Szy,Szx2=Szx*Szx;
+      double SyzSzymSyySzz2=2.0*(Syz*Szy-Syy*Szz);
+      double Sxx2Syy2Szz2Syz2Szy2=Syy2+Szz2-Sxx2+Syz2+Szy2;
+      double Sxy2Sxz2Syx2Szx2=Sxy2+Sxz2-Syx2-Szx2;
+      double SxzpSzx=Sxz+Szx,SyzpSzy=Syz+Szy,SxypSyx=Sxy+Syx;
+      double SyzmSzy=Syz-Szy,SxzmSzx=Sxz-Szx,SxymSyx=Sxy-Syx;
+      double SxxpSyy=Sxx+Syy,SxxmSyy=Sxx-Syy;
+
+      double c2=-2.0*(Sxx2+Syy2+Szz2+Sxy2+Syx2+Sxz2+Szx2+Syz2+Szy2);
+      double c1=8.0*(Sxx*Syz*Szy+Syy*Szx*Sxz+Szz*Sxy*Syx)
+        -8.0*(Sxx*Syy*Szz+Syz*Szx*Sxy+Szy*Syx*Sxz);
+      double c0=Sxy2Sxz2Syx2Szx2*Sxy2Sxz2Syx2Szx2
+        +(Sxx2Syy2Szz2Syz2Szy2+SyzSzymSyySzz2)*(Sxx2Syy2Szz2Syz2Szy2-SyzSzymSyySzz2)
+        +(-SxzpSzx*SyzmSzy+SxymSyx*(SxxmSyy-Szz))*(-SxzmSzx*SyzpSzy+SxymSyx*(SxxmSyy+Szz))
+        +(-SxzpSzx*SyzpSzy-SxypSyx*(SxxpSyy-Szz))*(-SxzmSzx*SyzmSzy-SxypSyx*(SxxpSyy+Szz))
+        +(SxypSyx*SyzpSzy+SxzpSzx*(SxxmSyy+Szz))*(-SxymSyx*SyzmSzy+SxzpSzx*(SxxpSyy+Szz))
+        +(SxypSyx*SyzmSzy+SxzmSzx*(SxxmSyy-Szz))*(-SxymSyx*SyzpSzy+SxzmSzx*(SxxpSyy-Szz));
+
+      // the largest eigenvalue is found with Newton's method, starting from
+      // its upper bound:
+      double e0=0.5*(refLenSq+probeLenSq);
+      double lambda=e0;
+      for(unsigned int iter=0;iter<50;++iter){
+        double old=lambda;
+        double x2=lambda*lambda;
+        double b=(x2+c2)*lambda;
+        double a=b+c1;
+        double denom=2.0*x2*lambda+b+a;
+        if(denom==0.0) break;
+        lambda -= (a*lambda+c0)/denom;
+        if(fabs(lambda-old)<fabs(1e-11*lambda)) break;
+      }
+      double ssr=2.0*(e0-lambda);
+      if(ssr<0.0) ssr=0.0;
+      return ssr;
+    }
   }
 }
 
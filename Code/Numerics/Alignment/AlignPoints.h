@@ -39,6 +39,34 @@ namespace RDNumeric {
                        RDGeom::Transform3D &trans,
                        const DoubleVector *weights=0, bool reflect=false, 
                        unsigned int maxIterations=50);
+
+    //! \brief Compute the minimum sum of squared distances between two sets
+    //! of centered points in 3D
+    /*!
+      Only the value is calculated, not the transformation. This uses the
+      closed-form quaternion characteristic polynomial (QCP) method, which is
+      much faster than AlignPoints():
+        D. L. Theobald, Acta Cryst. A61:478-480 (2005)
+
+      \param npt        the number of points
+      \param refPts     the reference points, as \c 3*npt contiguous coordinates
+                        (x0,y0,z0,x1,...). These must be centered on the origin.
+      \param probePts   the points to be aligned to refPts, these must also be
+                        centered on the origin
+      \param refLenSq   the sum of the squared lengths of refPts
+      \param probeLenSq the sum of the squared lengths of probePts
+      \param probeIdx   (optional) the index of the probe point paired with each
+                        reference point. By default point \c i is paired with
+                        point \c i
+      \param reflect    Add reflection is true
+
+      \return The sum of squared distances between the aligned points
+    */
+    double AlignCenteredPointsSSR(unsigned int npt,const double *refPts,
+                                  const double *probePts,
+                                  double refLenSq,double probeLenSq,
+                                  const unsigned int *probeIdx=0,
+                                  bool reflect=false);
   }
 }
 
@@ -15,6 +15,8 @@
 #include <Geometry/point.h>
 
 #include <math.h>
+#include <vector>
+#include <cstdlib>
 
 using namespace RDNumeric;
 using namespace RDNumeric::Alignments;
@@ -158,6 +160,77 @@ void testReflection() {
   
 }
 
+// centers the points and puts them in a contiguous array:
+double centerPoints(const RDGeom::Point3DConstPtrVect &pts,std::vector<double> &coords){
+  RDGeom::Point3D ctr;
+  for(unsigned int i=0;i<pts.size();++i) ctr += *pts[i];
+  ctr /= pts.size();
+  coords.resize(3*pts.size());
+  double lenSq=0.0;
+  for(unsigned int i=0;i<pts.size();++i){
+    RDGeom::Point3D p=*pts[i]-ctr;
+    coords[3*i]=p.x; coords[3*i+1]=p.y; coords[3*i+2]=p.z;
+    lenSq += p.lengthSq();
+  }
+  return lenSq;
+}
+
+void testCenteredSSR() {
+  // compare to AlignPoints on some random point sets:
+  std::srand(42);
+  for(unsigned int iter=0;iter<20;++iter){
+    unsigned int npt=3+iter*5;
+    std::vector<RDGeom::Point3D> rptStore(npt),qptStore(npt);
+    RDGeom::Point3DConstPtrVect rpts,qpts;
+    for(unsigned int i=0;i<npt;++i){
+      rptStore[i]=RDGeom::Point3D(10.0*std::rand()/RAND_MAX,
+                                  10.0*std::rand()/RAND_MAX,
+                                  10.0*std::rand()/RAND_MAX);
+      // a rotated and translated, noisy, copy:
+      const RDGeom::Point3D &p=rptStore[i];
+      qptStore[i]=RDGeom::Point3D(-p.y+5.0+0.5*std::rand()/RAND_MAX,
+                                  p.x-3.0+0.5*std::rand()/RAND_MAX,
+                                  p.z+1.0+0.5*std::rand()/RAND_MAX);
+    }
+    for(unsigned int i=0;i<npt;++i){
+      rpts.push_back(&rptStore[i]);
+      qpts.push_back(&qptStore[i]);
+    }
+    std::vector<double> rcoords,qcoords;
+    double rLenSq=centerPoints(rpts,rcoords);
+    double qLenSq=centerPoints(qpts,qcoords);
+
+    RDGeom::Transform3D trans;
+    double ssr=AlignPoints(rpts,qpts,trans);
+    double qcp=AlignCenteredPointsSSR(npt,&rcoords.front(),&qcoords.front(),rLenSq,qLenSq);
+    CHECK_INVARIANT(RDKit::feq(ssr,qcp,1e-4),"");
+    ssr=AlignPoints(rpts,qpts,trans,0,true);
+    qcp=AlignCenteredPointsSSR(npt,&rcoords.front(),&qcoords.front(),rLenSq,qLenSq,0,true);
+    CHECK_INVARIANT(RDKit::feq(ssr,qcp,1e-4),"");
+
+    // pairing the points through an index:
+    std::vector<unsigned int> idx(npt);
+    std::vector<double> qcoords2(3*npt);
+    for(unsigned int i=0;i<npt;++i){
+      idx[i]=npt-1-i;
+      for(unsigned int j=0;j<3;++j) qcoords2[3*idx[i]+j]=qcoords[3*i+j];
+    }
+    double qcp2=AlignCenteredPointsSSR(npt,&rcoords.front(),&qcoords2.front(),
+                                       rLenSq,qLenSq,&idx.front(),true);
+    CHECK_INVARIANT(RDKit::feq(qcp,qcp2),"");
+  }
+
+  // identical points:
+  RDGeom::Point3DConstPtrVect rpts;
+  RDGeom::Point3D rpt1(0.0, 0.0, 0.0); rpts.push_back(&rpt1);
+  RDGeom::Point3D rpt2(1.0, 0.0, 0.0); rpts.push_back(&rpt2);
+  RDGeom::Point3D rpt3(0.0, 1.0, 0.0); rpts.push_back(&rpt3);
+  std::vector<double> rcoords;
+  double rLenSq=centerPoints(rpts,rcoords);
+  double qcp=AlignCenteredPointsSSR(3,&rcoords.front(),&rcoords.front(),rLenSq,rLenSq);
+  CHECK_INVARIANT(RDKit::feq(qcp,0.0),"");
+}
+
 int main() {
   std::cout << "-----------------------------------------\n";
   std::cout << "Testing Alignment Code\n";
@@ -177,6 +250,10 @@ int main() {
   std::cout << "---------------------------------------\n";
   std::cout << "\t testReflection\n";
   testReflection();
+
+  std::cout << "---------------------------------------\n";
+  std::cout << "\t testCenteredSSR\n";
+  testCenteredSSR();
   std::cout << "---------------------------------------\n";
   return (0);
 }
@@ -7,9 +7,12 @@
 //  which is included in the file license.txt, found at the root
 //  of the RDKit source tree.
 //
+#ifndef __RD_BFGSOPT_H__
+#define __RD_BFGSOPT_H__
 #include <math.h>
 #include <RDGeneral/Invariant.h>
 #include <cstring>
+#include <algorithm>
 
 namespace BFGSOpt {
   const double FUNCTOL=1e-4;  //!< Default tolerance for function convergence in the minimizer
@@ -291,3 +294,4 @@ namespace BFGSOpt {
     return 1;
   }
 }
+#endif
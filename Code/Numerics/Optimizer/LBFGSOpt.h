@@ -0,0 +1,197 @@
+//
+// Copyright (C)  2013 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef __RD_LBFGSOPT_H__
+#define __RD_LBFGSOPT_H__
+#include "BFGSOpt.h"
+
+namespace LBFGSOpt {
+  const unsigned int HISTORYSIZE=8; //!< Default number of updates used to approximate the hessian
+
+#define LBFGS_CLEANUP() { delete [] grad; delete [] dGrad; delete [] newPos; \
+ delete [] xi; delete [] sHist; delete [] yHist; delete [] rho; delete [] alpha; }
+  //! Do a limited-memory BFGS minimization of a function.
+  /*!
+     See Nocedal and Wright, "Numerical Optimization", Section 7.2 for a
+     description of the algorithm.
+
+     Rather than storing the full inverse hessian, which needs \c dim*dim
+     doubles, it is approximated using the last \c historySize position and
+     gradient changes. This makes the memory use and the work per
+     iteration linear in \c dim.
+
+     The line search and the convergence criteria are the same as those
+     used by BFGSOpt::minimize(), so the two can be swapped.
+
+     \param dim     the dimensionality of the space.
+     \param pos   the starting position, as an array.
+     \param gradTol tolerance for gradient convergence
+     \param numIters used to return the number of iterations required
+     \param funcVal  used to return the final function value
+     \param func    the function to minimize
+     \param gradFunc  calculates the gradient of func
+     \param funcTol tolerance for changes in the function value for convergence.
+     \param maxIts   maximum number of iterations allowed
+     \param historySize the number of updates to keep
+
+     \return a flag indicating success (or type of failure). Possible values are:
+      -  0: success
+      -  1: too many iterations were required
+  */
+  template <typename EnergyFunctor,typename GradientFunctor>
+  int minimize(unsigned int dim,double *pos,
+               double gradTol,
+               unsigned int &numIters,
+               double &funcVal,
+               EnergyFunctor func,
+               GradientFunctor gradFunc,
+               double funcTol=BFGSOpt::TOLX,
+               unsigned int maxIts=BFGSOpt::MAXITS,
+               unsigned int historySize=HISTORYSIZE){
+    PRECONDITION(pos,"bad input array");
+    PRECONDITION(gradTol>0,"bad tolerance");
+    PRECONDITION(historySize>0,"bad history size");
+
+    double sum,maxStep,fp;
+
+    double *grad,*dGrad,*newPos,*xi;
+    double *sHist,*yHist,*rho,*alpha;
+
+    grad = new double[dim];
+    dGrad = new double[dim];
+    newPos = new double[dim];
+    xi = new double[dim];
+    sHist = new double[historySize*dim];
+    yHist = new double[historySize*dim];
+    rho = new double[historySize];
+    alpha = new double[historySize];
+
+    // the updates are stored in a ring, newest is the most recent:
+    unsigned int nStored=0,newest=0;
+    double gamma=1.0;
+
+    // evaluate the function and gradient in our current position:
+    fp=func(pos);
+    gradFunc(pos,grad);
+
+    sum = 0.0;
+    for(unsigned int i=0;i<dim;i++){
+      // the first line dir is -grad:
+      xi[i] = -grad[i];
+      sum += pos[i]*pos[i];
+    }
+    // pick a max step size:
+    maxStep = BFGSOpt::MAXSTEP * std::max(sqrt(sum),static_cast<double>(dim));
+
+    for(unsigned int iter=1;iter<=maxIts;iter++){
+      numIters=iter;
+      int status;
+
+      // do the line search:
+      BFGSOpt::linearSearch(dim,pos,fp,grad,xi,newPos,funcVal,func,maxStep,status);
+      if(status<0 && nStored){
+        // the approximate hessian has gone bad, start over
+        // from steepest descent:
+        nStored=0;
+        gamma=1.0;
+        for(unsigned int i=0;i<dim;i++){
+          xi[i] = -grad[i];
+        }
+        BFGSOpt::linearSearch(dim,pos,fp,grad,xi,newPos,funcVal,func,maxStep,status);
+      }
+      CHECK_INVARIANT(status>=0,"bad direction in linearSearch");
+
+      // save the function value for the next search:
+      fp = funcVal;
+
+      // set the direction of this line and save the gradient:
+      double test=0.0;
+      for(unsigned int i=0;i<dim;i++){
+        xi[i] = newPos[i]-pos[i];
+        pos[i] = newPos[i];
+        double temp=fabs(xi[i])/std::max(fabs(pos[i]),1.0);
+        if(temp>test) test=temp;
+        dGrad[i] = grad[i];
+      }
+      if(test<BFGSOpt::TOLX) {
+        LBFGS_CLEANUP();
+        return 0;
+      }
+
+      // update the gradient:
+      double gradScale=gradFunc(pos,grad);
+
+      // is the gradient converged?
+      test=0.0;
+      double term=std::max(funcVal*gradScale,1.0);
+      for(unsigned int i=0;i<dim;i++){
+        double temp=fabs(grad[i])*std::max(fabs(pos[i]),1.0);
+        test=std::max(test,temp);
+        dGrad[i] = grad[i]-dGrad[i];
+      }
+      test /= term;
+      if(test<gradTol){
+        LBFGS_CLEANUP();
+        return 0;
+      }
+
+      // store the update if the curvature condition holds:
+      double fac=0,sumDGrad=0,sumXi=0;
+      for(unsigned int i=0;i<dim;i++){
+        fac += dGrad[i]*xi[i];
+        sumDGrad += dGrad[i]*dGrad[i];
+        sumXi += xi[i]*xi[i];
+      }
+      if(fac > sqrt(BFGSOpt::EPS*sumDGrad*sumXi)){
+        newest = nStored ? (newest+1)%historySize : 0;
+        if(nStored<historySize) ++nStored;
+        memcpy(&sHist[newest*dim],xi,dim*sizeof(double));
+        memcpy(&yHist[newest*dim],dGrad,dim*sizeof(double));
+        rho[newest] = 1.0/fac;
+        gamma = fac/sumDGrad;
+      }
+
+      // generate the next direction to move using the two-loop recursion:
+      for(unsigned int i=0;i<dim;i++){
+        xi[i] = -grad[i];
+      }
+      for(unsigned int k=0;k<nStored;k++){
+        unsigned int idx=(newest+historySize-k)%historySize;
+        const double *s=&sHist[idx*dim],*y=&yHist[idx*dim];
+        double a=0.0;
+        for(unsigned int i=0;i<dim;i++){
+          a += s[i]*xi[i];
+        }
+        a *= rho[idx];
+        alpha[idx]=a;
+        for(unsigned int i=0;i<dim;i++){
+          xi[i] -= a*y[i];
+        }
+      }
+      for(unsigned int i=0;i<dim;i++){
+        xi[i] *= gamma;
+      }
+      for(unsigned int k=nStored;k>0;k--){
+        unsigned int idx=(newest+historySize-(k-1))%historySize;
+        const double *s=&sHist[idx*dim],*y=&yHist[idx*dim];
+        double b=0.0;
+        for(unsigned int i=0;i<dim;i++){
+          b += y[i]*xi[i];
+        }
+        b *= rho[idx];
+        for(unsigned int i=0;i<dim;i++){
+          xi[i] += (alpha[idx]-b)*s[i];
+        }
+      }
+    }
+    LBFGS_CLEANUP();
+    return 1;
+  }
+}
+#endif
@@ -13,6 +13,7 @@
 #include <RDGeneral/Invariant.h>
 
 #include "BFGSOpt.h"
+#include "LBFGSOpt.h"
 
 double circ_0_0(double *v){
   double dx=v[0];
@@ -167,7 +168,85 @@ void test2(){
 }
 
 
+// the n-dimensional Rosenbrock function:
+const unsigned int ROSEN_DIM=20;
+double rosenbrock(double *v){
+  double res=0.0;
+  for(unsigned int i=0;i<ROSEN_DIM-1;++i){
+    double t1=v[i+1]-v[i]*v[i];
+    double t2=1-v[i];
+    res += 100*t1*t1 + t2*t2;
+  }
+  return res;
+}
+
+double rosenbrock_grad(double *v,double *grad){
+  for(unsigned int i=0;i<ROSEN_DIM;++i) grad[i]=0.0;
+  for(unsigned int i=0;i<ROSEN_DIM-1;++i){
+    double t1=v[i+1]-v[i]*v[i];
+    grad[i] += -400*v[i]*t1 - 2*(1-v[i]);
+    grad[i+1] += 200*t1;
+  }
+  return 1.0;
+}
+
+void test3(){
+  std::cerr << "-------------------------------------" << std::endl;
+  std::cerr << "Testing L-BFGS optimization." << std::endl;
+
+  unsigned int dim=2;
+  double oLoc[2],oVal;
+  double nVal;
+  unsigned int nIters;
+  double (*func)(double *);
+  double (*gradFunc)(double *,double *);
+
+  func = circ_0_0;
+  gradFunc = circ_0_0_grad;
+  oLoc[0] = 0;oLoc[1] = 1.0;
+  oVal = func(oLoc);
+  TEST_ASSERT(fabs(oVal-1.0)<1e-4);
+
+  int res=LBFGSOpt::minimize(dim,oLoc,1e-4,nIters,nVal,func,gradFunc);
+  TEST_ASSERT(!res);
+  TEST_ASSERT(fabs(nVal)<1e-4);
+  TEST_ASSERT(fabs(oLoc[0])<1e-4);
+  TEST_ASSERT(fabs(oLoc[1])<1e-4);
+
+  func = func2;
+  gradFunc = grad2;
+  oLoc[0] = 2.0;oLoc[1] = 0.5;
+  res=LBFGSOpt::minimize(dim,oLoc,1e-4,nIters,nVal,func,gradFunc,1e-8);
+  TEST_ASSERT(!res);
+  TEST_ASSERT(fabs(nVal)<1e-4);
+  TEST_ASSERT(fabs(oLoc[0]-1)<1e-4);
+  TEST_ASSERT(fabs(oLoc[1])<1e-4);
+
+  // something harder, where a short history matters:
+  double loc[ROSEN_DIM],bLoc[ROSEN_DIM];
+  for(unsigned int i=0;i<ROSEN_DIM;++i){
+    loc[i] = (i%2) ? 1.2 : -1.0;
+    bLoc[i] = loc[i];
+  }
+  unsigned int bIters;
+  double bVal;
+  BFGSOpt::minimize(ROSEN_DIM,bLoc,1e-6,bIters,bVal,rosenbrock,rosenbrock_grad,
+                    1e-8,2000);
+  res=LBFGSOpt::minimize(ROSEN_DIM,loc,1e-6,nIters,nVal,rosenbrock,rosenbrock_grad,
+                         1e-8,2000,5);
+  TEST_ASSERT(!res);
+  TEST_ASSERT(nVal<1e-6);
+  TEST_ASSERT(fabs(nVal-bVal)<1e-6);
+  for(unsigned int i=0;i<ROSEN_DIM;++i){
+    TEST_ASSERT(fabs(loc[i]-1.0)<1e-3);
+  }
+
+  std::cerr << "  done" << std::endl;
+}
+
+
 int main(){
   test1();
   test2();
+  test3();
 }
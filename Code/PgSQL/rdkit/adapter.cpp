@@ -110,8 +110,7 @@ constructROMol(Mol *data) {
   ROMol   *mol = new ROMol();
         
   try {
-    ByteA b(data);
-    MolPickler::molFromPickle(b, mol);
+    MolPickler::molFromPickle(VARDATA(data), VARSIZE(data)-VARHDRSZ, mol);
   } catch (MolPicklerException& e) {
     elog(ERROR, "molFromPickle: %s", e.message());
   } catch (...) {
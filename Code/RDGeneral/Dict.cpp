@@ -15,6 +15,16 @@
 #include <boost/cstdint.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/utility.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/tss.hpp>
+#endif
+#include <RDGeneral/Invariant.h>
+#include <cstring>
+#include <deque>
 #include <vector>
 #include <list>
 #include <iostream>
@@ -22,6 +32,131 @@
 
 namespace RDKit{
   namespace {
+    struct CStrHash {
+      std::size_t operator()(const char *str) const {
+        return boost::hash_range(str,str+strlen(str));
+      }
+    };
+    struct CStrEqual {
+      bool operator()(const char *s1,const char *s2) const {
+        return !strcmp(s1,s2);
+      }
+    };
+    typedef boost::unordered_map<const char *,unsigned int,CStrHash,CStrEqual> IdMap;
+
+    // the table of interned property names. The names are stored in a
+    // deque so that they don't move as the table grows, the maps use
+    // pointers to them as keys.
+    //
+    // Names are looked up all the time and only rarely added. So that
+    // lookups don't take a lock, each thread has its own copy of the
+    // table, which is brought up to date (under the mutex) when a name or
+    // id isn't found in it.
+    class PropKeyTable {
+    public:
+      PropKeyTable() {
+        // these need to be in the same order as in common_properties:
+        const char *common[]={"_Name","__computedProps","_CIPCode","_CIPRank",
+                              "_ChiralityPossible","_StereochemDone","_ringStereoAtoms",
+                              "_ringStereochemCand","_doIsoSmiles","_RingClosures",
+                              "_SmilesStart","_unspecifiedOrder","_TraversalBondIndexOrder",
+                              "_TraversalRingClosureBond","_TraversalStartPoint",
+                              "_CanonRingClosureBondIndices","_smilesAtomOutputOrder",
+                              "_supplementalSmilesLabel","smilesSymbol","molAtomMapNumber",
+                              "dummyLabel","isImplicit","origNoImplicit"};
+        for(unsigned int i=0;i<common_properties::numCommonProperties;++i){
+          add(common[i]);
+        }
+      }
+#ifdef RDK_THREADSAFE_SSS
+      bool find(const char *name,unsigned int &id) const {
+        ThreadCopy &local=threadCopy();
+        if(lookup(local.ids,name,id)) return true;
+        boost::lock_guard<boost::mutex> lock(d_mutex);
+        update(local);
+        return lookup(local.ids,name,id);
+      }
+      unsigned int get(const char *name) {
+        unsigned int res;
+        if(find(name,res)) return res;
+        boost::lock_guard<boost::mutex> lock(d_mutex);
+        // someone else may have added it in the meantime:
+        if(lookup(d_ids,name,res)) return res;
+        return add(name);
+      }
+      const std::string &getName(unsigned int id) const {
+        ThreadCopy &local=threadCopy();
+        if(id>=local.names.size()){
+          boost::lock_guard<boost::mutex> lock(d_mutex);
+          update(local);
+        }
+        PRECONDITION(id<local.names.size(),"bad property key");
+        return *local.names[id];
+      }
+#else
+      bool find(const char *name,unsigned int &id) const {
+        return lookup(d_ids,name,id);
+      }
+      unsigned int get(const char *name) {
+        unsigned int res;
+        if(lookup(d_ids,name,res)) return res;
+        return add(name);
+      }
+      const std::string &getName(unsigned int id) const {
+        PRECONDITION(id<d_names.size(),"bad property key");
+        return d_names[id];
+      }
+#endif
+    private:
+      std::deque<std::string> d_names;
+      IdMap d_ids;
+
+      static bool lookup(const IdMap &ids,const char *name,unsigned int &id) {
+        IdMap::const_iterator pos=ids.find(name);
+        if(pos==ids.end()) return false;
+        id=pos->second;
+        return true;
+      }
+      // must be called with the mutex held
+      unsigned int add(const char *name) {
+        unsigned int res=d_names.size();
+        d_names.push_back(name);
+        d_ids[d_names.back().c_str()]=res;
+        return res;
+      }
+#ifdef RDK_THREADSAFE_SSS
+      struct ThreadCopy {
+        std::vector<const std::string *> names;
+        IdMap ids;
+      };
+      mutable boost::mutex d_mutex;
+      mutable boost::thread_specific_ptr<ThreadCopy> d_threadCopy;
+
+      ThreadCopy &threadCopy() const {
+        ThreadCopy *res=d_threadCopy.get();
+        if(!res){
+          res=new ThreadCopy();
+          d_threadCopy.reset(res);
+        }
+        return *res;
+      }
+      // adds the names added since the last update, must be called
+      // with the mutex held
+      void update(ThreadCopy &local) const {
+        for(unsigned int i=local.names.size();i<d_names.size();++i){
+          local.names.push_back(&d_names[i]);
+          local.ids[d_names[i].c_str()]=i;
+        }
+      }
+#endif
+    };
+    PropKeyTable &getPropKeyTable() {
+      // this is never deleted, so it outlives static objects that hold
+      // Dicts and threads that still have a copy of it:
+      static PropKeyTable *table=new PropKeyTable();
+      return *table;
+    }
+
     template <class T>
     std::string vectToString(const boost::any &val){
       const std::vector<T> &tv=boost::any_cast<std::vector<T> >(val);
@@ -34,7 +169,21 @@ namespace RDKit{
   }
   
   
-  void Dict::getVal(const std::string &what, std::string &res) const {
+  const std::string &PropKey::getName() const {
+    return getPropKeyTable().getName(id);
+  }
+  PropKey getPropKey(const char *name) {
+    PropKey res={getPropKeyTable().get(name)};
+    return res;
+  }
+  PropKey getPropKey(const std::string &name) {
+    return getPropKey(name.c_str());
+  }
+  bool findPropKey(const char *name,PropKey &key) {
+    return getPropKeyTable().find(name,key.id);
+  }
+
+  void Dict::getVal(PropKey what, std::string &res) const {
     //
     //  We're going to try and be somewhat crafty about this getVal stuff to make these
     //  containers a little bit more generic.  The normal behavior here is that the
@@ -42,8 +191,9 @@ namespace RDKit{
     //  little bit by trying that and, if the cast fails, attempting a couple of 
     //  other casts, which will then be lexically cast to type T.
     //
-    if(!hasVal(what) ) throw KeyErrorException(what);
-    const boost::any &val = _data.find(what)->second;
+    DataType::const_iterator pos=find(what);
+    if(pos==_data.end()) throw KeyErrorException(what.getName());
+    const boost::any &val = pos->second;
     try{
       res = boost::any_cast<std::string>(val);
     } catch (const boost::bad_any_cast &) {
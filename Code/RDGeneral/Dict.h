@@ -18,6 +18,7 @@
 #include <map>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <boost/any.hpp>
 #include <RDBoost/Exceptions.h>
 #include <boost/lexical_cast.hpp>
@@ -25,14 +26,72 @@
 namespace RDKit{
   typedef std::vector<std::string> STR_VECT;
 
+  //! \brief An interned property name
+  //!
+  //!  Each property name is assigned a small integer the first time it
+  //!  is seen, using a \c PropKey in place of the name avoids string
+  //!  comparisons and temporary strings in property lookups.
+  //!
+  struct PropKey {
+    unsigned int id;
+    //! returns the property name
+    const std::string &getName() const;
+    bool operator==(const PropKey &other) const { return id==other.id; };
+    bool operator!=(const PropKey &other) const { return id!=other.id; };
+  };
+
+  //! returns the \c PropKey for a name, adding it to the table if needed
+  PropKey getPropKey(const char *name);
+  //! \overload
+  PropKey getPropKey(const std::string &name);
+  //! looks up the \c PropKey for a name without adding it to the table
+  /*!
+     \return whether or not the name is in the table
+  */
+  bool findPropKey(const char *name,PropKey &key);
+
+  //! \brief keys for properties that are used internally by the RDKit
+  //!
+  //!  These are always in the table, so they can be used without any
+  //!  lookups.
+  namespace common_properties {
+    const PropKey _Name={0};
+    const PropKey __computedProps={1};
+    const PropKey _CIPCode={2};
+    const PropKey _CIPRank={3};
+    const PropKey _ChiralityPossible={4};
+    const PropKey _StereochemDone={5};
+    const PropKey _ringStereoAtoms={6};
+    const PropKey _ringStereochemCand={7};
+    const PropKey _doIsoSmiles={8};
+    const PropKey _RingClosures={9};
+    const PropKey _SmilesStart={10};
+    const PropKey _unspecifiedOrder={11};
+    const PropKey _TraversalBondIndexOrder={12};
+    const PropKey _TraversalRingClosureBond={13};
+    const PropKey _TraversalStartPoint={14};
+    const PropKey _CanonRingClosureBondIndices={15};
+    const PropKey _smilesAtomOutputOrder={16};
+    const PropKey _supplementalSmilesLabel={17};
+    const PropKey smilesSymbol={18};
+    const PropKey molAtomMapNumber={19};
+    const PropKey dummyLabel={20};
+    const PropKey isImplicit={21};
+    const PropKey origNoImplicit={22};
+    const unsigned int numCommonProperties=23;
+  }
+
   //! \brief The \c Dict class can be used to store objects of arbitrary
   //!        type keyed by \c strings.
   //!
-  //!  The actual storage is done using \c boost::any objects.
+  //!  The actual storage is done using \c boost::any objects in a
+  //!  vector keyed by \c PropKey ids. Dicts usually hold only a few
+  //!  values, so a linear scan of the vector is faster than a tree or
+  //!  hash lookup.
   //!
   class Dict {
   public:
-    typedef std::map<const std::string, boost::any> DataType;
+    typedef std::vector< std::pair<unsigned int, boost::any> > DataType;
     Dict(){
       _data.clear();
     };
@@ -49,28 +108,45 @@ namespace RDKit{
     //----------------------------------------------------------
     //! \brief Returns whether or not the dictionary contains a particular
     //!        key.
+    bool hasVal(PropKey what) const {
+      return find(what)!=_data.end();
+    };
+    //! \overload
     bool hasVal(const char *what) const{
-      std::string key(what);
+      PropKey key;
+      if(!findPropKey(what,key)) return false;
       return hasVal(key);
     };
+    //! \overload
     bool hasVal(const std::string &what) const {
-      return _data.find(what)!=_data.end();
+      return hasVal(what.c_str());
     };
 
     //----------------------------------------------------------
     //! Returns the set of keys in the dictionary
     /*!
-       \return  a \c STR_VECT
+       \return  a \c STR_VECT, sorted by name
     */
     STR_VECT keys() const {
       STR_VECT res;
+      res.reserve(_data.size());
       DataType::const_iterator item;
       for (item = _data.begin(); item != _data.end(); item++) {
-        res.push_back(item->first);
+        PropKey key={item->first};
+        res.push_back(key.getName());
       }
+      std::sort(res.begin(),res.end());
       return res;
     }
 
+    //----------------------------------------------------------
+    //! Returns the raw (key id, value) pairs in the dictionary
+    /*!
+       This allows the contents to be iterated over without the name
+       lookups and type conversions done by keys() and getVal().
+    */
+    const DataType &getData() const { return _data; };
+
     //----------------------------------------------------------
     //! \brief Gets the value associated with a particular key
     /*!
@@ -85,15 +161,20 @@ namespace RDKit{
           a KeyErrorException will be thrown.
     */
     template <typename T>
-    void getVal(const std::string &what,T &res) const {
-      DataType::const_iterator pos=_data.find(what);
+    void getVal(PropKey what,T &res) const {
+      DataType::const_iterator pos=find(what);
       if(pos==_data.end())
-	throw KeyErrorException(what);
+	throw KeyErrorException(what.getName());
       const boost::any &val = pos->second;
       res = fromany<T>(val);
     };
     //! \overload
     template <typename T>
+    void getVal(const std::string &what,T &res) const {
+      getVal(lookupKey(what.c_str()),res);
+    };
+    //! \overload
+    template <typename T>
     T getVal(const std::string &what) const {
       T res;
       getVal(what,res);
@@ -103,19 +184,60 @@ namespace RDKit{
     //! \overload
     template <typename T>
     T getVal(const char *what,T &res) const {
-      std::string key(what);
-      getVal(key, res);
+      getVal(lookupKey(what), res);
       return res;
     };
     //! \overload
     template <typename T>
     T getVal(const char *what) const {
-      std::string key(what);
-      return getVal<T>(key);
+      T res;
+      getVal(lookupKey(what), res);
+      return res;
     };
 
     //! \overload
-    void getVal(const std::string &what, std::string &res) const;
+    void getVal(PropKey what, std::string &res) const;
+    //! \overload
+    void getVal(const std::string &what, std::string &res) const {
+      getVal(lookupKey(what.c_str()),res);
+    };
+
+    //----------------------------------------------------------
+    //! \brief Gets the value associated with a particular key if
+    //!        it is present
+    /*!
+       This does a single lookup, rather than one for hasVal() and
+       another for getVal().
+
+       \return whether or not the key was present
+    */
+    template <typename T>
+    bool getValIfPresent(PropKey what,T &res) const {
+      DataType::const_iterator pos=find(what);
+      if(pos==_data.end()) return false;
+      res = fromany<T>(pos->second);
+      return true;
+    };
+
+    //----------------------------------------------------------
+    //! \brief Returns a pointer to the value associated with a key
+    /*!
+       No type conversions are done. If the dictionary does not contain
+       the key, or the value is not of type \c T, this returns null.
+    */
+    template <typename T>
+    T *getValPtr(PropKey what) {
+      DataType::iterator pos=find(what);
+      if(pos==_data.end()) return 0;
+      return boost::any_cast<T>(&pos->second);
+    };
+    //! \overload
+    template <typename T>
+    const T *getValPtr(PropKey what) const {
+      DataType::const_iterator pos=find(what);
+      if(pos==_data.end()) return 0;
+      return boost::any_cast<T>(&pos->second);
+    };
 
     //----------------------------------------------------------
     //! \brief Sets the value associated with a key
@@ -131,24 +253,35 @@ namespace RDKit{
             the value will be replaced.
     */
     template <typename T>
+    void setVal(PropKey what, T &val){
+      DataType::iterator pos=find(what);
+      if(pos!=_data.end()){
+        pos->second=toany(val);
+      } else {
+        _data.push_back(std::make_pair(what.id,toany(val)));
+      }
+    };
+    //! \overload
+    template <typename T>
     void setVal(const std::string &what, T &val){
-      std::string key = what;
-      _data[key] = toany(val);
+      setVal(getPropKey(what),val);
     };
     //! \overload
     template <typename T>
     void setVal(const char *what, T &val){
-      std::string key = what;
-      setVal(key,val);
+      setVal(getPropKey(what),val);
     };
     //! \overload
+    void setVal(PropKey what, const char *val){
+      std::string h(val);
+      setVal(what,h);
+    }
+    //! \overload
     void setVal(const std::string &what, const char *val){
       std::string h(val);
       setVal(what,h);
     }
 
-
-
     //----------------------------------------------------------
     //! \brief Clears the value associated with a particular key,
     //!     removing the key from the dictionary.
@@ -160,15 +293,18 @@ namespace RDKit{
         - If the dictionary does not contain the key \c what,
           a KeyErrorException will be thrown.
     */
+    void clearVal(PropKey what) {
+      DataType::iterator pos=find(what);
+      if(pos==_data.end()) throw KeyErrorException(what.getName());
+      _data.erase(pos);
+    };
+    //! \overload
     void clearVal(const std::string &what) {
-      if(! this->hasVal(what) ) throw KeyErrorException(what);
-      _data.erase(what);
+      clearVal(lookupKey(what.c_str()));
     };
-
     //! \overload
     void clearVal(const char *what) {
-      std::string key=what;
-      clearVal(key);
+      clearVal(lookupKey(what));
     };
 
     //----------------------------------------------------------
@@ -201,6 +337,28 @@ namespace RDKit{
 
   private:
     DataType _data; //!< the actual dictionary
+
+    DataType::const_iterator find(PropKey what) const {
+      DataType::const_iterator pos;
+      for(pos=_data.begin();pos!=_data.end();++pos){
+        if(pos->first==what.id) break;
+      }
+      return pos;
+    };
+    DataType::iterator find(PropKey what) {
+      DataType::iterator pos;
+      for(pos=_data.begin();pos!=_data.end();++pos){
+        if(pos->first==what.id) break;
+      }
+      return pos;
+    };
+    // returns the key for a name we are looking up, throwing a
+    // KeyErrorException if the name isn't in the table
+    PropKey lookupKey(const char *what) const {
+      PropKey res;
+      if(!findPropKey(what,res)) throw KeyErrorException(what);
+      return res;
+    };
   };
 }
 #endif
@@ -243,6 +243,29 @@ namespace RDKit{
     ss.read((char *)&tloc,sizeof(T));
     loc = EndianSwapBytes<LITTLE_ENDIAN_ORDER,HOST_ENDIAN_ORDER>(tloc);
   }
+
+  //! does a binary write of an array of objects to a stream
+  /*!
+    The result is the same as calling streamWrite() on each element, but
+    on little endian hosts the array is written in a single call.
+  */
+  template <typename T>
+    void streamWriteArray(std::ostream &ss,const T *vals,unsigned int nVals){
+    if(HOST_ENDIAN_ORDER==LITTLE_ENDIAN_ORDER){
+      ss.write((const char *)vals,nVals*sizeof(T));
+    } else {
+      for(unsigned int i=0;i<nVals;++i) streamWrite(ss,vals[i]);
+    }
+  }
+  //! does a binary read of an array of objects from a stream
+  template <typename T>
+    void streamReadArray(std::istream &ss,T *vals,unsigned int nVals){
+    if(HOST_ENDIAN_ORDER==LITTLE_ENDIAN_ORDER){
+      ss.read((char *)vals,nVals*sizeof(T));
+    } else {
+      for(unsigned int i=0;i<nVals;++i) streamRead(ss,vals[i]);
+    }
+  }
  
   //! grabs the next line from an instream and returns it.
   inline std::string getLine(std::istream *inStream) {
@@ -14,6 +14,10 @@
 #include <RDGeneral/Invariant.h>
 #include <RDGeneral/RDLog.h>
 #include <RDGeneral/utils.h>
+#include <sstream>
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread.hpp>
+#endif
 
 using namespace RDKit;
 using namespace std;
@@ -101,6 +105,162 @@ void testVectToString(){
   BOOST_LOG(rdErrorLog) << "\tdone" << std::endl;
 }
 
+void testPropKeys(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "Testing interned property keys." << std::endl;
+  {
+    TEST_ASSERT(common_properties::_Name.getName()=="_Name");
+    TEST_ASSERT(common_properties::molAtomMapNumber.getName()=="molAtomMapNumber");
+    TEST_ASSERT(common_properties::origNoImplicit.getName()=="origNoImplicit");
+    TEST_ASSERT(getPropKey("_CIPCode")==common_properties::_CIPCode);
+
+    PropKey key;
+    TEST_ASSERT(!findPropKey("testPropKeys_notThere",key));
+    PropKey key2=getPropKey(std::string("testPropKeys_notThere"));
+    TEST_ASSERT(findPropKey("testPropKeys_notThere",key));
+    TEST_ASSERT(key==key2);
+    TEST_ASSERT(key.id>=common_properties::numCommonProperties);
+    TEST_ASSERT(key.getName()=="testPropKeys_notThere");
+  }
+  {
+    Dict d;
+    int v=3;
+    d.setVal(common_properties::_CIPRank,v);
+    TEST_ASSERT(d.hasVal("_CIPRank"));
+    TEST_ASSERT(d.hasVal(common_properties::_CIPRank));
+    TEST_ASSERT(!d.hasVal(common_properties::_CIPCode));
+    TEST_ASSERT(d.getVal<int>("_CIPRank")==3);
+    v=4;
+    d.setVal("_CIPRank",v);
+    int v2=0;
+    d.getVal(common_properties::_CIPRank,v2);
+    TEST_ASSERT(v2==4);
+    TEST_ASSERT(d.keys().size()==1);
+
+    v2=0;
+    TEST_ASSERT(d.getValIfPresent(common_properties::_CIPRank,v2));
+    TEST_ASSERT(v2==4);
+    TEST_ASSERT(!d.getValIfPresent(common_properties::_CIPCode,v2));
+    TEST_ASSERT(v2==4);
+
+    int *vp=d.getValPtr<int>(common_properties::_CIPRank);
+    TEST_ASSERT(vp && *vp==4);
+    *vp=5;
+    TEST_ASSERT(d.getVal<int>("_CIPRank")==5);
+    TEST_ASSERT(!d.getValPtr<double>(common_properties::_CIPRank));
+    TEST_ASSERT(!d.getValPtr<int>(common_properties::_CIPCode));
+
+    std::string sv;
+    d.getVal(common_properties::_CIPRank,sv);
+    TEST_ASSERT(sv=="5");
+
+    // the keys are sorted by name:
+    d.setVal("b",v);
+    d.setVal("a",v);
+    STR_VECT keys=d.keys();
+    TEST_ASSERT(keys.size()==3);
+    TEST_ASSERT(keys[0]=="_CIPRank");
+    TEST_ASSERT(keys[1]=="a");
+    TEST_ASSERT(keys[2]=="b");
+
+    d.clearVal(common_properties::_CIPRank);
+    TEST_ASSERT(!d.hasVal("_CIPRank"));
+    d.clearVal("a");
+    TEST_ASSERT(d.keys().size()==1);
+    bool ok=false;
+    try{
+      d.clearVal("a");
+    } catch (const KeyErrorException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    ok=false;
+    try{
+      d.getVal(common_properties::_CIPRank,v2);
+    } catch (const KeyErrorException &e) {
+      TEST_ASSERT(e.key()=="_CIPRank");
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    ok=false;
+    try{
+      d.getVal("testPropKeys_neverSet",v2);
+    } catch (const KeyErrorException &e) {
+      TEST_ASSERT(e.key()=="testPropKeys_neverSet");
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    PropKey key;
+    TEST_ASSERT(!findPropKey("testPropKeys_neverSet",key));
+  }
+  BOOST_LOG(rdErrorLog) << "\tdone" << std::endl;
+}
+
+void testManyPropKeys(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "Testing adding many property keys." << std::endl;
+  {
+    // enough to need several blocks of names and to grow the hash table:
+    std::vector<PropKey> keys;
+    for(unsigned int i=0;i<2000;++i){
+      std::ostringstream name;
+      name<<"testManyPropKeys_"<<i;
+      keys.push_back(getPropKey(name.str()));
+    }
+    for(unsigned int i=0;i<keys.size();++i){
+      std::ostringstream name;
+      name<<"testManyPropKeys_"<<i;
+      PropKey key;
+      TEST_ASSERT(findPropKey(name.str().c_str(),key));
+      TEST_ASSERT(key==keys[i]);
+      TEST_ASSERT(keys[i].getName()==name.str());
+    }
+    TEST_ASSERT(getPropKey("_CIPCode")==common_properties::_CIPCode);
+    TEST_ASSERT(common_properties::origNoImplicit.getName()=="origNoImplicit");
+  }
+  BOOST_LOG(rdErrorLog) << "\tdone" << std::endl;
+}
+
+#ifdef RDK_THREADSAFE_SSS
+namespace {
+  void addAndFindKeys(unsigned int start,std::vector<PropKey> *res){
+    for(unsigned int i=0;i<1000;++i){
+      std::ostringstream name;
+      name<<"testThreadedPropKeys_"<<(start+i)%1500;
+      PropKey key=getPropKey(name.str());
+      res->push_back(key);
+      TEST_ASSERT(key.getName()==name.str());
+    }
+  }
+}
+void testThreadedPropKeys(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "Testing adding property keys from multiple threads." << std::endl;
+  {
+    // the threads overlap in the names they add:
+    const unsigned int nThreads=4;
+    std::vector<PropKey> res[nThreads];
+    boost::thread_group tg;
+    for(unsigned int ti=0;ti<nThreads;++ti){
+      tg.add_thread(new boost::thread(addAndFindKeys,ti*250,&res[ti]));
+    }
+    tg.join_all();
+    // everyone got the same key for the same name:
+    for(unsigned int ti=0;ti<nThreads;++ti){
+      TEST_ASSERT(res[ti].size()==1000);
+      for(unsigned int i=0;i<1000;++i){
+        std::ostringstream name;
+        name<<"testThreadedPropKeys_"<<(ti*250+i)%1500;
+        PropKey key;
+        TEST_ASSERT(findPropKey(name.str().c_str(),key));
+        TEST_ASSERT(key==res[ti][i]);
+      }
+    }
+  }
+  BOOST_LOG(rdErrorLog) << "\tdone" << std::endl;
+}
+#endif
+
 int main(){
   RDLog::InitLogs();
   Dict d;
@@ -188,6 +348,11 @@ int main(){
   
   testStringVals();
   testVectToString();
+  testPropKeys();
+  testManyPropKeys();
+#ifdef RDK_THREADSAFE_SSS
+  testThreadedPropKeys();
+#endif
 
   return 0;
 